@@ -0,0 +1,191 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Build a compiled kernel cache for a list of FFT problems, without
+// a GPU.
+//
+// Each line of the manifest describes one problem (see manifest.h).
+//
+// Every kernel that plans for those problems need on each of the
+// requested architectures is compiled and written to the output
+// cache.  If the output cache already exists, its kernels are kept
+// and are not recompiled.  The result can be imported with
+// rocfft_cache_deserialize, or used directly as the system cache by
+// pointing ROCFFT_RTC_SYS_CACHE_PATH at it.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../shared/environment.h"
+#include "../rocfft_params.h"
+#include "manifest.h"
+#include "rocfft.h"
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+// compile the kernels needed by a plan for the problem
+rocfft_status build_kernels(const fft_params& params, const std::string& gpu_arch)
+{
+    rocfft_plan_description desc = nullptr;
+    rocfft_status           ret  = create_description(params, desc);
+    if(ret != rocfft_status_success)
+        return ret;
+
+    auto length = params.length_cm();
+    ret         = rocfft_cache_build_kernels(
+        gpu_arch.c_str(),
+        rocfft_result_placement_from_fftparams(params.placement),
+        rocfft_transform_type_from_fftparams(params.transform_type),
+        rocfft_precision_from_fftparams(params.precision),
+        length.size(),
+        length.data(),
+        params.nbatch,
+        desc);
+    rocfft_plan_description_destroy(desc);
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string              manifest_path;
+    std::string              output_path;
+    std::vector<std::string> gpu_archs;
+    size_t                   num_threads = 0;
+
+    // clang-format off
+    po::options_description opdesc("rocfft-cache-warmup command line options");
+    opdesc.add_options()("help,h", "produces this help message")
+        ("manifest,m", po::value<std::string>(&manifest_path)->required(),
+         "File listing problems, one token or rocfft-rider command line per line")
+        ("output,o", po::value<std::string>(&output_path)->required(),
+         "Cache file to write compiled kernels to")
+        ("arch,a", po::value<std::vector<std::string>>(&gpu_archs)->required()->multitoken(),
+         "GPU architectures to compile for, as reported by the device "
+         "(e.g. gfx90a:sramecc+:xnack-)")
+        ("threads,j", po::value<size_t>(&num_threads)->default_value(0),
+         "Number of problems to plan at once (default: number of hardware threads)");
+    // clang-format on
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, opdesc), vm);
+    if(vm.count("help"))
+    {
+        std::cout << opdesc << std::endl;
+        return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+
+    std::vector<fft_params> problems;
+    try
+    {
+        problems = read_manifest(manifest_path);
+    }
+    catch(std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // compile into an in-memory cache, seeded from the existing
+    // output so its kernels aren't compiled again.  don't use the
+    // system cache, since its kernels need to end up in the output
+    // too.
+    rocfft_setenv("ROCFFT_RTC_CACHE_PATH", ":memory:");
+    rocfft_setenv("ROCFFT_RTC_SYS_CACHE_PATH", ":memory:");
+    rocfft_setenv("ROCFFT_RTC_CACHE_MAX_SIZE", "0");
+    rocfft_setup();
+
+    {
+        std::ifstream     existing(output_path, std::ios::binary);
+        std::vector<char> buf{std::istreambuf_iterator<char>(existing),
+                              std::istreambuf_iterator<char>()};
+        if(!buf.empty() && rocfft_cache_deserialize(buf.data(), buf.size()) != rocfft_status_success)
+        {
+            std::cerr << "unable to read existing cache " << output_path << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // plan problems in parallel - the library queues up the actual
+    // compilations on its own threads
+    const size_t        num_jobs = problems.size() * gpu_archs.size();
+    std::atomic<size_t> next_job(0);
+    std::atomic<size_t> failures(0);
+    if(num_threads == 0)
+        num_threads = std::thread::hardware_concurrency();
+
+    std::vector<std::thread> threads;
+    for(size_t i = 0; i < std::min(std::max<size_t>(num_threads, 1), num_jobs); ++i)
+    {
+        threads.emplace_back([&]() {
+            for(size_t job = next_job++; job < num_jobs; job = next_job++)
+            {
+                const auto& params   = problems[job / gpu_archs.size()];
+                const auto& gpu_arch = gpu_archs[job % gpu_archs.size()];
+                if(build_kernels(params, gpu_arch) != rocfft_status_success)
+                {
+                    ++failures;
+                    std::cerr << "failed to build kernels for " << gpu_arch << " "
+                              << params.token() << std::endl;
+                }
+            }
+        });
+    }
+    for(auto& t : threads)
+        t.join();
+
+    size_t entries    = 0;
+    size_t size_bytes = 0;
+    size_t misses     = 0;
+    rocfft_cache_get_stats(&entries, &size_bytes, nullptr, &misses, nullptr);
+
+    void*  buf     = nullptr;
+    size_t buf_len = 0;
+    if(rocfft_cache_serialize(&buf, &buf_len) != rocfft_status_success)
+    {
+        std::cerr << "unable to serialize cache" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::ofstream output(output_path, std::ios::binary | std::ios::trunc);
+    output.write(static_cast<const char*>(buf), buf_len);
+    rocfft_cache_buffer_free(buf);
+    output.close();
+    if(!output)
+    {
+        std::cerr << "unable to write " << output_path << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    rocfft_cleanup();
+
+    std::cout << problems.size() << " problems, " << gpu_archs.size() << " architectures: "
+              << misses << " kernels compiled, " << entries << " kernels (" << size_bytes
+              << " bytes) in " << output_path << std::endl;
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,181 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ROCFFT_MANIFEST_H
+#define ROCFFT_MANIFEST_H
+
+// Reading lists of FFT problems for tools that plan many problems.
+//
+// Each line of a manifest describes one problem, either as a test
+// token (as printed by rocfft-rider and the tests), or as a
+// rocfft-rider command line (as written to the bench log by
+// ROCFFT_LAYER=2).  Blank lines and lines starting with '#' are
+// ignored.
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../rocfft_params.h"
+#include "rocfft.h"
+#include <boost/program_options.hpp>
+
+// parse a rocfft-rider command line
+inline fft_params parse_rider_command(const std::string& line)
+{
+    namespace po = boost::program_options;
+
+    std::istringstream       ss(line);
+    std::vector<std::string> args{std::istream_iterator<std::string>(ss),
+                                  std::istream_iterator<std::string>()};
+    // first word is the program name
+    if(!args.empty())
+        args.erase(args.begin());
+
+    fft_params  params;
+    std::string token;
+
+    // only the options that describe the problem are needed, others
+    // are ignored
+    // clang-format off
+    po::options_description opdesc;
+    opdesc.add_options()
+        ("notInPlace,o", "")
+        ("double", "")
+        ("transformType,t", po::value<fft_transform_type>(&params.transform_type)
+         ->default_value(fft_transform_type_complex_forward), "")
+        ("batchSize,b", po::value<size_t>(&params.nbatch)->default_value(1), "")
+        ("itype", po::value<fft_array_type>(&params.itype)->default_value(fft_array_type_unset), "")
+        ("otype", po::value<fft_array_type>(&params.otype)->default_value(fft_array_type_unset), "")
+        ("length",  po::value<std::vector<size_t>>(&params.length)->multitoken(), "")
+        ("istride", po::value<std::vector<size_t>>(&params.istride)->multitoken(), "")
+        ("ostride", po::value<std::vector<size_t>>(&params.ostride)->multitoken(), "")
+        ("idist", po::value<size_t>(&params.idist)->default_value(0), "")
+        ("odist", po::value<size_t>(&params.odist)->default_value(0), "")
+        ("ioffset", po::value<std::vector<size_t>>(&params.ioffset)->multitoken(), "")
+        ("ooffset", po::value<std::vector<size_t>>(&params.ooffset)->multitoken(), "")
+        ("scalefactor", po::value<double>(&params.scale_factor), "")
+        ("token", po::value<std::string>(&token));
+    // clang-format on
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(args).options(opdesc).allow_unregistered().run(), vm);
+    po::notify(vm);
+
+    if(!token.empty())
+    {
+        params.from_token(token);
+        return params;
+    }
+
+    if(params.length.empty())
+        throw std::runtime_error("no length given");
+    params.placement = vm.count("notInPlace") ? fft_placement_notinplace : fft_placement_inplace;
+    params.precision = vm.count("double") ? fft_precision_double : fft_precision_single;
+    return params;
+}
+
+// parse one manifest line, which is either a rider command line or
+// a token
+inline fft_params parse_manifest_line(const std::string& line)
+{
+    std::istringstream ss(line);
+    std::string        first;
+    ss >> first;
+
+    fft_params params;
+    if(first.find("rider") != std::string::npos)
+        params = parse_rider_command(line);
+    else
+        params.from_token(first);
+
+    params.validate();
+    if(!params.valid(0))
+        throw std::runtime_error("invalid parameters");
+    return params;
+}
+
+// read all problems in a manifest file, throwing an exception that
+// names the offending line if a problem can't be parsed
+inline std::vector<fft_params> read_manifest(const std::string& manifest_path)
+{
+    std::ifstream manifest(manifest_path);
+    if(!manifest)
+        throw std::runtime_error("unable to open manifest " + manifest_path);
+
+    std::vector<fft_params> problems;
+    std::string             line;
+    size_t                  lineno = 0;
+    while(std::getline(manifest, line))
+    {
+        ++lineno;
+        auto begin = line.find_first_not_of(" \t\r");
+        if(begin == std::string::npos || line[begin] == '#')
+            continue;
+        try
+        {
+            problems.push_back(parse_manifest_line(line.substr(begin)));
+        }
+        catch(std::exception& e)
+        {
+            throw std::runtime_error(manifest_path + ":" + std::to_string(lineno) + ": "
+                                     + e.what());
+        }
+    }
+    return problems;
+}
+
+// create a plan description with the problem's data layout
+inline rocfft_status create_description(const fft_params& params, rocfft_plan_description& desc)
+{
+    desc = nullptr;
+    if(rocfft_plan_description_create(&desc) != rocfft_status_success)
+        return rocfft_status_failure;
+
+    auto          istride = params.istride_cm();
+    auto          ostride = params.ostride_cm();
+    rocfft_status ret
+        = rocfft_plan_description_set_data_layout(desc,
+                                                  rocfft_array_type_from_fftparams(params.itype),
+                                                  rocfft_array_type_from_fftparams(params.otype),
+                                                  params.ioffset.data(),
+                                                  params.ooffset.data(),
+                                                  istride.size(),
+                                                  istride.data(),
+                                                  params.idist,
+                                                  ostride.size(),
+                                                  ostride.data(),
+                                                  params.odist);
+#ifdef ROCFFT_SCALE_FACTOR
+    if(ret == rocfft_status_success && params.scale_factor != 1.0)
+        ret = rocfft_plan_description_set_scale_factor(desc, params.scale_factor);
+#endif
+    if(ret != rocfft_status_success)
+    {
+        rocfft_plan_description_destroy(desc);
+        desc = nullptr;
+    }
+    return ret;
+}
+
+#endif // ROCFFT_MANIFEST_H
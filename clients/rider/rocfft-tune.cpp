@@ -0,0 +1,140 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Tune plans for a list of FFT problems, and record the fastest
+// decompositions in a scheme table.
+//
+// Each line of the manifest describes one problem (see manifest.h).
+// Only complex transforms are tuned; other problems are skipped.
+//
+// Problems are tuned on the current device, one at a time.  If an
+// architecture is given, they are instead tuned for that
+// architecture without a GPU, using rocFFT's cost model.
+//
+// Entries for the winners are added to the output table, which is
+// created if it does not exist.  Plans use the table when
+// ROCFFT_SCHEME_TABLE points at it.
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../rocfft_params.h"
+#include "manifest.h"
+#include "rocfft.h"
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+// tune one problem, adding the result to the table at output_path
+rocfft_status tune(const fft_params&  params,
+                   const std::string& output_path,
+                   const std::string& gpu_arch)
+{
+    rocfft_plan_description desc = nullptr;
+    rocfft_status           ret  = create_description(params, desc);
+    if(ret != rocfft_status_success)
+        return ret;
+
+    if(!gpu_arch.empty())
+        ret = rocfft_plan_description_set_target_device(desc, gpu_arch.c_str(), 0, 0);
+
+    if(ret == rocfft_status_success)
+    {
+        auto length = params.length_cm();
+        ret         = rocfft_plan_tune(output_path.c_str(),
+                                       rocfft_result_placement_from_fftparams(params.placement),
+                                       rocfft_transform_type_from_fftparams(params.transform_type),
+                                       rocfft_precision_from_fftparams(params.precision),
+                                       length.size(),
+                                       length.data(),
+                                       params.nbatch,
+                                       desc);
+    }
+    rocfft_plan_description_destroy(desc);
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string manifest_path;
+    std::string output_path;
+    std::string gpu_arch;
+
+    // clang-format off
+    po::options_description opdesc("rocfft-tune command line options");
+    opdesc.add_options()("help,h", "produces this help message")
+        ("manifest,m", po::value<std::string>(&manifest_path)->required(),
+         "File listing problems, one token or rocfft-rider command line per line")
+        ("output,o", po::value<std::string>(&output_path)->required(),
+         "Scheme table file to add tuned entries to")
+        ("arch,a", po::value<std::string>(&gpu_arch),
+         "Tune for this GPU architecture with the cost model instead of timing on the "
+         "current device (e.g. gfx90a:sramecc+:xnack-)");
+    // clang-format on
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, opdesc), vm);
+    if(vm.count("help"))
+    {
+        std::cout << opdesc << std::endl;
+        return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+
+    std::vector<fft_params> problems;
+    try
+    {
+        problems = read_manifest(manifest_path);
+    }
+    catch(std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    rocfft_setup();
+
+    size_t tuned    = 0;
+    size_t failures = 0;
+    for(const auto& params : problems)
+    {
+        if(params.transform_type != fft_transform_type_complex_forward
+           && params.transform_type != fft_transform_type_complex_inverse)
+        {
+            std::cerr << "skipping real transform " << params.token() << std::endl;
+            continue;
+        }
+        if(tune(params, output_path, gpu_arch) != rocfft_status_success)
+        {
+            ++failures;
+            std::cerr << "failed to tune " << params.token() << std::endl;
+            continue;
+        }
+        ++tuned;
+    }
+
+    rocfft_cleanup();
+
+    std::cout << tuned << " of " << problems.size() << " problems tuned into " << output_path
+              << std::endl;
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
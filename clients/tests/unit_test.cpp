@@ -24,12 +24,24 @@
 #include "../../shared/gpubuf.h"
 #include "hip/hip_runtime_api.h"
 #include "hip/hip_vector_types.h"
+#include "launch_check.h"
+#include "ref_cpu_fft.h"
+#include <algorithm>
 #include <boost/scope_exit.hpp>
+#include <cmath>
+#include <complex>
 #include <condition_variable>
+#include <cstdlib>
 #include <fstream>
+#include <functional>
 #include <gtest/gtest.h>
+#include <limits>
+#include <map>
 #include <mutex>
+#include <numeric>
 #include <regex>
+#include <set>
+#include <sstream>
 #include <thread>
 #include <vector>
 
@@ -48,6 +60,9 @@ namespace fs = std::filesystem;
 #ifndef WIN32
 // get program_invocation_name
 #include <errno.h>
+// redirect standard output
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 TEST(rocfft_UnitTest, plan_description)
@@ -158,6 +173,117 @@ TEST(rocfft_UnitTest, repo_twiddle)
     rocfft_plan_destroy(plan_inverse);
 }
 
+// check that twiddle memory is reported per device, and that plans
+// needing the same tables don't add to it
+TEST(rocfft_UnitTest, repo_twiddle_stats)
+{
+    int deviceId = 0;
+    ASSERT_EQ(hipGetDevice(&deviceId), hipSuccess);
+
+    size_t buffers_before = 0;
+    size_t bytes_before   = 0;
+    size_t tables_before  = 0;
+    ASSERT_EQ(rocfft_twiddle_get_stats(deviceId, &buffers_before, &bytes_before, &tables_before),
+              rocfft_status_success);
+    EXPECT_EQ(rocfft_twiddle_get_stats(deviceId, nullptr, nullptr, nullptr),
+              rocfft_status_success);
+
+    const size_t length  = 1 << 24;
+    rocfft_plan  forward = nullptr;
+    rocfft_plan  inverse = nullptr;
+    ASSERT_EQ(rocfft_plan_create(&forward,
+                                 rocfft_placement_inplace,
+                                 rocfft_transform_type_complex_forward,
+                                 rocfft_precision_single,
+                                 1,
+                                 &length,
+                                 1,
+                                 nullptr),
+              rocfft_status_success);
+
+    size_t buffers_1 = 0;
+    size_t bytes_1   = 0;
+    size_t tables_1  = 0;
+    ASSERT_EQ(rocfft_twiddle_get_stats(deviceId, &buffers_1, &bytes_1, &tables_1),
+              rocfft_status_success);
+    EXPECT_GT(bytes_1, bytes_before);
+    EXPECT_GT(tables_1, tables_before);
+    EXPECT_LE(buffers_1 - buffers_before, tables_1 - tables_before);
+
+    // twiddles don't depend on direction, so the inverse plan uses
+    // the same tables
+    ASSERT_EQ(rocfft_plan_create(&inverse,
+                                 rocfft_placement_inplace,
+                                 rocfft_transform_type_complex_inverse,
+                                 rocfft_precision_single,
+                                 1,
+                                 &length,
+                                 1,
+                                 nullptr),
+              rocfft_status_success);
+    size_t buffers_2 = 0;
+    size_t bytes_2   = 0;
+    size_t tables_2  = 0;
+    ASSERT_EQ(rocfft_twiddle_get_stats(deviceId, &buffers_2, &bytes_2, &tables_2),
+              rocfft_status_success);
+    EXPECT_EQ(buffers_2, buffers_1);
+    EXPECT_EQ(bytes_2, bytes_1);
+    EXPECT_EQ(tables_2, tables_1);
+
+    // the tables are freed with the last plan using them
+    rocfft_plan_destroy(forward);
+    rocfft_plan_destroy(inverse);
+    size_t bytes_after = 0;
+    ASSERT_EQ(rocfft_twiddle_get_stats(deviceId, nullptr, &bytes_after, nullptr),
+              rocfft_status_success);
+    EXPECT_EQ(bytes_after, bytes_before);
+
+    auto create = [](rocfft_transform_type type, const std::vector<size_t>& lengths) {
+        rocfft_plan plan = nullptr;
+        EXPECT_EQ(rocfft_plan_create(&plan,
+                                     rocfft_placement_notinplace,
+                                     type,
+                                     rocfft_precision_single,
+                                     lengths.size(),
+                                     lengths.data(),
+                                     1,
+                                     nullptr),
+                  rocfft_status_success);
+        return plan;
+    };
+    auto buffers = [deviceId]() {
+        size_t count = 0;
+        EXPECT_EQ(rocfft_twiddle_get_stats(deviceId, &count, nullptr, nullptr),
+                  rocfft_status_success);
+        return count;
+    };
+
+    // an even-length real transform is done with a complex FFT of
+    // half the length, whose table has the half-N table attached.  a
+    // complex plan of that length is served from it.
+    {
+        rocfft_plan real_plan    = create(rocfft_transform_type_real_forward, {8192});
+        size_t      buffers_real = buffers();
+        rocfft_plan complex_plan = create(rocfft_transform_type_complex_forward, {4096});
+        EXPECT_EQ(buffers(), buffers_real);
+        rocfft_plan_destroy(complex_plan);
+        rocfft_plan_destroy(real_plan);
+    }
+
+    // a 1D plan is served from either dimension of a 2D table.  the
+    // 2D single kernel for these lengths uses the same factors as
+    // the 1D kernels.
+    for(size_t length_1D : {16, 8})
+    {
+        rocfft_plan plan_2D    = create(rocfft_transform_type_complex_forward, {16, 8});
+        size_t      buffers_2D = buffers();
+        rocfft_plan plan_1D    = create(rocfft_transform_type_complex_forward, {length_1D});
+        EXPECT_EQ(buffers(), buffers_2D) << "length " << length_1D;
+        rocfft_plan_destroy(plan_1D);
+        rocfft_plan_destroy(plan_2D);
+    }
+}
+
 // RAII object to set an environment variable and restore it to its
 // previous value on destruction
 struct EnvironmentSetTemp
@@ -181,6 +307,191 @@ struct EnvironmentSetTemp
     std::string oldvalue;
 };
 
+// run a forward complex 1D transform of 'input' and return the output
+template <typename T>
+static std::vector<std::complex<T>> run_complex_forward(rocfft_precision                   precision,
+                                                        const std::vector<std::complex<T>>& input)
+{
+    const size_t length = input.size();
+    rocfft_plan  plan   = nullptr;
+    EXPECT_EQ(rocfft_plan_create(&plan,
+                                 rocfft_placement_notinplace,
+                                 rocfft_transform_type_complex_forward,
+                                 precision,
+                                 1,
+                                 &length,
+                                 1,
+                                 nullptr),
+              rocfft_status_success);
+
+    auto   bytes = input.size() * sizeof(std::complex<T>);
+    gpubuf in_device;
+    gpubuf out_device;
+    EXPECT_EQ(in_device.alloc(bytes), hipSuccess);
+    EXPECT_EQ(out_device.alloc(bytes), hipSuccess);
+    EXPECT_EQ(hipMemcpy(in_device.data(), input.data(), bytes, hipMemcpyHostToDevice), hipSuccess);
+
+    void* in_ptr  = in_device.data();
+    void* out_ptr = out_device.data();
+    EXPECT_EQ(rocfft_execute(plan, &in_ptr, &out_ptr, nullptr), rocfft_status_success);
+
+    std::vector<std::complex<T>> output(input.size());
+    EXPECT_EQ(hipMemcpy(output.data(), out_device.data(), bytes, hipMemcpyDeviceToHost),
+              hipSuccess);
+    rocfft_plan_destroy(plan);
+    return output;
+}
+
+// relative L2 difference between two outputs
+template <typename T>
+static double relative_diff(const std::vector<std::complex<T>>& a,
+                            const std::vector<std::complex<T>>& b)
+{
+    double diff = 0.0;
+    double norm = 0.0;
+    for(size_t i = 0; i < a.size(); ++i)
+    {
+        diff += std::norm(std::complex<double>(a[i]) - std::complex<double>(b[i]));
+        norm += std::norm(std::complex<double>(b[i]));
+    }
+    return std::sqrt(diff / norm);
+}
+
+template <typename T>
+static void twiddle_generator_test(rocfft_precision precision, double tolerance)
+{
+    // large enough for large twiddles and for the tables to be cached
+    const size_t                 length = 1 << 22;
+    std::vector<std::complex<T>> input(length);
+    for(size_t i = 0; i < length; ++i)
+        input[i] = {static_cast<T>(std::sin(0.001 * i)), static_cast<T>(std::cos(0.003 * i))};
+
+    // host-generated tables are cached, so the second run reads them
+    // back from the cache and must give identical results
+    auto host      = run_complex_forward(precision, input);
+    auto host_warm = run_complex_forward(precision, input);
+    EXPECT_EQ(host, host_warm);
+
+    // device tables are computed differently, but must be just as
+    // accurate
+    EnvironmentSetTemp generator("ROCFFT_TWIDDLE_GENERATOR", "device");
+    auto               device = run_complex_forward(precision, input);
+    EXPECT_LT(relative_diff(host, device), tolerance);
+}
+
+// twiddles generated on the host match the ones generated on the
+// device
+TEST(rocfft_UnitTest, twiddle_host_generator)
+{
+    static const char* CACHE_FILE = "twiddle_host_generator.db";
+
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_cleanup();
+        remove(CACHE_FILE);
+        rocfft_setup();
+    };
+
+    rocfft_cleanup();
+    remove(CACHE_FILE);
+    EnvironmentSetTemp cache_env("ROCFFT_RTC_CACHE_PATH", CACHE_FILE);
+    rocfft_setup();
+
+    twiddle_generator_test<float>(rocfft_precision_single, 1e-6);
+    twiddle_generator_test<double>(rocfft_precision_double, 1e-14);
+}
+
+// DFT of contiguous vectors of 'length' elements, computed straight
+// from the definition
+template <typename T>
+static std::vector<std::complex<T>>
+    naive_dft(const std::vector<std::complex<T>>& input, size_t length, int direction)
+{
+    static const long double PI_LONG = 3.141592653589793238462643383279502884L;
+
+    std::vector<std::complex<double>> roots(length);
+    for(size_t k = 0; k < length; ++k)
+    {
+        long double theta = direction * 2.0L * PI_LONG * k / length;
+        roots[k] = {static_cast<double>(std::cos(theta)), static_cast<double>(std::sin(theta))};
+    }
+
+    std::vector<std::complex<T>> output(input.size());
+    for(size_t first = 0; first < input.size(); first += length)
+    {
+        for(size_t k = 0; k < length; ++k)
+        {
+            std::complex<double> sum = 0.0;
+            for(size_t n = 0; n < length; ++n)
+                sum += std::complex<double>(input[first + n]) * roots[(n * k) % length];
+            output[first + k] = static_cast<std::complex<T>>(sum);
+        }
+    }
+    return output;
+}
+
+template <typename T>
+static void ref_fft_test(double tolerance)
+{
+    auto fill = [](size_t count) {
+        std::vector<std::complex<T>> data(count);
+        for(size_t i = 0; i < count; ++i)
+            data[i] = {static_cast<T>(std::sin(0.37 * i + count)),
+                       static_cast<T>(std::cos(0.11 * i))};
+        return data;
+    };
+
+    auto check = [&](size_t length, size_t howmany, int direction) {
+        auto input  = fill(length * howmany);
+        auto output = input;
+        RefFFTPlan<T>(length, direction).Execute(output.data(), howmany);
+        EXPECT_LT(relative_diff(output, naive_dft(input, length, direction)), tolerance)
+            << "length " << length << ", batch " << howmany << ", direction " << direction;
+    };
+
+    // each radix as the only pass, and after other passes
+    for(size_t radix = 2; radix <= 17; ++radix)
+    {
+        check(radix, 3, -1);
+        check(radix * 6, 3, 1);
+    }
+    // prime factors over 17 get a plain DFT pass
+    check(19, 2, -1);
+    check(23 * 8, 2, 1);
+    // a lone long transform splits each pass across threads
+    check(16384, 1, -1);
+
+    // more transforms than fit in a block, with the vectors
+    // interleaved: vector (o, i) starts at o * dist + i and its
+    // elements are 'inner' apart
+    const size_t length = 12;
+    const size_t inner  = 5;
+    const size_t outer  = 14;
+    const size_t dist   = inner * length;
+
+    auto input  = fill(outer * dist);
+    auto output = input;
+    RefFFTPlan<T>(length, -1).Execute(output.data(), inner, inner, dist, outer);
+
+    auto gather = [&](const std::vector<std::complex<T>>& data) {
+        std::vector<std::complex<T>> packed;
+        for(size_t o = 0; o < outer; ++o)
+            for(size_t i = 0; i < inner; ++i)
+                for(size_t e = 0; e < length; ++e)
+                    packed.push_back(data[o * dist + i + e * inner]);
+        return packed;
+    };
+    EXPECT_LT(relative_diff(gather(output), naive_dft(gather(input), length, -1)), tolerance);
+}
+
+// the host FFT behind the CPU reference matches a plain DFT, without
+// needing a device
+TEST(rocfft_UnitTest, ref_cpu_fft)
+{
+    ref_fft_test<float>(1e-5);
+    ref_fft_test<double>(1e-12);
+}
+
 // Check whether logs can be emitted from multiple threads properly
 TEST(rocfft_UnitTest, log_multithreading)
 {
@@ -239,20 +550,24 @@ TEST(rocfft_UnitTest, log_multithreading)
     }
 }
 
-// a function that accepts a plan's requested size on input, and
-// returns the size to actually allocate for the test
-typedef std::function<size_t(size_t)> workmem_sizer;
-
-void workmem_test(workmem_sizer sizer,
-                  rocfft_status exec_status_expected,
-                  bool          give_null_work_buf = false)
+// Check that one plan can be executed from multiple threads at
+// once, each with its own buffers
+TEST(rocfft_UnitTest, execute_multithreading)
 {
-    // Prime size requires Bluestein, which guarantees work memory.
-    size_t      length = 8191;
-    rocfft_plan plan   = NULL;
+    static const int NUM_THREADS          = 4;
+    static const int NUM_ITERS_PER_THREAD = 20;
+    // decomposed into several kernels that use a work buffer
+    const size_t length = 1 << 20;
+    const size_t bytes  = length * sizeof(std::complex<float>);
+
+    std::vector<std::complex<float>> input(length);
+    for(size_t i = 0; i < length; ++i)
+        input[i] = {std::sin(0.001f * i), std::cos(0.003f * i)};
+    auto expected = run_complex_forward(rocfft_precision_single, input);
 
+    rocfft_plan plan = nullptr;
     ASSERT_EQ(rocfft_plan_create(&plan,
-                                 rocfft_placement_inplace,
+                                 rocfft_placement_notinplace,
                                  rocfft_transform_type_complex_forward,
                                  rocfft_precision_single,
                                  1,
@@ -260,78 +575,1758 @@ void workmem_test(workmem_sizer sizer,
                                  1,
                                  nullptr),
               rocfft_status_success);
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_plan_destroy(plan);
+    };
 
-    size_t requested_work_size = 0;
-    ASSERT_EQ(rocfft_plan_get_work_buffer_size(plan, &requested_work_size), rocfft_status_success);
-    ASSERT_GT(requested_work_size, 0);
+    std::vector<std::vector<std::complex<float>>> outputs(NUM_THREADS);
+    std::vector<std::thread>                      threads;
+    threads.reserve(NUM_THREADS);
+    for(int i = 0; i < NUM_THREADS; ++i)
+    {
+        threads.emplace_back([&, i]() {
+            // alternate between two sets of buffers, so the plan
+            // sees both new and repeated buffers
+            gpubuf in_device[2];
+            gpubuf out_device[2];
+            for(int b = 0; b < 2; ++b)
+            {
+                EXPECT_EQ(in_device[b].alloc(bytes), hipSuccess);
+                EXPECT_EQ(out_device[b].alloc(bytes), hipSuccess);
+            }
 
-    rocfft_execution_info info;
+            for(int j = 0; j < NUM_ITERS_PER_THREAD; ++j)
+            {
+                // out-of-place transforms may overwrite their input
+                auto& in  = in_device[j % 2];
+                auto& out = out_device[j % 2];
+                EXPECT_EQ(hipMemcpy(in.data(), input.data(), bytes, hipMemcpyHostToDevice),
+                          hipSuccess);
+                void* in_ptr  = in.data();
+                void* out_ptr = out.data();
+                EXPECT_EQ(rocfft_execute(plan, &in_ptr, &out_ptr, nullptr),
+                          rocfft_status_success);
+            }
+
+            outputs[i].resize(length);
+            EXPECT_EQ(hipMemcpy(outputs[i].data(),
+                                out_device[(NUM_ITERS_PER_THREAD - 1) % 2].data(),
+                                bytes,
+                                hipMemcpyDeviceToHost),
+                      hipSuccess);
+        });
+    }
+    for(auto& t : threads)
+        t.join();
+
+    for(const auto& output : outputs)
+        EXPECT_EQ(output, expected);
+}
+
+// Check that launching a plan through a graph gives the same results
+// as launching its kernels directly, as buffers and streams change
+TEST(rocfft_UnitTest, execute_graph)
+{
+    // several kernels that use a work buffer
+    const std::vector<size_t> lengths = {64, 64, 64};
+    const size_t              batch   = 2;
+    const size_t              count   = 64 * 64 * 64 * batch;
+    const size_t              bytes   = count * sizeof(std::complex<double>);
+
+    std::vector<std::complex<double>> input(count);
+    for(size_t i = 0; i < count; ++i)
+        input[i] = {std::sin(0.001 * i), std::cos(0.003 * i)};
+
+    rocfft_plan plan = nullptr;
+    ASSERT_EQ(rocfft_plan_create(&plan,
+                                 rocfft_placement_notinplace,
+                                 rocfft_transform_type_complex_forward,
+                                 rocfft_precision_double,
+                                 lengths.size(),
+                                 lengths.data(),
+                                 batch,
+                                 nullptr),
+              rocfft_status_success);
+    hipStream_t stream = nullptr;
+    ASSERT_EQ(hipStreamCreate(&stream), hipSuccess);
+    rocfft_execution_info info = nullptr;
     ASSERT_EQ(rocfft_execution_info_create(&info), rocfft_status_success);
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_execution_info_destroy(info);
+        (void)hipStreamDestroy(stream);
+        rocfft_plan_destroy(plan);
+    };
 
-    size_t alloc_work_size = sizer(requested_work_size);
-    gpubuf work_buffer;
-    if(alloc_work_size)
+    gpubuf in_device;
+    gpubuf out_device[2];
+    ASSERT_EQ(in_device.alloc(bytes), hipSuccess);
+    for(auto& out : out_device)
+        ASSERT_EQ(out.alloc(bytes), hipSuccess);
+
+    auto run = [&](gpubuf& out) {
+        // out-of-place transforms may overwrite their input
+        EXPECT_EQ(hipMemcpy(in_device.data(), input.data(), bytes, hipMemcpyHostToDevice),
+                  hipSuccess);
+        void* in_ptr  = in_device.data();
+        void* out_ptr = out.data();
+        EXPECT_EQ(rocfft_execute(plan, &in_ptr, &out_ptr, info), rocfft_status_success);
+        EXPECT_EQ(hipDeviceSynchronize(), hipSuccess);
+        std::vector<std::complex<double>> output(count);
+        EXPECT_EQ(hipMemcpy(output.data(), out.data(), bytes, hipMemcpyDeviceToHost), hipSuccess);
+        return output;
+    };
+
+    auto expected = run(out_device[0]);
+
+    ASSERT_EQ(rocfft_execution_info_set_launch_mode(info, rocfft_launch_mode_graph),
+              rocfft_status_success);
+    // record, replay, then record again for other buffers and
+    // another stream
+    EXPECT_EQ(run(out_device[0]), expected);
+    EXPECT_EQ(run(out_device[0]), expected);
+    EXPECT_EQ(run(out_device[1]), expected);
+    ASSERT_EQ(rocfft_execution_info_set_stream(info, stream), rocfft_status_success);
+    EXPECT_EQ(run(out_device[1]), expected);
+    EXPECT_EQ(run(out_device[0]), expected);
+
+    EXPECT_EQ(rocfft_execution_info_set_launch_mode(info, static_cast<rocfft_launch_mode>(-1)),
+              rocfft_status_invalid_arg_value);
+}
+
+// the check made before a plan's launches are recorded into a graph
+// rejects launches that don't match the plan
+TEST(rocfft_UnitTest, launch_sequence_check)
+{
+    typedef LaunchRecord<int> Launch;
+
+    // nodes only need distinct addresses
+    int                       nodes[3];
+    const std::vector<Launch> planned = {{&nodes[0], 1}, {&nodes[1], 2}, {&nodes[2], 3}};
+    EXPECT_NO_THROW(CheckLaunchSequence(planned, planned));
+
+    const std::vector<Launch> reordered = {planned[1], planned[0], planned[2]};
+    EXPECT_THROW(CheckLaunchSequence(planned, reordered), std::runtime_error);
+
+    auto wrongGrid    = planned;
+    wrongGrid[1].grid = 4;
+    EXPECT_THROW(CheckLaunchSequence(planned, wrongGrid), std::runtime_error);
+
+    auto missing = planned;
+    missing.pop_back();
+    EXPECT_THROW(CheckLaunchSequence(planned, missing), std::runtime_error);
+
+    auto extra = planned;
+    extra.push_back(planned[0]);
+    EXPECT_THROW(CheckLaunchSequence(planned, extra), std::runtime_error);
+}
+
+// Check that the plan cache returns usable plans, and evicts the
+// least-recently-used plan when full
+TEST(rocfft_UnitTest, plan_cache)
+{
+    static const char* TRACE_FILE = "plan_cache_trace.log";
+
+    BOOST_SCOPE_EXIT_ALL(=)
     {
-        ASSERT_EQ(work_buffer.alloc(alloc_work_size), hipSuccess);
+        rocfft_cleanup();
+        remove(TRACE_FILE);
+        rocfft_setup();
+    };
 
-        void*         work_buffer_ptr;
-        rocfft_status set_work_expected_status;
-        if(give_null_work_buf)
-        {
-            work_buffer_ptr          = nullptr;
-            set_work_expected_status = rocfft_status_invalid_work_buffer;
-        }
-        else
+    // cache capacity is read at setup time
+    rocfft_cleanup();
+    EnvironmentSetTemp cache_size("ROCFFT_PLAN_CACHE_SIZE", "2");
+    EnvironmentSetTemp layer("ROCFFT_LAYER", "1");
+    EnvironmentSetTemp tracepath("ROCFFT_LOG_TRACE_PATH", TRACE_FILE);
+    rocfft_setup();
+
+    auto create_plan = [](size_t length) {
+        rocfft_plan plan = nullptr;
+        EXPECT_EQ(rocfft_plan_create(&plan,
+                                     rocfft_placement_notinplace,
+                                     rocfft_transform_type_complex_forward,
+                                     rocfft_precision_single,
+                                     1,
+                                     &length,
+                                     1,
+                                     nullptr),
+                  rocfft_status_success);
+        return plan;
+    };
+
+    // fill the cache, then evict the first plan
+    for(size_t length : {64, 128, 256})
+        rocfft_plan_destroy(create_plan(length));
+    // miss, since 64 was evicted - this evicts 128
+    rocfft_plan_destroy(create_plan(64));
+
+    // hit - plan must still be usable after the original plan was
+    // destroyed
+    size_t      length = 256;
+    rocfft_plan plan   = create_plan(length);
+    ASSERT_NE(plan, nullptr);
+
+    std::vector<float> data_host(length * 2, 1.0f);
+    gpubuf             in_device;
+    gpubuf             out_device;
+    auto               data_size_bytes = data_host.size() * sizeof(float);
+    ASSERT_EQ(in_device.alloc(data_size_bytes), hipSuccess);
+    ASSERT_EQ(out_device.alloc(data_size_bytes), hipSuccess);
+    ASSERT_EQ(hipMemcpy(in_device.data(), data_host.data(), data_size_bytes, hipMemcpyHostToDevice),
+              hipSuccess);
+    void* ibuffers[] = {in_device.data()};
+    void* obuffers[] = {out_device.data()};
+    ASSERT_EQ(rocfft_execute(plan, ibuffers, obuffers, nullptr), rocfft_status_success);
+    ASSERT_EQ(hipMemcpy(data_host.data(), out_device.data(), data_size_bytes, hipMemcpyDeviceToHost),
+              hipSuccess);
+    // FFT of all ones is length at DC, 0 elsewhere
+    EXPECT_FLOAT_EQ(data_host[0], static_cast<float>(length));
+    EXPECT_FLOAT_EQ(data_host[2], 0.0f);
+    rocfft_plan_destroy(plan);
+
+    rocfft_cleanup();
+
+    // the last cache counters logged should reflect what we did
+    std::ifstream trace_log(TRACE_FILE);
+    std::string   line;
+    std::string   last_counters;
+    while(std::getline(trace_log, line))
+    {
+        if(line.compare(0, 11, "plan_cache,") == 0)
+            last_counters = line;
+    }
+    EXPECT_EQ(last_counters, "plan_cache,hit,hits,1,misses,4,evictions,2,size,2,capacity,2");
+}
+
+// Check that plans that came from the same cache entry can be
+// executed at once from several threads, with different buffers
+TEST(rocfft_UnitTest, plan_cache_concurrent_execute)
+{
+    static const int NUM_THREADS          = 4;
+    static const int NUM_ITERS_PER_THREAD = 20;
+
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_cleanup();
+        rocfft_setup();
+    };
+    rocfft_cleanup();
+    EnvironmentSetTemp cache_size("ROCFFT_PLAN_CACHE_SIZE", "1");
+    rocfft_setup();
+
+    // decomposed into several kernels that use a work buffer
+    const size_t length = 1 << 20;
+    const size_t bytes  = length * sizeof(std::complex<float>);
+
+    std::vector<std::complex<float>> input(length);
+    for(size_t i = 0; i < length; ++i)
+        input[i] = {std::sin(0.001f * i), std::cos(0.003f * i)};
+
+    // create a plan (copied from the cache after the first one), and
+    // execute it on its own buffers
+    auto run = [&](int iters) {
+        std::vector<std::complex<float>> output(length);
+        rocfft_plan                      plan = nullptr;
+        EXPECT_EQ(rocfft_plan_create(&plan,
+                                     rocfft_placement_notinplace,
+                                     rocfft_transform_type_complex_forward,
+                                     rocfft_precision_single,
+                                     1,
+                                     &length,
+                                     1,
+                                     nullptr),
+                  rocfft_status_success);
+        gpubuf in_device;
+        gpubuf out_device;
+        EXPECT_EQ(in_device.alloc(bytes), hipSuccess);
+        EXPECT_EQ(out_device.alloc(bytes), hipSuccess);
+        for(int j = 0; j < iters; ++j)
         {
-            work_buffer_ptr          = work_buffer.data();
-            set_work_expected_status = rocfft_status_success;
+            // out-of-place transforms may overwrite their input
+            EXPECT_EQ(hipMemcpy(in_device.data(), input.data(), bytes, hipMemcpyHostToDevice),
+                      hipSuccess);
+            void* in_ptr  = in_device.data();
+            void* out_ptr = out_device.data();
+            EXPECT_EQ(rocfft_execute(plan, &in_ptr, &out_ptr, nullptr), rocfft_status_success);
         }
-        ASSERT_EQ(rocfft_execution_info_set_work_buffer(info, work_buffer_ptr, alloc_work_size),
-                  set_work_expected_status);
+        EXPECT_EQ(hipMemcpy(output.data(), out_device.data(), bytes, hipMemcpyDeviceToHost),
+                  hipSuccess);
+        rocfft_plan_destroy(plan);
+        return output;
+    };
+
+    // the first plan fills the cache
+    auto expected = run(1);
+
+    std::vector<std::vector<std::complex<float>>> outputs(NUM_THREADS);
+    std::vector<std::thread>                      threads;
+    threads.reserve(NUM_THREADS);
+    for(int i = 0; i < NUM_THREADS; ++i)
+        threads.emplace_back([&, i]() { outputs[i] = run(NUM_ITERS_PER_THREAD); });
+    for(auto& t : threads)
+        t.join();
+
+    for(const auto& output : outputs)
+        EXPECT_EQ(output, expected);
+}
+
+TEST(rocfft_UnitTest, plan_serialize)
+{
+    // Prime size requires Bluestein, which gives a tree with several
+    // levels and a work buffer.
+    size_t      length = 8191;
+    rocfft_plan plan   = nullptr;
+    ASSERT_EQ(rocfft_plan_create(&plan,
+                                 rocfft_placement_notinplace,
+                                 rocfft_transform_type_complex_forward,
+                                 rocfft_precision_double,
+                                 1,
+                                 &length,
+                                 1,
+                                 nullptr),
+              rocfft_status_success);
+
+    void*  buffer     = nullptr;
+    size_t buffer_len = 0;
+    ASSERT_EQ(rocfft_plan_serialize(plan, &buffer, &buffer_len), rocfft_status_success);
+    std::vector<char> serialized(static_cast<char*>(buffer), static_cast<char*>(buffer) + buffer_len);
+    ASSERT_EQ(rocfft_plan_buffer_free(buffer), rocfft_status_success);
+
+    rocfft_plan loaded_plan = nullptr;
+    ASSERT_EQ(rocfft_plan_deserialize(&loaded_plan, serialized.data(), serialized.size()),
+              rocfft_status_success);
+    ASSERT_NE(loaded_plan, nullptr);
+
+    size_t work_size        = 0;
+    size_t loaded_work_size = 0;
+    ASSERT_EQ(rocfft_plan_get_work_buffer_size(plan, &work_size), rocfft_status_success);
+    ASSERT_EQ(rocfft_plan_get_work_buffer_size(loaded_plan, &loaded_work_size),
+              rocfft_status_success);
+    EXPECT_EQ(work_size, loaded_work_size);
+
+    // both plans must produce identical output
+    std::vector<std::complex<double>> input(length);
+    for(size_t i = 0; i < length; ++i)
+        input[i] = std::complex<double>(i % 7, i % 11);
+    auto   data_size_bytes = input.size() * sizeof(std::complex<double>);
+    gpubuf in_device;
+    gpubuf out_device;
+    ASSERT_EQ(in_device.alloc(data_size_bytes), hipSuccess);
+    ASSERT_EQ(out_device.alloc(data_size_bytes), hipSuccess);
+    void* ibuffers[] = {in_device.data()};
+    void* obuffers[] = {out_device.data()};
+
+    std::vector<std::complex<double>> output(length);
+    std::vector<std::complex<double>> loaded_output(length);
+    for(auto p : {std::make_pair(plan, &output), std::make_pair(loaded_plan, &loaded_output)})
+    {
+        ASSERT_EQ(hipMemcpy(in_device.data(), input.data(), data_size_bytes, hipMemcpyHostToDevice),
+                  hipSuccess);
+        ASSERT_EQ(rocfft_execute(p.first, ibuffers, obuffers, nullptr), rocfft_status_success);
+        ASSERT_EQ(
+            hipMemcpy(p.second->data(), out_device.data(), data_size_bytes, hipMemcpyDeviceToHost),
+            hipSuccess);
     }
+    EXPECT_EQ(output, loaded_output);
 
-    // allocate 2x length for complex
-    std::vector<float> data_host(length * 2, 1.0f);
-    gpubuf             data_device;
-    auto               data_size_bytes = data_host.size() * sizeof(float);
+    rocfft_plan_destroy(loaded_plan);
+    rocfft_plan_destroy(plan);
 
-    ASSERT_EQ(data_device.alloc(data_size_bytes), hipSuccess);
-    ASSERT_EQ(
-        hipMemcpy(data_device.data(), data_host.data(), data_size_bytes, hipMemcpyHostToDevice),
-        hipSuccess);
-    std::vector<void*> ibuffers(1, static_cast<void*>(data_device.data()));
+    // damaged buffers must be rejected without creating a plan
+    auto bad_magic = serialized;
+    bad_magic[0]   = 'x';
+    loaded_plan    = nullptr;
+    EXPECT_EQ(rocfft_plan_deserialize(&loaded_plan, bad_magic.data(), bad_magic.size()),
+              rocfft_status_failure);
+    EXPECT_EQ(loaded_plan, nullptr);
+
+    // format version follows the 8-byte magic
+    auto bad_version = serialized;
+    bad_version[8] ^= 0xff;
+    EXPECT_EQ(rocfft_plan_deserialize(&loaded_plan, bad_version.data(), bad_version.size()),
+              rocfft_status_failure);
+    EXPECT_EQ(loaded_plan, nullptr);
+
+    EXPECT_EQ(rocfft_plan_deserialize(&loaded_plan, serialized.data(), serialized.size() / 2),
+              rocfft_status_failure);
+    EXPECT_EQ(loaded_plan, nullptr);
+
+    // plan parameters start with the rank, then lengths padded with
+    // 1s, batch and placement
+    std::vector<size_t> params(16, 1);
+    params[1]              = length;
+    const auto params_data = reinterpret_cast<const char*>(params.data());
+    auto       params_pos  = std::search(serialized.begin(),
+                                         serialized.end(),
+                                         params_data,
+                                         params_data + params.size() * sizeof(size_t));
+    ASSERT_NE(params_pos, serialized.end());
+    const size_t rank_offset      = params_pos - serialized.begin();
+    const size_t placement_offset = rank_offset + params.size() * sizeof(size_t);
+
+    auto bad_rank = serialized;
+    std::fill_n(bad_rank.begin() + rank_offset, sizeof(size_t), 0xff);
+    EXPECT_EQ(rocfft_plan_deserialize(&loaded_plan, bad_rank.data(), bad_rank.size()),
+              rocfft_status_failure);
+    EXPECT_EQ(loaded_plan, nullptr);
+
+    auto bad_enum = serialized;
+    bad_enum[placement_offset] = 0x7f;
+    EXPECT_EQ(rocfft_plan_deserialize(&loaded_plan, bad_enum.data(), bad_enum.size()),
+              rocfft_status_failure);
+    EXPECT_EQ(loaded_plan, nullptr);
+}
 
-    ASSERT_EQ(rocfft_execute(plan, ibuffers.data(), nullptr, info), exec_status_expected);
+static std::vector<std::string> plan_kernel_names(rocfft_plan plan)
+{
+    std::vector<std::string> names;
+    size_t                   count = 0;
+    if(rocfft_plan_get_kernel_count(plan, &count) != rocfft_status_success)
+        return names;
+    for(size_t i = 0; i < count; ++i)
+    {
+        const char* name = nullptr;
+        if(rocfft_plan_get_kernel_name(plan, i, &name) != rocfft_status_success)
+            return {};
+        names.push_back(name);
+    }
+    return names;
+}
+
+TEST(rocfft_UnitTest, plan_target_device)
+{
+    rocfft_plan_description desc = nullptr;
+    ASSERT_EQ(rocfft_plan_description_create(&desc), rocfft_status_success);
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_plan_description_destroy(desc);
+    };
+
+    ASSERT_EQ(rocfft_plan_description_set_target_device(desc, nullptr, 0, 0),
+              rocfft_status_invalid_arg_value);
+
+    // plan for the current device's architecture, but without using
+    // the device
+    int             deviceId = 0;
+    hipDeviceProp_t prop;
+    ASSERT_EQ(hipGetDevice(&deviceId), hipSuccess);
+    ASSERT_EQ(hipGetDeviceProperties(&prop, deviceId), hipSuccess);
+    ASSERT_EQ(rocfft_plan_description_set_target_device(
+                  desc, prop.gcnArchName, prop.sharedMemPerBlock, prop.multiProcessorCount),
+              rocfft_status_success);
+
+    // Bluestein gives a plan with several kernels and a work buffer
+    size_t      length       = 8191;
+    rocfft_plan offline_plan = nullptr;
+    ASSERT_EQ(rocfft_plan_create(&offline_plan,
+                                 rocfft_placement_notinplace,
+                                 rocfft_transform_type_complex_forward,
+                                 rocfft_precision_double,
+                                 1,
+                                 &length,
+                                 1,
+                                 desc),
+              rocfft_status_success);
+
+    rocfft_plan device_plan = nullptr;
+    ASSERT_EQ(rocfft_plan_create(&device_plan,
+                                 rocfft_placement_notinplace,
+                                 rocfft_transform_type_complex_forward,
+                                 rocfft_precision_double,
+                                 1,
+                                 &length,
+                                 1,
+                                 nullptr),
+              rocfft_status_success);
+
+    // both plans must make the same decisions
+    size_t offline_work_size = 0;
+    size_t device_work_size  = 0;
+    ASSERT_EQ(rocfft_plan_get_work_buffer_size(offline_plan, &offline_work_size),
+              rocfft_status_success);
+    ASSERT_EQ(rocfft_plan_get_work_buffer_size(device_plan, &device_work_size),
+              rocfft_status_success);
+    EXPECT_GT(offline_work_size, 0u);
+    EXPECT_EQ(offline_work_size, device_work_size);
+
+    auto offline_names = plan_kernel_names(offline_plan);
+    EXPECT_GT(offline_names.size(), 1u);
+    EXPECT_EQ(offline_names, plan_kernel_names(device_plan));
+    for(const auto& name : offline_names)
+        EXPECT_FALSE(name.empty());
+
+    const char* name = nullptr;
+    EXPECT_EQ(rocfft_plan_get_kernel_name(offline_plan, offline_names.size(), &name),
+              rocfft_status_invalid_arg_value);
+
+    // the offline plan can't run, but can be loaded on the device
+    EXPECT_EQ(rocfft_execute(offline_plan, nullptr, nullptr, nullptr), rocfft_status_failure);
+
+    void*  buffer     = nullptr;
+    size_t buffer_len = 0;
+    ASSERT_EQ(rocfft_plan_serialize(offline_plan, &buffer, &buffer_len), rocfft_status_success);
+    rocfft_plan loaded_plan = nullptr;
+    EXPECT_EQ(rocfft_plan_deserialize(&loaded_plan, buffer, buffer_len), rocfft_status_success);
+    ASSERT_EQ(rocfft_plan_buffer_free(buffer), rocfft_status_success);
+    EXPECT_EQ(plan_kernel_names(loaded_plan), offline_names);
+
+    rocfft_plan_destroy(loaded_plan);
+    rocfft_plan_destroy(device_plan);
+    rocfft_plan_destroy(offline_plan);
+}
+
+// Pruning the buffer assignment search must not change the chosen
+// assignment.  Build device-free plans with and without
+// ROCFFT_ASSIGN_BUFFERS_EXHAUSTIVE and compare them.  Serialized
+// plans record every node's scheme and buffers after fusion.
+TEST(rocfft_UnitTest, assign_buffers_exhaustive)
+{
+    struct problem_t
+    {
+        rocfft_transform_type   type;
+        rocfft_result_placement placement;
+        std::vector<size_t>     lengths;
+        size_t                  batch;
+    };
+    const std::vector<problem_t> problems = {
+        // 3D real-even, with Bluestein for the fastest dimension's
+        // half length, or for the slowest dimension
+        {rocfft_transform_type_real_forward, rocfft_placement_notinplace, {2018, 16, 16}, 1},
+        {rocfft_transform_type_real_inverse, rocfft_placement_notinplace, {2018, 16, 16}, 1},
+        {rocfft_transform_type_real_forward, rocfft_placement_inplace, {64, 64, 1009}, 1},
+        // 2D and 3D C2C
+        {rocfft_transform_type_complex_forward, rocfft_placement_notinplace, {256, 256}, 1},
+        {rocfft_transform_type_complex_forward, rocfft_placement_inplace, {1024, 1024}, 1},
+        {rocfft_transform_type_complex_inverse, rocfft_placement_notinplace, {4096, 4096}, 1},
+        {rocfft_transform_type_complex_forward, rocfft_placement_notinplace, {64, 64, 64}, 1},
+        {rocfft_transform_type_complex_forward, rocfft_placement_inplace, {200, 128, 256}, 2},
+        {rocfft_transform_type_complex_inverse, rocfft_placement_notinplace, {336, 336, 56}, 1},
+    };
+
+    // serialize a device-free plan for the problem, and list its kernels
+    auto build = [](const problem_t& problem) {
+        rocfft_plan_description desc = nullptr;
+        EXPECT_EQ(rocfft_plan_description_create(&desc), rocfft_status_success);
+        EXPECT_EQ(rocfft_plan_description_set_target_device(desc, "gfx908:sramecc+:xnack-", 0, 0),
+                  rocfft_status_success);
+        // real transforms need their array types given explicitly
+        if(problem.type == rocfft_transform_type_real_forward
+           || problem.type == rocfft_transform_type_real_inverse)
+        {
+            bool forward = problem.type == rocfft_transform_type_real_forward;
+            auto real    = rocfft_array_type_real;
+            auto herm    = rocfft_array_type_hermitian_interleaved;
+            EXPECT_EQ(rocfft_plan_description_set_data_layout(desc,
+                                                              forward ? real : herm,
+                                                              forward ? herm : real,
+                                                              nullptr,
+                                                              nullptr,
+                                                              0,
+                                                              nullptr,
+                                                              0,
+                                                              0,
+                                                              nullptr,
+                                                              0),
+                      rocfft_status_success);
+        }
+
+        rocfft_plan plan = nullptr;
+        EXPECT_EQ(rocfft_plan_create(&plan,
+                                     problem.placement,
+                                     problem.type,
+                                     rocfft_precision_single,
+                                     problem.lengths.size(),
+                                     problem.lengths.data(),
+                                     problem.batch,
+                                     desc),
+                  rocfft_status_success);
+
+        std::vector<char> serialized;
+        void*             buffer     = nullptr;
+        size_t            buffer_len = 0;
+        if(rocfft_plan_serialize(plan, &buffer, &buffer_len) == rocfft_status_success)
+        {
+            serialized.assign(static_cast<char*>(buffer), static_cast<char*>(buffer) + buffer_len);
+            rocfft_plan_buffer_free(buffer);
+        }
+        auto names = plan_kernel_names(plan);
+
+        rocfft_plan_destroy(plan);
+        rocfft_plan_description_destroy(desc);
+        return std::make_pair(serialized, names);
+    };
+
+    for(size_t i = 0; i < problems.size(); ++i)
+    {
+        auto               pruned = build(problems[i]);
+        EnvironmentSetTemp exhaustive_env("ROCFFT_ASSIGN_BUFFERS_EXHAUSTIVE", "1");
+        auto               exhaustive = build(problems[i]);
+
+        ASSERT_FALSE(pruned.first.empty()) << "problem " << i;
+        EXPECT_EQ(pruned.first, exhaustive.first) << "problem " << i;
+        EXPECT_EQ(pruned.second, exhaustive.second) << "problem " << i;
+    }
+}
+
+TEST(rocfft_UnitTest, scheme_table_arch_tunings)
+{
+    // kernels of a 1D double-precision plan for an architecture
+    auto arch_kernel_names = [](const char* arch, size_t length) {
+        std::vector<std::string> names;
+        rocfft_plan_description  desc = nullptr;
+        EXPECT_EQ(rocfft_plan_description_create(&desc), rocfft_status_success);
+        EXPECT_EQ(rocfft_plan_description_set_target_device(desc, arch, 0, 0),
+                  rocfft_status_success);
+        rocfft_plan plan = nullptr;
+        EXPECT_EQ(rocfft_plan_create(&plan,
+                                     rocfft_placement_notinplace,
+                                     rocfft_transform_type_complex_forward,
+                                     rocfft_precision_double,
+                                     1,
+                                     &length,
+                                     1,
+                                     desc),
+                  rocfft_status_success);
+        names = plan_kernel_names(plan);
+        rocfft_plan_destroy(plan);
+        rocfft_plan_description_destroy(desc);
+        return names;
+    };
+
+    // the built-in table decomposes these lengths differently on
+    // some architectures
+    auto gfx906_262144 = arch_kernel_names("gfx906:sramecc+:xnack-", 262144);
+    auto gfx908_262144 = arch_kernel_names("gfx908:sramecc+:xnack-", 262144);
+    EXPECT_FALSE(gfx906_262144.empty());
+    EXPECT_FALSE(gfx908_262144.empty());
+    EXPECT_NE(gfx906_262144, gfx908_262144);
+
+    auto gfx90a_43008 = arch_kernel_names("gfx90a:sramecc+:xnack-", 43008);
+    auto gfx908_43008 = arch_kernel_names("gfx908:sramecc+:xnack-", 43008);
+    EXPECT_FALSE(gfx90a_43008.empty());
+    EXPECT_FALSE(gfx908_43008.empty());
+    EXPECT_NE(gfx90a_43008, gfx908_43008);
+}
+
+TEST(rocfft_UnitTest, plan_tune_device_free)
+{
+    const std::string table_path = std::tmpnam(nullptr);
+
+    rocfft_plan_description desc = nullptr;
+    ASSERT_EQ(rocfft_plan_description_create(&desc), rocfft_status_success);
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_plan_description_destroy(desc);
+        remove(table_path.c_str());
+        // forget the tuning, so later tests get the built-in table
+        rocfft_cleanup();
+        rocfft_setup();
+    };
+    ASSERT_EQ(rocfft_plan_description_set_target_device(desc, "gfx908:sramecc+:xnack-", 0, 0),
+              rocfft_status_success);
+
+    // only complex transforms can be tuned
+    size_t length = 20000;
+    EXPECT_EQ(rocfft_plan_tune(table_path.c_str(),
+                               rocfft_placement_notinplace,
+                               rocfft_transform_type_real_forward,
+                               rocfft_precision_single,
+                               1,
+                               &length,
+                               1,
+                               nullptr),
+              rocfft_status_invalid_arg_value);
+
+    auto kernel_names = [&]() {
+        rocfft_plan plan = nullptr;
+        EXPECT_EQ(rocfft_plan_create(&plan,
+                                     rocfft_placement_notinplace,
+                                     rocfft_transform_type_complex_forward,
+                                     rocfft_precision_single,
+                                     1,
+                                     &length,
+                                     1,
+                                     desc),
+                  rocfft_status_success);
+        auto names = plan_kernel_names(plan);
+        rocfft_plan_destroy(plan);
+        return names;
+    };
+    const auto untuned = kernel_names();
+    EXPECT_FALSE(untuned.empty());
+
+    // a length with several decompositions is tuned with the cost
+    // model, and the winner is written to the table file
+    ASSERT_EQ(rocfft_plan_tune(table_path.c_str(),
+                               rocfft_placement_notinplace,
+                               rocfft_transform_type_complex_forward,
+                               rocfft_precision_single,
+                               1,
+                               &length,
+                               1,
+                               desc),
+              rocfft_status_success);
+
+    std::ifstream table(table_path);
+    std::string   line;
+    ASSERT_TRUE(std::getline(table, line));
+    EXPECT_EQ(line, "rocfft_scheme_table 1");
+
+    // arch precision lengths scheme factor [disabled fusions]
+    std::vector<std::vector<std::string>> entries;
+    while(std::getline(table, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream       ls(line);
+        std::vector<std::string> fields;
+        std::string              field;
+        while(ls >> field)
+            fields.push_back(field);
+        if(!fields.empty())
+            entries.push_back(fields);
+    }
+    ASSERT_EQ(entries.size(), 1u);
+    ASSERT_GE(entries[0].size(), 5u);
+    EXPECT_EQ(entries[0][0], "gfx908");
+    EXPECT_EQ(entries[0][1], "single");
+    EXPECT_EQ(entries[0][2], std::to_string(length));
+
+    // plans for the problem now use the recorded decomposition
+    const auto tuned = kernel_names();
+    EXPECT_FALSE(tuned.empty());
+    EXPECT_NE(tuned, untuned);
+
+    // until the library is cleaned up
+    rocfft_cleanup();
+    rocfft_setup();
+    EXPECT_EQ(kernel_names(), untuned);
+}
+
+TEST(rocfft_UnitTest, plan_estimate_device_free)
+{
+    rocfft_plan_description desc = nullptr;
+    ASSERT_EQ(rocfft_plan_description_create(&desc), rocfft_status_success);
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_plan_description_destroy(desc);
+    };
+    ASSERT_EQ(rocfft_plan_description_set_target_device(desc, "gfx90a:sramecc+:xnack-", 0, 0),
+              rocfft_status_success);
+
+    auto estimated_time = [&](rocfft_precision precision, size_t batch) {
+        size_t      length = 8192;
+        rocfft_plan plan   = nullptr;
+        EXPECT_EQ(rocfft_plan_create(&plan,
+                                     rocfft_placement_notinplace,
+                                     rocfft_transform_type_complex_forward,
+                                     precision,
+                                     1,
+                                     &length,
+                                     batch,
+                                     desc),
+                  rocfft_status_success);
+
+        size_t kernel_count = 0;
+        EXPECT_EQ(rocfft_plan_get_kernel_count(plan, &kernel_count), rocfft_status_success);
+        EXPECT_GT(kernel_count, 0u);
+
+        // every kernel moves data and takes time, and the plan's
+        // time is the sum of its kernels' times
+        double kernel_total = 0.0;
+        for(size_t i = 0; i < kernel_count; ++i)
+        {
+            rocfft_kernel_estimate estimate;
+            EXPECT_EQ(rocfft_plan_get_kernel_estimate(plan, i, &estimate), rocfft_status_success);
+            EXPECT_GT(estimate.bytes_read + estimate.bytes_written, 0u);
+            EXPECT_GT(estimate.occupancy, 0.0);
+            EXPECT_LE(estimate.occupancy, 1.0);
+            EXPECT_GT(estimate.time_us, 0.0);
+            kernel_total += estimate.time_us;
+        }
+        rocfft_kernel_estimate estimate;
+        EXPECT_EQ(rocfft_plan_get_kernel_estimate(plan, kernel_count, &estimate),
+                  rocfft_status_invalid_arg_value);
+        EXPECT_EQ(rocfft_plan_get_kernel_estimate(plan, 0, nullptr),
+                  rocfft_status_invalid_arg_value);
+
+        double time_us = 0.0;
+        EXPECT_EQ(rocfft_plan_get_estimated_time(plan, &time_us), rocfft_status_success);
+        EXPECT_NEAR(time_us, kernel_total, kernel_total * 1e-9);
+        EXPECT_EQ(rocfft_plan_get_estimated_time(plan, nullptr), rocfft_status_invalid_arg_value);
+
+        rocfft_plan_destroy(plan);
+        return time_us;
+    };
+
+    // more data takes longer
+    EXPECT_GT(estimated_time(rocfft_precision_single, 1000),
+              estimated_time(rocfft_precision_single, 1));
+    EXPECT_GT(estimated_time(rocfft_precision_double, 1000),
+              estimated_time(rocfft_precision_single, 1000));
+}
+
+TEST(rocfft_UnitTest, bluestein_length_choice)
+{
+    static const char* PLAN_FILE = "bluestein_length_choice_plan.log";
+
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_cleanup();
+        remove(PLAN_FILE);
+        rocfft_setup();
+    };
+
+    rocfft_cleanup();
+    EnvironmentSetTemp layer("ROCFFT_LAYER", "8");
+    EnvironmentSetTemp planpath("ROCFFT_LOG_PLAN_PATH", PLAN_FILE);
+    rocfft_setup();
+
+    rocfft_plan_description desc = nullptr;
+    ASSERT_EQ(rocfft_plan_description_create(&desc), rocfft_status_success);
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_plan_description_destroy(desc);
+    };
+    ASSERT_EQ(rocfft_plan_description_set_target_device(desc, "gfx908:sramecc+:xnack-", 0, 0),
+              rocfft_status_success);
+
+    // primes small enough for single-kernel convolutions and large
+    // enough to need decomposed ones all get a plan with at least
+    // the multiplies and the two convolution FFTs
+    for(size_t length : {97, 1201, 8191, 65521, 1000003})
+    {
+        for(auto precision : {rocfft_precision_single, rocfft_precision_double})
+        {
+            rocfft_plan plan = nullptr;
+            ASSERT_EQ(rocfft_plan_create(&plan,
+                                         rocfft_placement_notinplace,
+                                         rocfft_transform_type_complex_forward,
+                                         precision,
+                                         1,
+                                         &length,
+                                         1,
+                                         desc),
+                      rocfft_status_success)
+                << "length " << length;
+
+            auto names = plan_kernel_names(plan);
+            EXPECT_GE(names.size(), 5u) << "length " << length;
+
+            double time_us = 0.0;
+            EXPECT_EQ(rocfft_plan_get_estimated_time(plan, &time_us), rocfft_status_success);
+            EXPECT_GT(time_us, 0.0);
+            rocfft_plan_destroy(plan);
+        }
+    }
+    rocfft_cleanup();
+
+    // the plan log has the estimate for each candidate convolution
+    // length, and the length that was chosen
+    std::ifstream plan_log(PLAN_FILE);
+    std::string   line;
+    std::regex    choice("^Bluestein length ([0-9]+) convolution estimates:(.*), chosen ([0-9]+)$");
+    std::regex    estimate(" ([0-9]+)=([0-9.e+-]+)us");
+    std::smatch   match;
+    size_t        choices    = 0;
+    bool          chose_npo2 = false;
+    while(std::getline(plan_log, line))
+    {
+        if(!std::regex_match(line, match, choice))
+            continue;
+        ++choices;
+        const size_t      length = std::stoull(match[1]);
+        const size_t      chosen = std::stoull(match[3]);
+        const std::string fields = match[2];
+
+        std::map<size_t, double> estimates;
+        for(std::sregex_iterator field(fields.begin(), fields.end(), estimate), end;
+            field != end;
+            ++field)
+            estimates[std::stoull((*field)[1])] = std::stod((*field)[2]);
+        ASSERT_EQ(estimates.count(chosen), 1u) << "length " << length;
+        EXPECT_GE(chosen, 2 * length - 1);
+
+        // the chosen length is estimated to be the fastest
+        for(const auto& e : estimates)
+            EXPECT_LE(estimates[chosen], e.second)
+                << "length " << length << " chose " << chosen << " over " << e.first;
+
+        if((chosen & (chosen - 1)) != 0)
+            chose_npo2 = true;
+    }
+    EXPECT_GE(choices, 10u);
+    // the power of two is a candidate, but isn't always the fastest
+    EXPECT_TRUE(chose_npo2);
+}
+
+TEST(rocfft_UnitTest, bluestein_work_buffer)
+{
+    rocfft_plan_description desc = nullptr;
+    ASSERT_EQ(rocfft_plan_description_create(&desc), rocfft_status_success);
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_plan_description_destroy(desc);
+    };
+    ASSERT_EQ(rocfft_plan_description_set_target_device(desc, "gfx908:sramecc+:xnack-", 0, 0),
+              rocfft_status_success);
+
+    // the chirp comes from the repo, so the work buffer only holds
+    // the padded data and grows in proportion to the batch
+    size_t length = 97;
+    size_t work_size[2];
+    for(size_t batch : {1, 2})
+    {
+        rocfft_plan plan = nullptr;
+        ASSERT_EQ(rocfft_plan_create(&plan,
+                                     rocfft_placement_notinplace,
+                                     rocfft_transform_type_complex_forward,
+                                     rocfft_precision_single,
+                                     1,
+                                     &length,
+                                     batch,
+                                     desc),
+                  rocfft_status_success);
+        BOOST_SCOPE_EXIT_ALL(=)
+        {
+            rocfft_plan_destroy(plan);
+        };
+
+        // pad-mul, FFT, fft-mul, inverse FFT, res-mul
+        EXPECT_EQ(plan_kernel_names(plan).size(), 5u);
+        ASSERT_EQ(rocfft_plan_get_work_buffer_size(plan, &work_size[batch - 1]),
+                  rocfft_status_success);
+    }
+    EXPECT_GT(work_size[0], 0u);
+    EXPECT_EQ(work_size[1], 2 * work_size[0]);
+}
+
+// temp regions of the work buffer that are never live at the same
+// time share memory, so plans with several regions need less than
+// the regions' summed size
+TEST(rocfft_UnitTest, work_buffer_packing)
+{
+    static const char* PLAN_FILE = "work_buffer_packing_plan.log";
+
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_cleanup();
+        remove(PLAN_FILE);
+        rocfft_setup();
+    };
+
+    rocfft_cleanup();
+    EnvironmentSetTemp layer("ROCFFT_LAYER", "8");
+    EnvironmentSetTemp planpath("ROCFFT_LOG_PLAN_PATH", PLAN_FILE);
+    rocfft_setup();
+
+    // odd real lengths go through the complex-for-real copy, and the
+    // prime length needs Bluestein.  multi-dimensional plans also
+    // transpose through the temp region.
+    struct problem_t
+    {
+        rocfft_transform_type type;
+        std::vector<size_t>   lengths;
+    };
+    const std::vector<problem_t> problems = {
+        {rocfft_transform_type_real_forward, {1009}},
+        {rocfft_transform_type_real_forward, {1009, 512}},
+        {rocfft_transform_type_real_forward, {1009, 64, 64}},
+        {rocfft_transform_type_complex_forward, {1009, 4096}},
+        {rocfft_transform_type_complex_forward, {1009, 64, 64}},
+    };
+
+    // work buffer size in bytes, for each problem
+    std::vector<size_t> work_bytes;
+    for(const auto& problem : problems)
+    {
+        rocfft_plan plan = nullptr;
+        ASSERT_EQ(rocfft_plan_create(&plan,
+                                     rocfft_placement_notinplace,
+                                     problem.type,
+                                     rocfft_precision_double,
+                                     problem.lengths.size(),
+                                     problem.lengths.data(),
+                                     1,
+                                     nullptr),
+                  rocfft_status_success);
+        BOOST_SCOPE_EXIT_ALL(&)
+        {
+            rocfft_plan_destroy(plan);
+        };
+        work_bytes.emplace_back();
+        ASSERT_EQ(rocfft_plan_get_work_buffer_size(plan, &work_bytes.back()),
+                  rocfft_status_success);
+
+        // the plan is logged when it's executed.  the buffers are
+        // large enough to hold the problem as complex data.
+        const size_t bytes = std::accumulate(problem.lengths.begin(),
+                                             problem.lengths.end(),
+                                             sizeof(std::complex<double>),
+                                             std::multiplies<size_t>());
+        gpubuf in_device;
+        gpubuf out_device;
+        ASSERT_EQ(in_device.alloc(bytes), hipSuccess);
+        ASSERT_EQ(out_device.alloc(bytes), hipSuccess);
+        ASSERT_EQ(hipMemset(in_device.data(), 0, bytes), hipSuccess);
+        void* in_ptr  = in_device.data();
+        void* out_ptr = out_device.data();
+        ASSERT_EQ(rocfft_execute(plan, &in_ptr, &out_ptr, nullptr), rocfft_status_success);
+        ASSERT_EQ(hipDeviceSynchronize(), hipSuccess);
+    }
+
+    rocfft_cleanup();
+
+    // regions of each plan, by name, in complex elements
+    struct region_t
+    {
+        size_t size   = 0;
+        size_t offset = 0;
+        bool   live   = false;
+        size_t first  = 0;
+        size_t last   = 0;
+    };
+    std::vector<size_t>                          work_sizes;
+    std::vector<std::map<std::string, region_t>> plan_regions;
+
+    std::ifstream plan_log(PLAN_FILE);
+    std::string   line;
+    std::regex    size_line("^Work buffer size: ([0-9]+)$");
+    std::regex    regions_line("^Work buffer regions:(.*)$");
+    std::regex    region_field(" ([a-z-]+) ([0-9]+)@([0-9]+)( kernels ([0-9]+)-([0-9]+))?");
+    std::smatch   match;
+    while(std::getline(plan_log, line))
+    {
+        if(std::regex_match(line, match, size_line))
+        {
+            work_sizes.push_back(std::stoull(match[1]));
+            plan_regions.emplace_back();
+        }
+        else if(std::regex_match(line, match, regions_line) && !plan_regions.empty())
+        {
+            const std::string fields = match[1];
+            for(std::sregex_iterator field(fields.begin(), fields.end(), region_field), end;
+                field != end;
+                ++field)
+            {
+                region_t r;
+                r.size   = std::stoull((*field)[2]);
+                r.offset = std::stoull((*field)[3]);
+                r.live   = (*field)[4].matched;
+                if(r.live)
+                {
+                    r.first = std::stoull((*field)[5]);
+                    r.last  = std::stoull((*field)[6]);
+                }
+                plan_regions.back()[(*field)[1]] = r;
+            }
+        }
+    }
+    ASSERT_EQ(work_sizes.size(), problems.size());
+
+    bool all_regions = false;
+    bool shrunk      = false;
+    for(size_t i = 0; i < problems.size(); ++i)
+    {
+        EXPECT_EQ(work_bytes[i], work_sizes[i] * sizeof(std::complex<double>));
+
+        // regions that are live together must not overlap, and the
+        // buffer has to hold all of them
+        size_t summed = 0;
+        size_t used   = 0;
+        for(const auto& a : plan_regions[i])
+        {
+            if(!a.second.live || !a.second.size)
+                continue;
+            summed += a.second.size;
+            ++used;
+            EXPECT_LE(a.second.offset + a.second.size, work_sizes[i]);
+            for(const auto& b : plan_regions[i])
+            {
+                if(a.first >= b.first || !b.second.live || !b.second.size)
+                    continue;
+                bool live_together
+                    = a.second.first <= b.second.last && b.second.first <= a.second.last;
+                bool overlap = a.second.offset < b.second.offset + b.second.size
+                               && b.second.offset < a.second.offset + a.second.size;
+                EXPECT_FALSE(live_together && overlap)
+                    << a.first << " and " << b.first << " overlap in problem " << i;
+            }
+        }
+        EXPECT_LE(work_sizes[i], summed);
+        if(used == 3)
+            all_regions = true;
+        if(used > 1 && work_sizes[i] < summed)
+            shrunk = true;
+    }
+    // at least one plan needs temp, copy and Bluestein regions, and
+    // at least one plan shares memory between its regions
+    EXPECT_TRUE(all_regions);
+    EXPECT_TRUE(shrunk);
+}
+
+TEST(rocfft_UnitTest, plan_optimize_strategy)
+{
+    rocfft_plan_description desc = nullptr;
+    ASSERT_EQ(rocfft_plan_description_create(&desc), rocfft_status_success);
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_plan_description_destroy(desc);
+    };
+
+    EXPECT_EQ(rocfft_plan_description_set_optimize_strategy(nullptr, rocfft_optimize_balance),
+              rocfft_status_invalid_arg_value);
+    EXPECT_EQ(rocfft_plan_description_set_optimize_strategy(
+                  desc, static_cast<rocfft_optimize_strategy>(-1)),
+              rocfft_status_invalid_arg_value);
+
+    // multi-dimensional real transforms have fusions that need
+    // extra temp buffers
+    struct result_t
+    {
+        size_t work_size   = 0;
+        size_t num_kernels = 0;
+    };
+    auto create = [&](const std::vector<size_t>& lengths, rocfft_optimize_strategy strategy) {
+        result_t result;
+        EXPECT_EQ(rocfft_plan_description_set_optimize_strategy(desc, strategy),
+                  rocfft_status_success);
+        rocfft_plan plan = nullptr;
+        EXPECT_EQ(rocfft_plan_create(&plan,
+                                     rocfft_placement_notinplace,
+                                     rocfft_transform_type_real_forward,
+                                     rocfft_precision_single,
+                                     lengths.size(),
+                                     lengths.data(),
+                                     1,
+                                     desc),
+                  rocfft_status_success);
+        EXPECT_EQ(rocfft_plan_get_work_buffer_size(plan, &result.work_size),
+                  rocfft_status_success);
+        result.num_kernels = plan_kernel_names(plan).size();
+        rocfft_plan_destroy(plan);
+        return result;
+    };
+
+    // max_fusion may use more buffer than min_buffer to fuse more
+    // kernels, and at least one of these problems has to show it
+    bool strategies_differ = false;
+    for(const auto& lengths : {std::vector<size_t>{336, 56, 64},
+                               std::vector<size_t>{64, 64, 64},
+                               std::vector<size_t>{128, 128, 128},
+                               std::vector<size_t>{200, 200, 200},
+                               std::vector<size_t>{256, 256}})
+    {
+        auto min_buffer = create(lengths, rocfft_optimize_min_buffer);
+        create(lengths, rocfft_optimize_balance);
+        auto max_fusion = create(lengths, rocfft_optimize_max_fusion);
+        EXPECT_LE(min_buffer.work_size, max_fusion.work_size);
+        EXPECT_GE(min_buffer.num_kernels, max_fusion.num_kernels);
+        if(min_buffer.work_size < max_fusion.work_size
+           || min_buffer.num_kernels > max_fusion.num_kernels)
+            strategies_differ = true;
+    }
+    EXPECT_TRUE(strategies_differ);
+}
+
+// the traffic model behind min_buffer and max_fusion should estimate
+// that fusing kernels costs less than not fusing them
+TEST(rocfft_UnitTest, assignment_cost_model)
+{
+    static const char* PLAN_FILE = "assignment_cost_model_plan.log";
+
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_cleanup();
+        remove(PLAN_FILE);
+        rocfft_setup();
+    };
+
+    rocfft_cleanup();
+    EnvironmentSetTemp layer("ROCFFT_LAYER", "8");
+    EnvironmentSetTemp planpath("ROCFFT_LOG_PLAN_PATH", PLAN_FILE);
+    rocfft_setup();
+
+    rocfft_plan_description desc = nullptr;
+    ASSERT_EQ(rocfft_plan_description_create(&desc), rocfft_status_success);
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_plan_description_destroy(desc);
+    };
+    ASSERT_EQ(rocfft_plan_description_set_optimize_strategy(desc, rocfft_optimize_max_fusion),
+              rocfft_status_success);
+
+    const std::vector<size_t> lengths = {336, 56, 64};
+    rocfft_plan               plan    = nullptr;
+    ASSERT_EQ(rocfft_plan_create(&plan,
+                                 rocfft_placement_notinplace,
+                                 rocfft_transform_type_real_forward,
+                                 rocfft_precision_single,
+                                 lengths.size(),
+                                 lengths.data(),
+                                 1,
+                                 desc),
+              rocfft_status_success);
+    rocfft_plan_destroy(plan);
+    rocfft_cleanup();
+
+    // each search logs its candidates in the order they were ranked
+    std::ifstream plan_log(PLAN_FILE);
+    std::string   line;
+    std::regex    header("^Assignment candidates.*");
+    std::regex    candidate("^  ([0-9]+), ([0-9]+), ([0-9]+), ([0-9]+), ([0-9]+)$");
+    std::smatch   match;
+    bool          in_candidates = false;
+    size_t        prev_score    = 0;
+    size_t        best_fused    = std::numeric_limits<size_t>::max();
+    size_t        best_unfused  = std::numeric_limits<size_t>::max();
+    while(std::getline(plan_log, line))
+    {
+        if(std::regex_match(line, header))
+        {
+            in_candidates = true;
+            prev_score    = 0;
+            continue;
+        }
+        if(!in_candidates || !std::regex_match(line, match, candidate))
+        {
+            in_candidates = false;
+            continue;
+        }
+        size_t fused = std::stoull(match[1]);
+        size_t score = std::stoull(match[5]);
+
+        // max_fusion ranks the least traffic first
+        EXPECT_GE(score, prev_score);
+        prev_score = score;
+
+        auto& best = fused ? best_fused : best_unfused;
+        best       = std::min(best, score);
+    }
+    ASSERT_NE(best_fused, std::numeric_limits<size_t>::max());
+    ASSERT_NE(best_unfused, std::numeric_limits<size_t>::max());
+    EXPECT_LT(best_fused, best_unfused);
+}
+
+// a function that accepts a plan's requested size on input, and
+// returns the size to actually allocate for the test
+typedef std::function<size_t(size_t)> workmem_sizer;
+
+void workmem_test(workmem_sizer sizer,
+                  rocfft_status exec_status_expected,
+                  bool          give_null_work_buf = false)
+{
+    // Prime size requires Bluestein, which guarantees work memory.
+    size_t      length = 8191;
+    rocfft_plan plan   = NULL;
+
+    ASSERT_EQ(rocfft_plan_create(&plan,
+                                 rocfft_placement_inplace,
+                                 rocfft_transform_type_complex_forward,
+                                 rocfft_precision_single,
+                                 1,
+                                 &length,
+                                 1,
+                                 nullptr),
+              rocfft_status_success);
+
+    size_t requested_work_size = 0;
+    ASSERT_EQ(rocfft_plan_get_work_buffer_size(plan, &requested_work_size), rocfft_status_success);
+    ASSERT_GT(requested_work_size, 0);
+
+    rocfft_execution_info info;
+    ASSERT_EQ(rocfft_execution_info_create(&info), rocfft_status_success);
+
+    size_t alloc_work_size = sizer(requested_work_size);
+    gpubuf work_buffer;
+    if(alloc_work_size)
+    {
+        ASSERT_EQ(work_buffer.alloc(alloc_work_size), hipSuccess);
+
+        void*         work_buffer_ptr;
+        rocfft_status set_work_expected_status;
+        if(give_null_work_buf)
+        {
+            work_buffer_ptr          = nullptr;
+            set_work_expected_status = rocfft_status_invalid_work_buffer;
+        }
+        else
+        {
+            work_buffer_ptr          = work_buffer.data();
+            set_work_expected_status = rocfft_status_success;
+        }
+        ASSERT_EQ(rocfft_execution_info_set_work_buffer(info, work_buffer_ptr, alloc_work_size),
+                  set_work_expected_status);
+    }
+
+    // allocate 2x length for complex
+    std::vector<float> data_host(length * 2, 1.0f);
+    gpubuf             data_device;
+    auto               data_size_bytes = data_host.size() * sizeof(float);
+
+    ASSERT_EQ(data_device.alloc(data_size_bytes), hipSuccess);
+    ASSERT_EQ(
+        hipMemcpy(data_device.data(), data_host.data(), data_size_bytes, hipMemcpyHostToDevice),
+        hipSuccess);
+    std::vector<void*> ibuffers(1, static_cast<void*>(data_device.data()));
+
+    ASSERT_EQ(rocfft_execute(plan, ibuffers.data(), nullptr, info), exec_status_expected);
+
+    rocfft_execution_info_destroy(info);
+    rocfft_plan_destroy(plan);
+}
+
+// check what happens if work memory is required but is not provided
+// - library should allocate
+TEST(rocfft_UnitTest, workmem_missing)
+{
+    workmem_test([](size_t) { return 0; }, rocfft_status_success);
+}
+
+// check what happens if work memory is required but not enough is provided
+TEST(rocfft_UnitTest, workmem_small)
+{
+    workmem_test([](size_t requested) { return requested / 2; }, rocfft_status_invalid_work_buffer);
+}
+
+// hard to imagine this being a problem, but try giving too much as well
+TEST(rocfft_UnitTest, workmem_big)
+{
+    workmem_test([](size_t requested) { return requested * 2; }, rocfft_status_success);
+}
+
+// check if a user explicitly gives a null pointer - set work buffer
+// should fail, but transform should succeed because library
+// allocates
+TEST(rocfft_UnitTest, workmem_null)
+{
+    workmem_test([](size_t requested) { return requested; }, rocfft_status_success, true);
+}
+
+// check that automatically-allocated work memory is reused, and freed
+// by a trim
+TEST(rocfft_UnitTest, workmem_pool)
+{
+    static const char* PROFILE_FILE = "workmem_pool_profile.log";
+
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_cleanup();
+        remove(PROFILE_FILE);
+        rocfft_setup();
+    };
+
+    rocfft_cleanup();
+    EnvironmentSetTemp layer("ROCFFT_LAYER", "4");
+    EnvironmentSetTemp profilepath("ROCFFT_LOG_PROFILE_PATH", PROFILE_FILE);
+    rocfft_setup();
+
+    workmem_test([](size_t) { return 0; }, rocfft_status_success);
+    workmem_test([](size_t) { return 0; }, rocfft_status_success);
+    ASSERT_EQ(rocfft_work_buffer_pool_trim(0), rocfft_status_success);
+    workmem_test([](size_t) { return 0; }, rocfft_status_success);
+
+    rocfft_cleanup();
+
+    std::vector<std::string> events;
+    std::ifstream            profile_log(PROFILE_FILE);
+    std::string              line;
+    std::regex               pool_event("^work_buffer_pool,event,([a-z]+),.*");
+    std::smatch              match;
+    while(std::getline(profile_log, line))
+    {
+        if(std::regex_match(line, match, pool_event))
+            events.push_back(match[1]);
+    }
+    std::vector<std::string> expected
+        = {"miss", "release", "hit", "release", "trim", "miss", "release"};
+    EXPECT_EQ(events, expected);
+}
+
+// check that a plan with a work buffer limit runs in batch chunks
+// that fit, and gives the same results as one that doesn't
+#ifndef WIN32
+// Run fn on a new thread with standard output going to a file, and
+// return what it printed.  rocfft_cout keeps a stream per thread, so
+// only a new thread sees the redirected output.
+static std::string capture_stdout(const std::function<void()>& fn)
+{
+    static const char* OUTPUT_FILE = "capture_stdout.txt";
+
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int file  = open(OUTPUT_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    EXPECT_NE(saved, -1);
+    EXPECT_NE(file, -1);
+    dup2(file, STDOUT_FILENO);
+    close(file);
+
+    std::thread(fn).join();
+
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    std::ifstream     in(OUTPUT_FILE);
+    std::stringstream output;
+    output << in.rdbuf();
+    remove(OUTPUT_FILE);
+    return output.str();
+}
+#endif
+
+static void workmem_limit_test(const std::vector<size_t>& lengths, size_t batch)
+{
+    const size_t count = std::accumulate(
+        lengths.begin(), lengths.end(), batch, std::multiplies<size_t>());
+    const size_t bytes = count * sizeof(std::complex<double>);
+
+    auto create = [&](size_t limit, rocfft_plan* plan) {
+        rocfft_plan_description desc = nullptr;
+        EXPECT_EQ(rocfft_plan_description_create(&desc), rocfft_status_success);
+        EXPECT_EQ(rocfft_plan_description_set_work_buffer_limit(desc, limit),
+                  rocfft_status_success);
+        auto status = rocfft_plan_create(plan,
+                                         rocfft_placement_notinplace,
+                                         rocfft_transform_type_complex_forward,
+                                         rocfft_precision_double,
+                                         lengths.size(),
+                                         lengths.data(),
+                                         batch,
+                                         desc);
+        rocfft_plan_description_destroy(desc);
+        return status;
+    };
+
+    rocfft_plan whole   = nullptr;
+    rocfft_plan chunked = nullptr;
+    BOOST_SCOPE_EXIT_ALL(&)
+    {
+        rocfft_plan_destroy(whole);
+        rocfft_plan_destroy(chunked);
+    };
+    ASSERT_EQ(create(0, &whole), rocfft_status_success);
+    size_t whole_bytes = 0;
+    ASSERT_EQ(rocfft_plan_get_work_buffer_size(whole, &whole_bytes), rocfft_status_success);
+    ASSERT_GT(whole_bytes, 0);
+
+    const size_t limit = whole_bytes / 3;
+    ASSERT_EQ(create(limit, &chunked), rocfft_status_success);
+    size_t chunked_bytes = 0;
+    ASSERT_EQ(rocfft_plan_get_work_buffer_size(chunked, &chunked_bytes), rocfft_status_success);
+    EXPECT_GT(chunked_bytes, 0);
+    EXPECT_LE(chunked_bytes, limit);
+
+#ifndef WIN32
+    // printing the plan says how it's split up
+    auto print = capture_stdout([=]() { rocfft_plan_get_print(chunked); });
+    std::smatch chunks;
+    ASSERT_TRUE(
+        std::regex_search(print, chunks, std::regex(R"(batch chunks: (\d+) of (\d+))")))
+        << print;
+    const size_t chunk_count = std::stoull(chunks[1]);
+    const size_t chunk_batch = std::stoull(chunks[2]);
+    EXPECT_GT(chunk_count, 1);
+    EXPECT_LT(chunk_batch, batch);
+    EXPECT_EQ(chunk_count, (batch + chunk_batch - 1) / chunk_batch);
+    EXPECT_EQ(capture_stdout([=]() { rocfft_plan_get_print(whole); }).find("batch chunks"),
+              std::string::npos);
+#endif
+
+    std::vector<std::complex<double>> input(count);
+    for(size_t i = 0; i < count; ++i)
+        input[i] = {std::sin(0.001 * i), std::cos(0.003 * i)};
+
+    gpubuf in_device;
+    gpubuf out_device;
+    ASSERT_EQ(in_device.alloc(bytes), hipSuccess);
+    ASSERT_EQ(out_device.alloc(bytes), hipSuccess);
+    auto run = [&](rocfft_plan plan) {
+        // out-of-place transforms may overwrite their input
+        EXPECT_EQ(hipMemcpy(in_device.data(), input.data(), bytes, hipMemcpyHostToDevice),
+                  hipSuccess);
+        void* in_ptr  = in_device.data();
+        void* out_ptr = out_device.data();
+        EXPECT_EQ(rocfft_execute(plan, &in_ptr, &out_ptr, nullptr), rocfft_status_success);
+        std::vector<std::complex<double>> output(count);
+        EXPECT_EQ(hipMemcpy(output.data(), out_device.data(), bytes, hipMemcpyDeviceToHost),
+                  hipSuccess);
+        return output;
+    };
+    auto expected = run(whole);
+    EXPECT_LT(relative_diff(run(chunked), expected), 1e-14);
+    // chunks' launches are reused on the next execution
+    EXPECT_LT(relative_diff(run(chunked), expected), 1e-14);
+
+    // a limit that one transform can't fit in is an error
+    rocfft_plan too_small = nullptr;
+    EXPECT_EQ(create(1, &too_small), rocfft_status_failure);
+    rocfft_plan_destroy(too_small);
+}
 
-    rocfft_execution_info_destroy(info);
-    rocfft_plan_destroy(plan);
+TEST(rocfft_UnitTest, workmem_limit)
+{
+    // large 1D lengths are decomposed through a work buffer, in
+    // higher dimensional transforms too.  batch isn't a multiple of
+    // the chunks, so the last is smaller.
+    workmem_limit_test({1 << 16}, 7);
+    workmem_limit_test({1 << 16, 4}, 7);
+    workmem_limit_test({1 << 14, 4, 4}, 7);
 }
 
-// check what happens if work memory is required but is not provided
-// - library should allocate
-TEST(rocfft_UnitTest, workmem_missing)
+// run an in-place forward complex transform on device data
+static void run_complex_inplace(void*                      data,
+                                const std::vector<size_t>& lengths,
+                                const std::vector<size_t>& strides,
+                                size_t                     batch,
+                                size_t                     dist)
 {
-    workmem_test([](size_t) { return 0; }, rocfft_status_success);
+    rocfft_plan_description desc = nullptr;
+    ASSERT_EQ(rocfft_plan_description_create(&desc), rocfft_status_success);
+    rocfft_plan plan = nullptr;
+    BOOST_SCOPE_EXIT_ALL(&)
+    {
+        rocfft_plan_destroy(plan);
+        rocfft_plan_description_destroy(desc);
+    };
+    ASSERT_EQ(rocfft_plan_description_set_data_layout(desc,
+                                                      rocfft_array_type_complex_interleaved,
+                                                      rocfft_array_type_complex_interleaved,
+                                                      nullptr,
+                                                      nullptr,
+                                                      strides.size(),
+                                                      strides.data(),
+                                                      dist,
+                                                      strides.size(),
+                                                      strides.data(),
+                                                      dist),
+              rocfft_status_success);
+    ASSERT_EQ(rocfft_plan_create(&plan,
+                                 rocfft_placement_inplace,
+                                 rocfft_transform_type_complex_forward,
+                                 rocfft_precision_double,
+                                 lengths.size(),
+                                 lengths.data(),
+                                 batch,
+                                 desc),
+              rocfft_status_success);
+    ASSERT_EQ(rocfft_execute(plan, &data, nullptr, nullptr), rocfft_status_success);
 }
 
-// check what happens if work memory is required but not enough is provided
-TEST(rocfft_UnitTest, workmem_small)
+TEST(rocfft_UnitTest, nd_transform)
 {
-    workmem_test([](size_t requested) { return requested / 2; }, rocfft_status_invalid_work_buffer);
+    // compare against a 3D transform of the innermost dimensions,
+    // followed by 1D transforms along each higher dimension.
+    // 7 x 11 has no 2D kernel and 11 has no SBCC kernel, so the
+    // inner node is 1D.  8192 has no SBCC kernel and is too long for
+    // one kernel, so its columns go through a work buffer.
+    for(const auto& lengths : {std::vector<size_t>{8, 6, 10, 5},
+                               std::vector<size_t>{4, 3, 6, 5, 2},
+                               std::vector<size_t>{7, 11, 6, 5},
+                               std::vector<size_t>{4, 4, 2, 8192}})
+    {
+        std::vector<size_t> strides = {1};
+        for(size_t i = 1; i < lengths.size(); ++i)
+            strides.push_back(strides.back() * lengths[i - 1]);
+        const size_t count = strides.back() * lengths.back();
+        const size_t bytes = count * sizeof(std::complex<double>);
+
+        std::vector<std::complex<double>> input(count);
+        for(size_t i = 0; i < count; ++i)
+            input[i] = {std::sin(0.01 * i), std::cos(0.03 * i)};
+
+        gpubuf nd_device;
+        gpubuf ref_device;
+        ASSERT_EQ(nd_device.alloc(bytes), hipSuccess);
+        ASSERT_EQ(ref_device.alloc(bytes), hipSuccess);
+        ASSERT_EQ(hipMemcpy(nd_device.data(), input.data(), bytes, hipMemcpyHostToDevice),
+                  hipSuccess);
+        ASSERT_EQ(hipMemcpy(ref_device.data(), input.data(), bytes, hipMemcpyHostToDevice),
+                  hipSuccess);
+
+        run_complex_inplace(nd_device.data(), lengths, strides, 1, count);
+
+        run_complex_inplace(ref_device.data(),
+                            {lengths.begin(), lengths.begin() + 3},
+                            {strides.begin(), strides.begin() + 3},
+                            count / strides[3],
+                            strides[3]);
+        for(size_t dim = 3; dim < lengths.size(); ++dim)
+        {
+            const size_t block = strides[dim] * lengths[dim];
+            auto         ref   = static_cast<std::complex<double>*>(ref_device.data());
+            for(size_t offset = 0; offset < count; offset += block)
+                run_complex_inplace(
+                    ref + offset, {lengths[dim]}, {strides[dim]}, strides[dim], 1);
+        }
+
+        std::vector<std::complex<double>> nd_output(count);
+        std::vector<std::complex<double>> ref_output(count);
+        ASSERT_EQ(hipMemcpy(nd_output.data(), nd_device.data(), bytes, hipMemcpyDeviceToHost),
+                  hipSuccess);
+        ASSERT_EQ(hipMemcpy(ref_output.data(), ref_device.data(), bytes, hipMemcpyDeviceToHost),
+                  hipSuccess);
+        EXPECT_LT(relative_diff(nd_output, ref_output), 1e-12);
+    }
+
+    const std::vector<size_t> long_column = {4, 4, 2, 8192};
+    rocfft_plan               plan        = nullptr;
+    ASSERT_EQ(rocfft_plan_create(&plan,
+                                 rocfft_placement_inplace,
+                                 rocfft_transform_type_complex_forward,
+                                 rocfft_precision_double,
+                                 long_column.size(),
+                                 long_column.data(),
+                                 1,
+                                 nullptr),
+              rocfft_status_success);
+    size_t work_bytes = 0;
+    EXPECT_EQ(rocfft_plan_get_work_buffer_size(plan, &work_bytes), rocfft_status_success);
+    EXPECT_GT(work_bytes, 0);
+    rocfft_plan_destroy(plan);
 }
 
-// hard to imagine this being a problem, but try giving too much as well
-TEST(rocfft_UnitTest, workmem_big)
+// transforms interleaved with each other (dist 1, strides multiplied
+// by batch) give the same results as transforms stored one after
+// another.  64 has an SBCC kernel, which can't be used for these
+// columns.
+TEST(rocfft_UnitTest, nd_transform_inner_batch)
 {
-    workmem_test([](size_t requested) { return requested * 2; }, rocfft_status_success);
+    const std::vector<size_t> lengths = {8, 6, 10, 64};
+    const size_t              batch   = 3;
+
+    std::vector<size_t> strides = {1};
+    for(size_t i = 1; i < lengths.size(); ++i)
+        strides.push_back(strides.back() * lengths[i - 1]);
+    const size_t count = strides.back() * lengths.back();
+    const size_t bytes = count * batch * sizeof(std::complex<double>);
+
+    std::vector<std::complex<double>> separate(count * batch);
+    for(size_t i = 0; i < separate.size(); ++i)
+        separate[i] = {std::sin(0.01 * i), std::cos(0.03 * i)};
+    // element i of transform b is at i * batch + b
+    std::vector<std::complex<double>> interleaved(separate.size());
+    for(size_t b = 0; b < batch; ++b)
+        for(size_t i = 0; i < count; ++i)
+            interleaved[i * batch + b] = separate[b * count + i];
+
+    gpubuf separate_device;
+    gpubuf interleaved_device;
+    ASSERT_EQ(separate_device.alloc(bytes), hipSuccess);
+    ASSERT_EQ(interleaved_device.alloc(bytes), hipSuccess);
+    ASSERT_EQ(hipMemcpy(separate_device.data(), separate.data(), bytes, hipMemcpyHostToDevice),
+              hipSuccess);
+    ASSERT_EQ(
+        hipMemcpy(interleaved_device.data(), interleaved.data(), bytes, hipMemcpyHostToDevice),
+        hipSuccess);
+
+    run_complex_inplace(separate_device.data(), lengths, strides, batch, count);
+    std::vector<size_t> interleaved_strides;
+    for(auto stride : strides)
+        interleaved_strides.push_back(stride * batch);
+    run_complex_inplace(interleaved_device.data(), lengths, interleaved_strides, batch, 1);
+
+    ASSERT_EQ(hipMemcpy(separate.data(), separate_device.data(), bytes, hipMemcpyDeviceToHost),
+              hipSuccess);
+    ASSERT_EQ(
+        hipMemcpy(interleaved.data(), interleaved_device.data(), bytes, hipMemcpyDeviceToHost),
+        hipSuccess);
+    std::vector<std::complex<double>> deinterleaved(separate.size());
+    for(size_t b = 0; b < batch; ++b)
+        for(size_t i = 0; i < count; ++i)
+            deinterleaved[b * count + i] = interleaved[i * batch + b];
+    EXPECT_LT(relative_diff(deinterleaved, separate), 1e-12);
 }
 
-// check if a user explicitly gives a null pointer - set work buffer
-// should fail, but transform should succeed because library
-// allocates
-TEST(rocfft_UnitTest, workmem_null)
+TEST(rocfft_UnitTest, nd_real_transform)
 {
-    workmem_test([](size_t requested) { return requested; }, rocfft_status_success, true);
+    const std::vector<size_t> lengths      = {8, 6, 10, 4};
+    const size_t              real_count   = 8 * 6 * 10 * 4;
+    const size_t              cmplx_stride = 5 * 6 * 10;
+    const size_t              cmplx_count  = cmplx_stride * 4;
+    const size_t              real_bytes   = real_count * sizeof(double);
+    const size_t              cmplx_bytes  = cmplx_count * sizeof(std::complex<double>);
+
+    auto create = [](rocfft_plan*               plan,
+                     rocfft_transform_type      type,
+                     const std::vector<size_t>& plan_lengths,
+                     size_t                     batch) {
+        return rocfft_plan_create(plan,
+                                  rocfft_placement_notinplace,
+                                  type,
+                                  rocfft_precision_double,
+                                  plan_lengths.size(),
+                                  plan_lengths.data(),
+                                  batch,
+                                  nullptr);
+    };
+    rocfft_plan forward  = nullptr;
+    rocfft_plan backward = nullptr;
+    rocfft_plan ref      = nullptr;
+    rocfft_plan odd      = nullptr;
+    BOOST_SCOPE_EXIT_ALL(&)
+    {
+        rocfft_plan_destroy(forward);
+        rocfft_plan_destroy(backward);
+        rocfft_plan_destroy(ref);
+        rocfft_plan_destroy(odd);
+    };
+    ASSERT_EQ(create(&forward, rocfft_transform_type_real_forward, lengths, 1),
+              rocfft_status_success);
+    ASSERT_EQ(create(&backward, rocfft_transform_type_real_inverse, lengths, 1),
+              rocfft_status_success);
+    ASSERT_EQ(create(&ref, rocfft_transform_type_real_forward, {8, 6, 10}, 4),
+              rocfft_status_success);
+    // odd lengths on the fastest dimension aren't supported above 3D
+    EXPECT_EQ(create(&odd, rocfft_transform_type_real_forward, {7, 6, 10, 4}, 1),
+              rocfft_status_failure);
+
+    std::vector<double> input(real_count);
+    for(size_t i = 0; i < real_count; ++i)
+        input[i] = std::sin(0.01 * i) + std::cos(0.07 * i);
+
+    gpubuf real_device;
+    gpubuf nd_device;
+    gpubuf ref_device;
+    ASSERT_EQ(real_device.alloc(real_bytes), hipSuccess);
+    ASSERT_EQ(nd_device.alloc(cmplx_bytes), hipSuccess);
+    ASSERT_EQ(ref_device.alloc(cmplx_bytes), hipSuccess);
+
+    // out-of-place real transforms may overwrite their input
+    auto run = [&](rocfft_plan plan, void* out_ptr) {
+        EXPECT_EQ(hipMemcpy(real_device.data(), input.data(), real_bytes, hipMemcpyHostToDevice),
+                  hipSuccess);
+        void* in_ptr = real_device.data();
+        EXPECT_EQ(rocfft_execute(plan, &in_ptr, &out_ptr, nullptr), rocfft_status_success);
+    };
+    run(forward, nd_device.data());
+    run(ref, ref_device.data());
+    run_complex_inplace(ref_device.data(), {4}, {cmplx_stride}, cmplx_stride, 1);
+
+    std::vector<std::complex<double>> nd_output(cmplx_count);
+    std::vector<std::complex<double>> ref_output(cmplx_count);
+    ASSERT_EQ(hipMemcpy(nd_output.data(), nd_device.data(), cmplx_bytes, hipMemcpyDeviceToHost),
+              hipSuccess);
+    ASSERT_EQ(hipMemcpy(ref_output.data(), ref_device.data(), cmplx_bytes, hipMemcpyDeviceToHost),
+              hipSuccess);
+    EXPECT_LT(relative_diff(nd_output, ref_output), 1e-12);
+
+    // the inverse brings back the input, scaled by the transform size
+    void* in_ptr  = nd_device.data();
+    void* out_ptr = real_device.data();
+    ASSERT_EQ(rocfft_execute(backward, &in_ptr, &out_ptr, nullptr), rocfft_status_success);
+    std::vector<double> roundtrip(real_count);
+    ASSERT_EQ(hipMemcpy(roundtrip.data(), real_device.data(), real_bytes, hipMemcpyDeviceToHost),
+              hipSuccess);
+    std::vector<std::complex<double>> scaled(real_count);
+    std::vector<std::complex<double>> expected(real_count);
+    for(size_t i = 0; i < real_count; ++i)
+    {
+        scaled[i]   = roundtrip[i] / real_count;
+        expected[i] = input[i];
+    }
+    EXPECT_LT(relative_diff(scaled, expected), 1e-12);
 }
 
 #ifdef ROCFFT_RUNTIME_COMPILE
@@ -496,6 +2491,435 @@ TEST(rocfft_UnitTest, rtc_cache_null)
     ASSERT_EQ(rocfft_cache_deserialize(&buf_len, 0), rocfft_status_invalid_arg_value);
 }
 
+// check cache statistics, and that the cache respects its size limit
+TEST(rocfft_UnitTest, rtc_cache_stats)
+{
+    const std::string rtc_cache_path = std::tmpnam(nullptr);
+
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_cleanup();
+        remove(rtc_cache_path.c_str());
+        rocfft_setup();
+    };
+
+    rocfft_cleanup();
+    EnvironmentSetTemp cache_env("ROCFFT_RTC_CACHE_PATH", rtc_cache_path.c_str());
+    rocfft_setup();
+
+    auto build_plan = []() {
+        rocfft_plan plan = nullptr;
+        ASSERT_EQ(rocfft_plan_create(&plan,
+                                     rocfft_placement_inplace,
+                                     rocfft_transform_type_complex_forward,
+                                     rocfft_precision_single,
+                                     1,
+                                     &RTC_PROBLEM_SIZE,
+                                     1,
+                                     nullptr),
+                  rocfft_status_success);
+        rocfft_plan_destroy(plan);
+    };
+
+    size_t entries       = 0;
+    size_t size_bytes    = 0;
+    size_t hits          = 0;
+    size_t misses        = 0;
+    double time_saved_ms = 0.0;
+
+    // null pointers are allowed
+    ASSERT_EQ(rocfft_cache_get_stats(nullptr, nullptr, nullptr, nullptr, nullptr),
+              rocfft_status_success);
+
+    // empty cache
+    ASSERT_EQ(rocfft_cache_get_stats(&entries, &size_bytes, &hits, &misses, &time_saved_ms),
+              rocfft_status_success);
+    ASSERT_EQ(entries, 0u);
+    ASSERT_EQ(size_bytes, 0u);
+    ASSERT_EQ(hits, 0u);
+    ASSERT_EQ(misses, 0u);
+
+    // first plan has to compile
+    build_plan();
+    ASSERT_EQ(rocfft_cache_get_stats(&entries, &size_bytes, &hits, &misses, &time_saved_ms),
+              rocfft_status_success);
+    ASSERT_GT(entries, 0u);
+    ASSERT_GT(size_bytes, 0u);
+    ASSERT_EQ(hits, 0u);
+    ASSERT_GT(misses, 0u);
+
+    // second plan should find everything in the cache
+    size_t first_misses = misses;
+    build_plan();
+    ASSERT_EQ(rocfft_cache_get_stats(&entries, &size_bytes, &hits, &misses, &time_saved_ms),
+              rocfft_status_success);
+    ASSERT_GT(hits, 0u);
+    ASSERT_EQ(misses, first_misses);
+    ASSERT_GE(time_saved_ms, 0.0);
+
+    // compile times survive serialization, so imported kernels still
+    // count as time saved
+    {
+        void*  buffer     = nullptr;
+        size_t buffer_len = 0;
+        ASSERT_EQ(rocfft_cache_serialize(&buffer, &buffer_len), rocfft_status_success);
+        std::vector<char> serialized(static_cast<char*>(buffer),
+                                     static_cast<char*>(buffer) + buffer_len);
+        rocfft_cache_buffer_free(buffer);
+
+        const std::string import_path = std::tmpnam(nullptr);
+        BOOST_SCOPE_EXIT_ALL(=)
+        {
+            rocfft_cleanup();
+            remove(import_path.c_str());
+        };
+        rocfft_cleanup();
+        EnvironmentSetTemp import_env("ROCFFT_RTC_CACHE_PATH", import_path.c_str());
+        rocfft_setup();
+        ASSERT_EQ(rocfft_cache_deserialize(serialized.data(), serialized.size()),
+                  rocfft_status_success);
+
+        build_plan();
+        ASSERT_EQ(rocfft_cache_get_stats(nullptr, nullptr, &hits, &misses, &time_saved_ms),
+                  rocfft_status_success);
+        ASSERT_GT(hits, 0u);
+        ASSERT_EQ(misses, 0u);
+        ASSERT_GT(time_saved_ms, 0.0);
+    }
+    rocfft_setup();
+
+    // limit the cache to a size that no kernel fits in - reopening
+    // the cache should evict everything, and newly-compiled kernels
+    // should not stay in the cache
+    rocfft_cleanup();
+    EnvironmentSetTemp max_size_env("ROCFFT_RTC_CACHE_MAX_SIZE", "1");
+    rocfft_setup();
+    ASSERT_EQ(rocfft_cache_get_stats(&entries, &size_bytes, nullptr, nullptr, nullptr),
+              rocfft_status_success);
+    ASSERT_EQ(entries, 0u);
+    ASSERT_EQ(size_bytes, 0u);
+
+    build_plan();
+    ASSERT_EQ(rocfft_cache_get_stats(&entries, &size_bytes, &hits, &misses, nullptr),
+              rocfft_status_success);
+    ASSERT_EQ(entries, 0u);
+    ASSERT_EQ(hits, 0u);
+    ASSERT_GT(misses, 0u);
+}
+
+// host-generated twiddle tables count towards the cache's size
+// limit, and are evicted with kernels
+TEST(rocfft_UnitTest, rtc_cache_twiddles_max_size)
+{
+    const std::string rtc_cache_path = std::tmpnam(nullptr);
+
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_cleanup();
+        remove(rtc_cache_path.c_str());
+        rocfft_setup();
+    };
+
+    rocfft_cleanup();
+    EnvironmentSetTemp cache_env("ROCFFT_RTC_CACHE_PATH", rtc_cache_path.c_str());
+    rocfft_setup();
+
+    // lengths large enough for their twiddle tables to be cached
+    auto build_plans = [](const std::vector<size_t>& lengths) {
+        for(auto length : lengths)
+        {
+            for(auto precision : {rocfft_precision_single, rocfft_precision_double})
+            {
+                rocfft_plan plan = nullptr;
+                ASSERT_EQ(rocfft_plan_create(&plan,
+                                             rocfft_placement_notinplace,
+                                             rocfft_transform_type_complex_forward,
+                                             precision,
+                                             1,
+                                             &length,
+                                             1,
+                                             nullptr),
+                          rocfft_status_success);
+                rocfft_plan_destroy(plan);
+            }
+        }
+    };
+    auto cache_bytes = []() {
+        size_t size_bytes = 0;
+        EXPECT_EQ(rocfft_cache_get_stats(nullptr, &size_bytes, nullptr, nullptr, nullptr),
+                  rocfft_status_success);
+        return size_bytes;
+    };
+
+    build_plans({1 << 22});
+    const size_t first_bytes = cache_bytes();
+    ASSERT_GT(first_bytes, 0u);
+
+    build_plans({1 << 21, 1 << 23});
+    const size_t all_bytes = cache_bytes();
+    ASSERT_GT(all_bytes, first_bytes);
+
+    // reopening with a smaller limit evicts tables until the rest
+    // fit
+    const size_t limit = all_bytes - 1;
+    rocfft_cleanup();
+    EnvironmentSetTemp max_size_env("ROCFFT_RTC_CACHE_MAX_SIZE", std::to_string(limit).c_str());
+    rocfft_setup();
+    const size_t evicted_bytes = cache_bytes();
+    EXPECT_LE(evicted_bytes, limit);
+    EXPECT_GT(evicted_bytes, 0u);
+
+    // filling the cache past the limit again keeps it under the
+    // limit
+    build_plans({1 << 22, 1 << 21, 1 << 23, 3 << 20});
+    EXPECT_LE(cache_bytes(), limit);
+}
+
+// a square 2D plan asks for the same kernel more than once - each
+// request has to load a usable kernel from the cache
+TEST(rocfft_UnitTest, rtc_cache_repeated_kernel)
+{
+    const std::string rtc_cache_path = std::tmpnam(nullptr);
+
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_cleanup();
+        remove(rtc_cache_path.c_str());
+        rocfft_setup();
+    };
+
+    rocfft_cleanup();
+    EnvironmentSetTemp cache_env("ROCFFT_RTC_CACHE_PATH", rtc_cache_path.c_str());
+    rocfft_setup();
+
+    const size_t lengths[2] = {RTC_PROBLEM_SIZE, RTC_PROBLEM_SIZE};
+    const size_t count      = lengths[0] * lengths[1];
+    const size_t bytes      = count * sizeof(std::complex<float>);
+
+    std::vector<std::complex<float>> input(count);
+    for(size_t i = 0; i < count; ++i)
+        input[i] = {std::sin(0.01f * (i % 1000)), std::cos(0.03f * (i % 700))};
+
+    gpubuf in_device;
+    gpubuf out_device;
+    ASSERT_EQ(in_device.alloc(bytes), hipSuccess);
+    ASSERT_EQ(out_device.alloc(bytes), hipSuccess);
+
+    auto run = [&](std::vector<std::complex<float>>& output) {
+        rocfft_plan plan = nullptr;
+        ASSERT_EQ(rocfft_plan_create(&plan,
+                                     rocfft_placement_notinplace,
+                                     rocfft_transform_type_complex_forward,
+                                     rocfft_precision_single,
+                                     2,
+                                     lengths,
+                                     1,
+                                     nullptr),
+                  rocfft_status_success);
+        BOOST_SCOPE_EXIT_ALL(&)
+        {
+            rocfft_plan_destroy(plan);
+        };
+        ASSERT_EQ(hipMemcpy(in_device.data(), input.data(), bytes, hipMemcpyHostToDevice),
+                  hipSuccess);
+        void* in_ptr  = in_device.data();
+        void* out_ptr = out_device.data();
+        ASSERT_EQ(rocfft_execute(plan, &in_ptr, &out_ptr, nullptr), rocfft_status_success);
+        ASSERT_EQ(hipDeviceSynchronize(), hipSuccess);
+        output.resize(count);
+        ASSERT_EQ(hipMemcpy(output.data(), out_device.data(), bytes, hipMemcpyDeviceToHost),
+                  hipSuccess);
+    };
+
+    // first plan compiles its kernels
+    std::vector<std::complex<float>> compiled;
+    run(compiled);
+
+    // later plans load them all from the cache
+    for(unsigned int i = 0; i < 3; ++i)
+    {
+        std::vector<std::complex<float>> loaded;
+        run(loaded);
+        ASSERT_EQ(loaded.size(), compiled.size());
+        EXPECT_LT(relative_diff(loaded, compiled), 1e-6);
+    }
+}
+
+// kernels built without a device should be found by a real plan
+// for the same problem
+TEST(rocfft_UnitTest, rtc_cache_build_kernels)
+{
+    const std::string rtc_cache_path = std::tmpnam(nullptr);
+
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_cleanup();
+        remove(rtc_cache_path.c_str());
+        rocfft_setup();
+    };
+
+    rocfft_cleanup();
+    EnvironmentSetTemp cache_env("ROCFFT_RTC_CACHE_PATH", rtc_cache_path.c_str());
+    rocfft_setup();
+
+    ASSERT_EQ(rocfft_cache_build_kernels(nullptr,
+                                         rocfft_placement_inplace,
+                                         rocfft_transform_type_complex_forward,
+                                         rocfft_precision_single,
+                                         1,
+                                         &RTC_PROBLEM_SIZE,
+                                         1,
+                                         nullptr),
+              rocfft_status_invalid_arg_value);
+
+    int             deviceId = 0;
+    hipDeviceProp_t prop;
+    ASSERT_EQ(hipGetDevice(&deviceId), hipSuccess);
+    ASSERT_EQ(hipGetDeviceProperties(&prop, deviceId), hipSuccess);
+
+    ASSERT_EQ(rocfft_cache_build_kernels(prop.gcnArchName,
+                                         rocfft_placement_inplace,
+                                         rocfft_transform_type_complex_forward,
+                                         rocfft_precision_single,
+                                         1,
+                                         &RTC_PROBLEM_SIZE,
+                                         1,
+                                         nullptr),
+              rocfft_status_success);
+
+    size_t entries = 0;
+    size_t hits    = 0;
+    size_t misses  = 0;
+    ASSERT_EQ(rocfft_cache_get_stats(&entries, nullptr, &hits, &misses, nullptr),
+              rocfft_status_success);
+    ASSERT_GT(entries, 0u);
+    ASSERT_GT(misses, 0u);
+
+    // nothing should need compiling for a real plan
+    size_t      built_misses = misses;
+    rocfft_plan plan         = nullptr;
+    ASSERT_EQ(rocfft_plan_create(&plan,
+                                 rocfft_placement_inplace,
+                                 rocfft_transform_type_complex_forward,
+                                 rocfft_precision_single,
+                                 1,
+                                 &RTC_PROBLEM_SIZE,
+                                 1,
+                                 nullptr),
+              rocfft_status_success);
+    rocfft_plan_destroy(plan);
+    ASSERT_EQ(rocfft_cache_get_stats(nullptr, nullptr, &hits, &misses, nullptr),
+              rocfft_status_success);
+    ASSERT_GT(hits, 0u);
+    ASSERT_EQ(misses, built_misses);
+}
+
+// plans created concurrently that need the same kernels should only
+// compile each kernel once
+TEST(rocfft_UnitTest, rtc_compile_queue)
+{
+    static const int  NUM_THREADS      = 8;
+    const std::string rtc_cache_path   = std::tmpnam(nullptr);
+    const std::string rtc_log_path     = std::tmpnam(nullptr);
+    const std::string profile_log_path = std::tmpnam(nullptr);
+
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        rocfft_cleanup();
+        remove(rtc_cache_path.c_str());
+        remove(rtc_log_path.c_str());
+        remove(profile_log_path.c_str());
+        rocfft_setup();
+    };
+
+    // start with an empty cache, and fewer compile threads than
+    // plans being created
+    rocfft_cleanup();
+    EnvironmentSetTemp cache_env("ROCFFT_RTC_CACHE_PATH", rtc_cache_path.c_str());
+    EnvironmentSetTemp threads_env("ROCFFT_RTC_COMPILE_THREADS", "2");
+    // log RTC and profile
+    EnvironmentSetTemp layer_env("ROCFFT_LAYER", "36");
+    EnvironmentSetTemp log_env("ROCFFT_LOG_RTC_PATH", rtc_log_path.c_str());
+    EnvironmentSetTemp profile_env("ROCFFT_LOG_PROFILE_PATH", profile_log_path.c_str());
+    rocfft_setup();
+
+    std::vector<std::thread> threads;
+    for(int i = 0; i < NUM_THREADS; ++i)
+    {
+        threads.emplace_back([]() {
+            rocfft_plan plan = nullptr;
+            EXPECT_EQ(rocfft_plan_create(&plan,
+                                         rocfft_placement_inplace,
+                                         rocfft_transform_type_complex_forward,
+                                         rocfft_precision_single,
+                                         1,
+                                         &RTC_PROBLEM_SIZE,
+                                         1,
+                                         nullptr),
+                      rocfft_status_success);
+            rocfft_plan_destroy(plan);
+        });
+    }
+    for(auto& t : threads)
+        t.join();
+
+    // close logs
+    rocfft_cleanup();
+
+    // source is only generated for a kernel that's actually
+    // compiled, so each kernel should only appear once
+    std::map<std::string, size_t> compiles;
+    std::ifstream                 logfile(rtc_log_path);
+    std::string                   line;
+    static const std::string      RTC_BEGIN = "ROCFFT_RTC_BEGIN ";
+    while(std::getline(logfile, line))
+    {
+        auto pos = line.find(RTC_BEGIN);
+        if(pos != std::string::npos)
+            ++compiles[line.substr(pos + RTC_BEGIN.size())];
+    }
+    ASSERT_FALSE(compiles.empty());
+    for(const auto& c : compiles)
+        EXPECT_EQ(c.second, 1u) << c.first;
+
+    // queue stats are logged each time a compile finishes.  The
+    // queue lives for the whole process, so counters may include
+    // earlier tests' compiles.
+    std::set<std::string> finished;
+    std::vector<size_t>   completed;
+    size_t                max_queue_depth = 0;
+    std::ifstream         profile_log(profile_log_path);
+    std::regex            queue_event("^compile_queue,kernel,([^,]+),threads,(\\d+),"
+                                      "max_threads,(\\d+),submitted,(\\d+),deduplicated,\\d+,"
+                                      "completed,(\\d+),queue_depth,(\\d+),"
+                                      "max_queue_depth,(\\d+),total_wait_ms,([^,]+),"
+                                      "max_wait_ms,([^,]+)$");
+    std::smatch           match;
+    while(std::getline(profile_log, line))
+    {
+        if(!std::regex_match(line, match, queue_event))
+            continue;
+        finished.insert(match[1]);
+        EXPECT_LE(std::stoull(match[2]), 2u);
+        EXPECT_EQ(std::stoull(match[3]), 2u);
+        EXPECT_GE(std::stoull(match[4]), std::stoull(match[5]));
+        completed.push_back(std::stoull(match[5]));
+        EXPECT_LE(std::stoull(match[6]), std::stoull(match[7]));
+        max_queue_depth = std::max<size_t>(max_queue_depth, std::stoull(match[7]));
+        EXPECT_GE(std::stod(match[8]), std::stod(match[9]));
+        EXPECT_GE(std::stod(match[9]), 0.0);
+    }
+    for(const auto& c : compiles)
+        EXPECT_EQ(finished.count(c.first), 1u) << c.first;
+    // each finished compile gets its own count, though threads may
+    // log them out of order
+    ASSERT_FALSE(completed.empty());
+    std::sort(completed.begin(), completed.end());
+    for(size_t i = 1; i < completed.size(); ++i)
+        EXPECT_EQ(completed[i], completed[i - 1] + 1);
+    EXPECT_GE(max_queue_depth, 1u);
+}
+
 // make sure RTC gracefully handles a helper process that crashes
 TEST(rocfft_UnitTest, rtc_helper_crash)
 {
@@ -562,4 +2986,118 @@ TEST(rocfft_UnitTest, rtc_helper_crash)
     plan = nullptr;
 }
 
+// check the helper's compile server protocol, using its fake
+// compiler so that no GPU or compiler is involved
+TEST(rocfft_UnitTest, rtc_helper_server)
+{
+#ifdef WIN32
+    char filename[MAX_PATH];
+    GetModuleFileNameA(NULL, filename, MAX_PATH);
+    fs::path test_exe   = filename;
+    fs::path helper_exe = test_exe.replace_filename("rocfft_rtc_helper.exe");
+#else
+    fs::path test_exe   = program_invocation_name;
+    fs::path helper_exe = test_exe.replace_filename("rocfft_rtc_helper");
+#endif
+    if(!fs::exists(helper_exe))
+        GTEST_SKIP() << "rocfft_rtc_helper not found next to test executable";
+
+    const std::string request_path  = std::tmpnam(nullptr);
+    const std::string response_path = std::tmpnam(nullptr);
+    BOOST_SCOPE_EXIT_ALL(=)
+    {
+        remove(request_path.c_str());
+        remove(response_path.c_str());
+    };
+
+    // a batch of requests - empty source makes the fake compiler fail
+    const std::vector<std::string> sources = {"kernel one", "", "kernel two"};
+    {
+        std::ofstream requests(request_path, std::ios::binary);
+        for(const auto& src : sources)
+        {
+            uint64_t len = src.size();
+            requests.write(reinterpret_cast<const char*>(&len), sizeof(len));
+            requests.write(src.data(), src.size());
+        }
+    }
+
+    std::string cmdline = "\"" + helper_exe.string() + "\" --server --fake gfx000 < \""
+                          + request_path + "\" > \"" + response_path + "\"";
+    ASSERT_EQ(std::system(cmdline.c_str()), 0);
+
+    // one response per request, in order
+    std::ifstream responses(response_path, std::ios::binary);
+    for(const auto& src : sources)
+    {
+        uint64_t status = 0;
+        uint64_t len    = 0;
+        ASSERT_TRUE(responses.read(reinterpret_cast<char*>(&status), sizeof(status)));
+        ASSERT_TRUE(responses.read(reinterpret_cast<char*>(&len), sizeof(len)));
+        std::string payload(len, '\0');
+        ASSERT_TRUE(responses.read(payload.data(), len));
+        if(src.empty())
+        {
+            EXPECT_NE(status, 0u);
+        }
+        else
+        {
+            EXPECT_EQ(status, 0u);
+            EXPECT_EQ(payload, src);
+        }
+    }
+    // nothing else should have been written
+    EXPECT_EQ(responses.peek(), std::ifstream::traits_type::eof());
+}
+
+// plans that compile kernels out-of-process at the same time should
+// all work, with their compiles shared among the pool of helpers
+TEST(rocfft_UnitTest, rtc_helper_pool)
+{
+    // don't touch the cache, to force compilation
+    EnvironmentSetTemp env_read("ROCFFT_RTC_CACHE_READ_DISABLE", "1");
+    EnvironmentSetTemp env_write("ROCFFT_RTC_CACHE_WRITE_DISABLE", "1");
+    // force out-of-process compile
+    EnvironmentSetTemp env_process("ROCFFT_RTC_PROCESS", "1");
+
+    // different lengths need different kernels
+    std::vector<std::thread> threads;
+    for(size_t length : {RTC_PROBLEM_SIZE, RTC_PROBLEM_SIZE * 2, RTC_PROBLEM_SIZE * 3})
+    {
+        threads.emplace_back([length]() {
+            rocfft_plan plan = nullptr;
+            EXPECT_EQ(rocfft_plan_create(&plan,
+                                         rocfft_placement_inplace,
+                                         rocfft_transform_type_complex_forward,
+                                         rocfft_precision_single,
+                                         1,
+                                         &length,
+                                         1,
+                                         nullptr),
+                      rocfft_status_success);
+
+            std::vector<float2> data_host(length, float2{1.0f, 0.0f});
+            gpubuf_t<float2>    data;
+            ASSERT_EQ(data.alloc(length * sizeof(float2)), hipSuccess);
+            ASSERT_EQ(hipMemcpy(data.data(),
+                                data_host.data(),
+                                length * sizeof(float2),
+                                hipMemcpyHostToDevice),
+                      hipSuccess);
+            void* ibuffers[] = {data.data()};
+            ASSERT_EQ(rocfft_execute(plan, ibuffers, nullptr, nullptr), rocfft_status_success);
+            ASSERT_EQ(hipMemcpy(data_host.data(),
+                                data.data(),
+                                length * sizeof(float2),
+                                hipMemcpyDeviceToHost),
+                      hipSuccess);
+            // FFT of all ones is length at DC
+            EXPECT_FLOAT_EQ(data_host[0].x, static_cast<float>(length));
+            rocfft_plan_destroy(plan);
+        });
+    }
+    for(auto& t : threads)
+        t.join();
+}
+
 #endif
@@ -109,6 +109,60 @@ typedef enum rocfft_array_type_e
     rocfft_array_type_unset,
 } rocfft_array_type;
 
+/*! @brief Strategy for assigning buffers to the steps of a plan
+ *  @details Plans with several steps store intermediate results in
+ *  the input, output or work buffers.  Using more work buffer memory
+ *  can allow more steps to be fused into one kernel, which reduces
+ *  memory traffic.
+ */
+typedef enum rocfft_optimize_strategy_e
+{
+    /*! minimize work buffer memory, possibly with fewer fused kernels */
+    rocfft_optimize_min_buffer,
+    /*! balance work buffer memory and kernel fusion (default) */
+    rocfft_optimize_balance,
+    /*! minimize memory traffic and kernel launches, possibly with more work buffer memory */
+    rocfft_optimize_max_fusion,
+} rocfft_optimize_strategy;
+
+/*! @brief How ::rocfft_execute launches the kernels of a plan
+ *  @details Plans with several steps launch several kernels.  For
+ *  small transforms, the time to launch them can be more than the
+ *  time to run them.
+ */
+typedef enum rocfft_launch_mode_e
+{
+    /*! launch each kernel separately (default) */
+    rocfft_launch_mode_direct,
+    /*! record the kernels into a HIP graph the first time a plan is
+     *  executed with a set of buffers, and launch the whole graph at
+     *  once on later executions with the same buffers */
+    rocfft_launch_mode_graph,
+} rocfft_launch_mode;
+
+/*! @brief Estimated cost of a kernel in a plan
+ *  @details Filled in by ::rocfft_plan_get_kernel_estimate.  The
+ *  estimate comes from a model of the kernel and the device the plan
+ *  was created for, not from running the kernel.
+ */
+typedef struct rocfft_kernel_estimate_s
+{
+    /*! bytes read from global memory */
+    size_t bytes_read;
+    /*! bytes written to global memory */
+    size_t bytes_written;
+    /*! floating-point operations */
+    double flops;
+    /*! LDS bytes used by each workgroup */
+    size_t lds_bytes;
+    /*! fraction of a compute unit's wavefront slots the kernel can fill, from 0 to 1 */
+    double occupancy;
+    /*! number of launches per execution; 0 if the kernel only runs with callbacks */
+    size_t launches;
+    /*! estimated execution time in microseconds, including launch overhead */
+    double time_us;
+} rocfft_kernel_estimate;
+
 #if 0
 /*! @brief Execution mode */
 typedef enum rocfft_execution_mode_e
@@ -133,10 +187,12 @@ ROCFFT_EXPORT rocfft_status rocfft_cleanup();
  *  subsequently.  This function takes many of the fundamental
  *  parameters needed to specify a transform.
  *
- *  The dimensions parameter can take a value of 1, 2, or 3. The
+ *  The dimensions parameter can take a value from 1 to 14. The
  *  'lengths' array specifies the size of data in each dimension. Note
  *  that lengths[0] is the size of the innermost dimension, lengths[1]
  *  is the next higher dimension and so on (column-major ordering).
+ *  Real transforms of more than 3 dimensions require lengths[0] to
+ *  be even and unit-stride.
  *
  *  The 'number_of_transforms' parameter specifies how many
  *  transforms (of the same kind) needs to be computed. By specifying
@@ -274,6 +330,99 @@ ROCFFT_EXPORT rocfft_status
                                             const size_t*           out_strides,
                                             const size_t            out_distance);
 
+/*! @brief Set buffer assignment strategy
+ *  @details Choose how plans created with this description trade
+ *  work buffer memory against fused kernels.  The default is
+ *  ::rocfft_optimize_balance.
+ *
+ *  @param[in, out] description description handle
+ *  @param[in] strategy buffer assignment strategy
+ *  */
+ROCFFT_EXPORT rocfft_status rocfft_plan_description_set_optimize_strategy(
+    rocfft_plan_description description, rocfft_optimize_strategy strategy);
+
+/*! @brief Limit the work buffer size of a plan
+ *  @details Work buffers of plans with several steps grow with the
+ *  number of transforms.  If the work buffer of a plan created with
+ *  this description would be larger than limit_bytes, the plan
+ *  instead runs its transforms in chunks, one after another, each
+ *  small enough for its work buffer to fit.
+ *
+ *  Plan creation fails if even a single transform needs more work
+ *  buffer than the limit.  Callbacks are not supported for plans that
+ *  run in chunks.  A limit of 0 (the default) means no limit.
+ *
+ *  @param[in, out] description description handle
+ *  @param[in] limit_bytes largest work buffer, in bytes
+ *  */
+ROCFFT_EXPORT rocfft_status rocfft_plan_description_set_work_buffer_limit(
+    rocfft_plan_description description, size_t limit_bytes);
+
+/*! @brief Plan for a device without using it
+ *  @details Plans created with this description are decided for a
+ *  device with the given properties, instead of the current device.
+ *  No GPU is used: kernels are not compiled and nothing is
+ *  allocated on a device.
+ *
+ *  Such a plan cannot be executed, but its decisions can be queried
+ *  with ::rocfft_plan_get_work_buffer_size,
+ *  ::rocfft_plan_get_kernel_count, ::rocfft_plan_get_kernel_name and
+ *  ::rocfft_plan_get_print.  This allows plan selection to be
+ *  inspected and tested on machines without a GPU.
+ *
+ *  @param[in, out] description description handle
+ *  @param[in] gpu_arch architecture name as reported by the device,
+ *  including any feature flags (e.g. "gfx90a:sramecc+:xnack-")
+ *  @param[in] lds_bytes LDS available per workgroup, or 0 for the default of 64 KiB
+ *  @param[in] compute_units number of compute units, or 0 if unknown
+ *  */
+ROCFFT_EXPORT rocfft_status
+    rocfft_plan_description_set_target_device(rocfft_plan_description description,
+                                              const char*             gpu_arch,
+                                              const size_t            lds_bytes,
+                                              const size_t            compute_units);
+
+/*! @brief Tune plans for a problem
+ *  @details Try the other ways rocFFT could decompose a complex
+ *  transform, and the kernel fusions it could do, and remember the
+ *  fastest for plans created later in this process, until
+ *  ::rocfft_cleanup is called.
+ *
+ *  Each candidate plan is executed on the current device and timed.
+ *  If the description has a target device (see
+ *  ::rocfft_plan_description_set_target_device), candidates are
+ *  scored with their estimated time instead (see
+ *  ::rocfft_plan_get_estimated_time), without using a GPU.  A
+ *  candidate is only recorded if it beats the plan rocFFT would
+ *  otherwise create by at least 2%.
+ *
+ *  If table_path is not null, the result is also added to the scheme
+ *  table file at that path, which is created if it does not exist.
+ *  Setting ROCFFT_SCHEME_TABLE to that path makes later processes
+ *  use the result.
+ *
+ *  The parameters describing the problem are the same as for
+ *  ::rocfft_plan_create.  Only complex transforms can be tuned.
+ *
+ *  @param[in] table_path scheme table file to update, or null
+ *  @param[in] placement placement of result
+ *  @param[in] transform_type type of transform, must be complex
+ *  @param[in] precision precision
+ *  @param[in] dimensions dimensions
+ *  @param[in] lengths dimensions-sized array of transform lengths
+ *  @param[in] number_of_transforms number of transforms
+ *  @param[in] description description handle created by
+ *  rocfft_plan_description_create; can be null for simple transforms
+ *  */
+ROCFFT_EXPORT rocfft_status rocfft_plan_tune(const char*                   table_path,
+                                             const rocfft_result_placement placement,
+                                             const rocfft_transform_type   transform_type,
+                                             const rocfft_precision        precision,
+                                             const size_t                  dimensions,
+                                             const size_t*                 lengths,
+                                             const size_t                  number_of_transforms,
+                                             const rocfft_plan_description description);
+
 /*! @brief Get library version string
  *
  * @param[in, out] buf buffer that receives the version string
@@ -305,6 +454,96 @@ ROCFFT_EXPORT rocfft_status rocfft_plan_get_work_buffer_size(const rocfft_plan p
  *  */
 ROCFFT_EXPORT rocfft_status rocfft_plan_get_print(const rocfft_plan plan);
 
+/*! @brief Get number of kernels in a plan
+ *  @details Get the number of kernels a plan launches each time it
+ *  is executed.
+ *  @param[in] plan plan handle
+ *  @param[out] count number of kernels
+ *  */
+ROCFFT_EXPORT rocfft_status rocfft_plan_get_kernel_count(const rocfft_plan plan, size_t* count);
+
+/*! @brief Get name of a kernel in a plan
+ *  @details Get a name identifying the kernel at the given position
+ *  in the plan's sequence of kernels.  Runtime-compiled kernels are
+ *  identified by their function name, and built-in kernels by their
+ *  scheme and lengths.  The name remains valid until the plan is
+ *  destroyed.
+ *  @param[in] plan plan handle
+ *  @param[in] index position of kernel, less than the count from
+ *  ::rocfft_plan_get_kernel_count
+ *  @param[out] name kernel name
+ *  */
+ROCFFT_EXPORT rocfft_status rocfft_plan_get_kernel_name(const rocfft_plan plan,
+                                                        size_t            index,
+                                                        const char**      name);
+
+/*! @brief Get estimated cost of a kernel in a plan
+ *  @details Estimate the memory traffic, arithmetic, occupancy and
+ *  execution time of the kernel at the given position in the
+ *  plan's sequence of kernels, without executing it.  Works for
+ *  plans created for a target device without a GPU (see
+ *  ::rocfft_plan_description_set_target_device).
+ *  @param[in] plan plan handle
+ *  @param[in] index position of kernel, less than the count from
+ *  ::rocfft_plan_get_kernel_count
+ *  @param[out] estimate estimated cost of the kernel
+ *  */
+ROCFFT_EXPORT rocfft_status rocfft_plan_get_kernel_estimate(const rocfft_plan       plan,
+                                                            size_t                  index,
+                                                            rocfft_kernel_estimate* estimate);
+
+/*! @brief Get estimated execution time of a plan
+ *  @details Estimate how long one execution of the plan takes, as
+ *  the sum of the estimated times of its kernels (see
+ *  ::rocfft_plan_get_kernel_estimate).  The estimate is meant for
+ *  comparing plans and scheduling work, and may differ from measured
+ *  times.
+ *  @param[in] plan plan handle
+ *  @param[out] time_us estimated time in microseconds
+ *  */
+ROCFFT_EXPORT rocfft_status rocfft_plan_get_estimated_time(const rocfft_plan plan,
+                                                           double*           time_us);
+
+/*! @brief Serialize a plan
+ *  @details Serialize the decisions rocFFT made when creating a plan
+ *  into a buffer, so that an identical plan can later be recreated
+ *  with ::rocfft_plan_deserialize without repeating those decisions.
+ *  The buffer is allocated by rocFFT and must be freed with a call to
+ *  ::rocfft_plan_buffer_free.  The length of the buffer in bytes is
+ *  written to 'buffer_len_bytes'.
+ *  @param[in] plan plan handle
+ *  @param[out] buffer serialized plan
+ *  @param[out] buffer_len_bytes length of buffer in bytes
+ *  */
+ROCFFT_EXPORT rocfft_status rocfft_plan_serialize(const rocfft_plan plan,
+                                                  void**            buffer,
+                                                  size_t*           buffer_len_bytes);
+
+/*! @brief Free plan serialization buffer
+ *  @details Deallocate a buffer allocated by ::rocfft_plan_serialize.
+ *  @param[in] buffer buffer to free
+ *  */
+ROCFFT_EXPORT rocfft_status rocfft_plan_buffer_free(void* buffer);
+
+/*! @brief Create a plan from a serialized plan
+ *  @details Recreate a plan from a buffer written by
+ *  ::rocfft_plan_serialize.  The plan must be freed with a call to
+ *  ::rocfft_plan_destroy.
+ *
+ *  Serialized plans can only be used by the same version of rocFFT
+ *  on a device with the same architecture, LDS size and compute unit
+ *  count as the one that wrote them.  If the buffer was written by a
+ *  different version or device, or is otherwise unusable, ::rocfft_status_failure is returned and no
+ *  plan is created.  The caller can then create the plan with
+ *  ::rocfft_plan_create instead.
+ *  @param[out] plan plan handle
+ *  @param[in] buffer serialized plan
+ *  @param[in] buffer_len_bytes length of buffer in bytes
+ *  */
+ROCFFT_EXPORT rocfft_status rocfft_plan_deserialize(rocfft_plan* plan,
+                                                    const void*  buffer,
+                                                    size_t       buffer_len_bytes);
+
 /*! @brief Create plan description
  *  @details This API creates a plan description with which the user
  * can set extra plan properties.  The plan description must be freed
@@ -350,8 +589,10 @@ ROCFFT_EXPORT rocfft_status rocfft_execution_info_destroy(rocfft_execution_info
  *
  *  If a work buffer is required for the transform but is not
  *  specified using this function, ::rocfft_execute will automatically
- *  allocate the required buffer and free it when execution is
- *  finished.
+ *  borrow the required buffer from a pool managed by the library.
+ *  Pooled buffers are reused by later executions on the same device
+ *  and stream, and are released by ::rocfft_work_buffer_pool_trim and
+ *  ::rocfft_cleanup.
  *
  *  Users should allocate their own work buffers if they need precise
  *  control over the lifetimes of those buffers, or if multiple plans
@@ -365,6 +606,38 @@ ROCFFT_EXPORT rocfft_status rocfft_execution_info_set_work_buffer(rocfft_executi
                                                                   void*                 work_buffer,
                                                                   const size_t size_in_bytes);
 
+/*! @brief Release pooled work buffers
+ *  @details Free work buffers that ::rocfft_execute allocated
+ *  automatically and kept for reuse, until at most keep_bytes of
+ *  unused buffers remain on each device.  Buffers in use by
+ *  executing transforms are not affected.
+ *
+ *  The amount of unused memory the pool keeps per device can also
+ *  be limited with the ROCFFT_WORK_BUFFER_POOL_SIZE environment
+ *  variable, which is read by ::rocfft_setup.
+ *  @param[in] keep_bytes bytes of unused buffers to keep on each device; 0 frees them all
+ *  */
+ROCFFT_EXPORT rocfft_status rocfft_work_buffer_pool_trim(size_t keep_bytes);
+
+/*! @brief Get twiddle table memory statistics
+ *
+ *  @details Get the number of device buffers holding twiddle tables
+ *  on the given device, their total size in bytes, and the number of
+ *  distinct tables served from them.  Plans with the same tables
+ *  share them, and a table contained in another (for example, one
+ *  dimension of a 2D table) is served as part of it, so the number
+ *  of tables can exceed the number of buffers.  Any output pointer
+ *  may be null, in which case that statistic is not returned.
+ *  @param[in] device_id HIP device ordinal
+ *  @param[out] buffers number of twiddle buffers
+ *  @param[out] size_bytes total size of twiddle buffers
+ *  @param[out] tables number of distinct tables in use
+ *  */
+ROCFFT_EXPORT rocfft_status rocfft_twiddle_get_stats(int     device_id,
+                                                     size_t* buffers,
+                                                     size_t* size_bytes,
+                                                     size_t* tables);
+
 #if 0
 /*! @brief Set execution mode in execution info
  *  @details This is one of the execution info functions to specify optional additional information to control execution.
@@ -393,6 +666,27 @@ ROCFFT_EXPORT rocfft_status rocfft_execution_info_set_mode( rocfft_execution_inf
 ROCFFT_EXPORT rocfft_status rocfft_execution_info_set_stream(rocfft_execution_info info,
                                                              void*                 stream);
 
+/*! @brief Set launch mode in execution info
+ *  @details Chooses how ::rocfft_execute launches the kernels of a
+ *  plan.  With ::rocfft_launch_mode_graph, the kernels are recorded
+ *  into a HIP graph the first time the plan is executed with a given
+ *  set of input, output and work buffers, stream and callbacks.
+ *  Later executions of the plan with all of those unchanged launch
+ *  the recorded graph, costing one submission instead of one per
+ *  kernel.  Recording happens on a separate stream, so any stream,
+ *  including the null stream, may be used for execution.
+ *
+ *  Graphs are not used while profile or kernel I/O logging is
+ *  enabled, since those need to see each kernel separately.  If a
+ *  recorded graph does not have exactly one node per kernel, it is
+ *  discarded and the kernels are launched one at a time instead.
+ *
+ *  @param[in] info execution info handle
+ *  @param[in] mode launch mode
+ *  */
+ROCFFT_EXPORT rocfft_status rocfft_execution_info_set_launch_mode(rocfft_execution_info info,
+                                                                  rocfft_launch_mode    mode);
+
 /*! @brief Set a load callback for a plan execution (experimental)
  *  @details This function specifies a user-defined callback function
  *  that is run to load input from global memory at the start of the
@@ -508,6 +802,44 @@ ROCFFT_EXPORT rocfft_status rocfft_cache_buffer_free(void* buffer);
  *  this operation.  The cache is unmodified if either a null buffer
  *  pointer or a zero length is passed. */
 ROCFFT_EXPORT rocfft_status rocfft_cache_deserialize(const void* buffer, size_t buffer_len_bytes);
+
+/*! @brief Get compiled kernel cache statistics
+
+ *  @details Get the number of kernels in the user-level kernel
+ *  cache and the total size in bytes of their compiled code and the
+ *  cached twiddle tables, as well as the number of cache hits and
+ *  misses, and the compile time in milliseconds that cache hits
+ *  have saved, since the library was set up.  Any output pointer may be null, in which case that
+ *  statistic is not returned. */
+ROCFFT_EXPORT rocfft_status rocfft_cache_get_stats(size_t* entries,
+                                                   size_t* size_bytes,
+                                                   size_t* hits,
+                                                   size_t* misses,
+                                                   double* time_saved_ms);
+
+/*! @brief Compile the kernels a plan needs into the kernel cache
+
+ *  @details Decide how a plan with the given parameters would be
+ *  built for the GPU architecture named by gpu_arch, and compile
+ *  every kernel that the plan needs at runtime into the compiled
+ *  kernel cache.  No plan is returned, and no GPU is used.
+ *
+ *  gpu_arch must be the full architecture name reported by the
+ *  target device, including any feature flags (for example,
+ *  "gfx90a:sramecc+:xnack-").  The other parameters have the same
+ *  meaning as for ::rocfft_plan_create.
+ *
+ *  This allows caches for known workloads to be built ahead of
+ *  time, and imported with ::rocfft_cache_deserialize.  */
+ROCFFT_EXPORT rocfft_status
+    rocfft_cache_build_kernels(const char*                   gpu_arch,
+                               rocfft_result_placement       placement,
+                               rocfft_transform_type         transform_type,
+                               rocfft_precision              precision,
+                               size_t                        dimensions,
+                               const size_t*                 lengths,
+                               size_t                        number_of_transforms,
+                               const rocfft_plan_description description);
 #endif
 
 #ifdef __cplusplus
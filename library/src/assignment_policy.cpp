@@ -19,32 +19,40 @@
 // THE SOFTWARE.
 
 #include "assignment_policy.h"
+#include "../../shared/environment.h"
 #include "../../shared/ptrdiff.h"
 #include "./device/kernels/array_format.h"
 #include "arithmetic.h"
 #include "logging.h"
+#include "perf_model.h"
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <map>
 #include <numeric>
 #include <optional>
 #include <set>
+#include <tuple>
 
-void PlacementTrace::Print(rocfft_ostream& os)
+void PlacementTrace::PrintPath(rocfft_ostream& os)
 {
     if(parent->curNode)
     {
-        parent->Print(os);
+        parent->PrintPath(os);
         os << " --> ";
     }
 
     os << "[ " << PrintScheme(curNode->scheme).c_str();
     os << ": " << PrintOperatingBufferCode(inBuf) << "->" << PrintOperatingBufferCode(outBuf);
     os << " ]";
+}
 
-    if(branches.empty())
-    {
-        os << ": num-fused-kernels= " << parent->numFusedNodes;
-        os << ", num-inplace-kernels= " << parent->numInplace;
-        os << std::endl;
-    }
+void PlacementTrace::Print(rocfft_ostream& os)
+{
+    PrintPath(os);
+    os << ": num-fused-kernels= " << parent->numFusedNodes;
+    os << ", num-inplace-kernels= " << parent->numInplace;
+    os << std::endl;
 }
 
 size_t PlacementTrace::BackwardCalcFusions(ExecPlan&       execPlan,
@@ -92,7 +100,7 @@ size_t PlacementTrace::BackwardCalcFusions(ExecPlan&       execPlan,
 
 size_t PlacementTrace::NumUsedBuffers() const
 {
-    return usedBuffers.size();
+    return std::bitset<8 * sizeof(usedBuffers)>(usedBuffers).count();
 }
 
 void PlacementTrace::Backtracking(ExecPlan& execPlan, int execSeqID)
@@ -112,33 +120,6 @@ void PlacementTrace::Backtracking(ExecPlan& execPlan, int execSeqID)
     // correct array type of callback, since it could be marked as CI during the process
     if(node->scheme == CS_KERNEL_APPLY_CALLBACK)
         node->outArrayType = node->inArrayType = rocfft_array_type_real;
-    // correct the obIn to S buffer, not really use the input buffer just for distinguishing
-    if(node->scheme == CS_KERNEL_CHIRP)
-    {
-        node->obIn      = OB_TEMP_BLUESTEIN;
-        node->placement = rocfft_placement_inplace;
-    }
-
-    // for nodes that uses bluestein buffer
-    auto setBluesteinOffset = [node](size_t& offset) {
-        for(auto p = node->parent; p != nullptr; p = p->parent)
-        {
-            if(p->iOffset)
-            {
-                offset = p->iOffset;
-                break;
-            }
-            else if(p->oOffset)
-            {
-                offset = p->oOffset;
-                break;
-            }
-        }
-    };
-    if(node->obIn == OB_TEMP_BLUESTEIN)
-        setBluesteinOffset(node->iOffset);
-    if(node->obOut == OB_TEMP_BLUESTEIN)
-        setBluesteinOffset(node->oOffset);
 
     if(execSeqID > 0)
     {
@@ -279,11 +260,11 @@ bool AssignmentPolicy::ValidOutBuffer(ExecPlan&           execPlan,
         test_result = true;
     }
     // bluestein nodes must write to temp bluestein buffer
-    else if(node.scheme == CS_KERNEL_CHIRP || node.scheme == CS_KERNEL_PAD_MUL)
+    else if(node.scheme == CS_KERNEL_PAD_MUL)
     {
         test_result = (buffer == OB_TEMP_BLUESTEIN);
     }
-    // More requirement for Bluestein: the 7 component-nodes need to output to bluestein buffer
+    // More requirement for Bluestein: the 5 component-nodes need to output to bluestein buffer
     // except for the last RES_MUL
     else if(node.IsLastLeafNodeOfBluesteinComponent() && node.scheme != CS_KERNEL_RES_MUL)
     {
@@ -367,6 +348,151 @@ bool AssignmentPolicy::CheckAssignmentValid(ExecPlan& execPlan)
     return true;
 }
 
+std::unique_ptr<AssignmentCostModel> AssignmentCostModel::Create(rocfft_optimize_strategy strategy)
+{
+    switch(strategy)
+    {
+    case rocfft_optimize_min_buffer:
+        return std::make_unique<TrafficCostModel>(true);
+    case rocfft_optimize_balance:
+        return std::make_unique<RankedCostModel>();
+    case rocfft_optimize_max_fusion:
+        return std::make_unique<TrafficCostModel>(false);
+    }
+    throw std::runtime_error("unknown optimize strategy");
+}
+
+void RankedCostModel::Rank(const ExecPlan& execPlan, std::vector<PlacementTrace*>& candidates) const
+{
+    std::sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) {
+        // compare numFusedNodes (more is better)
+        if(lhs->numFusedNodes > rhs->numFusedNodes)
+            return true;
+        if(lhs->numFusedNodes < rhs->numFusedNodes)
+            return false;
+
+        // if tie, we still choose the one with less buffers
+        if(lhs->NumUsedBuffers() < rhs->NumUsedBuffers())
+            return true;
+        if(lhs->NumUsedBuffers() > rhs->NumUsedBuffers())
+            return false;
+
+        // once we do have temp buffers, more temp ops that have
+        // better opportunities for padding are generally better,
+        // since we can avoid more bad memory access patterns
+        auto leftTempOps  = lhs->NumPaddableTempOps();
+        auto rightTempOps = rhs->NumPaddableTempOps();
+        if(leftTempOps != rightTempOps)
+            return leftTempOps > rightTempOps;
+
+        // if tie, we still choose the one with more inplace
+        if(lhs->numInplace > rhs->numInplace)
+            return true;
+        if(lhs->numInplace < rhs->numInplace)
+            return false;
+
+        // if tie, compare numTypeSwitching (less is better)
+        return lhs->numTypeSwitching < rhs->numTypeSwitching;
+    });
+}
+
+size_t PlacementCost::Score() const
+{
+    return bytesMoved + numKernels * launchCostBytes;
+}
+
+PlacementCost TrafficCostModel::Estimate(const ExecPlan& execPlan, const PlacementTrace& leaf)
+{
+    const auto& execSeq   = execPlan.execSeq;
+    auto        precision = execPlan.rootPlan->precision;
+
+    // collect the path from the root, one trace per node in execSeq
+    std::vector<const PlacementTrace*> path(execSeq.size());
+    size_t                             idx = execSeq.size();
+    for(auto trace = &leaf; trace && trace->curNode; trace = trace->parent)
+    {
+        if(idx == 0)
+            throw std::runtime_error("placement trace longer than execution sequence");
+        path[--idx] = trace;
+    }
+    if(idx != 0)
+        throw std::runtime_error("placement trace shorter than execution sequence");
+
+    PlacementCost cost;
+    cost.launchCostBytes = DeviceModel::FromDeviceProp(execPlan.deviceProp).LaunchCostBytes();
+
+    std::vector<size_t>               inBytes(path.size());
+    std::vector<size_t>               outBytes(path.size());
+    std::map<OperatingBuffer, size_t> tempBytes;
+    for(size_t i = 0; i < path.size(); ++i)
+    {
+        const TreeNode& node = *path[i]->curNode;
+        inBytes[i] = data_size_bytes(node.length, precision, path[i]->iType) * node.batch;
+        outBytes[i]
+            = data_size_bytes(node.GetOutputLength(), precision, path[i]->oType) * node.batch;
+
+        cost.bytesMoved += inBytes[i] + outBytes[i];
+        ++cost.numKernels;
+
+        auto outBuf = path[i]->outBuf;
+        if(outBuf == OB_TEMP || outBuf == OB_TEMP_CMPLX_FOR_REAL)
+            tempBytes[outBuf] = std::max(tempBytes[outBuf], outBytes[i]);
+    }
+    for(const auto& t : tempBytes)
+        cost.workBytes += t.second;
+
+    // fused kernels don't launch separately, and don't write their
+    // intermediate results to memory
+    std::vector<bool> fusedBoundary(path.size());
+    for(const auto& shim : execPlan.fuseShims)
+    {
+        auto nodeIndex = [&path](const TreeNode* node) {
+            auto it = std::find_if(path.begin(), path.end(), [node](const PlacementTrace* trace) {
+                return trace->curNode == node;
+            });
+            return static_cast<size_t>(std::distance(path.begin(), it));
+        };
+        size_t first = nodeIndex(shim->FirstFuseNode());
+        size_t last  = nodeIndex(shim->LastFuseNode());
+        if(first >= last || last >= path.size())
+            continue;
+        if(!shim->PlacementFusable(path[first]->inBuf, path[first]->outBuf, path[last]->outBuf))
+            continue;
+        for(size_t i = first; i < last; ++i)
+        {
+            if(fusedBoundary[i])
+                continue;
+            fusedBoundary[i] = true;
+            --cost.numKernels;
+            cost.bytesMoved -= outBytes[i] + inBytes[i + 1];
+        }
+    }
+    return cost;
+}
+
+void TrafficCostModel::Rank(const ExecPlan&               execPlan,
+                            std::vector<PlacementTrace*>& candidates) const
+{
+    // start from the fixed order, so that candidates that cost the
+    // same keep their relative ranking
+    RankedCostModel().Rank(execPlan, candidates);
+
+    std::map<const PlacementTrace*, PlacementCost> costs;
+    for(auto c : candidates)
+        costs[c] = Estimate(execPlan, *c);
+
+    std::stable_sort(
+        candidates.begin(), candidates.end(), [this, &costs](const auto& lhs, const auto& rhs) {
+            const auto& lhsCost = costs[lhs];
+            const auto& rhsCost = costs[rhs];
+            if(workBufferFirst)
+                return std::make_tuple(lhsCost.workBytes, lhsCost.Score())
+                       < std::make_tuple(rhsCost.workBytes, rhsCost.Score());
+            return std::make_tuple(lhsCost.Score(), lhsCost.workBytes)
+                   < std::make_tuple(rhsCost.Score(), rhsCost.workBytes);
+        });
+}
+
 void AssignmentPolicy::UpdateWinnerFromValidPaths(ExecPlan& execPlan)
 {
     if(winnerCandidates.empty())
@@ -375,37 +501,23 @@ void AssignmentPolicy::UpdateWinnerFromValidPaths(ExecPlan& execPlan)
     // std::cout << "total candidates: " << winnerCandidates.size() << std::endl;
 
     // sort the candidate, front is the best
-    std::sort(
-        winnerCandidates.begin(), winnerCandidates.end(), [](const auto& lhs, const auto& rhs) {
-            // compare numFusedNodes (more is better)
-            if(lhs->numFusedNodes > rhs->numFusedNodes)
-                return true;
-            if(lhs->numFusedNodes < rhs->numFusedNodes)
-                return false;
-
-            // if tie, we still choose the one with less buffers
-            if(lhs->NumUsedBuffers() < rhs->NumUsedBuffers())
-                return true;
-            if(lhs->NumUsedBuffers() > rhs->NumUsedBuffers())
-                return false;
-
-            // once we do have temp buffers, more temp ops that have
-            // better opportunities for padding are generally better,
-            // since we can avoid more bad memory access patterns
-            auto leftTempOps  = lhs->NumPaddableTempOps();
-            auto rightTempOps = rhs->NumPaddableTempOps();
-            if(leftTempOps != rightTempOps)
-                return leftTempOps > rightTempOps;
-
-            // if tie, we still choose the one with more inplace
-            if(lhs->numInplace > rhs->numInplace)
-                return true;
-            if(lhs->numInplace < rhs->numInplace)
-                return false;
+    AssignmentCostModel::Create(execPlan.assignOptStrategy)->Rank(execPlan, winnerCandidates);
 
-            // if tie, compare numTypeSwitching (less is better)
-            return lhs->numTypeSwitching < rhs->numTypeSwitching;
-        });
+    if(LOG_PLAN_ENABLED())
+    {
+        // log the traffic estimate of each candidate, whichever
+        // model ranked them
+        auto& os = *LogSingleton::GetInstance().GetPlanOS();
+        os << "Assignment candidates, best first (fused nodes, kernels, bytes moved, work bytes, "
+              "score):"
+           << std::endl;
+        for(auto candidate : winnerCandidates)
+        {
+            auto cost = TrafficCostModel::Estimate(execPlan, *candidate);
+            os << "  " << candidate->numFusedNodes << ", " << cost.numKernels << ", "
+               << cost.bytesMoved << ", " << cost.workBytes << ", " << cost.Score() << std::endl;
+        }
+    }
 
     for(auto& winner : winnerCandidates)
     {
@@ -441,6 +553,9 @@ bool AssignmentPolicy::AssignBuffers(ExecPlan& execPlan)
     numCurWinnerFusions = -1; // no winner yet
     mustUseTBuffer      = false;
     mustUseCBuffer      = false;
+    // search every path, to check that pruning doesn't change the
+    // chosen assignment
+    exhaustiveSearch = !rocfft_getenv("ROCFFT_ASSIGN_BUFFERS_EXHAUSTIVE").empty();
 
     // remember to clear the container either in the beginning or at the end
     winnerCandidates.clear();
@@ -448,6 +563,10 @@ bool AssignmentPolicy::AssignBuffers(ExecPlan& execPlan)
     availableArrayTypes.clear();
     node_buf_test_cache.clear();
 
+    shimsEndingAt.clear();
+    for(auto shim : execPlan.fuseShims)
+        shimsEndingAt[shim->LastFuseNode()].push_back(shim);
+
     // Start from a minimal requirement; // in, out buffer
     availableBuffers.insert(execPlan.rootPlan->obIn);
     availableBuffers.insert(execPlan.rootPlan->obOut);
@@ -473,7 +592,7 @@ bool AssignmentPolicy::AssignBuffers(ExecPlan& execPlan)
 
     // look for nodes that imply presence of other buffers (bluestein)
     RecursiveTraverse(execPlan.rootPlan.get(), [this](TreeNode* n) {
-        if(n->scheme == CS_KERNEL_CHIRP)
+        if(n->scheme == CS_BLUESTEIN)
         {
             availableBuffers.insert(OB_TEMP_BLUESTEIN);
             availableArrayTypes.insert(rocfft_array_type_complex_interleaved);
@@ -484,7 +603,7 @@ bool AssignmentPolicy::AssignBuffers(ExecPlan& execPlan)
     PlacementTrace dummyRoot;
     dummyRoot.outBuf = execPlan.rootPlan->obIn;
     dummyRoot.oType  = aliasInType;
-    Enumerate(&dummyRoot, execPlan, 0, dummyRoot.outBuf, dummyRoot.oType);
+    Search(dummyRoot, execPlan);
     // update num-of-winner's-fusions from winnerCandidates list
     UpdateWinnerFromValidPaths(execPlan);
     if(numCurWinnerFusions != -1)
@@ -504,9 +623,7 @@ bool AssignmentPolicy::AssignBuffers(ExecPlan& execPlan)
     //    (strategy > rocfft_optimize_min_buffer)
     mustUseTBuffer = true;
     availableBuffers.insert(OB_TEMP);
-    dummyRoot.branches.clear();
-    winnerCandidates.clear();
-    Enumerate(&dummyRoot, execPlan, 0, dummyRoot.outBuf, dummyRoot.oType);
+    Search(dummyRoot, execPlan);
     // NB:
     //   in this ABT try, winnerCandidates must contain T-buf (mustUseTBuffer=true)
     //   and it's possible winnerCandidates is empty because there is no new path giving more fusions.
@@ -527,9 +644,7 @@ bool AssignmentPolicy::AssignBuffers(ExecPlan& execPlan)
     mustUseCBuffer = true;
     availableBuffers.insert(OB_TEMP_CMPLX_FOR_REAL);
     availableArrayTypes.insert(rocfft_array_type_complex_interleaved);
-    dummyRoot.branches.clear();
-    winnerCandidates.clear();
-    Enumerate(&dummyRoot, execPlan, 0, dummyRoot.outBuf, dummyRoot.oType);
+    Search(dummyRoot, execPlan);
     // NB:
     //   in this ABTC try, winnerCandidates must contain C-buf (mustUseCBuffer=true)
     UpdateWinnerFromValidPaths(execPlan);
@@ -541,7 +656,85 @@ bool AssignmentPolicy::AssignBuffers(ExecPlan& execPlan)
     return false;
 }
 
-void AssignmentPolicy::Enumerate(PlacementTrace*   parent,
+void AssignmentPolicy::Search(PlacementTrace& dummyRoot, ExecPlan& execPlan)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // traces from a previous search are no longer needed, and dead
+    // states may be reachable with the new buffers
+    winnerCandidates.clear();
+    traces.clear();
+    deadStates.clear();
+    numPrunedPaths = 0;
+
+    Enumerate(&dummyRoot, execPlan, 0, dummyRoot.outBuf, dummyRoot.oType);
+
+    if(LOG_PROFILE_ENABLED())
+    {
+        std::chrono::duration<double, std::milli> duration
+            = std::chrono::steady_clock::now() - start;
+        log_profile("assign_buffers",
+                    "buffers",
+                    availableBuffers.size(),
+                    "traces",
+                    traces.size(),
+                    "pruned",
+                    numPrunedPaths,
+                    "candidates",
+                    winnerCandidates.size(),
+                    "duration_ms",
+                    duration.count());
+    }
+}
+
+PlacementTrace* AssignmentPolicy::AddTrace(TreeNode*         curNode,
+                                           OperatingBuffer   inBuf,
+                                           OperatingBuffer   outBuf,
+                                           rocfft_array_type inType,
+                                           rocfft_array_type outType,
+                                           PlacementTrace*   parent)
+{
+    traces.emplace_back(curNode, inBuf, outBuf, inType, outType, parent);
+    PlacementTrace* trace = &traces.back();
+
+    // this node completes some shims, so we know whether they can
+    // be fused with this path
+    auto shims = shimsEndingAt.find(curNode);
+    if(shims != shimsEndingAt.end())
+    {
+        for(auto shim : shims->second)
+        {
+            auto first = trace->parent;
+            while(first && first->curNode && first->curNode != shim->FirstFuseNode())
+                first = first->parent;
+            if(first && first->curNode
+               && !shim->PlacementFusable(first->inBuf, first->outBuf, trace->outBuf))
+                ++trace->numUnfusableShims;
+        }
+    }
+    return trace;
+}
+
+bool AssignmentPolicy::Descend(PlacementTrace*   trace,
+                               ExecPlan&         execPlan,
+                               size_t            curSeqID,
+                               OperatingBuffer   startBuf,
+                               rocfft_array_type startType)
+{
+    // every path through this trace would be rejected at the end for
+    // not outdoing the winner of the prev. try, so don't grow it.
+    // report it as reaching the end, since we don't know otherwise.
+    if(!exhaustiveSearch && numCurWinnerFusions >= 0
+       && static_cast<int>(execPlan.fuseShims.size() - trace->numUnfusableShims)
+              <= numCurWinnerFusions)
+    {
+        ++numPrunedPaths;
+        return true;
+    }
+    return Enumerate(trace, execPlan, curSeqID, startBuf, startType);
+}
+
+bool AssignmentPolicy::Enumerate(PlacementTrace*   parent,
                                  ExecPlan&         execPlan,
                                  size_t            curSeqID,
                                  OperatingBuffer   startBuf,
@@ -558,58 +751,45 @@ void AssignmentPolicy::Enumerate(PlacementTrace*   parent,
         auto endArrayType = execPlan.rootPlan->outArrayType;
 
         // the out buf and array type must match
-        if(parent->outBuf == endBuf && EquivalentArrayType(endArrayType, parent->oType))
-        {
-            // we are in the second try (adding T Buffer) but we don't have it in the path:
-            // this means we've already tried this path in the previous try.
-            if(mustUseTBuffer && parent->usedBuffers.count(OB_TEMP) == 0)
-                return;
-
-            // we are in the third try (adding C Buffer) but we don't have it in the path:
-            // this means we've already tried this path in the previous try.
-            if(mustUseCBuffer && parent->usedBuffers.count(OB_TEMP_CMPLX_FOR_REAL) == 0)
-                return;
+        if(parent->outBuf != endBuf || !EquivalentArrayType(endArrayType, parent->oType))
+            return false;
 
-            // See how many fusions can be done in this path
-            int numFusions = parent->BackwardCalcFusions(execPlan, fuseShims.size() - 1, nullptr);
-            // skip it if this doesn't outdo the winner of prev. try (prev try = fewer buffers)
-            if(numCurWinnerFusions >= numFusions)
-                return;
+        // we are in the second try (adding T Buffer) but we don't have it in the path:
+        // this means we've already tried this path in the previous try.
+        if(mustUseTBuffer && !(parent->usedBuffers & OB_TEMP))
+            return true;
 
-            // set the oType to its original type of RootPlan (for example, change internal-CP to HP)
-            parent->oType = endArrayType;
+        // we are in the third try (adding C Buffer) but we don't have it in the path:
+        // this means we've already tried this path in the previous try.
+        if(mustUseCBuffer && !(parent->usedBuffers & OB_TEMP_CMPLX_FOR_REAL))
+            return true;
 
-            winnerCandidates.emplace_back(parent);
-            // debug
-            // parent->Print(*LogSingleton::GetInstance().GetTraceOS());
-        }
-        return;
-    }
+        // See how many fusions can be done in this path
+        int numFusions = parent->BackwardCalcFusions(execPlan, fuseShims.size() - 1, nullptr);
+        // skip it if this doesn't outdo the winner of prev. try (prev try = fewer buffers)
+        if(numCurWinnerFusions >= numFusions)
+            return true;
 
-    TreeNode* curNode = execSeq[curSeqID];
+        // set the oType to its original type of RootPlan (for example, change internal-CP to HP)
+        parent->oType = endArrayType;
 
-    // For chirp scheme, the startBuf/AType can differ from parent's, so we don't do this
-    // auto startBuf  = parent->outBuf;
-    // auto startType = parent->oType;
+        winnerCandidates.emplace_back(parent);
+        // debug
+        // parent->Print(*LogSingleton::GetInstance().GetTraceOS());
+        return true;
+    }
 
-    if(curNode->scheme == CS_KERNEL_CHIRP)
+    // the rest of the sequence depends only on where we start, so
+    // don't search again from a start that is known to go nowhere
+    NodeBufTestCacheKey state{curSeqID, startBuf, startType};
+    if(!exhaustiveSearch && deadStates.count(state))
     {
-        // chirp kernel can output to bluestein buffer only,
-        // and it doesn't take input buffer, so pass the startBuf buffer to the next node
-        // note that input buffer and array type is irrelevant for chirp
-        // Create/Push a PlacementTrace for Chirp:
-        parent->branches.emplace_back(
-            std::make_unique<PlacementTrace>(curNode,
-                                             startBuf,
-                                             OB_TEMP_BLUESTEIN,
-                                             startType,
-                                             rocfft_array_type_complex_interleaved,
-                                             parent));
-        // advance to next
-        // NOTE that it is important we propagate startBuf, startType to next node
-        Enumerate(parent->branches.back().get(), execPlan, curSeqID + 1, startBuf, startType);
-        return;
+        ++numPrunedPaths;
+        return false;
     }
+    bool reachedEnd = false;
+
+    TreeNode* curNode = execSeq[curSeqID];
 
     // Branch of using inplace, any node dis-alllowing inplace will skip this
     if(curNode->isPlacementAllowed(rocfft_placement_inplace))
@@ -621,11 +801,9 @@ void AssignmentPolicy::Enumerate(PlacementTrace*   parent,
             if(ValidOutBuffer(execPlan, cKey, *curNode, startBuf, startType))
             {
                 // Create/Push a PlacementTrace for an Inplace-Operation (others recurs)
-                parent->branches.emplace_back(std::make_unique<PlacementTrace>(
-                    curNode, startBuf, startBuf, startType, startType, parent));
+                auto trace = AddTrace(curNode, startBuf, startBuf, startType, startType, parent);
                 // advance to next
-                Enumerate(
-                    parent->branches.back().get(), execPlan, curSeqID + 1, startBuf, startType);
+                reachedEnd |= Descend(trace, execPlan, curSeqID + 1, startBuf, startType);
             }
         }
     }
@@ -647,18 +825,19 @@ void AssignmentPolicy::Enumerate(PlacementTrace*   parent,
                 if(ValidOutBuffer(execPlan, cKey, *curNode, testOutputBuf, testOutType))
                 {
                     // Create/Push a PlacementTrace for OuOfPlace-Operation (others recurs)
-                    parent->branches.emplace_back(std::make_unique<PlacementTrace>(
-                        curNode, startBuf, testOutputBuf, startType, testOutType, parent));
+                    auto trace = AddTrace(
+                        curNode, startBuf, testOutputBuf, startType, testOutType, parent);
                     // advance to next
-                    Enumerate(parent->branches.back().get(),
-                              execPlan,
-                              curSeqID + 1,
-                              testOutputBuf,
-                              testOutType);
+                    reachedEnd |= Descend(
+                        trace, execPlan, curSeqID + 1, testOutputBuf, testOutType);
                 }
             } // end of testing each array type
         } // end of testing each out buffer
     } // end of out-of-place
+
+    if(!reachedEnd)
+        deadStates.insert(state);
+    return reachedEnd;
 }
 
 // Lengths/strides on tree nodes are usually (but not always) fastest
@@ -992,10 +1171,6 @@ void CollectTempBufOps(TreeNode&               node,
         // using the buffer
         for(auto& child : node.childNodes)
         {
-            // chirps don't connect to anything, so skip them
-            if(child->scheme == CS_KERNEL_CHIRP)
-                continue;
-
             // Once a child stops using this temp buffer, stop
             // looking at children and return so we don't consider
             // this node's output either (since even if obOut is the
@@ -22,11 +22,16 @@
 
 #include "../../shared/environment.h"
 #include "logging.h"
+#include "plan_cache.h"
 #include "repo.h"
 #include "rocfft.h"
 #include "rocfft_hip.h"
 #include "rocfft_ostream.hpp"
+#include "rtc.h"
 #include "rtc_cache.h"
+#include "rtc_compile_queue.h"
+#include "scheme_table.h"
+#include "work_buffer_pool.h"
 #include <fcntl.h>
 #include <memory>
 
@@ -81,7 +86,11 @@ rocfft_status rocfft_setup()
 
 #ifdef ROCFFT_RUNTIME_COMPILE
     RTCCache::single = std::make_unique<RTCCache>();
+    CompileQueue::Setup();
+    RTCKernel::SetupHelpers();
 #endif
+    PlanCache::Setup();
+    WorkBufferPool::Setup();
 
     // set layer_mode from value of environment variable ROCFFT_LAYER
     auto str_layer_mode = rocfft_getenv("ROCFFT_LAYER");
@@ -126,10 +135,19 @@ rocfft_status rocfft_cleanup()
 {
     log_trace(__func__);
 
-    // close the RTC cache and clear the repo, so that subsequent
+    // close the RTC cache and clear the plan cache, repo, work
+    // buffer pool and tuned schemes, so that subsequent
     // rocfft_setup() + plan creation will start from scratch
+    PlanCache::Clear();
     Repo::Clear();
+    WorkBufferPool::Clear();
+    SchemeTable::Reset();
 #ifdef ROCFFT_RUNTIME_COMPILE
+    // compile threads hold on to the log streams that are about to
+    // be closed
+    CompileQueue::Stop();
+    // helper processes are idle once the queue has stopped
+    RTCKernel::StopHelpers();
     RTCCache::single.reset();
 #endif
 
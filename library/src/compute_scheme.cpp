@@ -21,6 +21,7 @@
 #include "compute_scheme.h"
 
 #include <map>
+#include <stdexcept>
 
 #define TO_STR2(x) #x
 #define TO_STR(x) TO_STR2(x)
@@ -55,10 +56,10 @@ static const std::map<ComputeScheme, const char*>& ComputeSchemetoStringMap()
            {ENUMSTR(CS_KERNEL_TRANSPOSE_CMPLX_TO_R)},
            {ENUMSTR(CS_REAL_2D_EVEN)},
            {ENUMSTR(CS_REAL_3D_EVEN)},
+           {ENUMSTR(CS_REAL_ND_EVEN)},
            {ENUMSTR(CS_KERNEL_APPLY_CALLBACK)},
 
            {ENUMSTR(CS_BLUESTEIN)},
-           {ENUMSTR(CS_KERNEL_CHIRP)},
            {ENUMSTR(CS_KERNEL_PAD_MUL)},
            {ENUMSTR(CS_KERNEL_FFT_MUL)},
            {ENUMSTR(CS_KERNEL_RES_MUL)},
@@ -80,7 +81,9 @@ static const std::map<ComputeScheme, const char*>& ComputeSchemetoStringMap()
            {ENUMSTR(CS_3D_BLOCK_CR)},
            {ENUMSTR(CS_3D_RC)},
            {ENUMSTR(CS_KERNEL_3D_STOCKHAM_BLOCK_CC)},
-           {ENUMSTR(CS_KERNEL_3D_SINGLE)}};
+           {ENUMSTR(CS_KERNEL_3D_SINGLE)},
+
+           {ENUMSTR(CS_ND_RC)}};
     return ComputeSchemetoString;
 }
 
@@ -88,3 +91,13 @@ std::string PrintScheme(ComputeScheme cs)
 {
     return ComputeSchemetoStringMap().at(cs);
 }
+
+ComputeScheme StrToComputeScheme(const std::string& str)
+{
+    for(const auto& i : ComputeSchemetoStringMap())
+    {
+        if(str == i.second)
+            return i.first;
+    }
+    throw std::runtime_error("unknown compute scheme: " + str);
+}
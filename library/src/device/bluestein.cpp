@@ -23,83 +23,9 @@
 #include "rocfft_hip.h"
 #include <iostream>
 
-template <typename T>
-rocfft_status chirp_launch(size_t      N,
-                           size_t      M,
-                           T*          B,
-                           void*       twiddles_large,
-                           int         twl,
-                           int         dir,
-                           hipStream_t rocfft_stream,
-                           log_func_t  log_func)
-{
-    dim3 grid((M - N) / LAUNCH_BOUNDS_BLUESTEIN_KERNEL + 1);
-    dim3 threads(LAUNCH_BOUNDS_BLUESTEIN_KERNEL);
-
-    hipLaunchKernelGGL_shim(log_func,
-                            chirp_device<T>,
-                            dim3(grid),
-                            dim3(threads),
-                            0,
-                            rocfft_stream,
-                            N,
-                            M,
-                            B,
-                            (T*)twiddles_large,
-                            twl,
-                            dir);
-
-    return rocfft_status_success;
-}
-
-ROCFFT_DEVICE_EXPORT void rocfft_internal_chirp(const void* data_p, void* back_p)
-{
-    auto data = static_cast<const DeviceCallIn*>(data_p);
-
-    size_t N = data->node->length[0];
-    size_t M = data->node->lengthBlue;
-
-    int twl = 0;
-
-    if(data->node->large1D > (size_t)256 * 256 * 256 * 256)
-        printf("large1D twiddle size too large error");
-    else if(data->node->large1D > (size_t)256 * 256 * 256)
-        twl = 4;
-    else if(data->node->large1D > (size_t)256 * 256)
-        twl = 3;
-    // TODO- possibly using a smaller LargeTwdBase for chirp by large_twiddle_base
-    else if(data->node->large1D > (size_t)256)
-        twl = 2;
-    else
-        twl = 1;
-
-    int dir = data->node->direction;
-
-    hipStream_t rocfft_stream = data->rocfft_stream;
-
-    if(data->node->precision == rocfft_precision_single)
-        chirp_launch<float2>(N,
-                             M,
-                             (float2*)data->bufOut[0],
-                             data->node->twiddles_large,
-                             twl,
-                             dir,
-                             rocfft_stream,
-                             data->log_func);
-    else
-        chirp_launch<double2>(N,
-                              M,
-                              (double2*)data->bufOut[0],
-                              data->node->twiddles_large,
-                              twl,
-                              dir,
-                              rocfft_stream,
-                              data->log_func);
-}
-
 // find the right "mul" kernel, checking callback type and/or scale factor
 template <typename T>
-auto get_mul_kernel_I_I(CallbackType cbtype, TreeNode* node)
+auto get_mul_kernel_I_I(CallbackType cbtype, const TreeNode* node)
 {
     if(cbtype == CallbackType::USER_LOAD_STORE)
     {
@@ -118,7 +44,7 @@ auto get_mul_kernel_I_I(CallbackType cbtype, TreeNode* node)
 }
 
 template <typename T>
-auto get_mul_kernel_I_P(TreeNode* node)
+auto get_mul_kernel_I_P(const TreeNode* node)
 {
     if(node->IsScalingEnabled())
         return mul_device_I_P<T, true>;
@@ -167,24 +93,12 @@ ROCFFT_DEVICE_EXPORT void rocfft_internal_mul(const void* data_p, void* back_p)
     // are good enough for current strategy(check TreeNode::ReviseLeafsArrayType).
     // That is why we add asserts below.
 
-    size_t numof = 0;
+    // the repo buffer holds the chirp, followed by its FFT for FFT_MUL
+    void* chirp = data->node->twiddles;
     if(scheme == 0)
-    {
-        bufIn0  = ((char*)bufIn0 + M * cBytes);
-        bufOut0 = ((char*)bufOut0 + 2 * M * cBytes);
-
-        numof = M;
-    }
-    else if(scheme == 1)
-    {
-        bufOut0 = ((char*)bufOut0 + M * cBytes);
+        chirp = ((char*)chirp + M * cBytes);
 
-        numof = M;
-    }
-    else if(scheme == 2)
-    {
-        numof = N;
-    }
+    size_t numof = scheme == 2 ? N : M;
 
     size_t count = data->node->batch;
     for(size_t i = 1; i < data->node->length.size(); i++)
@@ -217,6 +131,7 @@ ROCFFT_DEVICE_EXPORT void rocfft_internal_mul(const void* data_p, void* back_p)
                                     M,
                                     (const float2*)bufIn0,
                                     (float2*)bufOut0,
+                                    (const float2*)chirp,
                                     data->node->length.size(),
                                     kargs_lengths(data->node->devKernArg),
                                     kargs_stride_in(data->node->devKernArg),
@@ -244,6 +159,7 @@ ROCFFT_DEVICE_EXPORT void rocfft_internal_mul(const void* data_p, void* back_p)
                                     M,
                                     (const double2*)bufIn0,
                                     (double2*)bufOut0,
+                                    (const double2*)chirp,
                                     data->node->length.size(),
                                     kargs_lengths(data->node->devKernArg),
                                     kargs_stride_in(data->node->devKernArg),
@@ -281,6 +197,7 @@ ROCFFT_DEVICE_EXPORT void rocfft_internal_mul(const void* data_p, void* back_p)
                                     (const real_type_t<float2>*)bufIn0,
                                     (const real_type_t<float2>*)bufIn1,
                                     (float2*)bufOut0,
+                                    (const float2*)chirp,
                                     data->node->length.size(),
                                     kargs_lengths(data->node->devKernArg),
                                     kargs_stride_in(data->node->devKernArg),
@@ -304,6 +221,7 @@ ROCFFT_DEVICE_EXPORT void rocfft_internal_mul(const void* data_p, void* back_p)
                                     (const real_type_t<double2>*)bufIn0,
                                     (const real_type_t<double2>*)bufIn1,
                                     (double2*)bufOut0,
+                                    (const double2*)chirp,
                                     data->node->length.size(),
                                     kargs_lengths(data->node->devKernArg),
                                     kargs_stride_in(data->node->devKernArg),
@@ -336,6 +254,7 @@ ROCFFT_DEVICE_EXPORT void rocfft_internal_mul(const void* data_p, void* back_p)
                                     (const float2*)bufIn0,
                                     (real_type_t<float2>*)bufOut0,
                                     (real_type_t<float2>*)bufOut1,
+                                    (const float2*)chirp,
                                     data->node->length.size(),
                                     kargs_lengths(data->node->devKernArg),
                                     kargs_stride_in(data->node->devKernArg),
@@ -359,6 +278,7 @@ ROCFFT_DEVICE_EXPORT void rocfft_internal_mul(const void* data_p, void* back_p)
                                     (const double2*)bufIn0,
                                     (real_type_t<double2>*)bufOut0,
                                     (real_type_t<double2>*)bufOut1,
+                                    (const double2*)chirp,
                                     data->node->length.size(),
                                     kargs_lengths(data->node->devKernArg),
                                     kargs_stride_in(data->node->devKernArg),
@@ -393,6 +313,7 @@ ROCFFT_DEVICE_EXPORT void rocfft_internal_mul(const void* data_p, void* back_p)
                                     (const real_type_t<float2>*)bufIn1,
                                     (real_type_t<float2>*)bufOut0,
                                     (real_type_t<float2>*)bufOut1,
+                                    (const float2*)chirp,
                                     data->node->length.size(),
                                     kargs_lengths(data->node->devKernArg),
                                     kargs_stride_in(data->node->devKernArg),
@@ -417,6 +338,7 @@ ROCFFT_DEVICE_EXPORT void rocfft_internal_mul(const void* data_p, void* back_p)
                                     (const real_type_t<double2>*)bufIn1,
                                     (real_type_t<double2>*)bufOut0,
                                     (real_type_t<double2>*)bufOut1,
+                                    (const double2*)chirp,
                                     data->node->length.size(),
                                     kargs_lengths(data->node->devKernArg),
                                     kargs_stride_in(data->node->devKernArg),
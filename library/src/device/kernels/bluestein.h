@@ -29,53 +29,14 @@
 
 static const unsigned int LAUNCH_BOUNDS_BLUESTEIN_KERNEL = 64;
 
-template <typename T>
-__global__ void __launch_bounds__(LAUNCH_BOUNDS_BLUESTEIN_KERNEL)
-    chirp_device(const size_t N,
-                 const size_t M,
-                 T*           output,
-                 const T*     twiddles_large,
-                 const int    twl,
-                 const int    dir)
-{
-    size_t tx = threadIdx.x + blockIdx.x * blockDim.x;
-
-    T val = lib_make_vector2<T>(0, 0);
-
-    if(twl == 1)
-        val = TWLstep1(twiddles_large, (tx * tx) % (2 * N));
-    else if(twl == 2)
-        val = TWLstep2(twiddles_large, (tx * tx) % (2 * N));
-    else if(twl == 3)
-        val = TWLstep3(twiddles_large, (tx * tx) % (2 * N));
-    else if(twl == 4)
-        val = TWLstep4(twiddles_large, (tx * tx) % (2 * N));
-
-    val.y *= (real_type_t<T>)(dir);
-
-    if(tx == 0)
-    {
-        output[tx]     = val;
-        output[tx + M] = val;
-    }
-    else if(tx < N)
-    {
-        output[tx]     = val;
-        output[tx + M] = val;
-
-        output[M - tx]     = val;
-        output[M - tx + M] = val;
-    }
-    else if(tx <= (M - N))
-    {
-        output[tx]     = lib_make_vector2<T>(0, 0);
-        output[tx + M] = lib_make_vector2<T>(0, 0);
-    }
-}
-
 // mul_device takes care of fft_mul, pad_mul, and res_mul, which
 // are 3 steps in Bluestein algorithm. And In the below, we have
 // 4 similar functions to support interleaved and planar format.
+//
+// 'chirp' is the precomputed chirp filter for pad_mul and res_mul,
+// and the FFT of the chirp for fft_mul.  Data in the Bluestein
+// buffer is laid out like the input, with the convolution length
+// as the first dimension.
 
 template <typename T, CallbackType cbtype, bool SCALE = false>
 __global__ void __launch_bounds__(LAUNCH_BOUNDS_BLUESTEIN_KERNEL)
@@ -85,6 +46,7 @@ __global__ void __launch_bounds__(LAUNCH_BOUNDS_BLUESTEIN_KERNEL)
                    const size_t  M,
                    const T*      input,
                    T*            output,
+                   const T*      chirp,
                    const size_t  dim,
                    const size_t* lengths,
                    const size_t* stride_in,
@@ -129,30 +91,23 @@ __global__ void __launch_bounds__(LAUNCH_BOUNDS_BLUESTEIN_KERNEL)
 
     auto load_cb  = get_load_cb<T, cbtype>(load_cb_fn);
     auto store_cb = get_store_cb<T, cbtype>(store_cb_fn);
+
+    iIdx += iOffset;
+    oIdx += oOffset;
     if(scheme == 0)
     {
         // FFT_MUL is in the middle of bluestein and should never be
         // the first/last kernel to read/write global memory.  So we
         // don't need to run callbacks.
-        output += oOffset;
-
-        T out          = output[oIdx];
-        output[oIdx].x = input[iIdx].x * out.x - input[iIdx].y * out.y;
-        output[oIdx].y = input[iIdx].x * out.y + input[iIdx].y * out.x;
+        T in           = input[iIdx];
+        output[oIdx].x = in.x * chirp[tx].x - in.y * chirp[tx].y;
+        output[oIdx].y = in.x * chirp[tx].y + in.y * chirp[tx].x;
     }
     else if(scheme == 1)
     {
-        // PAD_MUL is the first non-chirp step of bluestein and
-        // should never be the last kernel to write global memory.
-        // So we should never need to run a "store" callback.
-
-        T* chirp = output;
-
-        iIdx += iOffset;
-
-        oIdx += M;
-        oIdx += oOffset;
-
+        // PAD_MUL is the first step of bluestein and should never be
+        // the last kernel to write global memory.  So we should never
+        // need to run a "store" callback.
         if(tx < N)
         {
             // callback might modify input, but otherwise it's const
@@ -170,14 +125,6 @@ __global__ void __launch_bounds__(LAUNCH_BOUNDS_BLUESTEIN_KERNEL)
         // RES_MUL is the last step of bluestein and
         // should never be the first kernel to read global memory.
         // So we should never need to run a "load" callback.
-
-        const T* chirp = input;
-
-        iIdx += 2 * M;
-        iIdx += iOffset;
-
-        oIdx += oOffset;
-
         real_type_t<T> MI = 1.0 / (real_type_t<T>)M;
         T              out_elem;
 
@@ -197,6 +144,7 @@ __global__ void __launch_bounds__(LAUNCH_BOUNDS_BLUESTEIN_KERNEL)
                    const real_type_t<T>* inputRe,
                    const real_type_t<T>* inputIm,
                    T*                    output,
+                   const T*              chirp,
                    const size_t          dim,
                    const size_t*         lengths,
                    const size_t*         stride_in,
@@ -234,24 +182,15 @@ __global__ void __launch_bounds__(LAUNCH_BOUNDS_BLUESTEIN_KERNEL)
     size_t iIdx = tx * stride_in[0];
     size_t oIdx = tx * stride_out[0];
 
+    iIdx += iOffset;
+    oIdx += oOffset;
     if(scheme == 0)
     {
-        output += oOffset;
-
-        T out          = output[oIdx];
-        output[oIdx].x = inputRe[iIdx] * out.x - inputIm[iIdx] * out.y;
-        output[oIdx].y = inputRe[iIdx] * out.y + inputIm[iIdx] * out.x;
+        output[oIdx].x = inputRe[iIdx] * chirp[tx].x - inputIm[iIdx] * chirp[tx].y;
+        output[oIdx].y = inputRe[iIdx] * chirp[tx].y + inputIm[iIdx] * chirp[tx].x;
     }
     else if(scheme == 1)
     {
-        T* chirp = output;
-
-        inputRe += iOffset;
-        inputIm += iOffset;
-
-        output += M;
-        output += oOffset;
-
         if(tx < N)
         {
             output[oIdx].x = inputRe[iIdx] * chirp[tx].x + inputIm[iIdx] * chirp[tx].y;
@@ -264,20 +203,9 @@ __global__ void __launch_bounds__(LAUNCH_BOUNDS_BLUESTEIN_KERNEL)
     }
     else if(scheme == 2)
     {
-        const real_type_t<T>* chirpRe = inputRe;
-        const real_type_t<T>* chirpIm = inputIm;
-
-        inputRe += 2 * M;
-        inputRe += iOffset;
-
-        inputIm += 2 * M;
-        inputIm += iOffset;
-
-        output += oOffset;
-
         real_type_t<T> MI = 1.0 / (real_type_t<T>)M;
-        output[oIdx].x    = MI * (inputRe[iIdx] * chirpRe[tx] + inputIm[iIdx] * chirpIm[tx]);
-        output[oIdx].y    = MI * (-inputRe[iIdx] * chirpIm[tx] + inputIm[iIdx] * chirpRe[tx]);
+        output[oIdx].x    = MI * (inputRe[iIdx] * chirp[tx].x + inputIm[iIdx] * chirp[tx].y);
+        output[oIdx].y    = MI * (-inputRe[iIdx] * chirp[tx].y + inputIm[iIdx] * chirp[tx].x);
         if(SCALE)
             output[oIdx] *= scale_factor;
     }
@@ -292,6 +220,7 @@ __global__ void __launch_bounds__(LAUNCH_BOUNDS_BLUESTEIN_KERNEL)
                    const T*             input,
                    real_type_t<T>*      outputRe,
                    real_type_t<T>*      outputIm,
+                   const T*             chirp,
                    const size_t         dim,
                    const size_t*        lengths,
                    const size_t*        stride_in,
@@ -329,32 +258,20 @@ __global__ void __launch_bounds__(LAUNCH_BOUNDS_BLUESTEIN_KERNEL)
     size_t iIdx = tx * stride_in[0];
     size_t oIdx = tx * stride_out[0];
 
+    iIdx += iOffset;
+    oIdx += oOffset;
     if(scheme == 0)
     {
-        outputRe += oOffset;
-        outputIm += oOffset;
-
-        T out          = lib_make_vector2<T>(outputRe[oIdx], outputIm[oIdx]);
-        outputRe[oIdx] = input[iIdx].x * out.x - input[iIdx].y * out.y;
-        outputIm[oIdx] = input[iIdx].x * out.y + input[iIdx].y * out.x;
+        T in           = input[iIdx];
+        outputRe[oIdx] = in.x * chirp[tx].x - in.y * chirp[tx].y;
+        outputIm[oIdx] = in.x * chirp[tx].y + in.y * chirp[tx].x;
     }
     else if(scheme == 1)
     {
-        real_type_t<T>* chirpRe = outputRe;
-        real_type_t<T>* chirpIm = outputIm;
-
-        input += iOffset;
-
-        outputRe += M;
-        outputRe += oOffset;
-
-        outputIm += M;
-        outputIm += oOffset;
-
         if(tx < N)
         {
-            outputRe[oIdx] = input[iIdx].x * chirpRe[tx] + input[iIdx].y * chirpIm[tx];
-            outputIm[oIdx] = -input[iIdx].x * chirpIm[tx] + input[iIdx].y * chirpRe[tx];
+            outputRe[oIdx] = input[iIdx].x * chirp[tx].x + input[iIdx].y * chirp[tx].y;
+            outputIm[oIdx] = -input[iIdx].x * chirp[tx].y + input[iIdx].y * chirp[tx].x;
         }
         else
         {
@@ -364,14 +281,6 @@ __global__ void __launch_bounds__(LAUNCH_BOUNDS_BLUESTEIN_KERNEL)
     }
     else if(scheme == 2)
     {
-        const T* chirp = input;
-
-        input += 2 * M;
-        input += iOffset;
-
-        outputRe += oOffset;
-        outputIm += oOffset;
-
         real_type_t<T> MI = 1.0 / (real_type_t<T>)M;
         outputRe[oIdx]    = MI * (input[iIdx].x * chirp[tx].x + input[iIdx].y * chirp[tx].y);
         if(SCALE)
@@ -392,6 +301,7 @@ __global__ void __launch_bounds__(LAUNCH_BOUNDS_BLUESTEIN_KERNEL)
                    const real_type_t<T>* inputIm,
                    real_type_t<T>*       outputRe,
                    real_type_t<T>*       outputIm,
+                   const T*              chirp,
                    const size_t          dim,
                    const size_t*         lengths,
                    const size_t*         stride_in,
@@ -429,59 +339,34 @@ __global__ void __launch_bounds__(LAUNCH_BOUNDS_BLUESTEIN_KERNEL)
     size_t iIdx = tx * stride_in[0];
     size_t oIdx = tx * stride_out[0];
 
+    iIdx += iOffset;
+    oIdx += oOffset;
     if(scheme == 0)
     {
-        outputRe += oOffset;
-        outputIm += oOffset;
-
-        T out          = lib_make_vector2<T>(outputRe[oIdx], outputIm[oIdx]);
-        outputRe[oIdx] = inputRe[iIdx] * out.x - inputIm[iIdx] * out.y;
-        outputIm[oIdx] = inputRe[iIdx] * out.y + inputIm[iIdx] * out.x;
+        T in           = lib_make_vector2<T>(inputRe[iIdx], inputIm[iIdx]);
+        outputRe[oIdx] = in.x * chirp[tx].x - in.y * chirp[tx].y;
+        outputIm[oIdx] = in.x * chirp[tx].y + in.y * chirp[tx].x;
     }
     else if(scheme == 1)
     {
-        real_type_t<T>* chirpRe = outputRe;
-        real_type_t<T>* chirpIm = outputIm;
-
-        inputRe += iOffset;
-        inputIm += iOffset;
-
-        outputRe += M;
-        outputRe += oOffset;
-
-        outputIm += M;
-        outputIm += oOffset;
-
         if(tx < N)
         {
-            outputRe[oIdx] = inputRe[iIdx] * chirpRe[tx] + inputIm[iIdx] * chirpIm[tx];
-            outputIm[oIdx] = -inputRe[iIdx] * chirpIm[tx] + inputIm[iIdx] * chirpRe[tx];
+            outputRe[oIdx] = inputRe[iIdx] * chirp[tx].x + inputIm[iIdx] * chirp[tx].y;
+            outputIm[oIdx] = -inputRe[iIdx] * chirp[tx].y + inputIm[iIdx] * chirp[tx].x;
         }
         else
         {
-            outputRe[tx] = 0;
-            outputIm[tx] = 0;
+            outputRe[oIdx] = 0;
+            outputIm[oIdx] = 0;
         }
     }
     else if(scheme == 2)
     {
-        const real_type_t<T>* chirpRe = inputRe;
-        const real_type_t<T>* chirpIm = inputIm;
-
-        inputRe += 2 * M;
-        inputRe += iOffset;
-
-        inputIm += 2 * M;
-        inputIm += iOffset;
-
-        outputRe += oOffset;
-        outputIm += oOffset;
-
         real_type_t<T> MI = 1.0 / (real_type_t<T>)M;
-        outputRe[oIdx]    = MI * (inputRe[iIdx] * chirpRe[tx] + inputIm[iIdx] * chirpIm[tx]);
+        outputRe[oIdx]    = MI * (inputRe[iIdx] * chirp[tx].x + inputIm[iIdx] * chirp[tx].y);
         if(SCALE)
             outputRe[oIdx] *= scale_factor;
-        outputIm[oIdx] = MI * (-inputRe[iIdx] * chirpIm[tx] + inputIm[iIdx] * chirpRe[tx]);
+        outputIm[oIdx] = MI * (-inputRe[iIdx] * chirp[tx].y + inputIm[iIdx] * chirp[tx].x);
         if(SCALE)
             outputIm[oIdx] *= scale_factor;
     }
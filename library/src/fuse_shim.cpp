@@ -514,15 +514,11 @@ bool TransC2R_FuseShim::CheckSchemeFusable()
     //   then we couldn't change tranpose's input buffer
     ComputeScheme nextFFTScheme = nodes[2]->scheme;
     if(nextFFTScheme == CS_KERNEL_STOCKHAM || nextFFTScheme == CS_KERNEL_STOCKHAM_BLOCK_CC
-       || nextFFTScheme == CS_KERNEL_CHIRP)
+       || nextFFTScheme == CS_KERNEL_PAD_MUL)
         allowInplace = true;
     else
         allowInplace = false;
 
-    // if the nextLeaf is chirp, what we actually want is next sibling PAD-MUL
-    if(nextFFTScheme == CS_KERNEL_CHIRP)
-        nodes[2] = nodes[2]->parent->childNodes[1].get();
-
     return true;
 }
 
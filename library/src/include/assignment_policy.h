@@ -22,6 +22,10 @@
 #define ASSIGNMENT_POLICY_H
 
 #include "tree_node.h"
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
 #include <vector>
 
 /****************************************************************************
@@ -33,6 +37,8 @@
  * NOTE:
  *   the tree is not a complete tree, since we have lots of tests that do early
  *   rejection which can stop growing the branches
+ *   traces are owned by the AssignmentPolicy that creates them, and only
+ *   point back to their parents
  ****************************************************************************/
 struct PlacementTrace
 {
@@ -45,11 +51,14 @@ struct PlacementTrace
     size_t            numInplace       = 0;
     size_t            numTypeSwitching = 0;
     size_t            numFusedNodes    = 0;
+    // fuse shims in this path that are complete, but whose placement
+    // can't be fused
+    size_t numUnfusableShims = 0;
 
-    // parent for back-tracking, placement branches
-    PlacementTrace*                              parent = nullptr;
-    std::vector<std::unique_ptr<PlacementTrace>> branches;
-    std::set<OperatingBuffer>                    usedBuffers;
+    // parent for back-tracking
+    PlacementTrace* parent = nullptr;
+    // bitmask of the OperatingBuffers used so far
+    unsigned int usedBuffers = 0;
 
     PlacementTrace() {}
 
@@ -69,13 +78,12 @@ struct PlacementTrace
         isInplace        = (iB == oB);
         numInplace       = parent->numInplace + (isInplace ? 1 : 0);
         numTypeSwitching = parent->numTypeSwitching + (inType != outType ? 1 : 0);
-        // using set to record the used buffers. (we have 5 buffers at most)
-        usedBuffers = parent->usedBuffers;
-        usedBuffers.insert(iB);
-        usedBuffers.insert(oB);
+        // OperatingBuffers are distinct bits (we have 5 buffers at most)
+        usedBuffers       = parent->usedBuffers | iB | oB;
+        numUnfusableShims = parent->numUnfusableShims;
     }
 
-    // print the [in->out] for this placement
+    // print the [in->out] for the path ending at this placement
     void Print(rocfft_ostream& os);
 
     // Starting from the tail (leaf of each branch) back to the head (root),
@@ -91,22 +99,74 @@ struct PlacementTrace
     // Starting from the tail (leaf of each branch) back to the head (root),
     // Fill-in the assignment from the PlacemenTraces to the nodes
     void Backtracking(ExecPlan& execPlan, int execSeqID);
+
+private:
+    void PrintPath(rocfft_ostream& os);
 };
 
+// ID-in-execSeq (means that node) -> buffer_ENUM -> array-type_ENUM
 using NodeBufTestCacheKey = std::tuple<size_t, OperatingBuffer, rocfft_array_type>;
-struct CmpNodeBufTestCacheKey
+
+// Ranks the valid assignments found for a plan, so the best one can
+// be chosen.  Each optimize strategy has its own model.
+class AssignmentCostModel
+{
+public:
+    virtual ~AssignmentCostModel() = default;
+
+    // sort candidates (leaves of the placement tree) so that the
+    // front is the preferred assignment
+    virtual void Rank(const ExecPlan& execPlan, std::vector<PlacementTrace*>& candidates) const = 0;
+
+    static std::unique_ptr<AssignmentCostModel> Create(rocfft_optimize_strategy strategy);
+};
+
+// Fixed order of preference: most fusions, then fewest buffers, then
+// most paddable temp ops, most in-place kernels and fewest array
+// type switches.
+class RankedCostModel : public AssignmentCostModel
+{
+public:
+    void Rank(const ExecPlan& execPlan, std::vector<PlacementTrace*>& candidates) const override;
+};
+
+// Estimated cost of executing an assignment
+struct PlacementCost
+{
+    // bytes read and written by all kernels, after fusions
+    size_t bytesMoved = 0;
+    // number of kernel launches, after fusions
+    size_t numKernels = 0;
+    // bytes of temp buffers the assignment writes to
+    size_t workBytes = 0;
+    // a kernel launch costs roughly as much time as moving this many
+    // bytes through global memory
+    size_t launchCostBytes = 4 * 1024 * 1024;
+
+    // bytes moved, with each launch counted as launchCostBytes of
+    // traffic
+    size_t Score() const;
+};
+
+// Prefers assignments that move less data through fewer kernels,
+// or assignments with a smaller work buffer.
+class TrafficCostModel : public AssignmentCostModel
 {
-    // Key comparison function.
-    //  Comparing order is ID-in-exeSeq (means that node) -> buffer_ENUM -> array-type_ENUM
-    bool operator()(NodeBufTestCacheKey const& lhs, NodeBufTestCacheKey const& rhs) const
+public:
+    explicit TrafficCostModel(bool workBufferFirst)
+        : workBufferFirst(workBufferFirst)
     {
-        if(std::get<0>(lhs) < std::get<0>(rhs))
-            return true;
-        else if(std::get<1>(lhs) < std::get<1>(rhs))
-            return true;
-        else
-            return std::get<2>(lhs) < std::get<2>(rhs);
     }
+
+    void Rank(const ExecPlan& execPlan, std::vector<PlacementTrace*>& candidates) const override;
+
+    // estimate the cost of the assignment ending at the leaf trace
+    static PlacementCost Estimate(const ExecPlan& execPlan, const PlacementTrace& leaf);
+
+private:
+    // if true, the smallest work buffer wins and traffic breaks ties.
+    // otherwise, least traffic wins and work buffer size breaks ties.
+    bool workBufferFirst;
 };
 
 class AssignmentPolicy
@@ -138,20 +198,58 @@ private:
 
     void UpdateWinnerFromValidPaths(ExecPlan& execPlan);
 
-    void Enumerate(PlacementTrace*   parent,
+    // search all assignments with the currently available buffers,
+    // collecting the valid ones in winnerCandidates
+    void Search(PlacementTrace& dummyRoot, ExecPlan& execPlan);
+
+    // Depth-first search of assignments for execSeq[curSeqID:],
+    // starting from startBuf/startType.  Returns false if no
+    // assignment of the rest of the sequence can end in the root
+    // plan's output buffer.
+    bool Enumerate(PlacementTrace*   parent,
                    ExecPlan&         execPlan,
                    size_t            curSeqID,
                    OperatingBuffer   startBuf,
                    rocfft_array_type startType);
 
+    // create a trace for curNode's placement, after parent
+    PlacementTrace* AddTrace(TreeNode*         curNode,
+                             OperatingBuffer   inBuf,
+                             OperatingBuffer   outBuf,
+                             rocfft_array_type inType,
+                             rocfft_array_type outType,
+                             PlacementTrace*   parent);
+
+    // continue the search after trace, unless no path through it can
+    // have more fusions than the current winner
+    bool Descend(PlacementTrace*   trace,
+                 ExecPlan&         execPlan,
+                 size_t            curSeqID,
+                 OperatingBuffer   startBuf,
+                 rocfft_array_type startType);
+
     std::vector<PlacementTrace*> winnerCandidates;
     std::set<OperatingBuffer>    availableBuffers;
     std::set<rocfft_array_type>  availableArrayTypes;
     int  numCurWinnerFusions; // -1 means no winner, else = curr winner's #-fusions
     bool mustUseTBuffer = false;
     bool mustUseCBuffer = false;
-
-    std::map<NodeBufTestCacheKey, bool, CmpNodeBufTestCacheKey> node_buf_test_cache;
+    // turn off pruning and dead-state memoization
+    bool exhaustiveSearch = false;
+
+    std::map<NodeBufTestCacheKey, bool> node_buf_test_cache;
+
+    // all traces of the current search, in one place so growing the
+    // tree doesn't allocate per branch.  deque keeps them from moving.
+    std::deque<PlacementTrace> traces;
+    // (node, buffer, array type) states that were fully searched
+    // without reaching the end of the sequence
+    std::set<NodeBufTestCacheKey> deadStates;
+    // fuse shims, keyed by the last node they fuse
+    std::map<const TreeNode*, std::vector<FuseShim*>> shimsEndingAt;
+    // number of subtrees skipped because they can't beat the winner,
+    // or start from a dead state
+    size_t numPrunedPaths = 0;
 };
 
 #endif // ASSIGNMENT_POLICY_H
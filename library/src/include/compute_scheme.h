@@ -51,10 +51,10 @@ enum ComputeScheme
     CS_KERNEL_TRANSPOSE_CMPLX_TO_R,
     CS_REAL_2D_EVEN,
     CS_REAL_3D_EVEN,
+    CS_REAL_ND_EVEN,
     CS_KERNEL_APPLY_CALLBACK,
 
     CS_BLUESTEIN,
-    CS_KERNEL_CHIRP,
     CS_KERNEL_PAD_MUL,
     CS_KERNEL_FFT_MUL,
     CS_KERNEL_RES_MUL,
@@ -76,9 +76,13 @@ enum ComputeScheme
     CS_3D_BLOCK_CR,
     CS_3D_RC,
     CS_KERNEL_3D_STOCKHAM_BLOCK_CC, // not implemented yet
-    CS_KERNEL_3D_SINGLE // not implemented yet
+    CS_KERNEL_3D_SINGLE, // not implemented yet
+
+    CS_ND_RC
 };
 
 std::string PrintScheme(ComputeScheme cs);
+// inverse of PrintScheme, throws std::runtime_error for unknown names
+ComputeScheme StrToComputeScheme(const std::string& str);
 
 #endif
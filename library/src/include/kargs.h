@@ -30,30 +30,40 @@
 
 #define KERN_ARGS_ARRAY_WIDTH 16
 
-gpubuf_t<size_t> kargs_create(std::vector<size_t> length,
-                              std::vector<size_t> inStride,
-                              std::vector<size_t> outStride,
-                              size_t              iDist,
-                              size_t              oDist);
+// The length and stride arrays of all of a plan's kernels are packed
+// into one host vector, which is then uploaded to the device in one
+// copy.  Each kernel's arrays take 3*KERN_ARGS_ARRAY_WIDTH elements.
+
+// append a kernel's arrays to 'kernArgs', returning their offset
+size_t kargs_append(std::vector<size_t>&       kernArgs,
+                    const std::vector<size_t>& length,
+                    const std::vector<size_t>& inStride,
+                    const std::vector<size_t>& outStride,
+                    size_t                     iDist,
+                    size_t                     oDist);
+
+// malloc device buffer; copy packed arrays to it.  the buffer is
+// null on failure.
+gpubuf_t<size_t> kargs_create(const std::vector<size_t>& kernArgs);
 
 // data->node->devKernArg : points to the internal length device pointer
 // data->node->devKernArg + 1*KERN_ARGS_ARRAY_WIDTH : points to the intenal in
 // stride device pointer
 // data->node->devKernArg + 2*KERN_ARGS_ARRAY_WIDTH : points to the internal out
 // stride device pointer, only used in outof place kernels
-static size_t* kargs_lengths(const gpubuf_t<size_t>& devKernArg)
+static size_t* kargs_lengths(size_t* devKernArg)
 {
-    return devKernArg.data();
+    return devKernArg;
 }
 
-static size_t* kargs_stride_in(const gpubuf_t<size_t>& devKernArg)
+static size_t* kargs_stride_in(size_t* devKernArg)
 {
-    return devKernArg.data() + 1 * KERN_ARGS_ARRAY_WIDTH;
+    return devKernArg + 1 * KERN_ARGS_ARRAY_WIDTH;
 }
 
-static size_t* kargs_stride_out(const gpubuf_t<size_t>& devKernArg)
+static size_t* kargs_stride_out(size_t* devKernArg)
 {
-    return devKernArg.data() + 2 * KERN_ARGS_ARRAY_WIDTH;
+    return devKernArg + 2 * KERN_ARGS_ARRAY_WIDTH;
 }
 
 #endif // defined( KARGS_H )
@@ -63,9 +63,11 @@ using log_func_t = void (*)(const char* msg);
 // FIXME: documentation
 struct DeviceCallIn
 {
-    TreeNode* node;
-    void*     bufIn[2];
-    void*     bufOut[2];
+    // const, since the node may be shared by several plans that are
+    // executed at once (see PlanCache)
+    const TreeNode* node;
+    void*           bufIn[2];
+    void*           bufOut[2];
 
     hipStream_t     rocfft_stream;
     GridParam       gridParam;
@@ -117,7 +119,6 @@ bcc - block column column
 */
 
 ROCFFT_DEVICE_EXPORT void rocfft_internal_mul(const void* data_p, void* back_p);
-ROCFFT_DEVICE_EXPORT void rocfft_internal_chirp(const void* data_p, void* back_p);
 ROCFFT_DEVICE_EXPORT void rocfft_internal_transpose_var2(const void* data_p, void* back_p);
 
 /*
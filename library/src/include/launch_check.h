@@ -0,0 +1,56 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LAUNCH_CHECK_H
+#define LAUNCH_CHECK_H
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// A kernel launch of a plan, as far as checking the launches goes:
+// the node it runs, and its grid
+template <typename Grid>
+struct LaunchRecord
+{
+    const void* node;
+    Grid        grid;
+};
+
+// Check that the launches that were made are the planned ones, in
+// order and with the planned grids.  Throws if they're not.
+template <typename Grid>
+void CheckLaunchSequence(const std::vector<LaunchRecord<Grid>>& planned,
+                         const std::vector<LaunchRecord<Grid>>& launched)
+{
+    for(size_t i = 0; i < planned.size(); ++i)
+    {
+        if(i == launched.size() || launched[i].node != planned[i].node)
+            throw std::runtime_error("launch sequence does not match plan at launch "
+                                     + std::to_string(i));
+        if(!(launched[i].grid == planned[i].grid))
+            throw std::runtime_error("launch grid does not match plan at launch "
+                                     + std::to_string(i));
+    }
+    if(launched.size() > planned.size())
+        throw std::runtime_error("launch sequence has more kernels than plan");
+}
+
+#endif // LAUNCH_CHECK_H
@@ -23,16 +23,15 @@
 
 #include "tree_node.h"
 
+struct SchemeTuning;
+
 class NodeFactory
 {
 private:
-    // Maps from length[0] to divLength1 for 1D transforms in
-    // single and double precision using block computing.
-    typedef std::map<size_t, size_t> Map1DLength;
-    static const Map1DLength         map1DLengthSingle;
-    static const Map1DLength         map1DLengthDouble;
-
-    static bool Large1DLengthsValid(const Map1DLength& map1DLength, rocfft_precision precision);
+    // check that the kernels needed for a tuned 1D decomposition of
+    // length exist
+    static bool
+        Large1DTuningValid(size_t length, const SchemeTuning& tuning, rocfft_precision precision);
 
 public:
     // Create node (user level) using this function
@@ -49,6 +48,13 @@ public:
     static ComputeScheme Decide2DScheme(NodeMetaData& nodeData);
     static ComputeScheme Decide3DScheme(NodeMetaData& nodeData);
 
+    // check that a tuned 2D or 3D scheme can be built for the node
+    static bool MultiDimTuningValid(NodeMetaData& nodeData, ComputeScheme scheme);
+    // Schemes that a complex transform could be built with, with
+    // their split factors for 1D transforms.  Empty if there is
+    // nothing to choose.
+    static std::vector<SchemeTuning> TuningCandidates(NodeMetaData& nodeData);
+
     // determine function:
     static bool use_CS_2D_SINGLE(NodeMetaData& nodeData); // using scheme CS_KERNEL_2D_SINGLE or not
     static bool use_CS_2D_RC(NodeMetaData& nodeData); // using scheme CS_2D_RC or not
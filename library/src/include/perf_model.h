@@ -0,0 +1,105 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef PERF_MODEL_H
+#define PERF_MODEL_H
+
+#include "tree_node.h"
+
+#include <vector>
+
+// Rates and limits of a device that bound how fast kernels run.
+struct DeviceModel
+{
+    // global memory bandwidth
+    double memBytesPerUs = 0.0;
+    // peak arithmetic rates
+    double singleFlopsPerUs = 0.0;
+    double doubleFlopsPerUs = 0.0;
+
+    size_t computeUnits  = 0;
+    size_t ldsBytesPerCU = 0;
+    size_t maxWavesPerCU = 0;
+    size_t wavefrontSize = 64;
+
+    // fixed cost of each kernel launch
+    double launchUs = 0.0;
+
+    // Model of a device with these properties.  Anything the
+    // properties leave out (e.g. for a target device set without a
+    // GPU) comes from a table of known architectures.
+    // ROCFFT_DEVICE_BW overrides the memory bandwidth, in GB/s.
+    static DeviceModel FromDeviceProp(const hipDeviceProp_t& prop);
+
+    // bytes of memory traffic that take as long as one launch
+    size_t LaunchCostBytes() const;
+};
+
+// Estimated cost of one kernel of a plan
+struct KernelEstimate
+{
+    ComputeScheme scheme = CS_NONE;
+
+    // global memory traffic
+    size_t bytesRead    = 0;
+    size_t bytesWritten = 0;
+    // floating-point operations
+    double flops = 0.0;
+
+    // launch geometry
+    size_t workgroups    = 0;
+    size_t workgroupSize = 0;
+    size_t ldsBytes      = 0;
+    // fraction of each compute unit's wavefront slots that the
+    // kernel can fill, limited by workgroup size and LDS use
+    double occupancy = 0.0;
+
+    // 0 if the kernel is skipped when executing without callbacks
+    size_t launches = 1;
+    double timeUs   = 0.0;
+};
+
+// Estimated cost of executing a whole plan
+struct PlanEstimate
+{
+    // one per kernel in execSeq
+    std::vector<KernelEstimate> kernels;
+
+    size_t bytesRead    = 0;
+    size_t bytesWritten = 0;
+    double flops        = 0.0;
+    size_t launches     = 0;
+    double timeUs       = 0.0;
+};
+
+// Estimate how long a decided plan takes to execute, without
+// running it.  Each kernel in execSeq is modeled from its lengths,
+// array types and launch parameters as limited by either memory
+// bandwidth or arithmetic, plus a fixed launch cost.  Works on
+// device-free plans too.
+PlanEstimate EstimatePlan(const ExecPlan& execPlan, const DeviceModel& device);
+PlanEstimate EstimatePlan(const ExecPlan& execPlan);
+
+// Estimate one leaf node while a plan is still being built, before
+// it has launch parameters or buffers.  The launch is assumed to
+// fill the device, and data is assumed to be interleaved complex.
+KernelEstimate EstimateNode(const TreeNode& node, const DeviceModel& device);
+
+#endif // PERF_MODEL_H
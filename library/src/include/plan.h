@@ -21,8 +21,12 @@
 #ifndef PLAN_H
 #define PLAN_H
 
+#include <algorithm>
 #include <array>
 #include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "function_pool.h"
@@ -48,13 +52,18 @@ static inline bool IsPow(size_t u)
     return (u > 0 && max % u == 0);
 }
 
+// Most dimensions a transform can have.  Kernels take a length and
+// stride per dimension plus the batch distance, and large 1D
+// decompositions add a dimension.
+static const size_t MAX_TRANSFORM_RANK = KERN_ARGS_ARRAY_WIDTH - 2;
+
 struct rocfft_plan_description_t
 {
     rocfft_array_type inArrayType  = rocfft_array_type_complex_interleaved;
     rocfft_array_type outArrayType = rocfft_array_type_complex_interleaved;
 
-    std::array<size_t, 3> inStrides  = {0, 0, 0};
-    std::array<size_t, 3> outStrides = {0, 0, 0};
+    std::array<size_t, MAX_TRANSFORM_RANK> inStrides  = {};
+    std::array<size_t, MAX_TRANSFORM_RANK> outStrides = {};
 
     size_t inDist  = 0;
     size_t outDist = 0;
@@ -64,14 +73,37 @@ struct rocfft_plan_description_t
 
     double scale_factor = 1.0;
 
+    rocfft_optimize_strategy optimizeStrategy = rocfft_optimize_balance;
+
+    // largest work buffer a plan may use, in bytes, or 0 for no
+    // limit.  plans that would need more run in batch chunks.
+    size_t workBufferLimit = 0;
+
+    // if set, plans are decided for targetDevice instead of the
+    // current device, without using a GPU
+    bool            targetDeviceSet = false;
+    hipDeviceProp_t targetDevice    = {};
+
     rocfft_plan_description_t() = default;
 };
 
+struct ExecPlanLaunch;
+
+// Kernel launches of a plan, resolved for the buffers it most
+// recently ran with (see TransformPowX)
+struct ExecPlanLaunchCache
+{
+    std::mutex mutex;
+    // newest first
+    std::deque<std::shared_ptr<const ExecPlanLaunch>> recent;
+    size_t                                            capacity = 1;
+};
+
 struct rocfft_plan_t
 {
-    size_t                rank    = 1;
-    std::array<size_t, 3> lengths = {1, 1, 1};
-    size_t                batch   = 1;
+    size_t                                 rank = 1;
+    std::array<size_t, MAX_TRANSFORM_RANK> lengths;
+    size_t                                 batch = 1;
 
     rocfft_result_placement placement      = rocfft_placement_inplace;
     rocfft_transform_type   transformType  = rocfft_transform_type_complex_forward;
@@ -80,11 +112,67 @@ struct rocfft_plan_t
 
     rocfft_plan_description_t desc;
 
-    rocfft_plan_t() = default;
+    rocfft_plan_t()
+    {
+        lengths.fill(1);
+    }
 
     ExecPlan execPlan;
+
+    // Launches of execPlan.  Each handle has its own, even when the
+    // plan cache gives several handles the same ExecPlan.  Declared
+    // after execPlan, so the launches go before the nodes they use.
+    ExecPlanLaunchCache launchCache;
+
+    // Plans whose work buffer would be over desc.workBufferLimit run
+    // chunkCount chunks of chunkBatch transforms, one after another.
+    // execPlan is then decided for chunkBatch transforms, and
+    // remainderPlan for the last chunk if it's smaller.  chunkBatch
+    // is 0 for plans that run all their transforms at once.
+    size_t                         chunkBatch = 0;
+    size_t                         chunkCount = 1;
+    std::unique_ptr<rocfft_plan_t> remainderPlan;
+
+    // work buffer needed to execute the plan
+    size_t WorkBufBytes() const
+    {
+        size_t bytes = execPlan.WorkBufBytes(base_type_size);
+        if(remainderPlan)
+            bytes = std::max(bytes, remainderPlan->WorkBufBytes());
+        return bytes;
+    }
 };
 
 bool PlanPowX(ExecPlan& execPlan);
+// Work out the launch parameters of each kernel in execSeq.  No
+// device is needed, so device-free plans get them too.
+void PlanGridParams(ExecPlan& execPlan);
+
+// Fill in plan parameters and build its ExecPlan.  If deviceProp is
+// non-null, the plan is decided for that device without using a GPU
+// (see ExecPlan::deviceFree) and cannot be executed, but its kernels
+// are compiled into the cache.  A description with a target device
+// also gives a device-free plan, with no compilation.
+rocfft_status rocfft_plan_create_internal(rocfft_plan                   plan,
+                                          const rocfft_result_placement placement,
+                                          const rocfft_transform_type   transform_type,
+                                          const rocfft_precision        precision,
+                                          const size_t                  dimensions,
+                                          const size_t*                 lengths,
+                                          const size_t                  number_of_transforms,
+                                          const rocfft_plan_description description,
+                                          const hipDeviceProp_t*        deviceProp = nullptr);
+
+// Device properties to plan for the named GPU architecture without
+// a device.  gpu_arch should be the full architecture name as
+// reported by the device, including any feature flags
+// (e.g. "gfx90a:sramecc+:xnack-").  lds_bytes of 0 means the
+// default LDS size, compute_units of 0 means unknown.
+hipDeviceProp_t SyntheticDeviceProp(const std::string& gpu_arch,
+                                    size_t             lds_bytes     = 0,
+                                    size_t             compute_units = 0);
+
+// rocfft-rider command line that runs the same transform as a plan
+std::string rocfft_rider_command(rocfft_plan plan);
 
 #endif // PLAN_H
@@ -0,0 +1,123 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef PLAN_CACHE_H
+#define PLAN_CACHE_H
+
+#include "plan.h"
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Process-wide cache of finished ExecPlans.
+//
+// Building an ExecPlan (scheme decision, buffer assignment, fusion,
+// padding, runtime compilation, twiddle and kernel-arg setup) is
+// expensive, but the result only depends on the normalized plan
+// parameters and the device.  ExecPlans are copyable and share
+// their tree through a shared_ptr, so a cache hit is just a copy of
+// the cached ExecPlan.
+//
+// Handles that came from the same entry can be executed at once
+// from different threads, so executing a plan must never write to
+// its tree.  Kernel launches only see const TreeNodes (see
+// DeviceCallIn::node) to keep it that way.
+//
+// The cache is opt-in: it is enabled by setting
+// ROCFFT_PLAN_CACHE_SIZE to the maximum number of plans to keep.
+// When full, the least-recently-used plan is evicted.
+class PlanCache
+{
+public:
+    // everything rocfft_plan_create_internal normalizes, plus the
+    // device the plan was built for
+    struct plan_cache_key_t
+    {
+        size_t                                 rank = 1;
+        std::array<size_t, MAX_TRANSFORM_RANK> lengths;
+        size_t                                 batch = 1;
+        rocfft_result_placement                placement;
+        rocfft_transform_type                  transformType;
+        rocfft_precision                       precision;
+        rocfft_array_type                      inArrayType;
+        rocfft_array_type                      outArrayType;
+        std::array<size_t, MAX_TRANSFORM_RANK> inStrides;
+        std::array<size_t, MAX_TRANSFORM_RANK> outStrides;
+        size_t                                 inDist  = 0;
+        size_t                                 outDist = 0;
+        std::array<size_t, 2>                  inOffset;
+        std::array<size_t, 2>                  outOffset;
+        double                                 scale_factor     = 1.0;
+        rocfft_optimize_strategy               optimizeStrategy = rocfft_optimize_balance;
+        size_t                                 workBufferLimit  = 0;
+        // plans hold device memory (twiddles, kernel args), so they
+        // are per-device, not just per-arch
+        int         deviceId = 0;
+        std::string arch;
+
+        plan_cache_key_t(const rocfft_plan_t& plan, int deviceId, const hipDeviceProp_t& prop);
+
+        bool operator<(const plan_cache_key_t& other) const;
+    };
+
+    // cache is a singleton, so no copying or assignment
+    PlanCache(const PlanCache&) = delete;
+    PlanCache& operator=(const PlanCache&) = delete;
+
+    static PlanCache& GetPlanCache();
+
+    // Look up a plan.  On a hit, copy the cached plan into execPlan
+    // and return true.
+    bool Lookup(const plan_cache_key_t& key, ExecPlan& execPlan);
+
+    // Store a finished plan.  Does nothing if the cache is disabled.
+    // Otherwise, evicts the least-recently-used plan if the cache is
+    // full.
+    void Insert(const plan_cache_key_t& key, const ExecPlan& execPlan);
+
+    // read the configured capacity from the environment
+    static void Setup();
+
+    // remove all cached plans and reset counters
+    static void Clear();
+
+private:
+    PlanCache();
+
+    // read capacity from the environment
+    static size_t ConfiguredCapacity();
+
+    // log current hit/miss counters
+    void LogCounters(const char* event) const;
+
+    // most-recently-used plans at the front
+    typedef std::list<std::pair<plan_cache_key_t, ExecPlan>> lru_list_t;
+
+    lru_list_t                                       plans;
+    std::map<plan_cache_key_t, lru_list_t::iterator> index;
+    size_t                                           capacity  = 0;
+    size_t                                           hits      = 0;
+    size_t                                           misses    = 0;
+    size_t                                           evictions = 0;
+    mutable std::mutex                               mtx;
+};
+
+#endif // PLAN_CACHE_H
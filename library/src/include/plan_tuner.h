@@ -0,0 +1,109 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef PLAN_TUNER_H
+#define PLAN_TUNER_H
+
+#include "plan.h"
+#include "scheme_table.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Estimates how long a decided plan takes to execute, so that plans
+// can be compared without a device.  Costs are only comparable
+// between plans for the same problem.
+class PlanCostModel
+{
+public:
+    virtual ~PlanCostModel() = default;
+
+    virtual double Cost(const ExecPlan& execPlan) const = 0;
+};
+
+// Estimated execution time in microseconds, from the analytic
+// performance model (see EstimatePlan).
+class AnalyticPlanCostModel : public PlanCostModel
+{
+public:
+    double Cost(const ExecPlan& execPlan) const override;
+};
+
+// Chooses between the decompositions and fusions a complex
+// transform could be built with.
+//
+// Every candidate is built under a SchemeTable::ScopedOverride
+// holding the process table plus an entry for the candidate.  If the
+// plan is for the current device, candidates are executed and timed.
+// Device-free plans are scored with the cost model instead.
+class PlanTuner
+{
+public:
+    explicit PlanTuner(std::unique_ptr<PlanCostModel> costModel);
+
+    // Tune the problem described by the plan creation parameters.
+    // Returns true and fills in 'winner' if a candidate beat the
+    // plan built with the current table.  Throws if the problem
+    // can't be planned at all.
+    bool Tune(const rocfft_result_placement placement,
+              const rocfft_transform_type   transform_type,
+              const rocfft_precision        precision,
+              const size_t                  dimensions,
+              const size_t*                 lengths,
+              const size_t                  number_of_transforms,
+              const rocfft_plan_description description,
+              SchemeTuning&                 winner);
+
+    // architecture of the device tuned for, after Tune
+    const std::string& Arch() const
+    {
+        return arch;
+    }
+
+    // a candidate must be this much faster than the current plan to
+    // be recorded, so that noise doesn't churn the table
+    static constexpr double MIN_SPEEDUP = 1.02;
+
+    // fusion types in a plan beyond this many are always left enabled
+    static const size_t MAX_FUSE_TYPES = 4;
+
+private:
+    // build a plan with 'tuning' as the entry for the root problem,
+    // or with the current table if tuning is null.  returns null if
+    // the plan can't be built.
+    std::unique_ptr<rocfft_plan_t> Build(const SchemeTuning* tuning);
+
+    // time the plan on the device or score it with the cost model
+    double Evaluate(rocfft_plan_t& plan);
+
+    std::unique_ptr<PlanCostModel> costModel;
+
+    // plan creation parameters
+    rocfft_result_placement placement;
+    rocfft_transform_type   transformType;
+    rocfft_precision        precision;
+    std::vector<size_t>     length;
+    size_t                  batch;
+    rocfft_plan_description description;
+    std::string             arch;
+};
+
+#endif // PLAN_TUNER_H
@@ -0,0 +1,318 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef REF_CPU_FFT_H
+#define REF_CPU_FFT_H
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+// OpenMP directives, which are left out when OpenMP isn't enabled so
+// everything runs on one thread
+#ifdef _OPENMP
+#define REF_OMP(directive) _Pragma(#directive)
+#else
+#define REF_OMP(directive)
+#endif
+
+// Host FFTs for the CPU reference (see ref_cpu.h), in either
+// precision, with no external library.
+//
+// Lengths are factored into the radices the device kernels use (2
+// to 17), with a plain DFT pass for any larger prime factor, and
+// transformed with a Stockham autosort.  A block of transforms is
+// gathered into split real/imaginary arrays with the transform index
+// innermost, so each butterfly works on a whole block at once and
+// the compiler can vectorize it.  Blocks are spread across host
+// threads with OpenMP, when it's enabled.
+template <typename Treal>
+class RefFFTPlan
+{
+public:
+    // exp(direction * 2 * pi * i / length) is the root of unity
+    RefFFTPlan(size_t _length, int _direction)
+        : length(_length)
+        , direction(_direction)
+    {
+        static const long double PI_LONG = 3.141592653589793238462643383279502884L;
+
+        roots.resize(length);
+        for(size_t k = 0; k < length; ++k)
+        {
+            long double theta = direction * 2.0L * PI_LONG * k / length;
+            roots[k] = {static_cast<Treal>(std::cos(theta)), static_cast<Treal>(std::sin(theta))};
+        }
+
+        // largest radices first, so there are fewer passes
+        static const size_t radices[] = {16, 17, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2};
+        size_t              rem       = length;
+        for(auto radix : radices)
+        {
+            while(rem % radix == 0)
+            {
+                factors.push_back(radix);
+                rem /= radix;
+            }
+        }
+        // anything left has only prime factors over 17
+        for(size_t p = 19; rem > 1; p += 2)
+        {
+            while(rem % p == 0)
+            {
+                factors.push_back(p);
+                rem /= p;
+            }
+        }
+    }
+
+    // Transform outer * inner vectors in place.  Vector (o, i)
+    // starts at data[o * dist + i], and its elements are 'stride'
+    // apart.
+    void Execute(std::complex<Treal>* data,
+                 size_t               stride,
+                 size_t               inner,
+                 size_t               dist,
+                 size_t               outer) const
+    {
+        const size_t howmany = inner * outer;
+        if(length <= 1 || howmany == 0)
+            return;
+
+        const size_t lanes  = std::min(howmany, BLOCK);
+        const size_t blocks = (howmany + lanes - 1) / lanes;
+        // a lone block is split across threads inside each pass
+        // instead
+        const bool parallelPasses = blocks == 1 && length >= PARALLEL_PASS_LENGTH;
+
+        auto offset = [=](size_t v) { return (v / inner) * dist + (v % inner); };
+
+        REF_OMP(omp parallel for schedule(dynamic) if(blocks > 1))
+        for(long long blk = 0; blk < static_cast<long long>(blocks); ++blk)
+        {
+            const size_t first = blk * lanes;
+            const size_t count = std::min(lanes, howmany - first);
+
+            std::vector<Treal> work(4 * length * lanes, 0);
+            Treal*             xRe = work.data();
+            Treal*             xIm = xRe + length * lanes;
+            Treal*             yRe = xIm + length * lanes;
+            Treal*             yIm = yRe + length * lanes;
+
+            for(size_t b = 0; b < count; ++b)
+            {
+                const auto vec = data + offset(first + b);
+                for(size_t e = 0; e < length; ++e)
+                {
+                    xRe[e * lanes + b] = vec[e * stride].real();
+                    xIm[e * lanes + b] = vec[e * stride].imag();
+                }
+            }
+
+            size_t Ns = 1;
+            for(auto radix : factors)
+            {
+                RunPass(radix, Ns, lanes, parallelPasses, xRe, xIm, yRe, yIm);
+                std::swap(xRe, yRe);
+                std::swap(xIm, yIm);
+                Ns *= radix;
+            }
+
+            for(size_t b = 0; b < count; ++b)
+            {
+                auto vec = data + offset(first + b);
+                for(size_t e = 0; e < length; ++e)
+                    vec[e * stride] = {xRe[e * lanes + b], xIm[e * lanes + b]};
+            }
+        }
+    }
+
+    // transform 'howmany' contiguous vectors in place
+    void Execute(std::complex<Treal>* data, size_t howmany) const
+    {
+        Execute(data, 1, 1, length, howmany);
+    }
+
+private:
+    // transforms gathered into one block
+    static const size_t BLOCK = 32;
+    // single transforms at least this long run each pass's
+    // butterflies on multiple threads
+    static const size_t PARALLEL_PASS_LENGTH = 16384;
+
+    void RunPass(size_t       radix,
+                 size_t       Ns,
+                 size_t       lanes,
+                 bool         parallel,
+                 const Treal* inRe,
+                 const Treal* inIm,
+                 Treal*       outRe,
+                 Treal*       outIm) const
+    {
+        switch(radix)
+        {
+        case 2:
+            return Pass<2>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        case 3:
+            return Pass<3>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        case 4:
+            return Pass<4>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        case 5:
+            return Pass<5>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        case 6:
+            return Pass<6>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        case 7:
+            return Pass<7>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        case 8:
+            return Pass<8>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        case 9:
+            return Pass<9>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        case 10:
+            return Pass<10>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        case 11:
+            return Pass<11>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        case 12:
+            return Pass<12>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        case 13:
+            return Pass<13>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        case 16:
+            return Pass<16>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        case 17:
+            return Pass<17>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        default:
+            return Pass<0>(radix, Ns, lanes, parallel, inRe, inIm, outRe, outIm);
+        }
+    }
+
+    // One Stockham pass of radix R, where Ns is the product of the
+    // radices of earlier passes.  R is 0 for radices only known at
+    // runtime.
+    template <size_t R>
+    void Pass(size_t       radixRuntime,
+              size_t       Ns,
+              size_t       lanes,
+              bool         parallel,
+              const Treal* inRe,
+              const Treal* inIm,
+              Treal*       outRe,
+              Treal*       outIm) const
+    {
+        const size_t radix  = R ? R : radixRuntime;
+        const size_t stride = length / radix;
+        const size_t twStep = length / (Ns * radix);
+
+        REF_OMP(omp parallel if(parallel))
+        {
+            std::vector<Treal> v(2 * radix * lanes);
+            Treal*             vRe = v.data();
+            Treal*             vIm = vRe + radix * lanes;
+
+            REF_OMP(omp for)
+            for(long long jj = 0; jj < static_cast<long long>(stride); ++jj)
+            {
+                const size_t j = jj;
+                const size_t k = j % Ns;
+
+                // twiddle the inputs
+                for(size_t r = 0; r < radix; ++r)
+                {
+                    const auto   w   = roots[r * k * twStep];
+                    const Treal  wRe = w.real();
+                    const Treal  wIm = w.imag();
+                    const Treal* iRe = inRe + (j + r * stride) * lanes;
+                    const Treal* iIm = inIm + (j + r * stride) * lanes;
+                    Treal*       tRe = vRe + r * lanes;
+                    Treal*       tIm = vIm + r * lanes;
+                    REF_OMP(omp simd)
+                    for(size_t b = 0; b < lanes; ++b)
+                    {
+                        tRe[b] = iRe[b] * wRe - iIm[b] * wIm;
+                        tIm[b] = iRe[b] * wIm + iIm[b] * wRe;
+                    }
+                }
+
+                // length-radix DFT of the twiddled inputs
+                const size_t outBase = (j / Ns) * Ns * radix + k;
+                for(size_t q = 0; q < radix; ++q)
+                {
+                    Treal* oRe = outRe + (outBase + q * Ns) * lanes;
+                    Treal* oIm = outIm + (outBase + q * Ns) * lanes;
+                    REF_OMP(omp simd)
+                    for(size_t b = 0; b < lanes; ++b)
+                    {
+                        oRe[b] = vRe[b];
+                        oIm[b] = vIm[b];
+                    }
+                    for(size_t r = 1; r < radix; ++r)
+                    {
+                        const auto   w   = roots[(r * q * stride) % length];
+                        const Treal  wRe = w.real();
+                        const Treal  wIm = w.imag();
+                        const Treal* tRe = vRe + r * lanes;
+                        const Treal* tIm = vIm + r * lanes;
+                        REF_OMP(omp simd)
+                        for(size_t b = 0; b < lanes; ++b)
+                        {
+                            oRe[b] += tRe[b] * wRe - tIm[b] * wIm;
+                            oIm[b] += tRe[b] * wIm + tIm[b] * wRe;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    size_t                           length;
+    int                              direction;
+    std::vector<size_t>              factors;
+    std::vector<std::complex<Treal>> roots;
+};
+
+// Transform contiguous column-major arrays of 'lengths' along each of
+// the dimensions in 'dims', 'howmany' times.
+template <typename Treal>
+void RefFFT(std::complex<Treal>*       data,
+            const std::vector<size_t>& lengths,
+            const std::vector<size_t>& dims,
+            size_t                     howmany,
+            int                        direction)
+{
+    const size_t total = std::accumulate(
+        lengths.begin(), lengths.end(), howmany, std::multiplies<size_t>());
+    for(auto dim : dims)
+    {
+        const size_t len = lengths[dim];
+        // elements of each transform are as far apart as the
+        // dimensions before it are long
+        const size_t inner = std::accumulate(lengths.begin(),
+                                             lengths.begin() + dim,
+                                             static_cast<size_t>(1),
+                                             std::multiplies<size_t>());
+        RefFFTPlan<Treal> plan(len, direction);
+        plan.Execute(data, inner, inner, inner * len, total / (inner * len));
+    }
+}
+
+#undef REF_OMP
+
+#endif // REF_CPU_FFT_H
@@ -23,6 +23,8 @@
 #define REPO_H
 
 #include "../../../shared/gpubuf.h"
+#include "twiddles.h"
+#include <functional>
 #include <map>
 #include <mutex>
 
@@ -85,31 +87,74 @@ class Repo
         }
     };
 
-    // twiddle tables are buffers in device memory, along with a
-    // reference count
-    //
-    // NOTE: some buffers might be more shareable here (e.g. simple
-    // 1D might match half of a 2D twiddle, or a simple 1D might be
-    // shareable with a same-length attach_halfN buffer)
-    std::map<repo_key_1D_t, std::pair<gpubuf, unsigned int>> twiddles_1D;
-    std::map<repo_key_2D_t, std::pair<gpubuf, unsigned int>> twiddles_2D;
-    // reverse-map the device pointers back to the keys so users can
-    // free the pointer they were given
-    std::map<void*, repo_key_1D_t> twiddles_1D_reverse;
-    std::map<void*, repo_key_2D_t> twiddles_2D_reverse;
-    static std::mutex              mtx;
+    // key structure for Bluestein chirp filters
+    struct repo_key_chirp_t
+    {
+        // transform length and convolution length
+        size_t           length     = 0;
+        size_t           lengthBlue = 0;
+        rocfft_precision precision  = rocfft_precision_single;
+        int              direction  = -1;
+        // buffers are in device memory, so we need per-device
+        // filters
+        int deviceId = 0;
+
+        bool operator<(const repo_key_chirp_t& other) const
+        {
+            if(length != other.length)
+                return length < other.length;
+            if(lengthBlue != other.lengthBlue)
+                return lengthBlue < other.lengthBlue;
+            if(precision != other.precision)
+                return precision < other.precision;
+            if(direction != other.direction)
+                return direction < other.direction;
+            return deviceId < other.deviceId;
+        }
+    };
+
+    // a device buffer holding one or more twiddle tables back to
+    // back, along with the number of views of it handed out
+    struct twiddle_buffer_t
+    {
+        gpubuf                      buf;
+        rocfft_precision            precision = rocfft_precision_single;
+        int                         deviceId  = 0;
+        std::vector<TwiddleSegment> layout;
+        unsigned int                refs = 0;
+    };
+    // a table handed out to a plan, which is part or all of a buffer
+    struct twiddle_view_t
+    {
+        void*  ptr   = nullptr;
+        size_t bytes = 0;
+    };
+
+    // buffers by base address.  a table contained in a buffer that
+    // already exists (e.g. a 1D table that starts a same-length
+    // attach_halfN table, or one dimension of a 2D table) is served
+    // as a view of that buffer instead of being created again.
+    std::map<void*, twiddle_buffer_t> buffers;
+    // tables already handed out, so that repeated requests don't
+    // need to search the buffers
+    std::map<repo_key_1D_t, twiddle_view_t>    twiddles_1D;
+    std::map<repo_key_2D_t, twiddle_view_t>    twiddles_2D;
+    std::map<repo_key_chirp_t, twiddle_view_t> chirps;
+    static std::mutex                          mtx;
 
     // internal helpers to get and free twiddles
     template <typename KeyType>
     static std::pair<void*, size_t>
         GetTwiddlesInternal(KeyType,
-                            std::map<KeyType, std::pair<gpubuf, unsigned int>>&,
-                            std::map<void*, KeyType>&,
+                            rocfft_precision,
+                            std::map<KeyType, twiddle_view_t>&,
+                            std::function<std::vector<TwiddleSegment>()>,
                             std::function<gpubuf()>);
-    template <typename KeyType>
-    static void ReleaseTwiddlesInternal(void* ptr,
-                                        std::map<KeyType, std::pair<gpubuf, unsigned int>>&,
-                                        std::map<void*, KeyType>&);
+    // find a view of an existing buffer with the runs in 'layout'
+    twiddle_view_t
+        FindView(const std::vector<TwiddleSegment>& layout, rocfft_precision precision, int deviceId);
+    // find the buffer that a view points into
+    std::map<void*, twiddle_buffer_t>::iterator FindBuffer(void* ptr);
 
 public:
     // repo is a singleton, so no copying or assignment
@@ -134,9 +179,16 @@ public:
                                                   bool                       attach_halfN,
                                                   const std::vector<size_t>& radices);
     static std::pair<void*, size_t>
-                GetTwiddles2D(size_t length0, size_t length1, rocfft_precision precision);
-    static void ReleaseTwiddle1D(void* ptr);
-    static void ReleaseTwiddle2D(void* ptr);
+        GetTwiddles2D(size_t length0, size_t length1, rocfft_precision precision);
+    // Bluestein chirp filter for a transform of 'length' done with
+    // convolutions of 'lengthBlue': the chirp followed by its FFT
+    static std::pair<void*, size_t>
+        GetChirp(size_t length, size_t lengthBlue, rocfft_precision precision, int direction);
+    // release a table returned by any of the above
+    static void ReleaseTwiddles(void* ptr);
+    // number of twiddle buffers on a device, their total size, and
+    // the number of distinct tables they serve
+    static void GetStats(int deviceId, size_t& numBuffers, size_t& bytes, size_t& numTables);
     // remove cached twiddles
     static void Clear();
 
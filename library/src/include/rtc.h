@@ -27,6 +27,7 @@
 
 #include <algorithm>
 #include <future>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -69,6 +70,10 @@ public:
     {
         return buf.data();
     }
+    const void* data() const
+    {
+        return buf.data();
+    }
 
 private:
     void append(void* src, size_t nbytes)
@@ -95,6 +100,22 @@ struct RTCKernel
     static std::shared_future<std::unique_ptr<RTCKernel>> runtime_compile(
         const TreeNode& node, const std::string& gpu_arch, bool enable_callbacks = false);
 
+    // a node to compile, and whether to enable callbacks for it
+    typedef std::pair<const TreeNode*, bool> compile_request_t;
+
+    // compile kernels for many nodes at once.  all kernels are
+    // looked up in the cache together, kernels found in the cache
+    // are loaded in parallel, and only kernels not found are
+    // compiled.  returns one future per request, in the same order.
+    //
+    // if load is false, kernels are only compiled into the cache
+    // and the futures hold null pointers.  no device is needed in
+    // that case.
+    static std::vector<std::shared_future<std::unique_ptr<RTCKernel>>>
+        runtime_compile_batch(const std::vector<compile_request_t>& requests,
+                              const std::string&                    gpu_arch,
+                              bool                                  load = true);
+
     virtual ~RTCKernel()
     {
         kernel = nullptr;
@@ -102,19 +123,33 @@ struct RTCKernel
         module = nullptr;
     }
 
+    // name of the kernel that would be runtime-compiled for node,
+    // or empty if node doesn't use a runtime-compiled kernel
+    static std::string runtime_kernel_name(const TreeNode&    node,
+                                           const std::string& gpu_arch,
+                                           bool               enable_callbacks = false);
+
     // disallow copies, since we expect this to be managed by smart ptr
     RTCKernel(const RTCKernel&) = delete;
     RTCKernel(RTCKernel&&)      = delete;
     void operator=(const RTCKernel&) = delete;
 
+    // name of the kernel function in the compiled code object
+    const std::string kernel_name;
+
     // normal launch from within rocFFT execution plan
     void launch(DeviceCallIn& data);
     // direct launch with kernel args
-    void launch(RTCKernelArgs& kargs,
-                dim3           gridDim,
-                dim3           blockDim,
-                unsigned int   lds_bytes,
-                hipStream_t    stream = nullptr);
+    void launch(const RTCKernelArgs& kargs,
+                dim3                 gridDim,
+                dim3                 blockDim,
+                unsigned int         lds_bytes,
+                hipStream_t          stream = nullptr);
+
+    // args for a launch from within rocFFT execution plan, including
+    // the scale factor if the node has one.  they only depend on
+    // data, so they can be built once and launched many times.
+    RTCKernelArgs get_plan_launch_args(DeviceCallIn& data);
 
     // Subclasses implement this - each kernel type has different
     // parameters
@@ -178,10 +213,23 @@ struct RTCKernel
                                             const std::string& gpu_arch,
                                             kernel_src_gen_t   generate_src);
 
+    // Get compiled code objects for many kernels from the cache,
+    // without compiling anything.  Returns a map of kernel name to
+    // code object for the kernels that were found.
+    static std::map<std::string, std::vector<char>>
+        cached_lookup(const std::vector<std::string>& kernel_names, const std::string& gpu_arch);
+
     // compile source to a code object, in the current process.
     static std::vector<char> compile_inprocess(const std::string& kernel_src,
                                                const std::string& gpu_arch);
 
+    // Stop idle compile helper processes, and read the maximum
+    // number of helpers from the environment.  Helpers are started
+    // again by the next compile that needs one.
+    static void SetupHelpers();
+    // Stop idle compile helper processes.
+    static void StopHelpers();
+
 protected:
     // protected ctor, use "runtime_compile" to build kernel for a node
     RTCKernel(const std::string& kernel_name, const std::vector<char>& code);
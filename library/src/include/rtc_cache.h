@@ -20,6 +20,7 @@
 
 #include "rocfft.h"
 #include "sqlite3.h"
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -67,12 +68,52 @@ struct RTCCache
                                       int                         hip_version,
                                       const std::array<char, 32>& generator_sum);
 
-    // store the code object into the cache.
+    // get code objects for many kernels at once, returning a map of
+    // kernel name to code object for each kernel that was found.
+    // all lookups are done in a single transaction.
+    std::map<std::string, std::vector<char>>
+        get_code_objects(const std::vector<std::string>& kernel_names,
+                         const std::string&              gpu_arch,
+                         int                             hip_version,
+                         const std::array<char, 32>&     generator_sum);
+
+    // store the code object into the cache.  compile_ms is how long
+    // it took to produce the code object, which is the time saved
+    // each time it's found in the cache.
     void store_code_object(const std::string&          kernel_name,
                            const std::string&          gpu_arch,
                            int                         hip_version,
                            const std::array<char, 32>& generator_sum,
-                           const std::vector<char>&    code);
+                           const std::vector<char>&    code,
+                           size_t                      compile_ms = 0);
+
+    // get a twiddle table that was generated on the host, keyed by
+    // the arguments to twiddle creation.  returns empty vector if a
+    // matching table was not found.
+    std::vector<char> get_twiddles(size_t                     length,
+                                   size_t                     length_limit,
+                                   rocfft_precision           precision,
+                                   size_t                     large_twiddle_base,
+                                   bool                       attach_halfN,
+                                   const std::vector<size_t>& radices);
+
+    // store a host-generated twiddle table into the user cache
+    void store_twiddles(size_t                     length,
+                        size_t                     length_limit,
+                        rocfft_precision           precision,
+                        size_t                     large_twiddle_base,
+                        bool                       attach_halfN,
+                        const std::vector<size_t>& radices,
+                        const std::vector<char>&   data);
+
+    // get number of entries and total code size in the user cache,
+    // plus hits, misses and compile time saved since this cache was
+    // opened.  null pointers are ignored.
+    rocfft_status get_stats(size_t* entries,
+                            size_t* size_bytes,
+                            size_t* hits,
+                            size_t* misses,
+                            double* time_saved_ms);
 
     // allocates buffer, call serialize_free to free it
     rocfft_status serialize(void** buffer, size_t* buffer_len_bytes);
@@ -85,6 +126,10 @@ struct RTCCache
 private:
     sqlite3_ptr connect_db(const std::filesystem::path& path, bool readonly);
 
+    // evict least-recently-used kernels and twiddle tables from the
+    // user cache until it fits in max_bytes
+    void evict_lru();
+
     // database handles to system- and user-level caches.  either or
     // both may be a null pointer, if that particular cache could not
     // be located.
@@ -98,7 +143,26 @@ private:
     sqlite3_stmt_ptr get_stmt_user;
     std::mutex       get_mutex_user;
     sqlite3_stmt_ptr store_stmt_user;
+    // statements that modify the user cache share the store mutex
+    sqlite3_stmt_ptr touch_stmt_user;
+    sqlite3_stmt_ptr evict_stmt_user;
     std::mutex       store_mutex_user;
+    // twiddle tables are only kept in the user cache, and share the
+    // user cache mutexes
+    sqlite3_stmt_ptr get_twiddles_stmt_user;
+    sqlite3_stmt_ptr store_twiddles_stmt_user;
+    sqlite3_stmt_ptr touch_twiddles_stmt_user;
+    sqlite3_stmt_ptr evict_twiddles_stmt_user;
+
+    // maximum size of code and twiddle tables in the user cache, 0
+    // for no limit
+    size_t max_bytes = 0;
+
+    // usage counters
+    std::mutex stats_mutex;
+    size_t     hits          = 0;
+    size_t     misses        = 0;
+    double     time_saved_ms = 0.0;
 
     // lock around deserialization, since that attaches a fixed-name
     // schema to the db and we don't want a collision
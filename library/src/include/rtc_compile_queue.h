@@ -0,0 +1,149 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ROCFFT_RTC_COMPILE_QUEUE_H
+#define ROCFFT_RTC_COMPILE_QUEUE_H
+
+#include "rtc.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Process-wide pool of threads that compile kernels.
+//
+// Every plan needs a few kernels compiled (or fetched from the
+// cache), and plans may be created from many threads at once.
+// Compilations are queued here and run by a bounded number of
+// worker threads, rather than each one getting its own thread.
+//
+// Requests for a kernel that is already queued or being compiled
+// share the existing request's future instead of compiling the
+// kernel again.
+//
+// The number of threads defaults to the number of hardware threads,
+// and can be set with the ROCFFT_RTC_COMPILE_THREADS environment
+// variable.  Threads are started on demand.
+//
+// Queue statistics are written to the profile log each time a
+// compilation finishes.
+class CompileQueue
+{
+public:
+    typedef std::shared_future<std::unique_ptr<RTCKernel>> future_t;
+    typedef std::function<std::unique_ptr<RTCKernel>()>    compile_func_t;
+
+    // deviceId for compilations that don't load the kernel onto
+    // any device
+    static const int NO_DEVICE = -1;
+
+    // identifies a compilation: kernels are loaded onto a specific
+    // device, so identical kernels for different devices are
+    // distinct requests
+    struct key_t
+    {
+        std::string kernel_name;
+        std::string gpu_arch;
+        int         deviceId = 0;
+
+        bool operator<(const key_t& other) const
+        {
+            return std::tie(kernel_name, gpu_arch, deviceId)
+                   < std::tie(other.kernel_name, other.gpu_arch, other.deviceId);
+        }
+    };
+
+    struct stats_t
+    {
+        size_t threads         = 0;
+        size_t max_threads     = 0;
+        size_t submitted       = 0;
+        size_t deduplicated    = 0;
+        size_t completed       = 0;
+        size_t queue_depth     = 0;
+        size_t max_queue_depth = 0;
+        // time compilations spent waiting in the queue for a thread
+        std::chrono::duration<double, std::milli> total_wait{0};
+        std::chrono::duration<double, std::milli> max_wait{0};
+    };
+
+    // queue is a singleton, so no copying or assignment
+    CompileQueue(const CompileQueue&) = delete;
+    CompileQueue& operator=(const CompileQueue&) = delete;
+
+    ~CompileQueue();
+
+    static CompileQueue& GetCompileQueue();
+
+    // Queue a compilation, or return the future for an identical
+    // one that is already queued or running.  The compile function
+    // runs on a worker thread with key.deviceId as the current
+    // device, unless it's NO_DEVICE.
+    future_t Submit(const key_t& key, compile_func_t compile);
+
+    // read the configured thread count from the environment
+    static void Setup();
+
+    // Wait for queued compilations to finish and stop the worker
+    // threads.  Threads are restarted by the next Submit.
+    static void Stop();
+
+private:
+    CompileQueue();
+
+    // read thread count from the environment
+    static size_t ConfiguredThreads();
+
+    void WorkerLoop();
+    void StopWorkers();
+
+    // write stats to the profile log, after kernel_name has been
+    // compiled
+    static void LogStats(const std::string& kernel_name, const stats_t& s);
+
+    struct item_t
+    {
+        key_t                                              key;
+        compile_func_t                                     compile;
+        std::promise<std::unique_ptr<RTCKernel>>           result;
+        std::chrono::time_point<std::chrono::steady_clock> queued_at;
+    };
+
+    std::deque<item_t>        queue;
+    std::map<key_t, future_t> in_flight;
+    std::vector<std::thread>  workers;
+    size_t                    idle_workers = 0;
+    bool                      stopping     = false;
+    stats_t                   stats;
+
+    std::mutex              mtx;
+    std::condition_variable cv;
+};
+
+#endif // ROCFFT_RTC_COMPILE_QUEUE_H
@@ -0,0 +1,62 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ROCFFT_RTC_HELPER_PROTOCOL_H
+#define ROCFFT_RTC_HELPER_PROTOCOL_H
+
+#include <cstdint>
+
+// rocfft_rtc_helper command line is:
+//
+//   rocfft_rtc_helper [--server] [--fake] gfxNNN
+//
+// Without --server, the helper reads one kernel's source from stdin
+// until EOF, and writes the code object (or an error message, with
+// a non-zero exit status) to stdout.
+//
+// With --server, the helper is long-lived and compiles a stream of
+// requests.  Each request written to the helper's stdin is:
+//
+//   uint64_t  length of kernel source in bytes
+//   char[]    kernel source
+//
+// For each request, in order, the helper writes to stdout:
+//
+//   uint64_t  status, RTC_HELPER_OK or RTC_HELPER_ERROR
+//   uint64_t  length of payload in bytes
+//   char[]    payload - code object if OK, otherwise error message
+//
+// Several requests may be written before reading any responses.
+// The helper exits when its stdin is closed.  Integers are in the
+// native byte order, since the helper always runs on the same
+// machine as the library.
+//
+// --fake replaces the compiler with a trivial backend that returns
+// the kernel source as the "code object", and fails on empty
+// source.  It allows the helper protocol to be tested without a GPU
+// or compiler.
+
+static const char* const RTC_HELPER_SERVER_ARG = "--server";
+static const char* const RTC_HELPER_FAKE_ARG   = "--fake";
+
+static const uint64_t RTC_HELPER_OK    = 0;
+static const uint64_t RTC_HELPER_ERROR = 1;
+
+#endif // ROCFFT_RTC_HELPER_PROTOCOL_H
@@ -0,0 +1,159 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SCHEME_TABLE_H
+#define SCHEME_TABLE_H
+
+#include "tree_node.h"
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Tuned decision for one problem: the scheme to use, how to split
+// the length, and which fusions not to do.
+struct SchemeTuning
+{
+    // CS_NONE leaves the scheme to the usual heuristics
+    ComputeScheme scheme = CS_NONE;
+    // divLength1 for 1D decompositions, 0 if the scheme has none
+    size_t             factor = 0;
+    std::set<FuseType> disabledFusions;
+};
+
+// Per-architecture table of scheme decisions.
+//
+// Entries map (lengths, precision, architecture) to a SchemeTuning.
+// The number of lengths is the dimension of the problem.  The
+// architecture is a name like "gfx90a" (feature flags after ':' are
+// ignored), or "any" for entries that apply to every architecture.
+// An entry for the device's architecture is preferred over an "any"
+// entry.
+//
+// The built-in table holds rocFFT's default tunings.  If
+// ROCFFT_SCHEME_TABLE names a file, its entries are added on top,
+// replacing built-in entries with the same key.  A file that can't
+// be read is reported on stderr and ignored.  Tuning adds more
+// entries while the process runs.
+//
+// The process-wide table is replaced rather than modified, so
+// callers keep the shared_ptr they got for as long as they use
+// entries from it.
+//
+// The text format is one entry per line, '#' starting a comment:
+//
+//   rocfft_scheme_table <version>
+//   <arch> <single|double> <len0>[x<len1>[x<len2>]] <scheme|-> <factor> [<fuse type>,...]
+//
+// e.g. "gfx90a double 43008 CS_L1D_CC 224" or
+// "gfx906 single 168 - 0 FT_STOCKHAM_WITH_TRANS".  The last column
+// lists the fusions to disable.
+class SchemeTable
+{
+public:
+    static const unsigned int VERSION = 1;
+
+    SchemeTable() = default;
+
+    // Table to use for plans created on this thread: the override,
+    // if one is active, otherwise the built-in table plus
+    // ROCFFT_SCHEME_TABLE, loaded on first use.
+    static std::shared_ptr<const SchemeTable> GetSchemeTable();
+
+    // add an entry to the process-wide table
+    static void Install(const std::string&         arch,
+                        rocfft_precision           precision,
+                        const std::vector<size_t>& length,
+                        const SchemeTuning&        tuning);
+
+    // drop the process-wide table, including installed entries, so
+    // it's loaded again on next use
+    static void Reset();
+
+    // Use a different table for plans created on this thread while
+    // the override exists.  Plans created with an override are not
+    // put in or taken from the plan cache.
+    class ScopedOverride
+    {
+    public:
+        explicit ScopedOverride(std::shared_ptr<const SchemeTable> table);
+        ~ScopedOverride();
+
+        ScopedOverride(const ScopedOverride&) = delete;
+        ScopedOverride& operator=(const ScopedOverride&) = delete;
+
+        static bool Active();
+
+    private:
+        std::shared_ptr<const SchemeTable> previous;
+    };
+
+    // rocFFT's default tunings
+    static SchemeTable BuiltIn();
+
+    // Find the tuning for a problem, or nullptr if there is none.
+    // Only the first 'dimension' lengths are used.
+    const SchemeTuning* Find(const std::vector<size_t>& length,
+                             size_t                     dimension,
+                             rocfft_precision           precision,
+                             const std::string&         arch) const;
+    const SchemeTuning* Find(const std::vector<size_t>& length,
+                             size_t                     dimension,
+                             rocfft_precision           precision,
+                             const hipDeviceProp_t&     prop) const
+    {
+        return Find(length, dimension, precision, std::string(prop.gcnArchName));
+    }
+
+    // 1D lengths that have an entry using 'scheme', on any
+    // architecture
+    std::vector<size_t> Lengths1D(rocfft_precision precision, ComputeScheme scheme) const;
+
+    // add an entry, replacing any existing entry with the same key
+    void Add(const std::string&         arch,
+             rocfft_precision           precision,
+             const std::vector<size_t>& length,
+             const SchemeTuning&        tuning);
+
+    // Read entries in the text format, adding them to this table.
+    // Throws std::runtime_error on malformed input or an unsupported
+    // version, without modifying the table.
+    void Load(std::istream& is);
+    // write the table in the text format
+    void Write(std::ostream& os) const;
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+private:
+    // architecture name without feature flags
+    static std::string ArchName(const std::string& arch);
+
+    typedef std::tuple<std::vector<size_t>, rocfft_precision, std::string> key_t;
+    std::map<key_t, SchemeTuning>                                          entries;
+};
+
+#endif // SCHEME_TABLE_H
@@ -28,6 +28,8 @@ struct rocfft_execution_info_t
     void*       workBuffer;
     size_t      workBufferSize;
     hipStream_t rocfft_stream = 0; // by default it is stream 0
+    // how to launch the plan's kernels
+    rocfft_launch_mode launchMode = rocfft_launch_mode_direct;
     rocfft_execution_info_t()
         : workBuffer(nullptr)
         , workBufferSize(0)
@@ -36,7 +38,10 @@ struct rocfft_execution_info_t
     UserCallbacks callbacks;
 };
 
+struct ExecPlanLaunchCache;
+
 void TransformPowX(const ExecPlan&       execPlan,
+                   ExecPlanLaunchCache&  launchCache,
                    void*                 in_buffer[],
                    void*                 out_buffer[],
                    rocfft_execution_info info);
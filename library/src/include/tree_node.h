@@ -34,6 +34,7 @@
 #include "../device/kernels/common.h"
 #include "compute_scheme.h"
 #include "kargs.h"
+#include "rocfft.h"
 #include "rtc.h"
 #include <hip/hip_runtime_api.h>
 
@@ -65,16 +66,11 @@ enum FuseType
     FT_STOCKHAM_R2C_TRANSPOSE, // Stokham + post-r2c + transpose (Advance of FT_R2C_TRANSPOSE)
 };
 
-// TODO: move this to rocfft.h and allow users to select via plan description
-// the decision strategy for buffer assigment
-enum rocfft_optimize_strategy
-{
-    rocfft_optimize_min_buffer, // minimize number of buffers, possibly fewer fusions
-    rocfft_optimize_balance, // balance between buffer and fusion
-    rocfft_optimize_max_fusion, // maximize number of fusions, possibly more buffers
-};
-
 std::string PrintOperatingBuffer(const OperatingBuffer ob);
+// bytes needed for one FFT of the given lengths, precision and array type
+size_t      data_size_bytes(const std::vector<size_t>& lengths,
+                            rocfft_precision           precision,
+                            rocfft_array_type          type);
 std::string PrintOperatingBufferCode(const OperatingBuffer ob);
 std::string PrintSBRCTransposeType(const SBRC_TRANSPOSE_TYPE ty);
 std::string PrintDirectToFromRegMode(const DirectRegType ty);
@@ -98,6 +94,12 @@ struct GridParam
         , lds_bytes(0)
     {
     }
+
+    bool operator==(const GridParam& other) const
+    {
+        return b_x == other.b_x && b_y == other.b_y && b_z == other.b_z && wgs_x == other.wgs_x
+               && wgs_y == other.wgs_y && wgs_z == other.wgs_z && lds_bytes == other.lds_bytes;
+    }
 };
 
 static bool is_device_gcn_arch(const hipDeviceProp_t& prop, const std::string& cmpTarget)
@@ -330,10 +332,8 @@ public:
     size_t           twiddles_size       = 0;
     void*            twiddles_large      = nullptr;
     size_t           twiddles_large_size = 0;
-    gpubuf_t<size_t> devKernArg;
-
-    // callback parameters
-    UserCallbacks callbacks;
+    // length and stride arrays, in the plan's kernel argument buffer
+    size_t* devKernArg = nullptr;
 
     hipDeviceProp_t deviceProp = {};
 
@@ -432,8 +432,7 @@ public:
     // Determine work memory requirements:
     void DetermineBufferMemory(size_t& tmpBufSize,
                                size_t& cmplxForRealSize,
-                               size_t& blueSize,
-                               size_t& chirpSize);
+                               size_t& blueSize);
 
     // Output plan information for debug purposes:
     void Print(rocfft_ostream& os, int indent = 0) const;
@@ -472,10 +471,12 @@ public:
         return false;
     }
 
-    virtual bool KernelCheck()                                             = 0;
-    virtual bool CreateDevKernelArgs()                                     = 0;
-    virtual bool CreateTwiddleTableResource()                              = 0;
-    virtual void SetupGridParamAndFuncPtr(DevFnCall& fnPtr, GridParam& gp) = 0;
+    // AppendKernelArgs adds the kernel's length and stride arrays to
+    // the plan's packed kernel arguments, and returns their offset
+    virtual bool   KernelCheck()                                             = 0;
+    virtual size_t AppendKernelArgs(std::vector<size_t>& kernArgs)           = 0;
+    virtual bool   CreateTwiddleTableResource()                              = 0;
+    virtual void   SetupGridParamAndFuncPtr(DevFnCall& fnPtr, GridParam& gp) = 0;
 
     // for 3D SBRC kernels, decide the transpose type based on the
     // block width and lengths that the block tiles need to align on.
@@ -504,10 +505,10 @@ protected:
         nodeType = NT_INTERNAL;
     }
 
-    bool CreateDevKernelArgs() override
+    size_t AppendKernelArgs(std::vector<size_t>& kernArgs) override
     {
-        throw std::runtime_error("Shouldn't call CreateDevKernelArgs in a non-LeafNode");
-        return false;
+        throw std::runtime_error("Shouldn't call AppendKernelArgs in a non-LeafNode");
+        return 0;
     }
 
     bool CreateTwiddleTableResource() override
@@ -564,7 +565,7 @@ protected:
 public:
     bool         KernelCheck() override;
     void         SanityCheck() override;
-    virtual bool CreateDevKernelArgs() override;
+    size_t       AppendKernelArgs(std::vector<size_t>& kernArgs) override;
     bool         CreateTwiddleTableResource() override;
     void         SetupGridParamAndFuncPtr(DevFnCall& fnPtr, GridParam& gp) override;
     void         GetKernelFactors();
@@ -619,21 +620,42 @@ struct ExecPlan
     std::vector<DevFnCall> devFnCall;
     std::vector<GridParam> gridParam;
 
+    // length and stride arrays of all the kernels in execSeq.  leaf
+    // nodes point into this buffer.
+    std::shared_ptr<gpubuf_t<size_t>> kernArgs;
+
     hipDeviceProp_t deviceProp;
 
+    // true if the plan is only being decided, without a device.
+    // deviceProp is then supplied by the caller, kernels are not
+    // loaded, and nothing is allocated on a device.
+    bool deviceFree = false;
+    // whether a device-free plan compiles its kernels into the
+    // cache, or skips compilation entirely
+    bool deviceFreeCompile = false;
+
+    // name of each kernel in execSeq, for reporting
+    std::vector<std::string> kernelNames;
+
     std::vector<size_t> iLength;
     std::vector<size_t> oLength;
 
-    // default: starting from ABT, balance buffers and fusions
-    // we could allow users to set in the later PR
+    // default: starting from ABT, balance buffers and fusions.
+    // users can choose another strategy via the plan description.
     rocfft_optimize_strategy assignOptStrategy = rocfft_optimize_balance;
 
     // these sizes count in complex elements
-    size_t workBufSize      = 0;
-    size_t tmpWorkBufSize   = 0;
-    size_t copyWorkBufSize  = 0;
-    size_t blueWorkBufSize  = 0;
-    size_t chirpWorkBufSize = 0;
+    size_t workBufSize     = 0;
+    size_t tmpWorkBufSize  = 0;
+    size_t copyWorkBufSize = 0;
+    size_t blueWorkBufSize = 0;
+
+    // offsets of the temp regions in the work buffer, also in
+    // complex elements.  regions that are never live at the same
+    // time may overlap.
+    size_t tmpWorkBufOffset  = 0;
+    size_t copyWorkBufOffset = 0;
+    size_t blueWorkBufOffset = 0;
 
     size_t WorkBufBytes(size_t base_type_size) const
     {
@@ -648,6 +670,11 @@ struct ExecPlan
 };
 
 void ProcessNode(ExecPlan& execPlan);
+// Check a plan whose tree is fully decided (schemes, buffers,
+// strides, fusions), work out its work buffer requirements and
+// compile its kernels.  Called at the end of ProcessNode, and when
+// loading a serialized plan.
+void FinalizePlan(ExecPlan& execPlan);
 void PrintNode(rocfft_ostream& os, const ExecPlan& execPlan);
 
 #endif // TREE_NODE_H
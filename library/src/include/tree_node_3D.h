@@ -255,7 +255,7 @@ protected:
     }
 
 public:
-    bool CreateDevKernelArgs() override;
+    size_t AppendKernelArgs(std::vector<size_t>& kernArgs) override;
     bool UseOutputLengthForPadding() override
     {
         return true;
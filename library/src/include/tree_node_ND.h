@@ -0,0 +1,58 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef TREE_NODE_ND_H
+#define TREE_NODE_ND_H
+
+#include "tree_node.h"
+
+// copy of 'v' with element 'dim' moved to the front, and the others
+// kept in order behind it
+std::vector<size_t> DimToFront(const std::vector<size_t>& v, size_t dim);
+
+// Column FFTs along dimension 'dim' of 'length', with every other
+// dimension as batch, done in-place.  Uses an SBCC kernel if there
+// is one for the length, or whatever 1D node suits it otherwise.
+std::unique_ptr<TreeNode>
+    CreateColumnNode(TreeNode* parent, const std::vector<size_t>& length, size_t dim);
+
+/*****************************************************
+ * CS_ND_RC  *
+ * Transforms of more than 3 dimensions.
+ * R: one node for the innermost dimensions, which is
+ *   3D_RC, 2D_SINGLE or 2D_RC if the dimensions can be
+ *   done that way, or a 1D node otherwise,
+ * C: in-place column FFTs along each other dimension.
+ *****************************************************/
+class RCNDNode : public InternalNode
+{
+    friend class NodeFactory;
+
+protected:
+    explicit RCNDNode(TreeNode* p)
+        : InternalNode(p)
+    {
+        scheme = CS_ND_RC;
+    }
+    void AssignParams_internal() override;
+    void BuildTree_internal() override;
+};
+
+#endif // TREE_NODE_ND_H
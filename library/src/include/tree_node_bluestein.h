@@ -38,11 +38,15 @@ protected:
     }
     void AssignParams_internal() override;
     void BuildTree_internal() override;
+
+private:
+    // build the children for the current lengthBlue
+    void BuildChildren();
 };
 
 /*****************************************************
  * Component of Bluestein
- * Chirp, XXXMul
+ * XXXMul
  *****************************************************/
 class BluesteinComponentNode : public LeafNode
 {
@@ -70,6 +74,8 @@ protected:
         }
     }
 
+    // the chirp filter, shared through the repo
+    bool CreateTwiddleTableResource() override;
     void SetupGPAndFnPtr_internal(DevFnCall& fnPtr, GridParam& gp) override;
 };
 
@@ -133,6 +133,26 @@ protected:
     void AssignParams_internal_TR_pairs();
 };
 
+/*****************************************************
+ * CS_REAL_ND_EVEN
+ * Real transforms of more than 3 dimensions: the real
+ * even transform of the rows, and in-place column FFTs
+ * (see CS_ND_RC) along each other dimension.
+ *****************************************************/
+class RealNDEvenNode : public InternalNode
+{
+    friend class NodeFactory;
+
+protected:
+    explicit RealNDEvenNode(TreeNode* p)
+        : InternalNode(p)
+    {
+        scheme = CS_REAL_ND_EVEN;
+    }
+    void AssignParams_internal() override;
+    void BuildTree_internal() override;
+};
+
 /*****************************************************
  * CS_KERNEL_COPY_R_TO_CMPLX
  * CS_KERNEL_COPY_HERM_TO_CMPLX
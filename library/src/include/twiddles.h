@@ -28,6 +28,44 @@
 static const size_t LTWD_BASE_DEFAULT       = 8;
 static const size_t LARGE_TWIDDLE_THRESHOLD = 4096;
 
+// A run of values in a twiddle buffer.  Buffers built the same
+// way hold the same values, so a table can be served from any buffer
+// that has a matching run.
+struct TwiddleSegment
+{
+    enum Kind
+    {
+        // exp(-2*pi*i*k/length)
+        LINEAR,
+        // per-pass Stockham twiddles for 'radices'.  the table for a
+        // prefix of the radices is a prefix of this table
+        RADICES,
+        // large twiddles for 'length' with base 'base'
+        LARGE,
+        // Bluestein chirp of 'length' padded to 'base', and its FFT
+        CHIRP,
+    };
+    Kind                kind      = LINEAR;
+    size_t              length    = 0;
+    size_t              base      = 0;
+    int                 direction = 0;
+    std::vector<size_t> radices;
+    // number of complex values in the run
+    size_t count = 0;
+
+    // true if this run begins with all of 'other's values
+    bool Contains(const TwiddleSegment& other) const;
+};
+
+// the runs that the buffers made by the functions below are built from
+std::vector<TwiddleSegment> twiddles_layout(size_t                     N,
+                                            size_t                     length_limit,
+                                            size_t                     largeTwdBase,
+                                            bool                       attach_halfN,
+                                            const std::vector<size_t>& radices);
+std::vector<TwiddleSegment> twiddles_layout_2D(size_t N1, size_t N2, rocfft_precision precision);
+std::vector<TwiddleSegment> chirp_layout(size_t N, size_t M, int direction);
+
 gpubuf twiddles_create(size_t                     N,
                        size_t                     length_limit,
                        rocfft_precision           precision,
@@ -35,5 +73,9 @@ gpubuf twiddles_create(size_t                     N,
                        bool                       attach_halfN,
                        const std::vector<size_t>& radices);
 gpubuf twiddles_create_2D(size_t N1, size_t N2, rocfft_precision precision);
+// Bluestein chirp filter for a transform of length N using
+// convolutions of length M: the zero-padded chirp, followed by its
+// length-M FFT.  Computed on the host in double precision.
+gpubuf chirp_create(size_t N, size_t M, rocfft_precision precision, int direction);
 
 #endif // defined( TWIDDLES_H )
@@ -0,0 +1,147 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef WORK_BUFFER_POOL_H
+#define WORK_BUFFER_POOL_H
+
+#include "../../shared/gpubuf.h"
+
+#include <list>
+#include <map>
+#include <mutex>
+
+// Process-wide pool of work buffers for rocfft_execute.
+//
+// When the caller doesn't provide a work buffer, rocfft_execute
+// needs one for the duration of the transform.  Allocating and
+// freeing it on every call is a synchronous round trip to the
+// allocator, so buffers are kept in a pool and reused across
+// executions and plans.
+//
+// Buffers are pooled per device and per stream.  Releasing a buffer
+// records an event on its stream after the queued transform, and the
+// next transform to borrow it makes its own stream wait for that
+// event, without blocking the host.  So a buffer is reused safely
+// even if its stream was destroyed with work still queued and the
+// stream's handle then given to a new stream.
+// Requests are rounded up to size classes (four per power of two)
+// so that similar sizes share buffers.
+//
+// The idle memory kept per device is limited by
+// ROCFFT_WORK_BUFFER_POOL_SIZE, in bytes.  When over the limit, the
+// least-recently-released buffers are freed.  A limit of 0 disables
+// pooling, so each execution allocates and frees its own buffer.
+class WorkBufferPool
+{
+public:
+    // a buffer borrowed from the pool, returned to the pool when
+    // destroyed
+    class buffer_t
+    {
+    public:
+        buffer_t()           = default;
+        buffer_t(buffer_t&&) = default;
+        buffer_t& operator=(buffer_t&&) = default;
+        ~buffer_t();
+
+        void* data() const
+        {
+            return buf.data();
+        }
+
+    private:
+        friend class WorkBufferPool;
+
+        int         deviceId = 0;
+        hipStream_t stream   = nullptr;
+        // false if the buffer is freed instead of returned
+        bool        pooled   = false;
+        gpubuf      buf;
+    };
+
+    struct stats_t
+    {
+        size_t hits         = 0;
+        size_t misses       = 0;
+        size_t evictions    = 0;
+        // bytes borrowed by executing transforms, and bytes waiting
+        // in the pool for reuse
+        size_t in_use_bytes = 0;
+        size_t idle_bytes   = 0;
+        // highest in_use_bytes + idle_bytes seen
+        size_t peak_bytes   = 0;
+    };
+
+    // pool is a singleton, so no copying or assignment
+    WorkBufferPool(const WorkBufferPool&) = delete;
+    WorkBufferPool& operator=(const WorkBufferPool&) = delete;
+
+    static WorkBufferPool& GetWorkBufferPool();
+
+    // Borrow a buffer of at least size_bytes for work queued on
+    // stream, on the current device.  Throws on allocation failure.
+    buffer_t Acquire(size_t size_bytes, hipStream_t stream);
+
+    // Free idle buffers until at most keep_bytes remain idle on each
+    // device.
+    void Trim(size_t keep_bytes);
+
+    // read the configured limit from the environment
+    static void Setup();
+
+    // free all idle buffers and reset counters
+    static void Clear();
+
+private:
+    WorkBufferPool();
+
+    // read idle limit from the environment
+    static size_t ConfiguredLimit();
+
+    // size of buffer allocated for a request of size_bytes
+    static size_t SizeClass(size_t size_bytes);
+
+    void Release(buffer_t& buffer);
+
+    // Move the least-recently-released idle buffers of a device into
+    // evicted until at most keep_bytes remain idle.  Buffers are
+    // freed by the caller, outside the lock.
+    void EvictIdle(int deviceId, size_t keep_bytes, std::list<gpubuf>& evicted);
+
+    void LogStats(const char* event, size_t size_bytes) const;
+
+    struct idle_buffer_t
+    {
+        hipStream_t stream;
+        gpubuf      buf;
+        // recorded on stream when the buffer was released
+        hipEvent_t released;
+    };
+
+    // idle buffers for each device, least-recently-released first
+    std::map<int, std::list<idle_buffer_t>> idle;
+    std::map<int, size_t>                   idle_bytes;
+    size_t                                  limit = 0;
+    stats_t                                 stats;
+    mutable std::mutex                      mtx;
+};
+
+#endif // WORK_BUFFER_POOL_H
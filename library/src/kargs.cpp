@@ -24,27 +24,21 @@
 #include "rocfft_hip.h"
 #include <cassert>
 
-// malloc device buffer; copy host buffer to device buffer
-gpubuf_t<size_t> kargs_create(std::vector<size_t> length,
-                              std::vector<size_t> inStride,
-                              std::vector<size_t> outStride,
-                              size_t              iDist,
-                              size_t              oDist)
+size_t kargs_append(std::vector<size_t>&       kernArgs,
+                    const std::vector<size_t>& length,
+                    const std::vector<size_t>& inStride,
+                    const std::vector<size_t>& outStride,
+                    size_t                     iDist,
+                    size_t                     oDist)
 {
-    gpubuf_t<size_t> devk;
-    if(devk.alloc(3 * KERN_ARGS_ARRAY_WIDTH * sizeof(size_t)) != hipSuccess)
-        return devk;
-
-    size_t devkHost[3 * KERN_ARGS_ARRAY_WIDTH];
-
-    size_t i = 0;
-    while(i < 3 * KERN_ARGS_ARRAY_WIDTH)
-        devkHost[i++] = 0;
+    const size_t offset = kernArgs.size();
+    kernArgs.resize(offset + 3 * KERN_ARGS_ARRAY_WIDTH, 0);
+    size_t* devkHost = kernArgs.data() + offset;
 
     assert(length.size() == inStride.size());
     assert(length.size() == outStride.size());
 
-    i = 0;
+    size_t i = 0;
     while(i < length.size())
     {
         devkHost[i + 0 * KERN_ARGS_ARRAY_WIDTH] = length[i];
@@ -58,8 +52,17 @@ gpubuf_t<size_t> kargs_create(std::vector<size_t> length,
     devkHost[i + 1 * KERN_ARGS_ARRAY_WIDTH] = iDist;
     devkHost[i + 2 * KERN_ARGS_ARRAY_WIDTH] = oDist;
 
+    return offset;
+}
+
+gpubuf_t<size_t> kargs_create(const std::vector<size_t>& kernArgs)
+{
+    gpubuf_t<size_t> devk;
+    if(devk.alloc(kernArgs.size() * sizeof(size_t)) != hipSuccess)
+        return devk;
+
     if(hipMemcpy(
-           devk.data(), devkHost, 3 * KERN_ARGS_ARRAY_WIDTH * sizeof(size_t), hipMemcpyHostToDevice)
+           devk.data(), kernArgs.data(), kernArgs.size() * sizeof(size_t), hipMemcpyHostToDevice)
        != hipSuccess)
         devk.free();
     return devk;
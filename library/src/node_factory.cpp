@@ -24,187 +24,19 @@
 #include "fuse_shim.h"
 #include "hip/hip_runtime_api.h"
 #include "logging.h"
+#include "scheme_table.h"
 #include "tree_node_1D.h"
 #include "tree_node_2D.h"
 #include "tree_node_3D.h"
+#include "tree_node_ND.h"
 #include "tree_node_bluestein.h"
 #include "tree_node_real.h"
 
 #include <functional>
+#include <optional>
 #include <set>
 #include <vector>
 
-// TODO:
-//   - better data structure, and more elements for non pow of 2
-//   - validate corresponding functions existing in function pool or not
-//   - SBRC should support un-aligned dim with BWD such as 10752 = 84 x 128(bwd=8)
-NodeFactory::Map1DLength const NodeFactory::map1DLengthSingle = {
-    // ----------------------------------------------------------
-    // pow2 lengths
-    // ----------------------------------------------------------
-    {8192, 64}, //              CC (64cc + 128rc)
-    {16384, 64}, //             CC (64cc + 256rc) // 128x128 no faster
-    {32768, 128}, //            CC (128cc + 256rc)
-    {65536, 256}, //            CC (256cc + 256rc)
-    {131072, 256}, //           CC (256cc + 512rc)
-    {262144, 512}, //           CC (512cc + 512rc)
-
-    // ----------------------------------------------------------
-    // non-pow2 lengths in (4096, 8192)
-    // ----------------------------------------------------------
-    {4704, 96}, //              CC (96cc + 49rc)
-    {4913, 289}, //             CC (289cc + 17rc)
-    {5488, 112}, //             CC (112cc + 49rc)
-    {6144, 96}, //              CC (96cc + 64rc)
-    {6561, 81}, //              CC (81cc + 81rc)
-
-    // ----------------------------------------------------------
-    // non-pow2 lengths in (8192, 16384)
-    // ----------------------------------------------------------
-    {9216, 72}, //              CC (72cc + 128rc)
-    {10000, 100}, //            CC (100cc + 100rc)
-    {10240, 160}, //            CC (160cc + 64rc)
-    {10752, 96}, //             CC (96cc + 112rc)
-    {11200, 224}, //            CC (224cc + 50rc)
-    {12288, 192}, //            CC (192cc + 64rc)
-    {15625, 125}, //            CC (125cc + 125rc)
-
-    // ----------------------------------------------------------
-    // non-pow2 lengths in (16384, 32768)
-    // ----------------------------------------------------------
-    {16807, 343}, //            CC (343cc + 49rc)
-    {17576, 104}, //            CC (104cc + 169rc)
-    {18816, 168}, //            CC (168cc + 112rc)
-    {19200, 192}, //            CC (192cc + 100rc)
-    {19683, 243}, //            CC (243cc + 81rc)
-    {20480, 160}, //            CC (160cc + 128rc)
-    {21504, 168}, //            CC (168cc + 128rc)
-    {21952, 343}, //            CC (343cc + 64rc)
-    {23232, 192}, //            CC (192cc + 121rc)
-    {24576, 192}, //            CC (192cc + 128rc)
-    {26000, 208}, //            CC (208cc + 125rc)
-    {28672, 256}, //            CC (256cc + 112rc)
-    {32256, 168}, //            CC (168cc + 192rc)
-
-    // ----------------------------------------------------------
-    // non-pow2 lengths in (32768, 65536)
-    // ----------------------------------------------------------
-    {34969, 289}, //            CC (289cc + 121rc)
-    {36864, 192}, //            CC (192cc + 192rc)
-    {38880, 160}, //            CC (160cc + 243rc)
-    {40000, 200}, //            CC (200cc + 200rc)
-    {40960, 160}, //            CC (160cc + 256rc)
-    {43008, 168}, //            CC (168cc + 256rc) // CC (224cc + 192rc)
-    {46080, 240}, //            CC (240cc + 192rc)
-    {48000, 240}, //            CC (240cc + 200rc)
-    {49152, 256}, //            CC (256cc + 192rc)
-    {51200, 512}, //            CC (512cc + 100rc)
-    {53248, 208}, //            CC (208cc + 256rc)
-    {57344, 512}, //            CC (512cc + 112rc)
-
-    // ----------------------------------------------------------
-    // non-pow2 lengths in (65536, 131072)
-    // ----------------------------------------------------------
-    {68600, 343}, //            CC (343cc + 200rc)
-    {71344, 208}, //            CC (208cc + 343rc)
-    {73984, 289}, //            CC (289cc + 256rc)
-    {76832, 224}, //            CC (224cc + 343rc)
-    {79860, 60}, //             CC (60cc + 1331rc)
-    {81920, 160}, //            CC (160cc + 512rc)
-    {83521, 289}, //            CC (289cc + 289rc)
-    {87808, 343}, //            CC (343cc + 256rc)
-    {95832, 72}, //             CC (72cc + 1331rc)
-    {98304, 512}, //            CC (512cc + 192rc)
-    {102400, 512}, //           CC (512cc + 200rc)
-    {106496, 208}, //           CC (208cc + 512rc)
-    {110592, 216}, //           CC (216cc + 512rc)
-    {114688, 224}, //           CC (224cc + 512rc)
-};
-
-NodeFactory::Map1DLength const NodeFactory::map1DLengthDouble = {
-    // ----------------------------------------------------------
-    // pow2 lengths
-    // ----------------------------------------------------------
-    {4096, 64}, //              CC (64cc + 64rc)
-    {8192, 64}, //              CC (64cc + 128rc)
-    {16384, 64}, //             CC (64cc + 256rc) // 128x128 ?
-    {32768, 128}, //            CC (128cc + 256rc)
-    {65536, 256}, //            CC (256cc + 256rc) // {65536, 64}
-    {131072, 256}, //           CC (256cc + 512rc)
-    {262144, 512}, //           CC (512cc + 512rc)
-
-    // ----------------------------------------------------------
-    // non-pow2 lengths in (4096, 8192)
-    // ----------------------------------------------------------
-    {4704, 96}, //              CC (96cc + 49rc)
-    {4913, 289}, //             CC (289cc + 17rc)
-    {5488, 112}, //             CC (112cc + 49rc)
-    {6144, 96}, //              CC (96cc + 64rc)
-    {6561, 81}, //              CC (81cc + 81rc)
-
-    // ----------------------------------------------------------
-    // non-pow2 lengths in (8192, 16384)
-    // ----------------------------------------------------------
-    {9216, 72}, //              CC (72cc + 128rc)
-    {10000, 100}, //            CC (100cc + 100rc)
-    {10240, 160}, //            CC (160cc + 64rc)
-    {10752, 96}, //             CC (96cc + 112rc)
-    {11200, 224}, //            CC (224cc + 50rc)
-    {12288, 192}, //            CC (192cc + 64rc)
-    {15625, 125}, //            CC (125cc + 125rc)
-
-    // ----------------------------------------------------------
-    // non-pow2 lengths in (16384, 32768)
-    // ----------------------------------------------------------
-    {16807, 343}, //            CC (343cc + 49rc)
-    {17576, 104}, //            CC (104cc + 169rc)
-    {18816, 168}, //            CC (168cc + 112rc)
-    {19200, 192}, //            CC (192cc + 100rc)
-    {19683, 243}, //            CC (243cc + 81rc)
-    {20480, 160}, //            CC (160cc + 128rc)
-    {21504, 168}, //            CC (168cc + 128rc)
-    {21952, 343}, //            CC (343cc + 64rc)
-    {23232, 192}, //            CC (192cc + 121rc)
-    {24576, 192}, //            CC (192cc + 128rc)
-    {26000, 208}, //            CC (208cc + 125rc)
-    {28672, 256}, //            CC (256cc + 112rc)
-    {32256, 168}, //            CC (168cc + 192rc)
-
-    // ----------------------------------------------------------
-    // non-pow2 lengths in (32768, 65536)
-    // ----------------------------------------------------------
-    {34969, 289}, //            CC (289cc + 121rc)
-    {36864, 192}, //            CC (192cc + 192rc)
-    {38880, 160}, //            CC (160cc + 243rc)
-    {40000, 200}, //            CC (200cc + 200rc)
-    {40960, 160}, //            CC (160cc + 256rc)
-    {43008, 168}, //            CC (168cc + 256rc) // or (224cc + 192rc)
-    {46080, 240}, //            CC (240cc + 192rc)
-    {48000, 240}, //            CC (240cc + 200rc)
-    {49152, 256}, //            CC (256cc + 192rc)
-    {51200, 512}, //            CC (512cc + 100rc)
-    {53248, 208}, //            CC (208cc + 256rc)
-    {57344, 512}, //            CC (512cc + 112rc)
-
-    // ----------------------------------------------------------
-    // non-pow2 lengths in (65536, 131072)
-    // ----------------------------------------------------------
-    {68600, 343}, //            CC (343cc + 200rc)
-    {71344, 208}, //            CC (208cc + 343rc)
-    {76832, 224}, //            CC (224cc + 343rc)
-    {78125, 125}, //            CC (125cc + 625rc)
-    {79860, 60}, //             CC (60cc + 1331rc)
-    {81920, 160}, //            CC (160cc + 512rc)
-    {83521, 289}, //            CC (289cc + 289rc)
-    {87808, 343}, //            CC (343cc + 256rc)
-    {95832, 72}, //             CC (72cc + 1331rc)
-    {98304, 512}, //            CC (512cc + 192rc)
-    {102400, 512}, //           CC (512cc + 200rc)
-    {106496, 208}, //           CC (208cc + 512rc)
-    {110592, 216}, //           CC (216cc + 512rc)
-    {114688, 224}, //           CC (224cc + 512rc)
-};
-
 //
 // Factorisation helpers
 //
@@ -270,22 +102,27 @@ inline size_t get_largest_supported_factor(rocfft_precision precision, size_t le
     return search_pool(precision, length, supported_factor);
 }
 
-bool NodeFactory::Large1DLengthsValid(const NodeFactory::Map1DLength& map1DLength,
-                                      rocfft_precision                precision)
+bool NodeFactory::Large1DTuningValid(size_t              length,
+                                     const SchemeTuning& tuning,
+                                     rocfft_precision    precision)
 {
-    for(const auto& pair : map1DLength)
-    {
-        if(pair.first % pair.second != 0)
-            return false;
-
-        if(!function_pool::has_SBCC_kernel(pair.second, precision))
-            return false;
+    if(tuning.factor <= 1 || length % tuning.factor != 0)
+        return false;
 
-        if(!function_pool::has_SBRC_kernel(pair.first / pair.second, precision))
-            return false;
+    switch(tuning.scheme)
+    {
+    case CS_L1D_CC:
+        return function_pool::has_SBCC_kernel(tuning.factor, precision)
+               && function_pool::has_SBRC_kernel(length / tuning.factor, precision);
+    case CS_L1D_CRT:
+        return function_pool::has_SBCC_kernel(tuning.factor, precision)
+               && function_pool::has_function(fpkey(length / tuning.factor, precision));
+    case CS_L1D_TRTRT:
+        // children are decided recursively
+        return true;
+    default:
+        return false;
     }
-
-    return true;
 }
 
 // Checks whether the non-pow2 length input is supported for a Bluestein compute scheme
@@ -306,18 +143,10 @@ bool NodeFactory::NonPow2LengthSupported(rocfft_precision precision, size_t leng
     if(function_pool::has_function(fpkey(length, precision)))
         return true;
 
-    assert(Large1DLengthsValid(map1DLengthSingle, precision));
-    assert(Large1DLengthsValid(map1DLengthDouble, precision));
-
     // and for supported block CC + RC Stockham decompositions
-    if(precision == rocfft_precision_single
-       && (map1DLengthSingle.find(length) != map1DLengthSingle.end()))
-        return true;
-    if(precision == rocfft_precision_double
-       && (map1DLengthDouble.find(length) != map1DLengthDouble.end()))
-        return true;
-
-    return false;
+    auto table  = SchemeTable::GetSchemeTable();
+    auto tuning = table->Find({length}, 1, precision, "any");
+    return tuning && tuning->scheme == CS_L1D_CC && Large1DTuningValid(length, *tuning, precision);
 }
 
 inline bool SupportedLength(rocfft_precision precision, size_t len)
@@ -388,6 +217,8 @@ std::unique_ptr<TreeNode> NodeFactory::CreateNodeFromScheme(ComputeScheme s, Tre
         return std::unique_ptr<Real2DEvenNode>(new Real2DEvenNode(parent));
     case CS_REAL_3D_EVEN:
         return std::unique_ptr<Real3DEvenNode>(new Real3DEvenNode(parent));
+    case CS_REAL_ND_EVEN:
+        return std::unique_ptr<RealNDEvenNode>(new RealNDEvenNode(parent));
     case CS_BLUESTEIN:
         return std::unique_ptr<BluesteinNode>(new BluesteinNode(parent));
     case CS_L1D_TRTRT:
@@ -410,6 +241,8 @@ std::unique_ptr<TreeNode> NodeFactory::CreateNodeFromScheme(ComputeScheme s, Tre
         return std::unique_ptr<BLOCKCR3DNode>(new BLOCKCR3DNode(parent));
     case CS_3D_RC:
         return std::unique_ptr<RC3DNode>(new RC3DNode(parent));
+    case CS_ND_RC:
+        return std::unique_ptr<RCNDNode>(new RCNDNode(parent));
 
     // Leaf Node that need to check external kernel file
     case CS_KERNEL_STOCKHAM:
@@ -445,7 +278,6 @@ std::unique_ptr<TreeNode> NodeFactory::CreateNodeFromScheme(ComputeScheme s, Tre
     case CS_KERNEL_COPY_CMPLX_TO_R:
     case CS_KERNEL_APPLY_CALLBACK:
         return std::unique_ptr<RealTransDataCopyNode>(new RealTransDataCopyNode(parent, s));
-    case CS_KERNEL_CHIRP:
     case CS_KERNEL_PAD_MUL:
     case CS_KERNEL_FFT_MUL:
     case CS_KERNEL_RES_MUL:
@@ -511,6 +343,8 @@ ComputeScheme NodeFactory::DecideNodeScheme(NodeMetaData& nodeData, TreeNode* pa
     case 3:
         return Decide3DScheme(nodeData);
     default:
+        if(nodeData.dimension > 3)
+            return CS_ND_RC;
         throw std::runtime_error("Invalid dimension");
     }
 
@@ -530,13 +364,30 @@ ComputeScheme NodeFactory::DecideRealScheme(NodeMetaData& nodeData)
         case 3:
             return CS_REAL_3D_EVEN;
         default:
+            if(nodeData.dimension > 3)
+                return CS_REAL_ND_EVEN;
             throw std::runtime_error("Invalid dimension");
         }
     }
+    // the copy kernels of the fallback only go up to 3 dimensions
+    if(nodeData.dimension > 3)
+        throw std::runtime_error(
+            "real transforms of more than 3 dimensions need an even, unit-stride length[0]");
     // Fallback method
     return CS_REAL_TRANSFORM_USING_CMPLX;
 }
 
+// Tuned decision for a node's problem on its device, if any
+static std::optional<SchemeTuning> FindTuning(const NodeMetaData& nodeData)
+{
+    auto table  = SchemeTable::GetSchemeTable();
+    auto tuning = table->Find(
+        nodeData.length, nodeData.dimension, nodeData.precision, nodeData.deviceProp);
+    if(!tuning)
+        return {};
+    return *tuning;
+}
+
 ComputeScheme NodeFactory::Decide1DScheme(NodeMetaData& nodeData)
 {
     ComputeScheme scheme = CS_NONE;
@@ -553,46 +404,22 @@ ComputeScheme NodeFactory::Decide1DScheme(NodeMetaData& nodeData)
     size_t divLength1 = 1;
     bool   failed     = false;
 
-    if(IsPo2(nodeData.length[0])) // multiple kernels involving transpose
+    // prefer a tuned decomposition, if we have the kernels for it
+    auto tuning = FindTuning(nodeData);
+    if(tuning && Large1DTuningValid(nodeData.length[0], *tuning, nodeData.precision))
+    {
+        scheme     = tuning->scheme;
+        divLength1 = tuning->factor;
+    }
+    else if(IsPo2(nodeData.length[0])) // multiple kernels involving transpose
     {
         // TODO: wrap the below into a function and check with LDS size
         size_t block_threshold = 262144;
         if(nodeData.length[0] <= block_threshold)
         {
-            // Enable block compute under these conditions
-            if(nodeData.precision == rocfft_precision_single)
-            {
-                if(map1DLengthSingle.find(nodeData.length[0]) != map1DLengthSingle.end())
-                {
-                    divLength1 = map1DLengthSingle.at(nodeData.length[0]);
-                }
-                else
-                {
-                    failed = true;
-                }
-            }
-            else
-            {
-                if(map1DLengthDouble.find(nodeData.length[0]) != map1DLengthDouble.end())
-                {
-                    divLength1 = map1DLengthDouble.at(nodeData.length[0]);
-                }
-                else
-                {
-                    failed = true;
-                }
-            }
-            // for gfx906, 512 CC/RC isn't as fast, so use CRT
-            // with a nicer length
-            if(is_device_gcn_arch(nodeData.deviceProp, "gfx906") && nodeData.length[0] == 262144)
-            {
-                divLength1 = 64;
-                scheme     = CS_L1D_CRT;
-            }
-            else
-            {
-                scheme = CS_L1D_CC;
-            }
+            // block compute is only used for lengths in the scheme table
+            scheme = CS_L1D_CC;
+            failed = true;
         }
         else
         {
@@ -624,59 +451,24 @@ ComputeScheme NodeFactory::Decide1DScheme(NodeMetaData& nodeData)
     }
     else // if not Pow2
     {
-        if(nodeData.precision == rocfft_precision_single)
-        {
-            if(map1DLengthSingle.find(nodeData.length[0]) != map1DLengthSingle.end())
-            {
-                divLength1 = map1DLengthSingle.at(nodeData.length[0]);
-                scheme     = CS_L1D_CC;
-            }
-            else
-            {
-                failed = true;
-            }
-        }
-        else if(nodeData.precision == rocfft_precision_double)
+        scheme     = CS_L1D_TRTRT;
+        divLength1 = get_explicitly_supported_factor(nodeData.precision, nodeData.length[0]);
+        if(divLength1 == 0)
         {
-            if(map1DLengthDouble.find(nodeData.length[0]) != map1DLengthDouble.end())
-            {
-                divLength1 = map1DLengthDouble.at(nodeData.length[0]);
-                scheme     = CS_L1D_CC;
+            // We need to recurse.  Note, for CS_L1D_TRTRT,
+            // divLength0 has to be explictly supported
+            auto divLength0 = get_largest_supported_factor(nodeData.precision, nodeData.length[0]);
 
-                // hack for special case of 43008. On gfx90a, 224 is better
-                if(nodeData.length[0] == 43008 && is_device_gcn_arch(nodeData.deviceProp, "gfx90a"))
-                {
-                    divLength1 = 224;
-                }
-            }
-            else
-            {
-                failed = true;
-            }
-        }
-
-        if(failed)
-        {
-            scheme     = CS_L1D_TRTRT;
-            divLength1 = get_explicitly_supported_factor(nodeData.precision, nodeData.length[0]);
-            if(divLength1 == 0)
-            {
-                // We need to recurse.  Note, for CS_L1D_TRTRT,
-                // divLength0 has to be explictly supported
-                auto divLength0
-                    = get_largest_supported_factor(nodeData.precision, nodeData.length[0]);
-
-                // should ignore factor 1 or we're going into a infinity decompostion loop,
-                // (an example is to run len-81 when we build only pow2 kernels, we'll be here)
-                divLength1 = (divLength0 <= 1) ? 0 : nodeData.length[0] / divLength0;
-            }
-            failed = divLength1 == 0;
+            // should ignore factor 1 or we're going into a infinity decompostion loop,
+            // (an example is to run len-81 when we build only pow2 kernels, we'll be here)
+            divLength1 = (divLength0 <= 1) ? 0 : nodeData.length[0] / divLength0;
         }
+        failed = divLength1 == 0;
     }
 
     if(failed)
     {
-        // can't find the length in map1DLengthSingle/Double.
+        // can't find the length in the scheme table
         PrintFailInfo(nodeData.precision, nodeData.length[0], scheme);
         return CS_NONE;
     }
@@ -691,6 +483,11 @@ ComputeScheme NodeFactory::Decide1DScheme(NodeMetaData& nodeData)
 
 ComputeScheme NodeFactory::Decide2DScheme(NodeMetaData& nodeData)
 {
+    // use the tuned scheme, if it can be built for this problem
+    auto tuning = FindTuning(nodeData);
+    if(tuning && MultiDimTuningValid(nodeData, tuning->scheme))
+        return tuning->scheme;
+
     // First choice is 2D_SINGLE kernel, if the problem will fit into LDS.
     // Next best is CS_2D_RC. Last resort is RTRT.
     if(use_CS_2D_SINGLE(nodeData))
@@ -701,23 +498,105 @@ ComputeScheme NodeFactory::Decide2DScheme(NodeMetaData& nodeData)
         return CS_2D_RTRT;
 }
 
-// check if we want to use SBCR solution
-static bool Apply_SBCR(NodeMetaData& nodeData)
+// check if we can use SBCR solution
+static bool SBCR_possible(NodeMetaData& nodeData)
 {
     // NB:
     //   We enable SBCR for limited problem sizes in kernel-generator.py.
     //   Will enable it for non-unit stride cases later.
-    return (((is_device_gcn_arch(nodeData.deviceProp, "gfx908")
-              || is_device_gcn_arch(nodeData.deviceProp, "gfx90a"))
-             && function_pool::has_SBCR_kernel(nodeData.length[0], nodeData.precision)
-             && function_pool::has_SBCR_kernel(nodeData.length[1], nodeData.precision)
-             && function_pool::has_SBCR_kernel(nodeData.length[2], nodeData.precision)
-             && (nodeData.placement == rocfft_placement_notinplace)
-             && (nodeData.inStride[0] == 1 && nodeData.outStride[0] == 1 // unit strides
-                 && nodeData.inStride[1] == nodeData.length[0]
-                 && nodeData.outStride[1] == nodeData.length[0]
-                 && nodeData.inStride[2] == nodeData.inStride[1] * nodeData.length[1]
-                 && nodeData.outStride[2] == nodeData.outStride[1] * nodeData.length[1])));
+    return (function_pool::has_SBCR_kernel(nodeData.length[0], nodeData.precision)
+            && function_pool::has_SBCR_kernel(nodeData.length[1], nodeData.precision)
+            && function_pool::has_SBCR_kernel(nodeData.length[2], nodeData.precision)
+            && (nodeData.placement == rocfft_placement_notinplace)
+            && (nodeData.inStride[0] == 1 && nodeData.outStride[0] == 1 // unit strides
+                && nodeData.inStride[1] == nodeData.length[0]
+                && nodeData.outStride[1] == nodeData.length[0]
+                && nodeData.inStride[2] == nodeData.inStride[1] * nodeData.length[1]
+                && nodeData.outStride[2] == nodeData.outStride[1] * nodeData.length[1]));
+}
+
+// check if we want to use SBCR solution
+static bool Apply_SBCR(NodeMetaData& nodeData)
+{
+    return (is_device_gcn_arch(nodeData.deviceProp, "gfx908")
+            || is_device_gcn_arch(nodeData.deviceProp, "gfx90a"))
+           && SBCR_possible(nodeData);
+}
+
+bool NodeFactory::MultiDimTuningValid(NodeMetaData& nodeData, ComputeScheme scheme)
+{
+    switch(scheme)
+    {
+    case CS_KERNEL_2D_SINGLE:
+        return nodeData.dimension == 2 && use_CS_2D_SINGLE(nodeData);
+    case CS_2D_RC:
+        return nodeData.dimension == 2
+               && function_pool::has_SBCC_kernel(nodeData.length[1], nodeData.precision);
+    case CS_2D_RTRT:
+        return nodeData.dimension == 2;
+    case CS_3D_BLOCK_CR:
+        return nodeData.dimension == 3 && SBCR_possible(nodeData);
+    case CS_3D_BLOCK_RC:
+        return nodeData.dimension == 3 && use_CS_3D_BLOCK_RC(nodeData);
+    case CS_3D_RC:
+        // TODO: SBCC hasn't worked for inner batch (i/oDist == 1)
+        return nodeData.dimension == 3 && nodeData.iDist != 1 && nodeData.oDist != 1
+               && function_pool::has_SBCC_kernel(nodeData.length[2], nodeData.precision);
+    case CS_3D_RTRT:
+    case CS_3D_TRTRTR:
+        return nodeData.dimension == 3;
+    default:
+        return false;
+    }
+}
+
+std::vector<SchemeTuning> NodeFactory::TuningCandidates(NodeMetaData& nodeData)
+{
+    std::vector<SchemeTuning> candidates;
+    if(nodeData.dimension == 1)
+    {
+        auto length    = nodeData.length[0];
+        auto precision = nodeData.precision;
+        // nothing to decompose if there's a single kernel, and
+        // Bluestein has no choices here
+        if(function_pool::has_function(fpkey(length, precision))
+           || !SupportedLength(precision, length))
+            return candidates;
+
+        for(size_t factor = 2; factor < length; ++factor)
+        {
+            if(length % factor != 0)
+                continue;
+            for(auto scheme : {CS_L1D_CC, CS_L1D_CRT, CS_L1D_TRTRT})
+            {
+                SchemeTuning tuning{scheme, factor, {}};
+                if(!Large1DTuningValid(length, tuning, precision))
+                    continue;
+                // only try TRTRT with two kernels, deeper
+                // decompositions are left to the heuristics
+                if(scheme == CS_L1D_TRTRT
+                   && !(function_pool::has_function(fpkey(factor, precision))
+                        && function_pool::has_function(fpkey(length / factor, precision))))
+                    continue;
+                candidates.push_back(tuning);
+            }
+        }
+        return candidates;
+    }
+
+    for(auto scheme : {CS_KERNEL_2D_SINGLE,
+                       CS_2D_RC,
+                       CS_2D_RTRT,
+                       CS_3D_BLOCK_CR,
+                       CS_3D_BLOCK_RC,
+                       CS_3D_RC,
+                       CS_3D_RTRT,
+                       CS_3D_TRTRTR})
+    {
+        if(MultiDimTuningValid(nodeData, scheme))
+            candidates.push_back({scheme, 0, {}});
+    }
+    return candidates;
 }
 
 ComputeScheme NodeFactory::Decide3DScheme(NodeMetaData& nodeData)
@@ -726,6 +605,11 @@ ComputeScheme NodeFactory::Decide3DScheme(NodeMetaData& nodeData)
     // multi-dimension cases and small 2d, 3d within one kernel
     bool MultiDimFuseKernelsAvailable = false;
 
+    // use the tuned scheme, if it can be built for this problem
+    auto tuning = FindTuning(nodeData);
+    if(tuning && MultiDimTuningValid(nodeData, tuning->scheme))
+        return tuning->scheme;
+
     // try 3 SBCR kernels first
     if(Apply_SBCR(nodeData))
     {
@@ -0,0 +1,271 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "perf_model.h"
+#include "../../shared/environment.h"
+#include "arithmetic.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <numeric>
+
+// published figures for architectures we know, used when the device
+// properties don't say
+struct ArchFigures
+{
+    const char* arch;
+    size_t      computeUnits;
+    double      memGBPerSec;
+    double      clockMHz;
+    // double-precision rate relative to single
+    double fp64Ratio;
+    size_t maxWavesPerCU;
+};
+
+static const ArchFigures& FiguresForArch(const std::string& archName)
+{
+    static const ArchFigures known[] = {
+        {"gfx803", 64, 512.0, 1050.0, 1.0 / 16, 40},
+        {"gfx900", 64, 484.0, 1536.0, 1.0 / 16, 40},
+        {"gfx906", 60, 1024.0, 1725.0, 1.0 / 2, 40},
+        {"gfx908", 120, 1229.0, 1502.0, 1.0 / 2, 40},
+        {"gfx90a", 104, 1638.0, 1700.0, 1.0, 32},
+        {"gfx1030", 80, 512.0, 2250.0, 1.0 / 16, 32},
+        {"gfx1100", 96, 960.0, 2500.0, 1.0 / 16, 32},
+    };
+    // something in the middle, for architectures we don't know
+    static const ArchFigures unknown = {"", 60, 1000.0, 1500.0, 1.0 / 2, 40};
+
+    for(const auto& figures : known)
+    {
+        if(archName.compare(0, std::strlen(figures.arch), figures.arch) == 0
+           && (archName.size() == std::strlen(figures.arch)
+               || archName[std::strlen(figures.arch)] == ':'))
+            return figures;
+    }
+    return unknown;
+}
+
+DeviceModel DeviceModel::FromDeviceProp(const hipDeviceProp_t& prop)
+{
+    const auto& figures = FiguresForArch(prop.gcnArchName);
+
+    DeviceModel device;
+    device.computeUnits
+        = prop.multiProcessorCount > 0 ? prop.multiProcessorCount : figures.computeUnits;
+    device.wavefrontSize = prop.warpSize > 0 ? prop.warpSize : 64;
+    device.maxWavesPerCU = prop.maxThreadsPerMultiProcessor > 0
+                               ? prop.maxThreadsPerMultiProcessor / device.wavefrontSize
+                               : figures.maxWavesPerCU;
+    device.ldsBytesPerCU = prop.maxSharedMemoryPerMultiProcessor > 0
+                               ? prop.maxSharedMemoryPerMultiProcessor
+                               : std::max<size_t>(prop.sharedMemPerBlock, 64 * 1024);
+
+    // HIP gives clocks in kHz.  memory transfers happen on both
+    // clock edges, and bus width is in bits.  1 MB/s is 1 byte/us.
+    if(prop.memoryClockRate > 0 && prop.memoryBusWidth > 0)
+        device.memBytesPerUs = prop.memoryClockRate / 1000.0 * 2.0 * prop.memoryBusWidth / 8.0;
+    else
+        device.memBytesPerUs = figures.memGBPerSec * 1000.0;
+    auto envBW = rocfft_getenv("ROCFFT_DEVICE_BW");
+    if(!envBW.empty() && std::atof(envBW.c_str()) > 0.0)
+        device.memBytesPerUs = std::atof(envBW.c_str()) * 1000.0;
+
+    // 64 lanes per CU, each doing a fused multiply-add per clock
+    double clockMHz = prop.clockRate > 0 ? prop.clockRate / 1000.0 : figures.clockMHz;
+    device.singleFlopsPerUs = device.computeUnits * 64 * 2.0 * clockMHz;
+    device.doubleFlopsPerUs = device.singleFlopsPerUs * figures.fp64Ratio;
+
+    device.launchUs = 5.0;
+    return device;
+}
+
+size_t DeviceModel::LaunchCostBytes() const
+{
+    return static_cast<size_t>(launchUs * memBytesPerUs);
+}
+
+// number of points transformed by each FFT a kernel does, or 0 if
+// the kernel does no FFTs
+static size_t FFTPoints(const TreeNode& node)
+{
+    switch(node.scheme)
+    {
+    case CS_KERNEL_STOCKHAM:
+    case CS_KERNEL_STOCKHAM_BLOCK_CC:
+    case CS_KERNEL_STOCKHAM_BLOCK_RC:
+    case CS_KERNEL_STOCKHAM_BLOCK_CR:
+    case CS_KERNEL_STOCKHAM_TRANSPOSE_XY_Z:
+    case CS_KERNEL_STOCKHAM_TRANSPOSE_Z_XY:
+    case CS_KERNEL_STOCKHAM_R_TO_CMPLX_TRANSPOSE_Z_XY:
+        return node.length[0];
+    case CS_KERNEL_2D_SINGLE:
+        return node.length[0] * node.length[1];
+    case CS_KERNEL_3D_SINGLE:
+        return node.length[0] * node.length[1] * node.length[2];
+    default:
+        return 0;
+    }
+}
+
+// floating-point operations done by a kernel
+static double KernelFlops(const TreeNode& node)
+{
+    auto elems = std::accumulate(
+        node.length.begin(), node.length.end(), node.batch, std::multiplies<size_t>());
+
+    // the usual 5 N log2(N) estimate for a complex FFT of N points
+    double flops  = 0.0;
+    auto   points = FFTPoints(node);
+    if(points > 1)
+        flops += 5.0 * elems * std::log2(static_cast<double>(points));
+
+    // twiddle multiplication for large 1D decompositions
+    if(node.large1D > 0)
+        flops += 6.0 * elems;
+
+    // real pre/post-processing
+    if(node.ebtype != EmbeddedType::NONE)
+        flops += 10.0 * elems;
+
+    switch(node.scheme)
+    {
+    case CS_KERNEL_R_TO_CMPLX:
+    case CS_KERNEL_R_TO_CMPLX_TRANSPOSE:
+    case CS_KERNEL_CMPLX_TO_R:
+    case CS_KERNEL_TRANSPOSE_CMPLX_TO_R:
+        flops += 10.0 * elems;
+        break;
+    case CS_KERNEL_PAD_MUL:
+    case CS_KERNEL_FFT_MUL:
+    case CS_KERNEL_RES_MUL:
+        flops += 6.0 * elems;
+        break;
+    default:
+        break;
+    }
+    return flops;
+}
+
+// nodes that haven't had buffers assigned yet are assumed to work
+// on interleaved complex data
+static rocfft_array_type ModelArrayType(rocfft_array_type type)
+{
+    return type == rocfft_array_type_unset ? rocfft_array_type_complex_interleaved : type;
+}
+
+static KernelEstimate
+    EstimateKernel(const TreeNode& node, const GridParam* gp, const DeviceModel& device)
+{
+    KernelEstimate est;
+    est.scheme = node.scheme;
+
+    // the apply-callback kernel only runs if there are callbacks
+    if(node.scheme == CS_KERNEL_APPLY_CALLBACK)
+    {
+        est.launches = 0;
+        return est;
+    }
+
+    est.bytesRead
+        = data_size_bytes(node.length, node.precision, ModelArrayType(node.inArrayType))
+          * node.batch;
+    est.bytesWritten = data_size_bytes(node.GetOutputLength(),
+                                       node.precision,
+                                       ModelArrayType(node.outArrayType))
+                       * node.batch;
+    // Bluestein multiplies also read the chirp
+    if(node.scheme == CS_KERNEL_PAD_MUL || node.scheme == CS_KERNEL_FFT_MUL
+       || node.scheme == CS_KERNEL_RES_MUL)
+        est.bytesRead += data_size_bytes(
+            {node.lengthBlue}, node.precision, rocfft_array_type_complex_interleaved);
+    est.flops = KernelFlops(node);
+
+    // fraction of the device's wave slots the launch fills, and
+    // fraction of compute units with any work
+    double waveFill = 1.0;
+    double cuFill   = 1.0;
+    est.occupancy   = 1.0;
+    if(gp)
+    {
+        est.workgroups    = static_cast<size_t>(gp->b_x) * gp->b_y * gp->b_z;
+        est.workgroupSize = static_cast<size_t>(gp->wgs_x) * gp->wgs_y * gp->wgs_z;
+        est.ldsBytes      = gp->lds_bytes;
+
+        size_t wavesPerGroup
+            = std::max<size_t>(DivRoundingUp(est.workgroupSize, device.wavefrontSize), 1);
+        size_t groupsPerCU = device.maxWavesPerCU / wavesPerGroup;
+        if(est.ldsBytes)
+            groupsPerCU = std::min(groupsPerCU, device.ldsBytesPerCU / est.ldsBytes);
+        groupsPerCU = std::max<size_t>(groupsPerCU, 1);
+
+        est.occupancy = std::min(
+            1.0, static_cast<double>(groupsPerCU * wavesPerGroup) / device.maxWavesPerCU);
+
+        size_t resident = std::min(est.workgroups, groupsPerCU * device.computeUnits);
+        waveFill        = static_cast<double>(resident * wavesPerGroup)
+                   / (device.maxWavesPerCU * device.computeUnits);
+        cuFill = std::min(1.0, static_cast<double>(est.workgroups) / device.computeUnits);
+    }
+
+    // streaming kernels reach full bandwidth with about a quarter of
+    // the wave slots busy; fewer can't hide memory latency
+    double bandwidth = device.memBytesPerUs * std::min(1.0, waveFill / 0.25);
+    double flopRate  = node.precision == rocfft_precision_double ? device.doubleFlopsPerUs
+                                                                 : device.singleFlopsPerUs;
+    double memUs     = (est.bytesRead + est.bytesWritten) / bandwidth;
+    double computeUs = est.flops / (flopRate * cuFill);
+
+    est.timeUs = std::max(memUs, computeUs) + device.launchUs;
+    return est;
+}
+
+KernelEstimate EstimateNode(const TreeNode& node, const DeviceModel& device)
+{
+    return EstimateKernel(node, nullptr, device);
+}
+
+PlanEstimate EstimatePlan(const ExecPlan& execPlan, const DeviceModel& device)
+{
+    PlanEstimate plan;
+    for(size_t i = 0; i < execPlan.execSeq.size(); ++i)
+    {
+        // launch parameters are set up after the plan is decided
+        const GridParam* gp
+            = i < execPlan.gridParam.size() ? &execPlan.gridParam[i] : nullptr;
+        auto kernel = EstimateKernel(*execPlan.execSeq[i], gp, device);
+
+        plan.bytesRead += kernel.bytesRead;
+        plan.bytesWritten += kernel.bytesWritten;
+        plan.flops += kernel.flops;
+        plan.launches += kernel.launches;
+        plan.timeUs += kernel.timeUs;
+        plan.kernels.push_back(kernel);
+    }
+    return plan;
+}
+
+PlanEstimate EstimatePlan(const ExecPlan& execPlan)
+{
+    return EstimatePlan(execPlan, DeviceModel::FromDeviceProp(execPlan.deviceProp));
+}
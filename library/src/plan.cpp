@@ -27,10 +27,13 @@
 #include "hip/hip_runtime_api.h"
 #include "logging.h"
 #include "node_factory.h"
+#include "perf_model.h"
+#include "plan_cache.h"
 #include "rocfft-version.h"
 #include "rocfft.h"
 #include "rocfft_ostream.hpp"
 #include "rtc.h"
+#include "scheme_table.h"
 
 #include <algorithm>
 #include <assert.h>
@@ -40,6 +43,7 @@
 #include <numeric>
 #include <set>
 #include <sstream>
+#include <tuple>
 #include <vector>
 
 #define TO_STR2(x) #x
@@ -53,6 +57,39 @@
                                TO_STR(rocfft_version_tweak) )
 // clang-format on
 
+size_t data_size_bytes(const std::vector<size_t>& lengths,
+                       rocfft_precision           precision,
+                       rocfft_array_type          type)
+{
+    // first compute the raw number of elements
+    size_t elems = std::accumulate(
+        lengths.begin(), lengths.end(), static_cast<size_t>(1), std::multiplies<size_t>());
+    // size of each element
+    size_t elemsize = (precision == rocfft_precision_single ? sizeof(float) : sizeof(double));
+    switch(type)
+    {
+    case rocfft_array_type_complex_interleaved:
+    case rocfft_array_type_complex_planar:
+        // complex needs two numbers per element
+        return 2 * elems * elemsize;
+    case rocfft_array_type_real:
+        // real needs one number per element
+        return elems * elemsize;
+    case rocfft_array_type_hermitian_interleaved:
+    case rocfft_array_type_hermitian_planar:
+    {
+        // hermitian requires 2 numbers per element, but innermost
+        // dimension is cut down to roughly half
+        size_t non_innermost = elems / lengths[0];
+        return 2 * non_innermost * elemsize * ((lengths[0] / 2) + 1);
+    }
+    case rocfft_array_type_unset:
+        // we should really have an array type at this point
+        assert(false);
+        return 0;
+    }
+}
+
 std::string PrintOperatingBuffer(const OperatingBuffer ob)
 {
     const std::map<OperatingBuffer, const char*> BuffertoString
@@ -111,6 +148,54 @@ rocfft_status rocfft_plan_description_set_scale_factor(rocfft_plan_description d
 }
 #endif
 
+rocfft_status rocfft_plan_description_set_optimize_strategy(rocfft_plan_description  description,
+                                                           rocfft_optimize_strategy strategy)
+{
+    log_trace(__func__, "description", description, "strategy", strategy);
+    if(!description)
+        return rocfft_status_invalid_arg_value;
+    switch(strategy)
+    {
+    case rocfft_optimize_min_buffer:
+    case rocfft_optimize_balance:
+    case rocfft_optimize_max_fusion:
+        description->optimizeStrategy = strategy;
+        return rocfft_status_success;
+    }
+    return rocfft_status_invalid_arg_value;
+}
+
+rocfft_status rocfft_plan_description_set_work_buffer_limit(rocfft_plan_description description,
+                                                           size_t                  limit_bytes)
+{
+    log_trace(__func__, "description", description, "limit_bytes", limit_bytes);
+    if(!description)
+        return rocfft_status_invalid_arg_value;
+    description->workBufferLimit = limit_bytes;
+    return rocfft_status_success;
+}
+
+rocfft_status rocfft_plan_description_set_target_device(rocfft_plan_description description,
+                                                        const char*             gpu_arch,
+                                                        const size_t            lds_bytes,
+                                                        const size_t            compute_units)
+{
+    log_trace(__func__,
+              "description",
+              description,
+              "gpu_arch",
+              gpu_arch ? gpu_arch : "",
+              "lds_bytes",
+              lds_bytes,
+              "compute_units",
+              compute_units);
+    if(!description || !gpu_arch || !*gpu_arch)
+        return rocfft_status_invalid_arg_value;
+    description->targetDevice    = SyntheticDeviceProp(gpu_arch, lds_bytes, compute_units);
+    description->targetDeviceSet = true;
+    return rocfft_status_success;
+}
+
 static size_t offset_count(rocfft_array_type type)
 {
     // planar data has 2 sets of offsets, otherwise we have one
@@ -172,7 +257,7 @@ rocfft_status rocfft_plan_description_set_data_layout(rocfft_plan_description de
 
     if(in_strides != nullptr)
     {
-        for(size_t i = 0; i < std::min((size_t)3, in_strides_size); i++)
+        for(size_t i = 0; i < std::min(MAX_TRANSFORM_RANK, in_strides_size); i++)
             description->inStrides[i] = in_strides[i];
     }
 
@@ -181,7 +266,7 @@ rocfft_status rocfft_plan_description_set_data_layout(rocfft_plan_description de
 
     if(out_strides != nullptr)
     {
-        for(size_t i = 0; i < std::min((size_t)3, out_strides_size); i++)
+        for(size_t i = 0; i < std::min(MAX_TRANSFORM_RANK, out_strides_size); i++)
             description->outStrides[i] = out_strides[i];
     }
 
@@ -212,7 +297,9 @@ std::string rocfft_rider_command(rocfft_plan plan)
     std::stringstream rider;
     rider << "rocfft-rider --length ";
     std::ostream_iterator<size_t> rider_iter(rider, " ");
-    std::copy(plan->lengths.rbegin() + (3 - plan->rank), plan->lengths.rend(), rider_iter);
+    std::copy(plan->lengths.rbegin() + (MAX_TRANSFORM_RANK - plan->rank),
+              plan->lengths.rend(),
+              rider_iter);
     rider << "-b " << plan->batch << " ";
 
     if(plan->placement == rocfft_placement_notinplace)
@@ -225,10 +312,11 @@ std::string rocfft_rider_command(rocfft_plan plan)
     rider << "--itype " << plan->desc.inArrayType << " ";
     rider << "--otype " << plan->desc.outArrayType << " ";
     rider << "--istride ";
-    std::copy(
-        plan->desc.inStrides.rbegin() + (3 - plan->rank), plan->desc.inStrides.rend(), rider_iter);
+    std::copy(plan->desc.inStrides.rbegin() + (MAX_TRANSFORM_RANK - plan->rank),
+              plan->desc.inStrides.rend(),
+              rider_iter);
     rider << "--ostride ";
-    std::copy(plan->desc.outStrides.rbegin() + (3 - plan->rank),
+    std::copy(plan->desc.outStrides.rbegin() + (MAX_TRANSFORM_RANK - plan->rank),
               plan->desc.outStrides.rend(),
               rider_iter);
     rider << "--idist " << plan->desc.inDist << " ";
@@ -240,6 +328,97 @@ std::string rocfft_rider_command(rocfft_plan plan)
     return rider.str();
 }
 
+hipDeviceProp_t
+    SyntheticDeviceProp(const std::string& gpu_arch, size_t lds_bytes, size_t compute_units)
+{
+    hipDeviceProp_t prop{};
+    std::strncpy(prop.gcnArchName, gpu_arch.c_str(), sizeof(prop.gcnArchName) - 1);
+    prop.sharedMemPerBlock   = lds_bytes ? lds_bytes : 64 * 1024;
+    prop.multiProcessorCount = compute_units;
+    // RDNA GPUs run wave32 by default, everything else is wave64
+    prop.warpSize = 64;
+    if(gpu_arch.compare(0, 5, "gfx10") == 0 || gpu_arch.compare(0, 5, "gfx11") == 0)
+        prop.warpSize = 32;
+    return prop;
+}
+
+// Decide a plan as chunks of fewer transforms, each with a work
+// buffer under the description's limit.  fullWorkBufBytes is the
+// work buffer the plan would need for its whole batch.  Chunks are
+// ordinary plans created with the same parameters, and a smaller
+// batch.
+static rocfft_status PlanInChunks(rocfft_plan                   plan,
+                                  size_t                        fullWorkBufBytes,
+                                  const rocfft_result_placement placement,
+                                  const rocfft_transform_type   transform_type,
+                                  const rocfft_precision        precision,
+                                  const size_t                  dimensions,
+                                  const size_t*                 lengths,
+                                  const hipDeviceProp_t*        deviceProp)
+{
+    // launches are kept for at most this many chunks' buffers
+    static const size_t MAX_CHUNK_LAUNCHES = 64;
+
+    const size_t limit = plan->desc.workBufferLimit;
+    if(plan->batch == 1)
+        throw std::runtime_error("work buffer for one transform is over the limit");
+
+    rocfft_plan_description_t chunkDesc = plan->desc;
+    chunkDesc.workBufferLimit           = 0;
+    auto createChunk = [&](size_t batch, std::unique_ptr<rocfft_plan_t>& chunk) {
+        chunk = std::make_unique<rocfft_plan_t>();
+        return rocfft_plan_create_internal(chunk.get(),
+                                           placement,
+                                           transform_type,
+                                           precision,
+                                           dimensions,
+                                           lengths,
+                                           batch,
+                                           &chunkDesc,
+                                           deviceProp);
+    };
+    // work buffers grow about linearly with batch, so start from
+    // the chunk that would fit if they grew exactly linearly, and
+    // shrink it until it does fit
+    auto fittingBatch = [limit](size_t batch, size_t bytes) {
+        return std::max<size_t>(static_cast<double>(limit) / bytes * batch, 1);
+    };
+
+    size_t chunkBatch = std::min(plan->batch - 1, fittingBatch(plan->batch, fullWorkBufBytes));
+    std::unique_ptr<rocfft_plan_t> chunk;
+    while(true)
+    {
+        auto status = createChunk(chunkBatch, chunk);
+        if(status != rocfft_status_success)
+            return status;
+        auto bytes = chunk->WorkBufBytes();
+        if(bytes <= limit)
+            break;
+        if(chunkBatch == 1)
+            throw std::runtime_error("work buffer for one transform is over the limit");
+        chunkBatch = std::min(chunkBatch - 1, fittingBatch(chunkBatch, bytes));
+    }
+
+    // chunks of fewer transforms need no more work buffer
+    const size_t remainder = plan->batch % chunkBatch;
+    if(remainder)
+    {
+        auto status = createChunk(remainder, plan->remainderPlan);
+        if(status != rocfft_status_success)
+            return status;
+        if(plan->remainderPlan->WorkBufBytes() > limit)
+            throw std::runtime_error("work buffer for last chunk is over the limit");
+    }
+
+    plan->execPlan   = chunk->execPlan;
+    plan->chunkBatch = chunkBatch;
+    plan->chunkCount = DivRoundingUp(plan->batch, chunkBatch);
+    // the launch cache is the chunked handle's own, so this doesn't
+    // change the cached plan the chunks were made from
+    plan->launchCache.capacity = std::min(plan->chunkCount, MAX_CHUNK_LAUNCHES);
+    return rocfft_status_success;
+}
+
 rocfft_status rocfft_plan_create_internal(rocfft_plan                   plan,
                                           const rocfft_result_placement placement,
                                           const rocfft_transform_type   transform_type,
@@ -247,7 +426,8 @@ rocfft_status rocfft_plan_create_internal(rocfft_plan                   plan,
                                           const size_t                  dimensions,
                                           const size_t*                 lengths,
                                           const size_t                  number_of_transforms,
-                                          const rocfft_plan_description description)
+                                          const rocfft_plan_description description,
+                                          const hipDeviceProp_t*        deviceProp)
 {
     // Check plan validity
     if(description != nullptr)
@@ -301,14 +481,12 @@ rocfft_status rocfft_plan_create_internal(rocfft_plan                   plan,
         }
     }
 
-    if(dimensions > 3)
+    if(dimensions > MAX_TRANSFORM_RANK)
         return rocfft_status_invalid_dimensions;
 
     rocfft_plan p = plan;
     p->rank       = dimensions;
-    p->lengths[0] = 1;
-    p->lengths[1] = 1;
-    p->lengths[2] = 1;
+    p->lengths.fill(1);
     for(size_t ilength = 0; ilength < dimensions; ++ilength)
     {
         p->lengths[ilength] = lengths[ilength];
@@ -472,15 +650,39 @@ rocfft_status rocfft_plan_create_internal(rocfft_plan                   plan,
 
         ExecPlan& execPlan = plan->execPlan;
         int       deviceId = 0;
-        if(hipGetDevice(&deviceId) != hipSuccess)
+        if(deviceProp)
         {
-            throw std::runtime_error("hipGetDevice failed.");
+            execPlan.deviceProp        = *deviceProp;
+            execPlan.deviceFree        = true;
+            execPlan.deviceFreeCompile = true;
         }
-        if(hipGetDeviceProperties(&(execPlan.deviceProp), deviceId) != hipSuccess)
+        else if(p->desc.targetDeviceSet)
         {
-            throw std::runtime_error("hipGetDeviceProperties failed for deviceId "
-                                     + std::to_string(deviceId));
+            execPlan.deviceProp = p->desc.targetDevice;
+            execPlan.deviceFree = true;
         }
+        else
+        {
+            if(hipGetDevice(&deviceId) != hipSuccess)
+            {
+                throw std::runtime_error("hipGetDevice failed.");
+            }
+            if(hipGetDeviceProperties(&(execPlan.deviceProp), deviceId) != hipSuccess)
+            {
+                throw std::runtime_error("hipGetDeviceProperties failed for deviceId "
+                                         + std::to_string(deviceId));
+            }
+        }
+
+        // if an identical plan was already built for this device,
+        // just copy it.  plans decided with an overridden scheme
+        // table differ from ones with the same parameters, so they
+        // bypass the cache.
+        PlanCache::plan_cache_key_t cacheKey(*plan, deviceId, execPlan.deviceProp);
+        bool useCache = !execPlan.deviceFree && !SchemeTable::ScopedOverride::Active();
+        if(useCache && PlanCache::GetPlanCache().Lookup(cacheKey, execPlan))
+            return rocfft_status_success;
+
         rootPlanData.deviceProp = execPlan.deviceProp;
         execPlan.rootPlan       = NodeFactory::CreateExplicitNode(rootPlanData, nullptr);
 
@@ -507,6 +709,8 @@ rocfft_status rocfft_plan_create_internal(rocfft_plan                   plan,
         // set scaling on the root plan
         execPlan.rootPlan->scale_factor = p->desc.scale_factor;
 
+        execPlan.assignOptStrategy = p->desc.optimizeStrategy;
+
         try
         {
             ProcessNode(execPlan); // TODO: more descriptions are needed
@@ -518,11 +722,35 @@ rocfft_status rocfft_plan_create_internal(rocfft_plan                   plan,
             throw;
         }
 
+        // plans that need more work buffer than allowed run in batch
+        // chunks instead
+        const auto workBufBytes = execPlan.WorkBufBytes(plan->base_type_size);
+        if(p->desc.workBufferLimit && workBufBytes > p->desc.workBufferLimit)
+            return PlanInChunks(plan,
+                                workBufBytes,
+                                placement,
+                                transform_type,
+                                precision,
+                                dimensions,
+                                lengths,
+                                deviceProp);
+
+        // device-free plans are finished once they're decided,
+        // apart from launch parameters for performance estimates
+        if(execPlan.deviceFree)
+        {
+            PlanGridParams(execPlan);
+            return rocfft_status_success;
+        }
+
         if(!PlanPowX(execPlan)) // PlanPowX enqueues the GPU kernels by function
         {
 
             throw std::runtime_error("Unable to create execution plan.");
         }
+
+        if(useCache)
+            PlanCache::GetPlanCache().Insert(cacheKey, execPlan);
         return rocfft_status_success;
     }
     catch(std::exception& e)
@@ -599,11 +827,79 @@ rocfft_status rocfft_plan_get_work_buffer_size(const rocfft_plan plan, size_t* s
     if(!plan)
         return rocfft_status_failure;
 
-    *size_in_bytes = plan->execPlan.WorkBufBytes(plan->base_type_size);
+    *size_in_bytes = plan->WorkBufBytes();
     log_trace(__func__, "plan", plan, "size_in_bytes ptr", size_in_bytes, "val", *size_in_bytes);
     return rocfft_status_success;
 }
 
+rocfft_status rocfft_plan_get_kernel_count(const rocfft_plan plan, size_t* count)
+{
+    log_trace(__func__, "plan", plan, "count", count);
+    if(!plan || !count)
+        return rocfft_status_invalid_arg_value;
+
+    *count = plan->execPlan.kernelNames.size();
+    return rocfft_status_success;
+}
+
+rocfft_status rocfft_plan_get_kernel_name(const rocfft_plan plan, size_t index, const char** name)
+{
+    log_trace(__func__, "plan", plan, "index", index, "name", name);
+    if(!plan || !name || index >= plan->execPlan.kernelNames.size())
+        return rocfft_status_invalid_arg_value;
+
+    *name = plan->execPlan.kernelNames[index].c_str();
+    return rocfft_status_success;
+}
+
+rocfft_status rocfft_plan_get_kernel_estimate(const rocfft_plan       plan,
+                                              size_t                  index,
+                                              rocfft_kernel_estimate* estimate)
+{
+    log_trace(__func__, "plan", plan, "index", index, "estimate", estimate);
+    if(!plan || !estimate || index >= plan->execPlan.execSeq.size())
+        return rocfft_status_invalid_arg_value;
+
+    try
+    {
+        const auto& kernel = EstimatePlan(plan->execPlan).kernels[index];
+
+        estimate->bytes_read    = kernel.bytesRead;
+        estimate->bytes_written = kernel.bytesWritten;
+        estimate->flops         = kernel.flops;
+        estimate->lds_bytes     = kernel.ldsBytes;
+        estimate->occupancy     = kernel.occupancy;
+        estimate->launches      = kernel.launches;
+        estimate->time_us       = kernel.timeUs;
+        return rocfft_status_success;
+    }
+    catch(std::exception&)
+    {
+        return rocfft_status_failure;
+    }
+}
+
+rocfft_status rocfft_plan_get_estimated_time(const rocfft_plan plan, double* time_us)
+{
+    log_trace(__func__, "plan", plan, "time_us", time_us);
+    if(!plan || !time_us)
+        return rocfft_status_invalid_arg_value;
+
+    try
+    {
+        // all chunks but a smaller last one take the same time
+        *time_us = EstimatePlan(plan->execPlan).timeUs
+                   * (plan->remainderPlan ? plan->chunkCount - 1 : plan->chunkCount);
+        if(plan->remainderPlan)
+            *time_us += EstimatePlan(plan->remainderPlan->execPlan).timeUs;
+        return rocfft_status_success;
+    }
+    catch(std::exception&)
+    {
+        return rocfft_status_failure;
+    }
+}
+
 rocfft_status rocfft_plan_get_print(const rocfft_plan plan)
 {
     log_trace(__func__, "plan", plan);
@@ -699,6 +995,14 @@ rocfft_status rocfft_plan_get_print(const rocfft_plan plan)
         rocfft_cout << ", " << plan->lengths[i];
     rocfft_cout << std::endl;
     rocfft_cout << "batch size: " << plan->batch << std::endl;
+    if(plan->chunkBatch)
+    {
+        rocfft_cout << "batch chunks: " << plan->chunkCount << " of " << plan->chunkBatch;
+        if(plan->remainderPlan)
+            rocfft_cout << ", last of " << plan->remainderPlan->batch;
+        rocfft_cout << " (work buffer limit " << plan->desc.workBufferLimit << " bytes)"
+                    << std::endl;
+    }
     rocfft_cout << std::endl;
 
     rocfft_cout << "input offset: " << plan->desc.inOffset[0];
@@ -883,10 +1187,7 @@ void TreeNode::SanityCheck()
         childNodes[i]->SanityCheck();
 
         // 2. Assert that the kernel chain is connected
-        // The Bluestein algorithm uses a separate buffer which is
-        // convoluted with the input; the chain assumption isn't true here.
-        // NB: we assume that the CS_KERNEL_CHIRP is first in the chain.
-        if((i > 0) && (childNodes[i - 1]->scheme != CS_KERNEL_CHIRP))
+        if(i > 0)
         {
             if(childNodes[i - 1]->obOut != childNodes[i]->obIn)
                 throw std::runtime_error("Sanity Check failed: buffers mismatch");
@@ -994,10 +1295,7 @@ void TreeNode::RefreshTree()
     auto& first = childNodes.front();
     auto& last  = childNodes.back();
 
-    // the obIn of chirp is always set to S buffer, which is not really a input buffer
-    // the parent's obIn should be the next node's obIn, instead of the S buffer
-    // this avoid error when finding the callback-load-fn kernel
-    this->obIn         = (first->scheme == CS_KERNEL_CHIRP) ? childNodes[1]->obIn : first->obIn;
+    this->obIn         = first->obIn;
     this->obOut        = last->obOut;
     this->placement    = (obIn == obOut) ? rocfft_placement_inplace : rocfft_placement_notinplace;
     this->inArrayType  = first->inArrayType;
@@ -1066,24 +1364,35 @@ void OrderFuseShims(std::vector<TreeNode*>& seq, std::vector<FuseShim*>& fuseSeq
     fuseSeq.swap(reordered);
 }
 
+// Some fusions perform worse on some architectures.  The scheme
+// table can disable fusions for the whole problem, or for the FFT
+// length of the first fused kernel.
 void CheckFuseShimForArch(ExecPlan& execPlan)
 {
-    // for gfx906...
-    if(is_device_gcn_arch(execPlan.deviceProp, "gfx906"))
-    {
-        auto& fusions = execPlan.fuseShims;
-        for(auto& fusion : fusions)
-        {
-            if(fusion->fuseType == FT_STOCKHAM_WITH_TRANS
-               && fusion->FirstFuseNode()->length[0] == 168)
-            {
-                fusion->OverwriteFusableFlag(false);
+    auto        table = SchemeTable::GetSchemeTable();
+    const auto* root  = execPlan.rootPlan.get();
+    auto        rootTuning
+        = table->Find(root->length, root->dimension, root->precision, execPlan.deviceProp);
 
-                // remove it from the execPlan list
-                fusions.erase(std::remove(fusions.begin(), fusions.end(), fusion), fusions.end());
-            }
-        }
-    }
+    auto disabled = [&](FuseShim* fusion) {
+        if(rootTuning && rootTuning->disabledFusions.count(fusion->fuseType))
+            return true;
+        auto first        = fusion->FirstFuseNode();
+        auto kernelTuning = table->Find(first->length, 1, first->precision, execPlan.deviceProp);
+        return kernelTuning && kernelTuning->disabledFusions.count(fusion->fuseType);
+    };
+
+    // remove them from the execPlan list
+    auto& fusions = execPlan.fuseShims;
+    fusions.erase(std::remove_if(fusions.begin(),
+                                 fusions.end(),
+                                 [&](FuseShim* fusion) {
+                                     if(!disabled(fusion))
+                                         return false;
+                                     fusion->OverwriteFusableFlag(false);
+                                     return true;
+                                 }),
+                  fusions.end());
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1091,17 +1400,13 @@ void CheckFuseShimForArch(ExecPlan& execPlan)
 /// note this should be done after buffer assignment and deciding oDist
 void TreeNode::DetermineBufferMemory(size_t& tmpBufSize,
                                      size_t& cmplxForRealSize,
-                                     size_t& blueSize,
-                                     size_t& chirpSize)
+                                     size_t& blueSize)
 {
     if(nodeType == NT_LEAF)
     {
         auto outputPtrDiff = compute_ptrdiff(
             UseOutputLengthForPadding() ? GetOutputLength() : length, outStride, batch, oDist);
 
-        if(scheme == CS_KERNEL_CHIRP)
-            chirpSize = std::max(lengthBlue, chirpSize);
-
         if(obOut == OB_TEMP_BLUESTEIN)
             blueSize = std::max(outputPtrDiff, blueSize);
 
@@ -1113,7 +1418,7 @@ void TreeNode::DetermineBufferMemory(size_t& tmpBufSize,
     }
 
     for(auto& child : childNodes)
-        child->DetermineBufferMemory(tmpBufSize, cmplxForRealSize, blueSize, chirpSize);
+        child->DetermineBufferMemory(tmpBufSize, cmplxForRealSize, blueSize);
 }
 
 void TreeNode::Print(rocfft_ostream& os, const int indent) const
@@ -1411,25 +1716,36 @@ std::pair<TreeNode*, TreeNode*> ExecPlan::get_load_store_nodes() const
 
 void RuntimeCompilePlan(ExecPlan& execPlan)
 {
+    // collect every kernel the plan needs, so they can all be
+    // looked up in the cache at once
+    std::vector<RTCKernel::compile_request_t> requests;
     for(auto& node : execPlan.execSeq)
-        node->compiledKernel = RTCKernel::runtime_compile(*node, execPlan.deviceProp.gcnArchName);
+        requests.emplace_back(node, false);
+
     TreeNode* load_node             = nullptr;
     TreeNode* store_node            = nullptr;
     std::tie(load_node, store_node) = execPlan.get_load_store_nodes();
     // we don't need callbacks if the kernel is all planar
-    if(!array_type_is_planar(load_node->inArrayType)
-       || !array_type_is_planar(load_node->outArrayType))
-    {
-        load_node->compiledKernelWithCallbacks
-            = RTCKernel::runtime_compile(*load_node, execPlan.deviceProp.gcnArchName, true);
-    }
-    if(store_node != load_node
-       && (!array_type_is_planar(store_node->inArrayType)
-           || !array_type_is_planar(store_node->outArrayType)))
-    {
-        store_node->compiledKernelWithCallbacks
-            = RTCKernel::runtime_compile(*store_node, execPlan.deviceProp.gcnArchName, true);
-    }
+    bool load_callbacks = !array_type_is_planar(load_node->inArrayType)
+                          || !array_type_is_planar(load_node->outArrayType);
+    bool store_callbacks = store_node != load_node
+                           && (!array_type_is_planar(store_node->inArrayType)
+                               || !array_type_is_planar(store_node->outArrayType));
+    if(load_callbacks)
+        requests.emplace_back(load_node, true);
+    if(store_callbacks)
+        requests.emplace_back(store_node, true);
+
+    auto kernels = RTCKernel::runtime_compile_batch(
+        requests, execPlan.deviceProp.gcnArchName, !execPlan.deviceFree);
+
+    auto kernel = kernels.begin();
+    for(auto& node : execPlan.execSeq)
+        node->compiledKernel = *kernel++;
+    if(load_callbacks)
+        load_node->compiledKernelWithCallbacks = *kernel++;
+    if(store_callbacks)
+        store_node->compiledKernelWithCallbacks = *kernel++;
 
     // All of the compilations are started in parallel (via futures),
     // so resolve the futures now.  That ensures that the plan is
@@ -1463,12 +1779,10 @@ void ProcessNode(ExecPlan& execPlan)
         execPlan.rootPlan->obIn
             = execPlan.rootPlan->placement == rocfft_placement_inplace ? OB_USER_OUT : OB_USER_IN;
 
-    // guarantee min buffers but possible less fusions
-    // execPlan.assignOptStrategy = rocfft_optimize_min_buffer;
-    // starting from ABT
-    execPlan.assignOptStrategy = rocfft_optimize_balance;
-    // try to use all buffer to get most fusion
-    //execPlan.assignOptStrategy = rocfft_optimize_max_fusion;
+    // execPlan.assignOptStrategy chooses how hard to try for fusions:
+    //   min_buffer: guarantee min buffers but possible less fusions
+    //   balance: starting from ABT
+    //   max_fusion: try to use all buffer to get most fusion
     AssignmentPolicy policy;
     policy.AssignBuffers(execPlan);
 
@@ -1533,6 +1847,107 @@ void ProcessNode(ExecPlan& execPlan)
     // Collapse high dims on leaf nodes where possible
     execPlan.rootPlan->CollapseContiguousDims();
 
+    FinalizePlan(execPlan);
+}
+
+// Indexes of the first and last kernels in execSeq that read or
+// write a temp region.  first is greater than last if no kernel
+// uses the region.
+static std::pair<size_t, size_t> WorkBufLiveRange(const ExecPlan& execPlan, OperatingBuffer ob)
+{
+    size_t first = std::numeric_limits<size_t>::max();
+    size_t last  = 0;
+    for(size_t i = 0; i < execPlan.execSeq.size(); ++i)
+    {
+        if(execPlan.execSeq[i]->obIn == ob || execPlan.execSeq[i]->obOut == ob)
+        {
+            first = std::min(first, i);
+            last  = std::max(last, i);
+        }
+    }
+    return {first, last};
+}
+
+// Lay out the temp regions in the work buffer.  Each region is live
+// from the first to the last kernel in execSeq that reads or writes
+// it, and regions whose lifetimes don't intersect can share memory.
+// Regions are placed largest first, each at the lowest offset that
+// doesn't overlap a region it is live together with.
+static void PackWorkBuffer(ExecPlan& execPlan)
+{
+    struct region_t
+    {
+        OperatingBuffer ob;
+        size_t          size;
+        size_t*         offset;
+        size_t          first = 0;
+        size_t          last  = 0;
+
+        bool live_with(const region_t& other) const
+        {
+            return first <= other.last && other.first <= last;
+        }
+    };
+    std::vector<region_t> regions = {
+        {OB_TEMP, execPlan.tmpWorkBufSize, &execPlan.tmpWorkBufOffset},
+        {OB_TEMP_CMPLX_FOR_REAL, execPlan.copyWorkBufSize, &execPlan.copyWorkBufOffset},
+        {OB_TEMP_BLUESTEIN, execPlan.blueWorkBufSize, &execPlan.blueWorkBufOffset},
+    };
+
+    for(auto& r : regions)
+        std::tie(r.first, r.last) = WorkBufLiveRange(execPlan, r.ob);
+
+    // unused regions take no space
+    regions.erase(std::remove_if(regions.begin(),
+                                 regions.end(),
+                                 [](const region_t& r) { return r.size == 0 || r.last < r.first; }),
+                  regions.end());
+    std::stable_sort(regions.begin(), regions.end(), [](const region_t& a, const region_t& b) {
+        return a.size > b.size;
+    });
+
+    execPlan.workBufSize = 0;
+    for(auto r = regions.begin(); r != regions.end(); ++r)
+    {
+        // try the start of the buffer, and the end of each region
+        // that's already placed
+        std::vector<size_t> candidates = {0};
+        for(auto placed = regions.begin(); placed != r; ++placed)
+            candidates.push_back(*placed->offset + placed->size);
+        std::sort(candidates.begin(), candidates.end());
+
+        for(auto offset : candidates)
+        {
+            bool fits = std::none_of(regions.begin(), r, [&](const region_t& placed) {
+                return r->live_with(placed) && offset < *placed.offset + placed.size
+                       && *placed.offset < offset + r->size;
+            });
+            if(fits)
+            {
+                *r->offset = offset;
+                break;
+            }
+        }
+        execPlan.workBufSize = std::max(execPlan.workBufSize, *r->offset + r->size);
+    }
+}
+
+// name identifying the kernel a node launches
+static std::string KernelName(const TreeNode& node, const std::string& gpu_arch)
+{
+    auto name = RTCKernel::runtime_kernel_name(node, gpu_arch);
+    if(!name.empty())
+        return name;
+
+    // built-in kernel, identify it by scheme and lengths
+    name = PrintScheme(node.scheme) + "_len";
+    for(size_t i = 0; i < node.length.size(); ++i)
+        name += (i ? "_" : "") + std::to_string(node.length[i]);
+    return name;
+}
+
+void FinalizePlan(ExecPlan& execPlan)
+{
     // Check the buffer, param and tree integrity, Note we do this after fusion
     execPlan.rootPlan->SanityCheck();
 
@@ -1540,8 +1955,7 @@ void ProcessNode(ExecPlan& execPlan)
     size_t tmpBufSize       = 0;
     size_t cmplxForRealSize = 0;
     size_t blueSize         = 0;
-    size_t chirpSize        = 0;
-    execPlan.rootPlan->DetermineBufferMemory(tmpBufSize, cmplxForRealSize, blueSize, chirpSize);
+    execPlan.rootPlan->DetermineBufferMemory(tmpBufSize, cmplxForRealSize, blueSize);
 
     // Set scale factor on final leaf node prior to RTC, since we
     // force RTC on Stockham kernels that need scaling
@@ -1555,13 +1969,17 @@ void ProcessNode(ExecPlan& execPlan)
     (*scale_node)->scale_factor = execPlan.rootPlan->scale_factor;
 
     // compile kernels for applicable nodes
-    RuntimeCompilePlan(execPlan);
+    if(!execPlan.deviceFree || execPlan.deviceFreeCompile)
+        RuntimeCompilePlan(execPlan);
+
+    execPlan.kernelNames.clear();
+    for(auto& node : execPlan.execSeq)
+        execPlan.kernelNames.push_back(KernelName(*node, execPlan.deviceProp.gcnArchName));
 
-    execPlan.workBufSize      = tmpBufSize + cmplxForRealSize + blueSize + chirpSize;
-    execPlan.tmpWorkBufSize   = tmpBufSize;
-    execPlan.copyWorkBufSize  = cmplxForRealSize;
-    execPlan.blueWorkBufSize  = blueSize;
-    execPlan.chirpWorkBufSize = chirpSize;
+    execPlan.tmpWorkBufSize  = tmpBufSize;
+    execPlan.copyWorkBufSize = cmplxForRealSize;
+    execPlan.blueWorkBufSize = blueSize;
+    PackWorkBuffer(execPlan);
 }
 
 void PrintNode(rocfft_ostream& os, const ExecPlan& execPlan)
@@ -1575,6 +1993,27 @@ void PrintNode(rocfft_ostream& os, const ExecPlan& execPlan)
                                      execPlan.rootPlan->batch,
                                      std::multiplies<size_t>());
     os << "Work buffer size: " << execPlan.workBufSize << std::endl;
+    if(execPlan.workBufSize)
+    {
+        // size@offset, then the kernels the region is live for
+        auto printRegion = [&](const char* name, OperatingBuffer ob, size_t size, size_t offset) {
+            os << " " << name << " " << size << "@" << offset;
+            auto live = WorkBufLiveRange(execPlan, ob);
+            if(live.first <= live.second)
+                os << " kernels " << live.first << "-" << live.second;
+        };
+        os << "Work buffer regions:";
+        printRegion("temp", OB_TEMP, execPlan.tmpWorkBufSize, execPlan.tmpWorkBufOffset);
+        os << ",";
+        printRegion("cmplx-for-real",
+                    OB_TEMP_CMPLX_FOR_REAL,
+                    execPlan.copyWorkBufSize,
+                    execPlan.copyWorkBufOffset);
+        os << ",";
+        printRegion(
+            "bluestein", OB_TEMP_BLUESTEIN, execPlan.blueWorkBufSize, execPlan.blueWorkBufOffset);
+        os << std::endl;
+    }
     os << "Work buffer ratio: " << (double)execPlan.workBufSize / (double)N << std::endl;
     os << "Assignment strategy: " << PrintOptimizeStrategy(execPlan.assignOptStrategy) << std::endl;
 
@@ -1602,12 +2041,9 @@ void PrintNode(rocfft_ostream& os, const ExecPlan& execPlan)
                 }
             }
 
-            if((*prev_p)->scheme != CS_KERNEL_CHIRP && (*curr_p)->scheme != CS_KERNEL_CHIRP)
+            if((*prev_p)->obOut != (*curr_p)->obIn)
             {
-                if((*prev_p)->obOut != (*curr_p)->obIn)
-                {
-                    os << "error in buffer assignments" << std::endl;
-                }
+                os << "error in buffer assignments" << std::endl;
             }
 
             prev_p = curr_p;
@@ -0,0 +1,205 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "plan_cache.h"
+#include "../../shared/environment.h"
+#include "logging.h"
+#include "repo.h"
+
+#include <iterator>
+#include <tuple>
+
+PlanCache::plan_cache_key_t::plan_cache_key_t(const rocfft_plan_t&   plan,
+                                              int                    deviceId,
+                                              const hipDeviceProp_t& prop)
+    : rank(plan.rank)
+    , lengths(plan.lengths)
+    , batch(plan.batch)
+    , placement(plan.placement)
+    , transformType(plan.transformType)
+    , precision(plan.precision)
+    , inArrayType(plan.desc.inArrayType)
+    , outArrayType(plan.desc.outArrayType)
+    , inStrides(plan.desc.inStrides)
+    , outStrides(plan.desc.outStrides)
+    , inDist(plan.desc.inDist)
+    , outDist(plan.desc.outDist)
+    , inOffset(plan.desc.inOffset)
+    , outOffset(plan.desc.outOffset)
+    , scale_factor(plan.desc.scale_factor)
+    , optimizeStrategy(plan.desc.optimizeStrategy)
+    , workBufferLimit(plan.desc.workBufferLimit)
+    , deviceId(deviceId)
+    , arch(prop.gcnArchName)
+{
+}
+
+bool PlanCache::plan_cache_key_t::operator<(const plan_cache_key_t& other) const
+{
+    return std::tie(rank,
+                    lengths,
+                    batch,
+                    placement,
+                    transformType,
+                    precision,
+                    inArrayType,
+                    outArrayType,
+                    inStrides,
+                    outStrides,
+                    inDist,
+                    outDist,
+                    inOffset,
+                    outOffset,
+                    scale_factor,
+                    optimizeStrategy,
+                    workBufferLimit,
+                    deviceId,
+                    arch)
+           < std::tie(other.rank,
+                      other.lengths,
+                      other.batch,
+                      other.placement,
+                      other.transformType,
+                      other.precision,
+                      other.inArrayType,
+                      other.outArrayType,
+                      other.inStrides,
+                      other.outStrides,
+                      other.inDist,
+                      other.outDist,
+                      other.inOffset,
+                      other.outOffset,
+                      other.scale_factor,
+                      other.optimizeStrategy,
+                      other.workBufferLimit,
+                      other.deviceId,
+                      other.arch);
+}
+
+PlanCache::PlanCache()
+    : capacity(ConfiguredCapacity())
+{
+    // Cached plans release their twiddles back to the Repo when
+    // they're destroyed.  Make sure the Repo is constructed first,
+    // so that it is destroyed after this cache during static
+    // deinitialization.
+    Repo::GetRepo();
+}
+
+PlanCache& PlanCache::GetPlanCache()
+{
+    static PlanCache cache;
+    return cache;
+}
+
+size_t PlanCache::ConfiguredCapacity()
+{
+    auto str_capacity = rocfft_getenv("ROCFFT_PLAN_CACHE_SIZE");
+    if(str_capacity.empty())
+        return 0;
+    return strtoull(str_capacity.c_str(), nullptr, 0);
+}
+
+void PlanCache::LogCounters(const char* event) const
+{
+    log_trace("plan_cache",
+              event,
+              "hits",
+              hits,
+              "misses",
+              misses,
+              "evictions",
+              evictions,
+              "size",
+              plans.size(),
+              "capacity",
+              capacity);
+}
+
+bool PlanCache::Lookup(const plan_cache_key_t& key, ExecPlan& execPlan)
+{
+    std::lock_guard<std::mutex> lck(mtx);
+    if(capacity == 0)
+        return false;
+
+    auto it = index.find(key);
+    if(it == index.end())
+    {
+        ++misses;
+        LogCounters("miss");
+        return false;
+    }
+
+    // move to the front of the LRU list
+    plans.splice(plans.begin(), plans, it->second);
+    execPlan = it->second->second;
+    ++hits;
+    LogCounters("hit");
+    return true;
+}
+
+void PlanCache::Insert(const plan_cache_key_t& key, const ExecPlan& execPlan)
+{
+    // evicted plans are destroyed outside the lock, since tearing
+    // down a plan takes the Repo lock and frees device memory
+    lru_list_t evicted;
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        if(capacity == 0)
+            return;
+
+        // another thread might have built the same plan concurrently
+        if(index.count(key))
+            return;
+
+        plans.emplace_front(key, execPlan);
+        index.emplace(key, plans.begin());
+
+        while(plans.size() > capacity)
+        {
+            index.erase(plans.back().first);
+            evicted.splice(evicted.end(), plans, std::prev(plans.end()));
+            ++evictions;
+        }
+        LogCounters("insert");
+    }
+}
+
+void PlanCache::Setup()
+{
+    PlanCache&                  cache = GetPlanCache();
+    std::lock_guard<std::mutex> lck(cache.mtx);
+    cache.capacity = ConfiguredCapacity();
+}
+
+void PlanCache::Clear()
+{
+    PlanCache& cache = GetPlanCache();
+
+    lru_list_t evicted;
+    {
+        std::lock_guard<std::mutex> lck(cache.mtx);
+        cache.index.clear();
+        evicted.swap(cache.plans);
+        cache.hits      = 0;
+        cache.misses    = 0;
+        cache.evictions = 0;
+    }
+}
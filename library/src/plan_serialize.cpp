@@ -0,0 +1,566 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Serialization of fully-decided plans.
+//
+// A serialized plan records the plan parameters and the tree that
+// ProcessNode produced: the scheme of every node, its buffer
+// assignment, and its lengths, strides and offsets after fusion and
+// padding.  Loading a plan rebuilds the tree directly from that
+// data, so DecideNodeScheme, AssignBuffers and ApplyFusion are
+// skipped.  Twiddles, kernel arguments and compiled kernels are
+// device resources, so those are recreated on load.
+//
+// The format is a native-endian binary stream, meant to be reused by
+// the same library build on the same kind of device.  Loading fails
+// cleanly if the format version, library version, kernel generator
+// or device (architecture, LDS size, CU count) don't match, or if
+// the buffer holds values the library could not have written.
+
+#include "device/kernel-generator-embed.h"
+#include "logging.h"
+#include "node_factory.h"
+#include "plan.h"
+#include "plan_cache.h"
+#include "rocfft-version.h"
+#include "rocfft.h"
+#include "rtc.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+static const char     PLAN_MAGIC[8]       = {'r', 'o', 'c', 'F', 'F', 'T', 'P', 'L'};
+static const uint32_t PLAN_FORMAT_VERSION = 7;
+
+static std::string library_version()
+{
+    return std::to_string(rocfft_version_major) + "." + std::to_string(rocfft_version_minor) + "."
+           + std::to_string(rocfft_version_patch) + "." + std::to_string(rocfft_version_tweak);
+}
+
+// Append values to a byte buffer
+class PlanWriter
+{
+public:
+    template <typename T>
+    void write(const T& val)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "cannot serialize type");
+        append(&val, sizeof(T));
+    }
+    void write(const std::string& s)
+    {
+        write<uint64_t>(s.size());
+        append(s.data(), s.size());
+    }
+    template <typename T>
+    void write(const std::vector<T>& v)
+    {
+        write<uint64_t>(v.size());
+        for(const auto& elem : v)
+            write(elem);
+    }
+
+    std::vector<char> buf;
+
+private:
+    void append(const void* src, size_t nbytes)
+    {
+        auto src_bytes = static_cast<const char*>(src);
+        buf.insert(buf.end(), src_bytes, src_bytes + nbytes);
+    }
+};
+
+// Read values back out of a byte buffer.  Throws if we'd read past
+// the end of the buffer, or if an enum or bool is out of range.
+class PlanReader
+{
+public:
+    PlanReader(const char* data, size_t len)
+        : cur(data)
+        , end(data + len)
+    {
+    }
+
+    template <typename T>
+    void read(T& val)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "cannot deserialize type");
+        // the buffer isn't trusted, so enums need read_enum
+        static_assert(!std::is_enum<T>::value, "enums must be range-checked");
+        take(&val, sizeof(T));
+    }
+    void read(bool& val)
+    {
+        uint8_t raw = 0;
+        take(&raw, sizeof(raw));
+        if(raw > 1)
+            throw std::runtime_error("serialized plan has an invalid bool");
+        val = raw;
+    }
+    // read an enum that must be in [first, last]
+    template <typename T>
+    void read_enum(T& val, T first, T last)
+    {
+        static_assert(std::is_enum<T>::value, "not an enum");
+        typename std::underlying_type<T>::type raw;
+        take(&raw, sizeof(raw));
+        if(raw < static_cast<decltype(raw)>(first) || raw > static_cast<decltype(raw)>(last))
+            throw std::runtime_error("serialized plan has an invalid enum value");
+        val = static_cast<T>(raw);
+    }
+    void read(std::string& s)
+    {
+        uint64_t len = 0;
+        read(len);
+        check_remaining(len);
+        s.assign(cur, len);
+        cur += len;
+    }
+    template <typename T>
+    void read(std::vector<T>& v)
+    {
+        uint64_t len = 0;
+        read(len);
+        // every element needs at least one byte, so this catches
+        // garbage lengths before we try to allocate for them
+        check_remaining(len);
+        v.resize(len);
+        for(auto& elem : v)
+            read(elem);
+    }
+
+    bool at_end() const
+    {
+        return cur == end;
+    }
+
+private:
+    void check_remaining(size_t nbytes) const
+    {
+        if(nbytes > static_cast<size_t>(end - cur))
+            throw std::runtime_error("serialized plan is truncated");
+    }
+    void take(void* dst, size_t nbytes)
+    {
+        check_remaining(nbytes);
+        std::copy_n(cur, nbytes, static_cast<char*>(dst));
+        cur += nbytes;
+    }
+
+    const char* cur;
+    const char* end;
+};
+
+static void write_node(PlanWriter& w, const TreeNode& node)
+{
+    w.write(node.scheme);
+    w.write(node.nodeType);
+    w.write(node.batch);
+    w.write(node.dimension);
+    w.write(node.length);
+    w.write(node.outputLength);
+    w.write(node.inStride);
+    w.write(node.outStride);
+    w.write(node.iDist);
+    w.write(node.oDist);
+    w.write(node.iOffset);
+    w.write(node.oOffset);
+    w.write(node.direction);
+    w.write(node.lds_padding);
+    w.write(node.placement);
+    w.write(node.precision);
+    w.write(node.inArrayType);
+    w.write(node.outArrayType);
+    w.write(node.large1D);
+    w.write(node.largeTwdBase);
+    w.write(node.largeTwd3Steps);
+    w.write(node.ltwdSteps);
+    w.write(node.ebtype);
+    w.write(node.dir2regMode);
+    w.write(node.sbrcTranstype);
+    w.write(node.obIn);
+    w.write(node.obOut);
+    w.write(node.lengthBlue);
+    w.write(node.allowInplace);
+    w.write(node.allowOutofplace);
+    w.write(node.intrinsicMode);
+    w.write(node.allowedOutBuf);
+    w.write(std::vector<rocfft_array_type>(node.allowedOutArrayTypes.begin(),
+                                           node.allowedOutArrayTypes.end()));
+    w.write(node.scale_factor);
+    w.write(node.comments);
+
+    w.write<uint64_t>(node.childNodes.size());
+    for(const auto& child : node.childNodes)
+        write_node(w, *child);
+}
+
+static void read_placement(PlanReader& r, rocfft_result_placement& val)
+{
+    r.read_enum(val, rocfft_placement_inplace, rocfft_placement_notinplace);
+}
+
+static void read_precision(PlanReader& r, rocfft_precision& val)
+{
+    r.read_enum(val, rocfft_precision_single, rocfft_precision_double);
+}
+
+static void read_array_type(PlanReader& r, rocfft_array_type& val)
+{
+    r.read_enum(val, rocfft_array_type_complex_interleaved, rocfft_array_type_unset);
+}
+
+static void read_optimize_strategy(PlanReader& r, rocfft_optimize_strategy& val)
+{
+    r.read_enum(val, rocfft_optimize_min_buffer, rocfft_optimize_max_fusion);
+}
+
+static const unsigned int ALL_OPERATING_BUFFERS = OB_USER_IN | OB_USER_OUT | OB_TEMP
+                                                  | OB_TEMP_CMPLX_FOR_REAL | OB_TEMP_BLUESTEIN;
+
+// a node's buffer is at most one of the operating buffers
+static void read_operating_buffer(PlanReader& r, OperatingBuffer& val)
+{
+    r.read_enum(val, OB_UNINIT, OB_TEMP_BLUESTEIN);
+    if((val & ~ALL_OPERATING_BUFFERS) || (val & (val - 1)))
+        throw std::runtime_error("serialized plan has an invalid operating buffer");
+}
+
+// the description's target device isn't saved: a loaded plan is
+// always for the current device
+static void write_description(PlanWriter& w, const rocfft_plan_description_t& desc)
+{
+    w.write(desc.inArrayType);
+    w.write(desc.outArrayType);
+    w.write(desc.inStrides);
+    w.write(desc.outStrides);
+    w.write(desc.inDist);
+    w.write(desc.outDist);
+    w.write(desc.inOffset);
+    w.write(desc.outOffset);
+    w.write(desc.scale_factor);
+    w.write(desc.optimizeStrategy);
+    w.write(desc.workBufferLimit);
+}
+
+static void read_description(PlanReader& r, rocfft_plan_description_t& desc)
+{
+    read_array_type(r, desc.inArrayType);
+    read_array_type(r, desc.outArrayType);
+    r.read(desc.inStrides);
+    r.read(desc.outStrides);
+    r.read(desc.inDist);
+    r.read(desc.outDist);
+    r.read(desc.inOffset);
+    r.read(desc.outOffset);
+    r.read(desc.scale_factor);
+    read_optimize_strategy(r, desc.optimizeStrategy);
+    r.read(desc.workBufferLimit);
+}
+
+// Real plans are only a few levels deep, even when multi-dimensional
+// real transforms, large 1D and Bluestein nest.  Anything much
+// deeper didn't come from the library, and recursing into it could
+// overflow the stack.
+static const size_t MAX_NODE_DEPTH = 16;
+
+static std::unique_ptr<TreeNode> read_node(PlanReader&            r,
+                                           TreeNode*              parent,
+                                           const hipDeviceProp_t& deviceProp,
+                                           size_t                 depth = 0)
+{
+    if(depth >= MAX_NODE_DEPTH)
+        throw std::runtime_error("serialized plan tree is too deep");
+
+    ComputeScheme scheme;
+    r.read_enum(scheme, CS_NONE, CS_ND_RC);
+    // the node constructor sets up everything specific to the
+    // scheme, the rest is overwritten below
+    auto node = NodeFactory::CreateNodeFromScheme(scheme, parent);
+
+    NodeType nodeType;
+    r.read_enum(nodeType, NT_UNDEFINED, NT_LEAF);
+    if(nodeType != node->nodeType)
+        throw std::runtime_error("serialized node type mismatch");
+
+    r.read(node->batch);
+    r.read(node->dimension);
+    r.read(node->length);
+    r.read(node->outputLength);
+    r.read(node->inStride);
+    r.read(node->outStride);
+    r.read(node->iDist);
+    r.read(node->oDist);
+    r.read(node->iOffset);
+    r.read(node->oOffset);
+    r.read(node->direction);
+    r.read(node->lds_padding);
+    read_placement(r, node->placement);
+    read_precision(r, node->precision);
+    read_array_type(r, node->inArrayType);
+    read_array_type(r, node->outArrayType);
+    r.read(node->large1D);
+    r.read(node->largeTwdBase);
+    r.read(node->largeTwd3Steps);
+    r.read(node->ltwdSteps);
+    r.read_enum(node->ebtype, EmbeddedType::NONE, EmbeddedType::C2Real_PRE);
+    r.read_enum(node->dir2regMode, FORCE_OFF_OR_NOT_SUPPORT, TRY_ENABLE_IF_SUPPORT);
+    r.read_enum(
+        node->sbrcTranstype, SBRC_TRANSPOSE_TYPE::NONE, SBRC_TRANSPOSE_TYPE::TILE_UNALIGNED);
+    read_operating_buffer(r, node->obIn);
+    read_operating_buffer(r, node->obOut);
+    r.read(node->lengthBlue);
+    r.read(node->allowInplace);
+    r.read(node->allowOutofplace);
+    r.read_enum(node->intrinsicMode, DISABLE_BOTH, ENABLE_BOTH);
+    r.read(node->allowedOutBuf);
+    if(node->allowedOutBuf & ~static_cast<size_t>(ALL_OPERATING_BUFFERS))
+        throw std::runtime_error("serialized plan has invalid allowed buffers");
+    uint64_t numAllowedOutArrayTypes = 0;
+    r.read(numAllowedOutArrayTypes);
+    node->allowedOutArrayTypes.clear();
+    for(uint64_t i = 0; i < numAllowedOutArrayTypes; ++i)
+    {
+        rocfft_array_type type;
+        read_array_type(r, type);
+        node->allowedOutArrayTypes.insert(type);
+    }
+    r.read(node->scale_factor);
+    r.read(node->comments);
+    node->deviceProp = deviceProp;
+
+    uint64_t numChildren = 0;
+    r.read(numChildren);
+    for(uint64_t i = 0; i < numChildren; ++i)
+        node->childNodes.emplace_back(read_node(r, node.get(), deviceProp, depth + 1));
+    return node;
+}
+
+rocfft_status rocfft_plan_serialize(const rocfft_plan plan, void** buffer, size_t* buffer_len_bytes)
+{
+    log_trace(__func__, "plan", plan, "buffer", buffer, "buffer_len_bytes", buffer_len_bytes);
+    if(!plan || !buffer || !buffer_len_bytes)
+        return rocfft_status_invalid_arg_value;
+    // only whole plans are saved, not the chunks of a plan run in
+    // batch chunks
+    if(plan->chunkBatch)
+    {
+        log_trace(__func__, "invalid", "plan runs in batch chunks");
+        return rocfft_status_failure;
+    }
+
+    try
+    {
+        const ExecPlan& execPlan = plan->execPlan;
+
+        PlanWriter w;
+        w.write(PLAN_MAGIC);
+        w.write(PLAN_FORMAT_VERSION);
+        w.write(library_version());
+        w.write(generator_sum());
+        // only the device properties that plan decisions depend on
+        w.write(std::string(execPlan.deviceProp.gcnArchName));
+        w.write<uint64_t>(execPlan.deviceProp.sharedMemPerBlock);
+        w.write<uint64_t>(execPlan.deviceProp.multiProcessorCount);
+
+        // plan parameters
+        w.write(plan->rank);
+        w.write(plan->lengths);
+        w.write(plan->batch);
+        w.write(plan->placement);
+        w.write(plan->transformType);
+        w.write(plan->precision);
+        w.write(plan->base_type_size);
+        write_description(w, plan->desc);
+
+        // decided tree
+        w.write(execPlan.iLength);
+        w.write(execPlan.oLength);
+        w.write(execPlan.assignOptStrategy);
+        write_node(w, *execPlan.rootPlan);
+
+        // what the tree is expected to produce, including per-kernel
+        // launch information, so that loading a plan can confirm
+        // that it will launch exactly what was saved
+        w.write(execPlan.workBufSize);
+        w.write(execPlan.kernelNames);
+        w.write(execPlan.gridParam);
+
+        *buffer_len_bytes = w.buf.size();
+        *buffer           = new char[w.buf.size()];
+        std::copy(w.buf.begin(), w.buf.end(), static_cast<char*>(*buffer));
+    }
+    catch(std::exception& e)
+    {
+        if(LOG_TRACE_ENABLED())
+            (*LogSingleton::GetInstance().GetTraceOS()) << e.what() << std::endl;
+        return rocfft_status_failure;
+    }
+    return rocfft_status_success;
+}
+
+rocfft_status rocfft_plan_buffer_free(void* buffer)
+{
+    log_trace(__func__, "buffer", buffer);
+    delete[] static_cast<char*>(buffer);
+    return rocfft_status_success;
+}
+
+// Check that a serialized plan was produced by this library for the
+// current device.  Returns an empty string if so, otherwise the
+// reason it can't be used.
+static std::string check_header(PlanReader& r, const hipDeviceProp_t& deviceProp)
+{
+    std::array<char, sizeof(PLAN_MAGIC)> magic;
+    r.read(magic);
+    if(!std::equal(magic.begin(), magic.end(), PLAN_MAGIC))
+        return "not a serialized plan";
+
+    uint32_t format_version = 0;
+    r.read(format_version);
+    if(format_version != PLAN_FORMAT_VERSION)
+        return "serialized plan format version mismatch";
+
+    std::string version;
+    r.read(version);
+    if(version != library_version())
+        return "serialized plan library version mismatch";
+
+    std::array<char, 32> sum;
+    r.read(sum);
+    if(sum != generator_sum())
+        return "serialized plan kernel generator mismatch";
+
+    std::string arch;
+    r.read(arch);
+    if(arch != deviceProp.gcnArchName)
+        return "serialized plan device architecture mismatch";
+
+    uint64_t lds_bytes = 0;
+    r.read(lds_bytes);
+    if(lds_bytes != deviceProp.sharedMemPerBlock)
+        return "serialized plan device LDS size mismatch";
+
+    // plans decided without a device may not know the CU count
+    uint64_t compute_units = 0;
+    r.read(compute_units);
+    if(compute_units && compute_units != static_cast<uint64_t>(deviceProp.multiProcessorCount))
+        return "serialized plan device compute unit count mismatch";
+
+    return {};
+}
+
+rocfft_status
+    rocfft_plan_deserialize(rocfft_plan* plan, const void* buffer, size_t buffer_len_bytes)
+{
+    log_trace(__func__, "plan", plan, "buffer", buffer, "buffer_len_bytes", buffer_len_bytes);
+    if(!plan || !buffer || !buffer_len_bytes)
+        return rocfft_status_invalid_arg_value;
+    *plan = nullptr;
+
+    try
+    {
+        auto      p        = std::make_unique<rocfft_plan_t>();
+        ExecPlan& execPlan = p->execPlan;
+
+        int deviceId = 0;
+        if(hipGetDevice(&deviceId) != hipSuccess)
+            throw std::runtime_error("hipGetDevice failed.");
+        if(hipGetDeviceProperties(&execPlan.deviceProp, deviceId) != hipSuccess)
+            throw std::runtime_error("hipGetDeviceProperties failed for deviceId "
+                                     + std::to_string(deviceId));
+
+        PlanReader r(static_cast<const char*>(buffer), buffer_len_bytes);
+        auto       mismatch = check_header(r, execPlan.deviceProp);
+        if(!mismatch.empty())
+        {
+            log_trace(__func__, "invalid", mismatch);
+            return rocfft_status_failure;
+        }
+
+        r.read(p->rank);
+        if(p->rank == 0 || p->rank > MAX_TRANSFORM_RANK)
+            throw std::runtime_error("serialized plan has an invalid rank");
+        r.read(p->lengths);
+        r.read(p->batch);
+        read_placement(r, p->placement);
+        r.read_enum(p->transformType,
+                    rocfft_transform_type_complex_forward,
+                    rocfft_transform_type_real_inverse);
+        read_precision(r, p->precision);
+        r.read(p->base_type_size);
+        read_description(r, p->desc);
+
+        r.read(execPlan.iLength);
+        r.read(execPlan.oLength);
+        read_optimize_strategy(r, execPlan.assignOptStrategy);
+        execPlan.rootPlan = read_node(r, nullptr, execPlan.deviceProp);
+
+        size_t                   workBufSize = 0;
+        std::vector<std::string> names;
+        std::vector<GridParam>   gridParam;
+        r.read(workBufSize);
+        r.read(names);
+        r.read(gridParam);
+        if(!r.at_end())
+            throw std::runtime_error("unexpected data after serialized plan");
+
+        log_bench(rocfft_rider_command(p.get()));
+
+        execPlan.rootPlan->CollectLeaves(execPlan.execSeq, execPlan.fuseShims);
+        FinalizePlan(execPlan);
+        if(!PlanPowX(execPlan))
+            throw std::runtime_error("Unable to create execution plan.");
+
+        // make sure we rebuilt what was saved, including launch
+        // parameters if any were saved
+        if(execPlan.workBufSize != workBufSize || execPlan.kernelNames != names
+           || (!gridParam.empty() && execPlan.gridParam.size() != gridParam.size())
+           || !std::equal(gridParam.begin(),
+                          gridParam.end(),
+                          execPlan.gridParam.begin(),
+                          [](const GridParam& a, const GridParam& b) {
+                              return a.b_x == b.b_x && a.b_y == b.b_y && a.b_z == b.b_z
+                                     && a.wgs_x == b.wgs_x && a.wgs_y == b.wgs_y
+                                     && a.wgs_z == b.wgs_z && a.lds_bytes == b.lds_bytes;
+                          }))
+            throw std::runtime_error("deserialized plan does not match serialized kernels");
+
+        // later plan creation with the same parameters can reuse
+        // this plan, if the plan cache is enabled
+        PlanCache::GetPlanCache().Insert(
+            PlanCache::plan_cache_key_t(*p, deviceId, execPlan.deviceProp), execPlan);
+
+        *plan = p.release();
+    }
+    catch(std::exception& e)
+    {
+        if(LOG_TRACE_ENABLED())
+            (*LogSingleton::GetInstance().GetTraceOS()) << e.what() << std::endl;
+        return rocfft_status_failure;
+    }
+    return rocfft_status_success;
+}
@@ -0,0 +1,372 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "plan_tuner.h"
+#include "../../shared/gpubuf.h"
+#include "../../shared/ptrdiff.h"
+#include "logging.h"
+#include "node_factory.h"
+#include "perf_model.h"
+#include "plan_cache.h"
+#include "rocfft.h"
+
+#include <algorithm>
+#include <fstream>
+
+double AnalyticPlanCostModel::Cost(const ExecPlan& execPlan) const
+{
+    return EstimatePlan(execPlan).timeUs;
+}
+
+PlanTuner::PlanTuner(std::unique_ptr<PlanCostModel> costModel)
+    : costModel(std::move(costModel))
+{
+}
+
+std::unique_ptr<rocfft_plan_t> PlanTuner::Build(const SchemeTuning* tuning)
+{
+    std::unique_ptr<SchemeTable::ScopedOverride> tableOverride;
+    if(tuning)
+    {
+        auto table = std::make_shared<SchemeTable>(*SchemeTable::GetSchemeTable());
+        table->Add(arch, precision, length, *tuning);
+        tableOverride = std::make_unique<SchemeTable::ScopedOverride>(table);
+    }
+
+    auto plan = std::make_unique<rocfft_plan_t>();
+    if(rocfft_plan_create_internal(plan.get(),
+                                   placement,
+                                   transformType,
+                                   precision,
+                                   length.size(),
+                                   length.data(),
+                                   batch,
+                                   description)
+       != rocfft_status_success)
+        return nullptr;
+    return plan;
+}
+
+// input or output buffers for a side of the plan
+static std::vector<gpubuf> AllocBuffers(const rocfft_plan_t&                          plan,
+                                        rocfft_array_type                             type,
+                                        const std::array<size_t, MAX_TRANSFORM_RANK>& strides,
+                                        size_t                                        dist,
+                                        const std::array<size_t, 2>&                  offsets,
+                                        std::vector<void*>&                           ptrs)
+{
+    std::vector<size_t> length(plan.lengths.begin(), plan.lengths.begin() + plan.rank);
+    std::vector<size_t> stride(strides.begin(), strides.begin() + plan.rank);
+    auto                elems = compute_ptrdiff(length, stride, plan.batch, dist);
+
+    bool planar = type == rocfft_array_type_complex_planar;
+    // interleaved complex elements are two reals
+    auto elemBytes = planar ? plan.base_type_size : 2 * plan.base_type_size;
+
+    std::vector<gpubuf> bufs(planar ? 2 : 1);
+    for(size_t i = 0; i < bufs.size(); ++i)
+    {
+        auto bytes = (offsets[i] + elems) * elemBytes;
+        if(bufs[i].alloc(bytes) != hipSuccess)
+            throw std::runtime_error("unable to allocate buffer for tuning");
+        // transform zeros, so repeated in-place execution stays finite
+        if(hipMemset(bufs[i].data(), 0, bytes) != hipSuccess)
+            throw std::runtime_error("hipMemset failed");
+        ptrs.push_back(bufs[i].data());
+    }
+    return bufs;
+}
+
+double PlanTuner::Evaluate(rocfft_plan_t& plan)
+{
+    if(plan.execPlan.deviceFree)
+        return costModel->Cost(plan.execPlan);
+
+    std::vector<void*>  inPtrs;
+    std::vector<void*>  outPtrs;
+    std::vector<gpubuf> inBufs = AllocBuffers(plan,
+                                              plan.desc.inArrayType,
+                                              plan.desc.inStrides,
+                                              plan.desc.inDist,
+                                              plan.desc.inOffset,
+                                              inPtrs);
+    std::vector<gpubuf> outBufs;
+    if(plan.placement == rocfft_placement_notinplace)
+        outBufs = AllocBuffers(plan,
+                               plan.desc.outArrayType,
+                               plan.desc.outStrides,
+                               plan.desc.outDist,
+                               plan.desc.outOffset,
+                               outPtrs);
+
+    hipEvent_t start;
+    hipEvent_t stop;
+    if(hipEventCreate(&start) != hipSuccess)
+        throw std::runtime_error("hipEventCreate failed");
+    if(hipEventCreate(&stop) != hipSuccess)
+    {
+        (void)hipEventDestroy(start);
+        throw std::runtime_error("hipEventCreate failed");
+    }
+
+    std::vector<float> times;
+    try
+    {
+        void** out = outPtrs.empty() ? nullptr : outPtrs.data();
+        // first run is a warm-up, it may compile kernels or
+        // allocate a work buffer
+        if(rocfft_execute(&plan, inPtrs.data(), out, nullptr) != rocfft_status_success)
+            throw std::runtime_error("rocfft_execute failed");
+        for(unsigned int i = 0; i < 11; ++i)
+        {
+            if(hipEventRecord(start) != hipSuccess)
+                throw std::runtime_error("hipEventRecord start failed");
+            if(rocfft_execute(&plan, inPtrs.data(), out, nullptr) != rocfft_status_success)
+                throw std::runtime_error("rocfft_execute failed");
+            if(hipEventRecord(stop) != hipSuccess)
+                throw std::runtime_error("hipEventRecord stop failed");
+            if(hipEventSynchronize(stop) != hipSuccess)
+                throw std::runtime_error("hipEventSynchronize failed");
+            float time;
+            if(hipEventElapsedTime(&time, start, stop) != hipSuccess)
+                throw std::runtime_error("hipEventElapsedTime failed");
+            times.push_back(time);
+        }
+    }
+    catch(std::exception&)
+    {
+        (void)hipEventDestroy(start);
+        (void)hipEventDestroy(stop);
+        throw;
+    }
+    (void)hipEventDestroy(start);
+    (void)hipEventDestroy(stop);
+
+    // median
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// fusion types used by a plan
+static std::vector<FuseType> PlanFuseTypes(const ExecPlan& execPlan)
+{
+    std::vector<FuseType> types;
+    for(const auto shim : execPlan.fuseShims)
+    {
+        if(std::find(types.begin(), types.end(), shim->fuseType) == types.end())
+            types.push_back(shim->fuseType);
+    }
+    return types;
+}
+
+bool PlanTuner::Tune(const rocfft_result_placement placement,
+                     const rocfft_transform_type   transform_type,
+                     const rocfft_precision        precision,
+                     const size_t                  dimensions,
+                     const size_t*                 lengths,
+                     const size_t                  number_of_transforms,
+                     const rocfft_plan_description description,
+                     SchemeTuning&                 winner)
+{
+    // real and complex transforms of the same lengths share table
+    // entries, so only complex transforms are tuned
+    if(transform_type != rocfft_transform_type_complex_forward
+       && transform_type != rocfft_transform_type_complex_inverse)
+        throw std::runtime_error("only complex transforms can be tuned");
+    if(dimensions < 1 || dimensions > 3)
+        throw std::runtime_error("invalid dimensions for tuning");
+
+    this->placement     = placement;
+    this->transformType = transform_type;
+    this->precision     = precision;
+    this->length.assign(lengths, lengths + dimensions);
+    this->batch       = number_of_transforms;
+    this->description = description;
+
+    // the plan rocFFT would build now is what candidates need to beat
+    auto current = Build(nullptr);
+    if(!current)
+        throw std::runtime_error("unable to create plan to tune");
+    const auto& currentPlan = current->execPlan;
+    arch                    = currentPlan.deviceProp.gcnArchName;
+    auto bestCost           = Evaluate(*current);
+    log_trace("plan_tune", "candidate", "current", "cost", bestCost);
+
+    // schemes to try.  the current scheme is tried with different
+    // fusions, keeping any decomposition it was given by the table.
+    SchemeTuning currentTuning;
+    auto         table = SchemeTable::GetSchemeTable();
+    auto         found = table->Find(length, length.size(), precision, arch);
+    if(found)
+        currentTuning = *found;
+    currentTuning.disabledFusions.clear();
+
+    std::vector<SchemeTuning> schemes = {currentTuning};
+
+    NodeMetaData rootData(currentPlan.rootPlan.get());
+    const auto&  root     = *currentPlan.rootPlan;
+    rootData.dimension    = root.dimension;
+    rootData.length       = root.length;
+    rootData.inStride     = root.inStride;
+    rootData.outStride    = root.outStride;
+    rootData.iDist        = root.iDist;
+    rootData.oDist        = root.oDist;
+    rootData.placement    = root.placement;
+    rootData.inArrayType  = root.inArrayType;
+    rootData.outArrayType = root.outArrayType;
+    for(const auto& candidate : NodeFactory::TuningCandidates(rootData))
+        schemes.push_back(candidate);
+
+    bool improved = false;
+    for(const auto& scheme : schemes)
+    {
+        // build with all fusions enabled to see which are possible
+        auto plan = Build(&scheme);
+        // the scheme might be rejected during plan building, in
+        // which case we'd get the default plan back
+        if(!plan
+           || (scheme.scheme != CS_NONE && plan->execPlan.rootPlan->scheme != scheme.scheme))
+            continue;
+
+        auto fuseTypes = PlanFuseTypes(plan->execPlan);
+        if(fuseTypes.size() > MAX_FUSE_TYPES)
+            fuseTypes.resize(MAX_FUSE_TYPES);
+
+        // try every subset of fusions to disable, starting with the
+        // plan we just built that disables none
+        for(size_t mask = 0; mask < (size_t(1) << fuseTypes.size()); ++mask)
+        {
+            SchemeTuning candidate = scheme;
+            for(size_t bit = 0; bit < fuseTypes.size(); ++bit)
+            {
+                if(mask & (size_t(1) << bit))
+                    candidate.disabledFusions.insert(fuseTypes[bit]);
+            }
+            if(mask != 0)
+                plan = Build(&candidate);
+            if(!plan)
+                continue;
+
+            auto cost = Evaluate(*plan);
+            log_trace("plan_tune",
+                      "candidate",
+                      PrintScheme(candidate.scheme),
+                      "factor",
+                      candidate.factor,
+                      "disabled_fusions",
+                      candidate.disabledFusions.size(),
+                      "cost",
+                      cost);
+            if(cost * MIN_SPEEDUP < bestCost)
+            {
+                bestCost = cost;
+                winner   = candidate;
+                improved = true;
+            }
+        }
+    }
+    return improved;
+}
+
+rocfft_status rocfft_plan_tune(const char*                   table_path,
+                               const rocfft_result_placement placement,
+                               const rocfft_transform_type   transform_type,
+                               const rocfft_precision        precision,
+                               const size_t                  dimensions,
+                               const size_t*                 lengths,
+                               const size_t                  number_of_transforms,
+                               const rocfft_plan_description description)
+{
+    log_trace(__func__,
+              "table_path",
+              table_path ? table_path : "",
+              "placement",
+              placement,
+              "transform_type",
+              transform_type,
+              "precision",
+              precision,
+              "dimensions",
+              dimensions,
+              "lengths",
+              std::make_pair(lengths, dimensions),
+              "number_of_transforms",
+              number_of_transforms,
+              "description",
+              description);
+
+    if(!lengths)
+        return rocfft_status_invalid_arg_value;
+    if(transform_type != rocfft_transform_type_complex_forward
+       && transform_type != rocfft_transform_type_complex_inverse)
+        return rocfft_status_invalid_arg_value;
+    if(dimensions < 1 || dimensions > 3)
+        return rocfft_status_invalid_dimensions;
+
+    try
+    {
+        PlanTuner    tuner(std::make_unique<AnalyticPlanCostModel>());
+        SchemeTuning winner;
+        bool         improved = tuner.Tune(placement,
+                                           transform_type,
+                                           precision,
+                                           dimensions,
+                                           lengths,
+                                           number_of_transforms,
+                                           description,
+                                           winner);
+
+        const auto&         arch = tuner.Arch();
+        std::vector<size_t> length(lengths, lengths + dimensions);
+        if(improved)
+        {
+            SchemeTable::Install(arch, precision, length, winner);
+            // cached plans for this problem were decided with the
+            // old table
+            PlanCache::Clear();
+        }
+
+        if(table_path)
+        {
+            // add to whatever the file already records
+            SchemeTable   fileTable;
+            std::ifstream is(table_path);
+            if(is)
+                fileTable.Load(is);
+            is.close();
+            if(improved)
+                fileTable.Add(arch, precision, length, winner);
+
+            std::ofstream os(table_path);
+            fileTable.Write(os);
+            if(!os)
+                throw std::runtime_error(std::string("unable to write ") + table_path);
+        }
+        return rocfft_status_success;
+    }
+    catch(std::exception& e)
+    {
+        if(LOG_TRACE_ENABLED())
+        {
+            (*LogSingleton::GetInstance().GetTraceOS()) << e.what() << std::endl;
+        }
+        return rocfft_status_failure;
+    }
+}
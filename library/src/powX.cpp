@@ -23,6 +23,7 @@
 #include <cstddef>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <numeric>
 #include <unordered_map>
 #include <vector>
@@ -35,6 +36,7 @@
 #include "transform.h"
 
 #include "kernel_launch.h"
+#include "launch_check.h"
 
 #include "function_pool.h"
 #include "ref_cpu.h"
@@ -51,15 +53,31 @@
 // failure returns false right away.
 bool PlanPowX(ExecPlan& execPlan)
 {
+    std::vector<size_t> kernArgs;
+    std::vector<size_t> kernArgOffsets;
     for(const auto& node : execPlan.execSeq)
     {
         if(node->CreateTwiddleTableResource() == false)
             return false;
 
-        if(node->CreateDevKernelArgs() == false)
-            return false;
+        kernArgOffsets.push_back(node->AppendKernelArgs(kernArgs));
     }
 
+    // all kernel arguments go to the device in one copy
+    execPlan.kernArgs = std::make_shared<gpubuf_t<size_t>>(kargs_create(kernArgs));
+    if(!execPlan.execSeq.empty() && !*execPlan.kernArgs)
+        return false;
+    for(size_t i = 0; i < execPlan.execSeq.size(); ++i)
+        execPlan.execSeq[i]->devKernArg = execPlan.kernArgs->data() + kernArgOffsets[i];
+
+    PlanGridParams(execPlan);
+    return true;
+}
+
+void PlanGridParams(ExecPlan& execPlan)
+{
+    execPlan.devFnCall.clear();
+    execPlan.gridParam.clear();
     for(const auto& node : execPlan.execSeq)
     {
         DevFnCall ptr = nullptr;
@@ -70,41 +88,6 @@ bool PlanPowX(ExecPlan& execPlan)
         execPlan.devFnCall.push_back(ptr);
         execPlan.gridParam.push_back(gp);
     }
-
-    return true;
-}
-
-static size_t data_size_bytes(const std::vector<size_t>& lengths,
-                              rocfft_precision           precision,
-                              rocfft_array_type          type)
-{
-    // first compute the raw number of elements
-    size_t elems = std::accumulate(
-        lengths.begin(), lengths.end(), static_cast<size_t>(1), std::multiplies<size_t>());
-    // size of each element
-    size_t elemsize = (precision == rocfft_precision_single ? sizeof(float) : sizeof(double));
-    switch(type)
-    {
-    case rocfft_array_type_complex_interleaved:
-    case rocfft_array_type_complex_planar:
-        // complex needs two numbers per element
-        return 2 * elems * elemsize;
-    case rocfft_array_type_real:
-        // real needs one number per element
-        return elems * elemsize;
-    case rocfft_array_type_hermitian_interleaved:
-    case rocfft_array_type_hermitian_planar:
-    {
-        // hermitian requires 2 numbers per element, but innermost
-        // dimension is cut down to roughly half
-        size_t non_innermost = elems / lengths[0];
-        return 2 * non_innermost * elemsize * ((lengths[0] / 2) + 1);
-    }
-    case rocfft_array_type_unset:
-        // we should really have an array type at this point
-        assert(false);
-        return 0;
-    }
 }
 
 static float execution_bandwidth_GB_per_s(size_t data_size_bytes, float duration_ms)
@@ -150,7 +133,7 @@ static float max_memory_bandwidth_GB_per_s()
 void DebugPrintBuffer(rocfft_ostream&            stream,
                       rocfft_array_type          type,
                       rocfft_precision           precision,
-                      void*                      buffer[],
+                      void* const                buffer[],
                       const std::vector<size_t>& length_cm,
                       const std::vector<size_t>& stride_cm,
                       size_t                     dist,
@@ -308,190 +291,459 @@ void SetDefaultCallback(const TreeNode* node, const SetCallbackType& type, void*
         throw std::runtime_error("hipMemcpyFromSymbol failure");
 }
 
-// Internal plan executor.
-// For in-place transforms, in_buffer == out_buffer.
-void TransformPowX(const ExecPlan&       execPlan,
-                   void*                 in_buffer[],
-                   void*                 out_buffer[],
-                   rocfft_execution_info info)
+// Pointers to the data a node reads or writes in operating buffer
+// ob.  The second pointer is only used for planar data.
+static void ResolveBuffer(const ExecPlan&                execPlan,
+                          const TreeNode&                node,
+                          OperatingBuffer                ob,
+                          rocfft_array_type              type,
+                          size_t                         blueOffset,
+                          void*                          in_buffer[],
+                          void*                          out_buffer[],
+                          const rocfft_execution_info_t& info,
+                          void*                          buf[2])
 {
-    assert(execPlan.execSeq.size() == execPlan.devFnCall.size());
-    assert(execPlan.execSeq.size() == execPlan.gridParam.size());
+    // Size of complex type
+    const size_t complexTSize
+        = (node.precision == rocfft_precision_single) ? sizeof(float) * 2 : sizeof(double) * 2;
+    // temp regions are at their packed offsets in the work buffer
+    auto workBufPtr = [&info](size_t offset_bytes) {
+        return static_cast<void*>(static_cast<char*>(info.workBuffer) + offset_bytes);
+    };
+    const bool planar = type == rocfft_array_type_complex_planar
+                        || type == rocfft_array_type_hermitian_planar;
+
+    switch(ob)
+    {
+    case OB_USER_IN:
+        buf[0] = in_buffer[0];
+        if(planar)
+            buf[1] = in_buffer[1];
+        break;
+    case OB_USER_OUT:
+        buf[0] = out_buffer[0];
+        if(planar)
+            buf[1] = out_buffer[1];
+        break;
+    case OB_TEMP:
+        buf[0] = workBufPtr(execPlan.tmpWorkBufOffset * complexTSize);
+        if(planar)
+        {
+            // Assume planar using the same extra size of memory as
+            // interleaved format, and we just need to split it for
+            // planar.
+            buf[1] = workBufPtr(execPlan.tmpWorkBufOffset * complexTSize
+                                + execPlan.tmpWorkBufSize * complexTSize / 2);
+        }
+        break;
+    case OB_TEMP_CMPLX_FOR_REAL:
+        buf[0] = workBufPtr(execPlan.copyWorkBufOffset * complexTSize);
+        // TODO: Can we use this in planar as well ??
+        // if(planar)
+        // {
+        //     buf[1] = workBufPtr((execPlan.tmpWorkBufSize + execPlan.copyWorkBufSize / 2)
+        //                         * complexTSize);
+        // }
+        break;
+    case OB_TEMP_BLUESTEIN:
+        buf[0] = workBufPtr((execPlan.blueWorkBufOffset + blueOffset) * complexTSize);
+        // Bluestein mul-kernels (3 types) work well for CI->CI
+        // so we only consider CI->CI now
+        break;
+    case OB_UNINIT:
+        rocfft_cerr << "Error: operating buffer not initialized for kernel!\n";
+        assert(ob != OB_UNINIT);
+        break;
+    default:
+        rocfft_cerr << "Error: operating buffer not specified for kernel!\n";
+        assert(false);
+    }
+}
 
-    // we can log profile information if we're on the null stream,
-    // since we will be able to wait for the transform to finish
-    bool            emit_profile_log  = LOG_PROFILE_ENABLED() && !info->rocfft_stream;
-    bool            emit_kernelio_log = LOG_KERNELIO_ENABLED();
-    rocfft_ostream* kernelio_stream   = nullptr;
-    float           max_memory_bw     = 0.0;
-    hipEvent_t      start, stop;
-    if(emit_profile_log)
+// One kernel of a plan, ready to launch
+struct KernelLaunch
+{
+    DeviceCallIn data = {};
+    DevFnCall    fn   = nullptr;
+    // runtime-compiled kernel, launched with kargs instead of calling
+    // fn
+    RTCKernel*    rtcKernel = nullptr;
+    RTCKernelArgs kargs;
+    // the apply-callback kernel only runs if there are callbacks
+    bool skip = false;
+};
+
+struct KernelLauncher
+{
+    virtual ~KernelLauncher()                        = default;
+    virtual void Launch(const KernelLaunch& kernel) = 0;
+};
+
+// Launches kernels on the device
+struct DeviceLauncher : public KernelLauncher
+{
+    void Launch(const KernelLaunch& kernel) override
     {
-        if(hipEventCreate(&start) != hipSuccess || hipEventCreate(&stop) != hipSuccess)
-            throw std::runtime_error("hipEventCreate failure");
-        max_memory_bw = max_memory_bandwidth_GB_per_s();
+        const auto& data = kernel.data;
+        if(kernel.rtcKernel)
+        {
+            const auto& gp = data.gridParam;
+            kernel.rtcKernel->launch(kernel.kargs,
+                                     {gp.b_x, gp.b_y, gp.b_z},
+                                     {gp.wgs_x, gp.wgs_y, gp.wgs_z},
+                                     gp.lds_bytes,
+                                     data.rocfft_stream);
+        }
+        else
+        {
+            DeviceCallOut back;
+            kernel.fn(&data, &back);
+        }
+    }
+};
+
+// Only records what would be launched, without touching the device,
+// so a launch sequence can be checked before it's recorded into a
+// graph
+struct MockLauncher : public KernelLauncher
+{
+    std::vector<LaunchRecord<GridParam>> launched;
+
+    void Launch(const KernelLaunch& kernel) override
+    {
+        launched.push_back({kernel.data.node, kernel.data.gridParam});
+    }
+};
+
+// The kernels of execSeq in order, with their planned grids.  The
+// apply-callback kernel is only launched if there are callbacks.
+static std::vector<LaunchRecord<GridParam>> PlannedLaunches(const ExecPlan& execPlan,
+                                                            bool            have_callbacks)
+{
+    std::vector<LaunchRecord<GridParam>> planned;
+    for(size_t i = 0; i < execPlan.execSeq.size(); ++i)
+    {
+        const auto node = execPlan.execSeq[i];
+        if(node->scheme == CS_KERNEL_APPLY_CALLBACK && !have_callbacks)
+            continue;
+        planned.push_back({node, execPlan.gridParam[i]});
+    }
+    return planned;
+}
+
+// Whether to launch through a graph.  Logging that looks at each
+// kernel separately needs them launched one at a time.
+static bool UseGraph(const rocfft_execution_info_t& info)
+{
+#ifdef REF_DEBUG
+    return false;
+#else
+    return info.launchMode == rocfft_launch_mode_graph && !LOG_PROFILE_ENABLED()
+           && !LOG_KERNELIO_ENABLED();
+#endif
+}
+
+// Every kernel launch of a plan, resolved for one set of user
+// buffers, work buffer, stream and callbacks.  Running it only
+// launches kernels: nothing in the plan is written, so several
+// threads can execute the same plan at once.
+//
+// In graph mode, the launches are also recorded into a HIP graph,
+// which is launched instead of the separate kernels if it has one
+// node per launch.
+struct ExecPlanLaunch
+{
+    std::vector<KernelLaunch> kernels;
+
+    // what the launches were resolved for.  the second pointer of a
+    // user buffer is only looked at if it's planar.
+    void*         in[2]      = {nullptr, nullptr};
+    void*         out[2]     = {nullptr, nullptr};
+    void*         workBuffer = nullptr;
+    hipStream_t   stream     = nullptr;
+    UserCallbacks callbacks;
+    bool          useGraph = false;
+
+    hipGraph_t     graph     = nullptr;
+    hipGraphExec_t graphExec = nullptr;
+
+    ExecPlanLaunch(const ExecPlan&                execPlan,
+                   void*                          in_buffer[],
+                   void*                          out_buffer[],
+                   const rocfft_execution_info_t& info);
+    ~ExecPlanLaunch()
+    {
+        if(graphExec)
+            (void)hipGraphExecDestroy(graphExec);
+        if(graph)
+            (void)hipGraphDestroy(graph);
+    }
+    ExecPlanLaunch(const ExecPlanLaunch&) = delete;
+    void operator=(const ExecPlanLaunch&) = delete;
+
+    bool Matches(const ExecPlan&                execPlan,
+                 void*                          in_buffer[],
+                 void*                          out_buffer[],
+                 const rocfft_execution_info_t& info) const
+    {
+        const bool inPlanar  = array_type_is_planar(execPlan.rootPlan->inArrayType);
+        const bool outPlanar = array_type_is_planar(execPlan.rootPlan->outArrayType);
+        return in[0] == in_buffer[0] && (!inPlanar || in[1] == in_buffer[1])
+               && out[0] == out_buffer[0] && (!outPlanar || out[1] == out_buffer[1])
+               && workBuffer == info.workBuffer && stream == info.rocfft_stream
+               && useGraph == UseGraph(info)
+               && callbacks.load_cb_fn == info.callbacks.load_cb_fn
+               && callbacks.load_cb_data == info.callbacks.load_cb_data
+               && callbacks.load_cb_lds_bytes == info.callbacks.load_cb_lds_bytes
+               && callbacks.store_cb_fn == info.callbacks.store_cb_fn
+               && callbacks.store_cb_data == info.callbacks.store_cb_data
+               && callbacks.store_cb_lds_bytes == info.callbacks.store_cb_lds_bytes;
+    }
+
+    // hand every kernel that runs to the launcher, in order
+    void Run(KernelLauncher& launcher) const
+    {
+        for(const auto& kernel : kernels)
+            if(!kernel.skip)
+                launcher.Launch(kernel);
     }
 
-    // assign callbacks to the node that are actually doing the
-    // loading and storing to/from global memory
+private:
+    void RecordGraph(const ExecPlan& execPlan, hipStream_t captureStream);
+};
+
+ExecPlanLaunch::ExecPlanLaunch(const ExecPlan&                execPlan,
+                               void*                          in_buffer[],
+                               void*                          out_buffer[],
+                               const rocfft_execution_info_t& info)
+    : workBuffer(info.workBuffer)
+    , stream(info.rocfft_stream)
+    , callbacks(info.callbacks)
+    , useGraph(UseGraph(info))
+{
+    in[0]  = in_buffer[0];
+    out[0] = out_buffer[0];
+    if(array_type_is_planar(execPlan.rootPlan->inArrayType))
+        in[1] = in_buffer[1];
+    if(array_type_is_planar(execPlan.rootPlan->outArrayType))
+        out[1] = out_buffer[1];
+
+    // callbacks go to the nodes that are actually doing the loading
+    // and storing to/from global memory
     TreeNode* load_node             = nullptr;
     TreeNode* store_node            = nullptr;
     std::tie(load_node, store_node) = execPlan.get_load_store_nodes();
 
-    load_node->callbacks.load_cb_fn        = info->callbacks.load_cb_fn;
-    load_node->callbacks.load_cb_data      = info->callbacks.load_cb_data;
-    load_node->callbacks.load_cb_lds_bytes = info->callbacks.load_cb_lds_bytes;
-
-    store_node->callbacks.store_cb_fn        = info->callbacks.store_cb_fn;
-    store_node->callbacks.store_cb_data      = info->callbacks.store_cb_data;
-    store_node->callbacks.store_cb_lds_bytes = info->callbacks.store_cb_lds_bytes;
+    // graphs are recorded on a stream of our own, since the null
+    // stream can't be captured
+    struct CaptureStream
+    {
+        hipStream_t stream = nullptr;
+        ~CaptureStream()
+        {
+            if(stream)
+                (void)hipStreamDestroy(stream);
+        }
+    } capture;
+    if(useGraph && hipStreamCreateWithFlags(&capture.stream, hipStreamNonBlocking) != hipSuccess)
+        throw std::runtime_error("hipStreamCreateWithFlags failure");
 
+    kernels.resize(execPlan.execSeq.size());
     for(size_t i = 0; i < execPlan.execSeq.size(); i++)
     {
-        DeviceCallIn data;
+        auto& kernel = kernels[i];
+        auto& data   = kernel.data;
+
         data.node          = execPlan.execSeq[i];
-        data.rocfft_stream = (info == nullptr) ? 0 : info->rocfft_stream;
+        data.rocfft_stream = useGraph ? capture.stream : info.rocfft_stream;
         data.deviceProp    = execPlan.deviceProp;
         if(LOG_PLAN_ENABLED())
             data.log_func = log_plan;
         else
             data.log_func = nullptr;
 
-        // Size of complex type
-        const size_t complexTSize = (data.node->precision == rocfft_precision_single)
-                                        ? sizeof(float) * 2
-                                        : sizeof(double) * 2;
-
-        switch(data.node->obIn)
+        ResolveBuffer(execPlan,
+                      *data.node,
+                      data.node->obIn,
+                      data.node->inArrayType,
+                      data.node->iOffset,
+                      in_buffer,
+                      out_buffer,
+                      info,
+                      data.bufIn);
+        ResolveBuffer(execPlan,
+                      *data.node,
+                      data.node->obOut,
+                      data.node->outArrayType,
+                      data.node->oOffset,
+                      in_buffer,
+                      out_buffer,
+                      info,
+                      data.bufOut);
+
+        if(data.node == load_node)
         {
-        case OB_USER_IN:
-            data.bufIn[0] = in_buffer[0];
-            if(data.node->inArrayType == rocfft_array_type_complex_planar
-               || data.node->inArrayType == rocfft_array_type_hermitian_planar)
-            {
-                data.bufIn[1] = in_buffer[1];
-            }
-            break;
-        case OB_USER_OUT:
-            data.bufIn[0] = out_buffer[0];
-            if(data.node->inArrayType == rocfft_array_type_complex_planar
-               || data.node->inArrayType == rocfft_array_type_hermitian_planar)
-            {
-                data.bufIn[1] = out_buffer[1];
-            }
-            break;
-        case OB_TEMP:
-            data.bufIn[0] = info->workBuffer;
-            if(data.node->inArrayType == rocfft_array_type_complex_planar
-               || data.node->inArrayType == rocfft_array_type_hermitian_planar)
-            {
-                // Assume planar using the same extra size of memory as
-                // interleaved format, and we just need to split it for
-                // planar.
-                data.bufIn[1]
-                    = (void*)((char*)info->workBuffer + execPlan.tmpWorkBufSize * complexTSize / 2);
-            }
-            break;
-        case OB_TEMP_CMPLX_FOR_REAL:
-            data.bufIn[0]
-                = (void*)((char*)info->workBuffer + execPlan.tmpWorkBufSize * complexTSize);
-            // TODO: Can we use this in planar as well ??
-            // if(data.node->inArrayType == rocfft_array_type_complex_planar
-            //    || data.node->inArrayType == rocfft_array_type_hermitian_planar)
-            // {
-            //     data.bufIn[1] = (void*)((char*)info->workBuffer
-            //                             + (execPlan.tmpWorkBufSize + execPlan.copyWorkBufSize / 2)
-            //                                   * complexTSize);
-            // }
-            break;
-        case OB_TEMP_BLUESTEIN:
-            data.bufIn[0] = (void*)((char*)info->workBuffer
-                                    + (execPlan.tmpWorkBufSize + execPlan.copyWorkBufSize
-                                       + data.node->iOffset)
-                                          * complexTSize);
-            // Bluestein mul-kernels (3 types) work well for CI->CI
-            // so we only consider CI->CI now
-            break;
-        case OB_UNINIT:
-            rocfft_cerr << "Error: operating buffer not initialized for kernel!\n";
-            assert(data.node->obIn != OB_UNINIT);
-            break;
-        default:
-            rocfft_cerr << "Error: operating buffer not specified for kernel!\n";
-            assert(false);
+            data.callbacks.load_cb_fn        = info.callbacks.load_cb_fn;
+            data.callbacks.load_cb_data      = info.callbacks.load_cb_data;
+            data.callbacks.load_cb_lds_bytes = info.callbacks.load_cb_lds_bytes;
         }
-
-        switch(data.node->obOut)
+        if(data.node == store_node)
         {
-        case OB_USER_IN:
-            data.bufOut[0] = in_buffer[0];
-            if(data.node->outArrayType == rocfft_array_type_complex_planar
-               || data.node->outArrayType == rocfft_array_type_hermitian_planar)
-            {
-                data.bufOut[1] = in_buffer[1];
-            }
-            break;
-        case OB_USER_OUT:
-            data.bufOut[0] = out_buffer[0];
-            if(data.node->outArrayType == rocfft_array_type_complex_planar
-               || data.node->outArrayType == rocfft_array_type_hermitian_planar)
-            {
-                data.bufOut[1] = out_buffer[1];
-            }
-            break;
-        case OB_TEMP:
-            data.bufOut[0] = info->workBuffer;
-            if(data.node->outArrayType == rocfft_array_type_complex_planar
-               || data.node->outArrayType == rocfft_array_type_hermitian_planar)
-            {
-                // assume planar using the same extra size of memory as
-                // interleaved format, and we just need to split it for
-                // planar.
-                data.bufOut[1]
-                    = (void*)((char*)info->workBuffer + execPlan.tmpWorkBufSize * complexTSize / 2);
-            }
-            break;
-        case OB_TEMP_CMPLX_FOR_REAL:
-            data.bufOut[0]
-                = (void*)((char*)info->workBuffer + execPlan.tmpWorkBufSize * complexTSize);
-            // TODO: Can we use this in planar as well ??
-            // if(data.node->outArrayType == rocfft_array_type_complex_planar
-            //    || data.node->outArrayType == rocfft_array_type_hermitian_planar)
-            // {
-            //     data.bufOut[1] = (void*)((char*)info->workBuffer
-            //                              + (execPlan.tmpWorkBufSize + execPlan.copyWorkBufSize / 2)
-            //                                    * complexTSize);
-            // }
-            break;
-        case OB_TEMP_BLUESTEIN:
-            data.bufOut[0] = (void*)((char*)info->workBuffer
-                                     + (execPlan.tmpWorkBufSize + execPlan.copyWorkBufSize
-                                        + data.node->oOffset)
-                                           * complexTSize);
-            // Bluestein mul-kernels (3 types) work well for CI->CI
-            // so we only consider CI->CI now
-            break;
-        default:
-            assert(false);
+            data.callbacks.store_cb_fn        = info.callbacks.store_cb_fn;
+            data.callbacks.store_cb_data      = info.callbacks.store_cb_data;
+            data.callbacks.store_cb_lds_bytes = info.callbacks.store_cb_lds_bytes;
         }
 
         // if callbacks are enabled, make sure load_cb_fn and store_cb_fn are not nullptrs
-        if((data.node->callbacks.load_cb_fn == nullptr
-            && data.node->callbacks.store_cb_fn != nullptr))
+        if(data.callbacks.load_cb_fn == nullptr && data.callbacks.store_cb_fn != nullptr)
         {
             // set default load callback
-            SetDefaultCallback(data.node, SetCallbackType::LOAD, &data.node->callbacks.load_cb_fn);
+            SetDefaultCallback(data.node, SetCallbackType::LOAD, &data.callbacks.load_cb_fn);
         }
-        else if((data.node->callbacks.load_cb_fn != nullptr
-                 && data.node->callbacks.store_cb_fn == nullptr))
+        else if(data.callbacks.load_cb_fn != nullptr && data.callbacks.store_cb_fn == nullptr)
         {
             // set default store callback
-            SetDefaultCallback(
-                data.node, SetCallbackType::STORE, &data.node->callbacks.store_cb_fn);
+            SetDefaultCallback(data.node, SetCallbackType::STORE, &data.callbacks.store_cb_fn);
         }
 
         data.gridParam = execPlan.gridParam[i];
 
+        kernel.fn = execPlan.devFnCall[i];
+
+        // choose which compiled kernel to run
+        kernel.rtcKernel = data.get_callback_type() == CallbackType::NONE
+                               ? data.node->compiledKernel.get().get()
+                               : data.node->compiledKernelWithCallbacks.get().get();
+        if(kernel.rtcKernel)
+            kernel.kargs = kernel.rtcKernel->get_plan_launch_args(data);
+
+        // skip apply callback kernel if there's no callback
+        kernel.skip = data.node->scheme == CS_KERNEL_APPLY_CALLBACK
+                      && data.get_callback_type() == CallbackType::NONE;
+    }
+
+    if(useGraph)
+        RecordGraph(execPlan, capture.stream);
+}
+
+void ExecPlanLaunch::RecordGraph(const ExecPlan& execPlan, hipStream_t captureStream)
+{
+    // check what's about to be recorded, without launching anything
+    MockLauncher mock;
+    Run(mock);
+    CheckLaunchSequence(
+        PlannedLaunches(execPlan,
+                        callbacks.load_cb_fn != nullptr || callbacks.store_cb_fn != nullptr),
+        mock.launched);
+
+    if(hipStreamBeginCapture(captureStream, hipStreamCaptureModeThreadLocal) != hipSuccess)
+        throw std::runtime_error("hipStreamBeginCapture failure");
+    try
+    {
+        DeviceLauncher device;
+        Run(device);
+    }
+    catch(...)
+    {
+        hipGraph_t partial = nullptr;
+        if(hipStreamEndCapture(captureStream, &partial) == hipSuccess && partial)
+            (void)hipGraphDestroy(partial);
+        throw;
+    }
+    if(hipStreamEndCapture(captureStream, &graph) != hipSuccess)
+        throw std::runtime_error("hipStreamEndCapture failure");
+
+    // each launch should have become one node of the graph.  kernel
+    // functions that enqueue nothing, or more than one operation,
+    // can't be checked against the plan, so launch them directly
+    // instead.
+    size_t numNodes = 0;
+    if(hipGraphGetNodes(graph, nullptr, &numNodes) != hipSuccess)
+        throw std::runtime_error("hipGraphGetNodes failure");
+    if(numNodes != mock.launched.size())
+    {
+        if(LOG_PLAN_ENABLED())
+            (*LogSingleton::GetInstance().GetPlanOS())
+                << "recorded graph has " << numNodes << " nodes for " << mock.launched.size()
+                << " launches, launching kernels directly" << std::endl;
+        (void)hipGraphDestroy(graph);
+        graph = nullptr;
+        for(auto& kernel : kernels)
+            kernel.data.rocfft_stream = stream;
+        return;
+    }
+
+    if(hipGraphInstantiate(&graphExec, graph, nullptr, nullptr, 0) != hipSuccess)
+        throw std::runtime_error("hipGraphInstantiate failure");
+}
+
+// Launches for executing the plan with these buffers.  Plans are
+// usually executed over and over with the same buffers, so the
+// launches for the most recent buffers are kept.  Plans run in batch
+// chunks see one set of buffers per chunk, so they keep more.
+static std::shared_ptr<const ExecPlanLaunch> GetLaunch(const ExecPlan&                execPlan,
+                                                       ExecPlanLaunchCache&           launchCache,
+                                                       void*                          in_buffer[],
+                                                       void*                          out_buffer[],
+                                                       const rocfft_execution_info_t& info)
+{
+    {
+        std::lock_guard<std::mutex> lck(launchCache.mutex);
+        for(const auto& launch : launchCache.recent)
+            if(launch->Matches(execPlan, in_buffer, out_buffer, info))
+                return launch;
+    }
+
+    auto launch = std::make_shared<const ExecPlanLaunch>(execPlan, in_buffer, out_buffer, info);
+
+    std::lock_guard<std::mutex> lck(launchCache.mutex);
+    launchCache.recent.push_front(launch);
+    while(launchCache.recent.size() > launchCache.capacity)
+        launchCache.recent.pop_back();
+    return launch;
+}
+
+// Internal plan executor.
+// For in-place transforms, in_buffer == out_buffer.
+void TransformPowX(const ExecPlan&       execPlan,
+                   ExecPlanLaunchCache&  launchCache,
+                   void*                 in_buffer[],
+                   void*                 out_buffer[],
+                   rocfft_execution_info info)
+{
+    assert(execPlan.execSeq.size() == execPlan.devFnCall.size());
+    assert(execPlan.execSeq.size() == execPlan.gridParam.size());
+
+    // we can log profile information if we're on the null stream,
+    // since we will be able to wait for the transform to finish
+    bool            emit_profile_log  = LOG_PROFILE_ENABLED() && !info->rocfft_stream;
+    bool            emit_kernelio_log = LOG_KERNELIO_ENABLED();
+    rocfft_ostream* kernelio_stream   = nullptr;
+    float           max_memory_bw     = 0.0;
+    hipEvent_t      start, stop;
+    if(emit_profile_log)
+    {
+        if(hipEventCreate(&start) != hipSuccess || hipEventCreate(&stop) != hipSuccess)
+            throw std::runtime_error("hipEventCreate failure");
+        max_memory_bw = max_memory_bandwidth_GB_per_s();
+    }
+
+    auto launch = GetLaunch(execPlan, launchCache, in_buffer, out_buffer, *info);
+
+    // the whole plan is one submission
+    if(launch->graphExec)
+    {
+        if(hipGraphLaunch(launch->graphExec, info->rocfft_stream) != hipSuccess)
+            throw std::runtime_error("hipGraphLaunch failure");
+        return;
+    }
+
+    DeviceLauncher device;
+    for(size_t i = 0; i < launch->kernels.size(); i++)
+    {
+        const auto& kernel = launch->kernels[i];
+        const auto& data   = kernel.data;
+
         if(emit_kernelio_log)
         {
             kernelio_stream = LogSingleton::GetInstance().GetKernelIOOS();
@@ -511,32 +763,31 @@ void TransformPowX(const ExecPlan&       execPlan,
                              data.node->batch);
         }
 
-        DevFnCall fn = execPlan.devFnCall[i];
-        if(fn || data.node->compiledKernel.get())
+        if(kernel.fn || kernel.rtcKernel)
         {
 #ifdef REF_DEBUG
             rocfft_cout << "\n---------------------------------------------\n";
             rocfft_cout << "\n\nkernel: " << i << std::endl;
-            rocfft_cout << "\tscheme: " << PrintScheme(execPlan.execSeq[i]->scheme) << std::endl;
-            rocfft_cout << "\titype: " << execPlan.execSeq[i]->inArrayType << std::endl;
-            rocfft_cout << "\totype: " << execPlan.execSeq[i]->outArrayType << std::endl;
+            rocfft_cout << "\tscheme: " << PrintScheme(data.node->scheme) << std::endl;
+            rocfft_cout << "\titype: " << data.node->inArrayType << std::endl;
+            rocfft_cout << "\totype: " << data.node->outArrayType << std::endl;
             rocfft_cout << "\tlength: ";
-            for(const auto& i : execPlan.execSeq[i]->length)
+            for(const auto& i : data.node->length)
             {
                 rocfft_cout << i << " ";
             }
             rocfft_cout << std::endl;
-            rocfft_cout << "\tbatch:   " << execPlan.execSeq[i]->batch << std::endl;
-            rocfft_cout << "\tidist:   " << execPlan.execSeq[i]->iDist << std::endl;
-            rocfft_cout << "\todist:   " << execPlan.execSeq[i]->oDist << std::endl;
+            rocfft_cout << "\tbatch:   " << data.node->batch << std::endl;
+            rocfft_cout << "\tidist:   " << data.node->iDist << std::endl;
+            rocfft_cout << "\todist:   " << data.node->oDist << std::endl;
             rocfft_cout << "\tistride:";
-            for(const auto& i : execPlan.execSeq[i]->inStride)
+            for(const auto& i : data.node->inStride)
             {
                 rocfft_cout << " " << i;
             }
             rocfft_cout << std::endl;
             rocfft_cout << "\tostride:";
-            for(const auto& i : execPlan.execSeq[i]->outStride)
+            for(const auto& i : data.node->outStride)
             {
                 rocfft_cout << " " << i;
             }
@@ -550,26 +801,8 @@ void TransformPowX(const ExecPlan&       execPlan,
                 if(hipEventRecord(start) != hipSuccess)
                     throw std::runtime_error("hipEventRecord failure");
 
-            DeviceCallOut back;
-
-            // give callback parameters to kernel launcher
-            data.callbacks = execPlan.execSeq[i]->callbacks;
-
-            // choose which compiled kernel to run
-            RTCKernel* localCompiledKernel
-                = data.get_callback_type() == CallbackType::NONE
-                      ? data.node->compiledKernel.get().get()
-                      : data.node->compiledKernelWithCallbacks.get().get();
-
-            // skip apply callback kernel if there's no callback
-            if(data.node->scheme != CS_KERNEL_APPLY_CALLBACK
-               || data.get_callback_type() != CallbackType::NONE)
-            {
-                if(localCompiledKernel)
-                    localCompiledKernel->launch(data);
-                else
-                    fn(&data, &back);
-            }
+            if(!kernel.skip)
+                device.Launch(kernel);
             if(emit_profile_log)
                 if(hipEventRecord(stop) != hipSuccess)
                     throw std::runtime_error("hipEventRecord failure");
@@ -597,7 +830,7 @@ void TransformPowX(const ExecPlan&       execPlan,
                     efficiency_pct = 100.0 * exec_bw / max_memory_bw;
                 log_profile(__func__,
                             "scheme",
-                            PrintScheme(execPlan.execSeq[i]->scheme),
+                            PrintScheme(data.node->scheme),
                             "duration_ms",
                             duration_ms,
                             "in_size",
@@ -20,6 +20,7 @@
 * THE SOFTWARE.
 *******************************************************************************/
 
+#include <algorithm>
 #include <assert.h>
 #include <iostream>
 #include <numeric>
@@ -37,12 +38,65 @@
 std::mutex        Repo::mtx;
 std::atomic<bool> Repo::repoDestroyed(false);
 
+Repo::twiddle_view_t Repo::FindView(const std::vector<TwiddleSegment>& layout,
+                                    rocfft_precision                   precision,
+                                    int                                deviceId)
+{
+    size_t count = 0;
+    for(const auto& seg : layout)
+        count += seg.count;
+    // empty tables have nothing to share
+    if(count == 0)
+        return {};
+
+    const auto elemBytes = sizeof_precision(precision);
+    for(auto& b : buffers)
+    {
+        const auto& buffer = b.second;
+        if(buffer.precision != precision || buffer.deviceId != deviceId
+           || buffer.layout.size() < layout.size())
+            continue;
+
+        size_t offset = 0;
+        for(size_t first = 0; first + layout.size() <= buffer.layout.size(); ++first)
+        {
+            bool match = true;
+            for(size_t i = 0; i < layout.size() && match; ++i)
+            {
+                const auto& have = buffer.layout[first + i];
+                match            = have.Contains(layout[i]);
+                // all but the last run have to end where the next
+                // one starts
+                if(i + 1 < layout.size())
+                    match = match && have.count == layout[i].count;
+            }
+            if(match)
+                return {static_cast<char*>(b.first) + offset * elemBytes, count * elemBytes};
+            offset += buffer.layout[first].count;
+        }
+    }
+    return {};
+}
+
+std::map<void*, Repo::twiddle_buffer_t>::iterator Repo::FindBuffer(void* ptr)
+{
+    // the buffer with the highest base address at or below ptr
+    auto it = buffers.upper_bound(ptr);
+    if(it == buffers.begin())
+        return buffers.end();
+    --it;
+    if(static_cast<char*>(ptr) >= static_cast<char*>(it->first) + it->second.buf.size())
+        return buffers.end();
+    return it;
+}
+
 template <typename KeyType>
 std::pair<void*, size_t>
-    Repo::GetTwiddlesInternal(KeyType                                             key,
-                              std::map<KeyType, std::pair<gpubuf, unsigned int>>& twiddles,
-                              std::map<void*, KeyType>&                           twiddles_reverse,
-                              std::function<gpubuf()>                             create_twiddle)
+    Repo::GetTwiddlesInternal(KeyType                                      key,
+                              rocfft_precision                             precision,
+                              std::map<KeyType, twiddle_view_t>&           views,
+                              std::function<std::vector<TwiddleSegment>()> layout_twiddle,
+                              std::function<gpubuf()>                      create_twiddle)
 {
     if(repoDestroyed)
     {
@@ -55,51 +109,60 @@ std::pair<void*, size_t>
         throw std::runtime_error("hipGetDevice failed.");
     }
 
-    auto it = twiddles.find(key);
-    if(it != twiddles.end())
+    Repo& repo = Repo::GetRepo();
+
+    auto it = views.find(key);
+    if(it != views.end())
     {
         // already had this length
-        it->second.second += 1;
-        return {it->second.first.data(), it->second.first.size()};
+        repo.FindBuffer(it->second.ptr)->second.refs += 1;
+        return {it->second.ptr, it->second.bytes};
     }
 
-    // otherwise, need to allocate
-    auto buf = create_twiddle();
-    // if allocation failed, don't update maps
-    if(buf.data() == nullptr)
-        return {nullptr, 0};
-    it = twiddles.insert({key, std::make_pair(std::move(buf), 1)}).first;
-    twiddles_reverse.insert({it->second.first.data(), key});
-    return {it->second.first.data(), it->second.first.size()};
+    // see if an existing buffer contains this table
+    auto layout = layout_twiddle();
+    auto view   = repo.FindView(layout, precision, key.deviceId);
+    if(view.ptr == nullptr)
+    {
+        // otherwise, need to allocate
+        auto buf = create_twiddle();
+        // if allocation failed, don't update maps
+        if(buf.data() == nullptr)
+            return {nullptr, 0};
+        view.ptr   = buf.data();
+        view.bytes = buf.size();
+
+        auto& buffer     = repo.buffers[view.ptr];
+        buffer.buf       = std::move(buf);
+        buffer.precision = precision;
+        buffer.deviceId  = key.deviceId;
+        buffer.layout    = std::move(layout);
+    }
+    repo.FindBuffer(view.ptr)->second.refs += 1;
+    views.insert({key, view});
+    return {view.ptr, view.bytes};
 }
 
-template <typename KeyType>
-void Repo::ReleaseTwiddlesInternal(void*                                               ptr,
-                                   std::map<KeyType, std::pair<gpubuf, unsigned int>>& twiddles,
-                                   std::map<void*, KeyType>& twiddles_reverse)
+// forget the views of a buffer that's being freed
+template <typename ViewMap>
+static void EraseViews(ViewMap& views, char* begin, char* end)
 {
-    if(repoDestroyed)
+    for(auto it = views.begin(); it != views.end();)
     {
-        throw std::runtime_error("Repo prematurely destroyed.");
+        auto ptr = static_cast<char*>(it->second.ptr);
+        if(ptr >= begin && ptr < end)
+            it = views.erase(it);
+        else
+            ++it;
     }
+}
 
-    auto reverse_it = twiddles_reverse.find(ptr);
-    if(reverse_it == twiddles_reverse.end())
-        return;
-    auto forward_it = twiddles.find(reverse_it->second);
-    if(forward_it == twiddles.end())
-    {
-        // orphaned reverse entry?
-        twiddles_reverse.erase(reverse_it);
-        return;
-    }
-    forward_it->second.second -= 1;
-    if(forward_it->second.second == 0)
-    {
-        // remove from both maps
-        twiddles.erase(forward_it);
-        twiddles_reverse.erase(reverse_it);
-    }
+template <typename ViewMap>
+static size_t CountViews(const ViewMap& views, int deviceId)
+{
+    return std::count_if(views.begin(), views.end(), [deviceId](const auto& view) {
+        return view.first.deviceId == deviceId;
+    });
 }
 
 std::pair<void*, size_t> Repo::GetTwiddles1D(size_t                     length,
@@ -113,10 +176,15 @@ std::pair<void*, size_t> Repo::GetTwiddles1D(size_t                     length,
     Repo&                       repo = Repo::GetRepo();
 
     repo_key_1D_t key{length, length_limit, precision, largeTwdBase, attach_halfN, radices};
-    return GetTwiddlesInternal(key, repo.twiddles_1D, repo.twiddles_1D_reverse, [&]() {
-        return twiddles_create(
-            length, length_limit, precision, largeTwdBase, attach_halfN, radices);
-    });
+    return GetTwiddlesInternal(
+        key,
+        precision,
+        repo.twiddles_1D,
+        [&]() { return twiddles_layout(length, length_limit, largeTwdBase, attach_halfN, radices); },
+        [&]() {
+            return twiddles_create(
+                length, length_limit, precision, largeTwdBase, attach_halfN, radices);
+        });
 }
 
 std::pair<void*, size_t>
@@ -126,25 +194,74 @@ std::pair<void*, size_t>
     Repo&                       repo = Repo::GetRepo();
 
     repo_key_2D_t key{length0, length1, precision};
-    return GetTwiddlesInternal(key, repo.twiddles_2D, repo.twiddles_2D_reverse, [&]() {
-        return twiddles_create_2D(length0, length1, precision);
-    });
+    return GetTwiddlesInternal(
+        key,
+        precision,
+        repo.twiddles_2D,
+        [&]() { return twiddles_layout_2D(length0, length1, precision); },
+        [&]() { return twiddles_create_2D(length0, length1, precision); });
+}
+
+std::pair<void*, size_t>
+    Repo::GetChirp(size_t length, size_t lengthBlue, rocfft_precision precision, int direction)
+{
+    std::lock_guard<std::mutex> lck(mtx);
+    Repo&                       repo = Repo::GetRepo();
+
+    repo_key_chirp_t key{length, lengthBlue, precision, direction};
+    return GetTwiddlesInternal(
+        key,
+        precision,
+        repo.chirps,
+        [&]() { return chirp_layout(length, lengthBlue, direction); },
+        [&]() { return chirp_create(length, lengthBlue, precision, direction); });
 }
 
-void Repo::ReleaseTwiddle1D(void* ptr)
+void Repo::ReleaseTwiddles(void* ptr)
 {
     std::lock_guard<std::mutex> lck(mtx);
 
+    if(repoDestroyed)
+    {
+        throw std::runtime_error("Repo prematurely destroyed.");
+    }
+
     Repo& repo = Repo::GetRepo();
-    return ReleaseTwiddlesInternal(ptr, repo.twiddles_1D, repo.twiddles_1D_reverse);
+    auto  it   = repo.FindBuffer(ptr);
+    if(it == repo.buffers.end())
+        return;
+    it->second.refs -= 1;
+    if(it->second.refs == 0)
+    {
+        auto begin = static_cast<char*>(it->first);
+        auto end   = begin + it->second.buf.size();
+        EraseViews(repo.twiddles_1D, begin, end);
+        EraseViews(repo.twiddles_2D, begin, end);
+        EraseViews(repo.chirps, begin, end);
+        repo.buffers.erase(it);
+    }
 }
 
-void Repo::ReleaseTwiddle2D(void* ptr)
+void Repo::GetStats(int deviceId, size_t& numBuffers, size_t& bytes, size_t& numTables)
 {
     std::lock_guard<std::mutex> lck(mtx);
 
+    numBuffers = 0;
+    bytes      = 0;
+    numTables  = 0;
+    if(repoDestroyed)
+        return;
+
     Repo& repo = Repo::GetRepo();
-    return ReleaseTwiddlesInternal(ptr, repo.twiddles_2D, repo.twiddles_2D_reverse);
+    for(const auto& b : repo.buffers)
+    {
+        if(b.second.deviceId != deviceId)
+            continue;
+        ++numBuffers;
+        bytes += b.second.buf.size();
+    }
+    numTables = CountViews(repo.twiddles_1D, deviceId) + CountViews(repo.twiddles_2D, deviceId)
+                + CountViews(repo.chirps, deviceId);
 }
 
 void Repo::Clear()
@@ -155,4 +272,6 @@ void Repo::Clear()
     Repo& repo = Repo::GetRepo();
     repo.twiddles_1D.clear();
     repo.twiddles_2D.clear();
+    repo.chirps.clear();
+    repo.buffers.clear();
 }
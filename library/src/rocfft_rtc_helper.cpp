@@ -19,6 +19,8 @@
 // THE SOFTWARE.
 
 #include "rtc.h"
+#include "rtc_helper_protocol.h"
+#include <cstring>
 #include <iostream>
 #include <iterator>
 
@@ -27,23 +29,88 @@
 #include <io.h>
 #endif
 
+typedef std::vector<char> (*compile_func)(const std::string& kernel_src,
+                                          const std::string& gpu_arch);
+
+// stand-in for the compiler, for testing the helper without a GPU
+static std::vector<char> compile_fake(const std::string& kernel_src, const std::string& gpu_arch)
+{
+    if(kernel_src.empty())
+        throw std::runtime_error("fake compile of empty source");
+    return {kernel_src.begin(), kernel_src.end()};
+}
+
+static void write_response(uint64_t status, const char* payload, uint64_t payload_len)
+{
+    std::cout.write(reinterpret_cast<const char*>(&status), sizeof(status));
+    std::cout.write(reinterpret_cast<const char*>(&payload_len), sizeof(payload_len));
+    std::cout.write(payload, payload_len);
+    // caller may be waiting for this response before sending more
+    std::cout.flush();
+}
+
+// compile requests from stdin until it's closed
+static void serve(compile_func compile, const std::string& gpu_arch)
+{
+    for(;;)
+    {
+        uint64_t src_len = 0;
+        if(!std::cin.read(reinterpret_cast<char*>(&src_len), sizeof(src_len)))
+            return;
+        std::string kernel_src(src_len, '\0');
+        if(!std::cin.read(kernel_src.data(), src_len))
+            throw std::runtime_error("rocfft_rtc_helper: truncated request");
+
+        try
+        {
+            auto code = compile(kernel_src, gpu_arch);
+            write_response(RTC_HELPER_OK, code.data(), code.size());
+        }
+        catch(std::exception& e)
+        {
+            // compile errors are reported to the caller, and we
+            // carry on with the next request
+            write_response(RTC_HELPER_ERROR, e.what(), strlen(e.what()));
+        }
+    }
+}
+
 int main(int argc, const char* const* argv)
 {
 #ifdef WIN32
-    // stdout on Windows defaults to text mode and will mangle our code objects
+    // stdin/stdout on Windows default to text mode and will mangle
+    // our requests and code objects
+    _setmode(_fileno(stdin), _O_BINARY);
     _setmode(_fileno(stdout), _O_BINARY);
 #endif
 
     try
     {
-        if(argc != 2)
+        bool         server  = false;
+        compile_func compile = RTCKernel::compile_inprocess;
+        std::string  gpu_arch;
+        for(int i = 1; i < argc; ++i)
+        {
+            if(strcmp(argv[i], RTC_HELPER_SERVER_ARG) == 0)
+                server = true;
+            else if(strcmp(argv[i], RTC_HELPER_FAKE_ARG) == 0)
+                compile = compile_fake;
+            else
+                gpu_arch = argv[i];
+        }
+
+        if(gpu_arch.empty())
         {
             // GPU architecture is passed as a command line argument
-            std::cerr << "usage: rocfft_rtc_helper gfxNNN\n";
+            std::cerr << "usage: rocfft_rtc_helper [--server] [--fake] gfxNNN\n";
             throw std::runtime_error("rocfft_rtc_helper: invalid command line");
         }
 
-        std::string gpu_arch = argv[1];
+        if(server)
+        {
+            serve(compile, gpu_arch);
+            return 0;
+        }
 
         // collect stdin as kernel source
         std::string kernel_src;
@@ -53,7 +120,7 @@ int main(int argc, const char* const* argv)
                   std::back_inserter(kernel_src));
 
         // compile and write code object to stdout
-        auto code = RTCKernel::compile_inprocess(kernel_src, gpu_arch);
+        auto code = compile(kernel_src, gpu_arch);
         std::cout.write(code.data(), code.size());
         return 0;
     }
@@ -27,10 +27,12 @@
 #include "logging.h"
 #include "plan.h"
 #include "rtc_cache.h"
+#include "rtc_compile_queue.h"
 #include "rtc_stockham.h"
 #include "tree_node.h"
 
 RTCKernel::RTCKernel(const std::string& kernel_name, const std::vector<char>& code)
+    : kernel_name(kernel_name)
 {
     if(hipModuleLoadData(&module, code.data()) != hipSuccess)
         throw std::runtime_error("failed to load module");
@@ -39,7 +41,7 @@ RTCKernel::RTCKernel(const std::string& kernel_name, const std::vector<char>& co
         throw std::runtime_error("failed to get function");
 }
 
-void RTCKernel::launch(DeviceCallIn& data)
+RTCKernelArgs RTCKernel::get_plan_launch_args(DeviceCallIn& data)
 {
     RTCKernelArgs kargs = get_launch_args(data);
 
@@ -58,22 +60,31 @@ void RTCKernel::launch(DeviceCallIn& data)
             break;
         }
     }
+    return kargs;
+}
 
+void RTCKernel::launch(DeviceCallIn& data)
+{
     const auto& gp = data.gridParam;
 
-    launch(kargs,
+    launch(get_plan_launch_args(data),
            {gp.b_x, gp.b_y, gp.b_z},
            {gp.wgs_x, gp.wgs_y, gp.wgs_z},
            gp.lds_bytes,
            data.rocfft_stream);
 }
 
-void RTCKernel::launch(
-    RTCKernelArgs& kargs, dim3 gridDim, dim3 blockDim, unsigned int lds_bytes, hipStream_t stream)
+void RTCKernel::launch(const RTCKernelArgs& kargs,
+                       dim3                 gridDim,
+                       dim3                 blockDim,
+                       unsigned int         lds_bytes,
+                       hipStream_t          stream)
 {
+    // the launch only reads the args, though HIP wants a non-const
+    // pointer
     auto  size     = kargs.size_bytes();
     void* config[] = {HIP_LAUNCH_PARAM_BUFFER_POINTER,
-                      kargs.data(),
+                      const_cast<void*>(kargs.data()),
                       HIP_LAUNCH_PARAM_BUFFER_SIZE,
                       &size,
                       HIP_LAUNCH_PARAM_END};
@@ -107,37 +118,124 @@ void RTCKernel::launch(
 
 std::shared_future<std::unique_ptr<RTCKernel>> RTCKernel::runtime_compile(
     const TreeNode& node, const std::string& gpu_arch, bool enable_callbacks)
+{
+    return runtime_compile_batch({{&node, enable_callbacks}}, gpu_arch).front();
+}
+
+std::string RTCKernel::runtime_kernel_name(const TreeNode&    node,
+                                           const std::string& gpu_arch,
+                                           bool               enable_callbacks)
 {
 #ifdef ROCFFT_RUNTIME_COMPILE
-    RTCGenerator generator;
-    // try each type of generator until one is valid
-    generator = RTCKernelStockham::generate_from_node(node, gpu_arch, enable_callbacks);
+    auto generator = RTCKernelStockham::generate_from_node(node, gpu_arch, enable_callbacks);
     if(generator.valid())
+        return generator.generate_name();
+#endif
+    return {};
+}
+
+std::vector<std::shared_future<std::unique_ptr<RTCKernel>>>
+    RTCKernel::runtime_compile_batch(const std::vector<compile_request_t>& requests,
+                                     const std::string&                    gpu_arch,
+                                     bool                                  load)
+{
+    std::vector<std::shared_future<std::unique_ptr<RTCKernel>>> ret;
+    ret.reserve(requests.size());
+
+#ifdef ROCFFT_RUNTIME_COMPILE
+    // kernels are loaded onto the device that this thread is using
+    int deviceId = CompileQueue::NO_DEVICE;
+    if(load && hipGetDevice(&deviceId) != hipSuccess)
+        throw std::runtime_error("hipGetDevice failed.");
+
+    std::vector<RTCGenerator> generators;
+    std::vector<std::string>  kernel_names;
+    for(const auto& request : requests)
+    {
+        // try each type of generator until one is valid
+        generators.push_back(
+            RTCKernelStockham::generate_from_node(*request.first, gpu_arch, request.second));
+        if(generators.back().valid())
+            kernel_names.push_back(generators.back().generate_name());
+        else
+            kernel_names.emplace_back();
+    }
+
+    // find everything we can in the cache at once, so only the
+    // misses need to be compiled
+    auto cached = cached_lookup(kernel_names, gpu_arch);
+
+    for(size_t i = 0; i < requests.size(); ++i)
+    {
+        const auto& generator   = generators[i];
+        const auto& kernel_name = kernel_names[i];
+        auto        hit         = cached.find(kernel_name);
+        // nothing to do for a kernel that's already cached, if we're
+        // not loading it
+        if(!generator.valid() || (!load && hit != cached.end()))
+        {
+            // no kernel found, return null RTCKernel
+            std::promise<std::unique_ptr<RTCKernel>> p;
+            p.set_value(nullptr);
+            ret.push_back(p.get_future());
+            continue;
+        }
+
+        CompileQueue::compile_func_t compile;
+        if(hit != cached.end())
+        {
+            // only need to load the code object into a module.  The
+            // code is copied, since several requests in the batch
+            // may be for the same kernel.
+            compile = [=, code = hit->second]() {
+                try
+                {
+                    return generator.construct_rtckernel(kernel_name, code);
+                }
+                catch(std::exception& e)
+                {
+                    if(LOG_RTC_ENABLED())
+                        (*LogSingleton::GetInstance().GetRTCOS()) << e.what() << std::endl;
+                    throw;
+                }
+            };
+        }
+        else
+        {
+            compile = [=]() {
+                try
+                {
+                    std::vector<char> code
+                        = cached_compile(kernel_name, gpu_arch, generator.generate_src);
+                    if(!load)
+                        return std::unique_ptr<RTCKernel>();
+                    return generator.construct_rtckernel(kernel_name, code);
+                }
+                catch(std::exception& e)
+                {
+                    if(LOG_RTC_ENABLED())
+                        (*LogSingleton::GetInstance().GetRTCOS()) << e.what() << std::endl;
+                    throw;
+                }
+            };
+        }
+
+        // load or compile on the shared compile threads, so that
+        // modules for cache hits are loaded in parallel
+        CompileQueue::key_t key;
+        key.kernel_name = kernel_name;
+        key.gpu_arch    = gpu_arch;
+        key.deviceId    = deviceId;
+        ret.push_back(CompileQueue::GetCompileQueue().Submit(key, std::move(compile)));
+    }
+#else
+    // runtime compilation is not enabled, return null RTCKernels
+    for(size_t i = 0; i < requests.size(); ++i)
     {
-        std::string kernel_name = generator.generate_name();
-
-        auto compile = [=]() {
-            try
-            {
-                std::vector<char> code
-                    = cached_compile(kernel_name, gpu_arch, generator.generate_src);
-                return generator.construct_rtckernel(kernel_name, code);
-            }
-            catch(std::exception& e)
-            {
-                if(LOG_RTC_ENABLED())
-                    (*LogSingleton::GetInstance().GetRTCOS()) << e.what() << std::endl;
-                throw e;
-            }
-        };
-
-        // compile to code object
-        return std::async(std::launch::async, compile);
+        std::promise<std::unique_ptr<RTCKernel>> p;
+        p.set_value(nullptr);
+        ret.push_back(p.get_future());
     }
 #endif
-    // runtime compilation is not enabled or no kernel found, return
-    // null RTCKernel
-    std::promise<std::unique_ptr<RTCKernel>> p;
-    p.set_value(nullptr);
-    return p.get_future();
+    return ret;
 }
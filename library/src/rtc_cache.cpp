@@ -28,7 +28,9 @@
 
 #include "device/kernel-generator-embed.h"
 
+#include <algorithm>
 #include <chrono>
+#include <ctime>
 
 namespace fs = std::filesystem;
 
@@ -36,6 +38,19 @@ std::unique_ptr<RTCCache> RTCCache::single;
 
 static const char* default_cache_filename = "rocfft_kernel_cache.db";
 
+// Rows are only touched on a hit if they were last used longer ago
+// than this, so that hot kernels in read-mostly caches don't take a
+// write lock on every lookup.  Eviction order is only accurate to
+// within this interval.
+static const sqlite3_int64 TOUCH_INTERVAL_SECONDS = 60;
+
+// whether a row with this timestamp should be touched now.
+// timestamps are seconds since the epoch, like STRFTIME('%s').
+static bool needs_touch(sqlite3_int64 timestamp)
+{
+    return static_cast<sqlite3_int64>(std::time(nullptr)) - timestamp >= TOUCH_INTERVAL_SECONDS;
+}
+
 // Get path to system RTC cache - returns empty if no suitable path
 // can be found
 static fs::path rtccache_db_sys_path()
@@ -146,11 +161,40 @@ sqlite3_ptr RTCCache::connect_db(const fs::path& path, bool readonly)
                                    "  generator_sum BLOB NOT NULL,"
                                    "  code BLOB NOT NULL,"
                                    "  timestamp INTEGER NOT NULL,"
+                                   "  compile_ms INTEGER NOT NULL DEFAULT 0,"
                                    "  PRIMARY KEY ("
                                    "      kernel_name, arch, hip_version, generator_sum"
                                    "      ))");
         if(sqlite3_step(create.get()) != SQLITE_DONE)
             return nullptr;
+
+        // caches created by older versions won't have compile
+        // times.  this fails harmlessly if the column is already
+        // there.
+        sqlite3_exec(db.get(),
+                     "ALTER TABLE cache_v1 ADD COLUMN compile_ms INTEGER NOT NULL DEFAULT 0",
+                     nullptr,
+                     nullptr,
+                     nullptr);
+
+        // twiddle tables generated on the host.  values don't depend
+        // on the device or HIP runtime, only on the table parameters
+        auto create_twiddles = prepare_stmt(db,
+                                            "CREATE TABLE IF NOT EXISTS twiddles_v1 ("
+                                            "  length INTEGER NOT NULL,"
+                                            "  length_limit INTEGER NOT NULL,"
+                                            "  precision INTEGER NOT NULL,"
+                                            "  large_twiddle_base INTEGER NOT NULL,"
+                                            "  attach_halfN INTEGER NOT NULL,"
+                                            "  radices TEXT NOT NULL,"
+                                            "  data BLOB NOT NULL,"
+                                            "  timestamp INTEGER NOT NULL,"
+                                            "  PRIMARY KEY ("
+                                            "      length, length_limit, precision,"
+                                            "      large_twiddle_base, attach_halfN, radices"
+                                            "      ))");
+        if(sqlite3_step(create_twiddles.get()) != SQLITE_DONE)
+            return nullptr;
     }
 
     return db;
@@ -170,13 +214,22 @@ RTCCache::RTCCache()
             break;
     }
 
-    static const char* get_stmt_text = "SELECT code "
+    static const char* get_stmt_text = "SELECT code, compile_ms, timestamp "
                                        "FROM cache_v1 "
                                        "WHERE"
                                        "  kernel_name = :kernel_name "
                                        "  AND arch = :arch "
                                        "  AND hip_version = :hip_version "
                                        "  AND generator_sum = :generator_sum ";
+    // system caches are read-only, and may have been created before
+    // compile times were recorded
+    static const char* get_stmt_text_no_time = "SELECT code "
+                                               "FROM cache_v1 "
+                                               "WHERE"
+                                               "  kernel_name = :kernel_name "
+                                               "  AND arch = :arch "
+                                               "  AND hip_version = :hip_version "
+                                               "  AND generator_sum = :generator_sum ";
 
     static const char* store_stmt_text = "INSERT OR REPLACE INTO cache_v1 ("
                                          "    kernel_name,"
@@ -184,7 +237,8 @@ RTCCache::RTCCache()
                                          "    hip_version,"
                                          "    generator_sum,"
                                          "    code,"
-                                         "    timestamp"
+                                         "    timestamp,"
+                                         "    compile_ms"
                                          ")"
                                          "VALUES ("
                                          "    :kernel_name,"
@@ -192,9 +246,91 @@ RTCCache::RTCCache()
                                          "    :hip_version,"
                                          "    :generator_sum,"
                                          "    :code,"
-                                         "    CAST(STRFTIME('%s','now') AS INTEGER)"
+                                         "    CAST(STRFTIME('%s','now') AS INTEGER),"
+                                         "    :compile_ms"
                                          ")";
 
+    // timestamp is the last time a row was stored or used, so that
+    // eviction is least-recently-used
+    static const char* touch_stmt_text = "UPDATE cache_v1 "
+                                         "SET timestamp = CAST(STRFTIME('%s','now') AS INTEGER) "
+                                         "WHERE"
+                                         "  kernel_name = :kernel_name "
+                                         "  AND arch = :arch "
+                                         "  AND hip_version = :hip_version "
+                                         "  AND generator_sum = :generator_sum ";
+
+    // keep the most-recently-used kernels and twiddle tables that
+    // fit in the size limit, and delete the rest.  rows of both
+    // tables are ranked together, and each table is evicted by its
+    // own statement.
+    static const std::string evict_ranked_rows
+        = "WITH ranked AS ("
+          "  SELECT"
+          "    tbl,"
+          "    id,"
+          "    SUM(bytes) OVER (ORDER BY timestamp DESC, tbl DESC, id DESC) AS total_bytes"
+          "  FROM ("
+          "    SELECT 0 AS tbl, rowid AS id, timestamp, LENGTH(code) AS bytes FROM cache_v1"
+          "    UNION ALL"
+          "    SELECT 1 AS tbl, rowid AS id, timestamp, LENGTH(data) AS bytes FROM twiddles_v1"
+          "  )"
+          ") ";
+    static const std::string evict_stmt_text
+        = evict_ranked_rows
+          + "DELETE FROM cache_v1 "
+            "WHERE rowid IN ("
+            "  SELECT id FROM ranked WHERE tbl = 0 AND total_bytes > :max_bytes"
+            ")";
+    static const std::string evict_twiddles_stmt_text
+        = evict_ranked_rows
+          + "DELETE FROM twiddles_v1 "
+            "WHERE rowid IN ("
+            "  SELECT id FROM ranked WHERE tbl = 1 AND total_bytes > :max_bytes"
+            ")";
+
+    static const char* get_twiddles_stmt_text = "SELECT data, timestamp "
+                                                "FROM twiddles_v1 "
+                                                "WHERE"
+                                                "  length = :length "
+                                                "  AND length_limit = :length_limit "
+                                                "  AND precision = :precision "
+                                                "  AND large_twiddle_base = :large_twiddle_base "
+                                                "  AND attach_halfN = :attach_halfN "
+                                                "  AND radices = :radices ";
+
+    static const char* store_twiddles_stmt_text = "INSERT OR REPLACE INTO twiddles_v1 ("
+                                                  "    length,"
+                                                  "    length_limit,"
+                                                  "    precision,"
+                                                  "    large_twiddle_base,"
+                                                  "    attach_halfN,"
+                                                  "    radices,"
+                                                  "    data,"
+                                                  "    timestamp"
+                                                  ")"
+                                                  "VALUES ("
+                                                  "    :length,"
+                                                  "    :length_limit,"
+                                                  "    :precision,"
+                                                  "    :large_twiddle_base,"
+                                                  "    :attach_halfN,"
+                                                  "    :radices,"
+                                                  "    :data,"
+                                                  "    CAST(STRFTIME('%s','now') AS INTEGER)"
+                                                  ")";
+
+    static const char* touch_twiddles_stmt_text
+        = "UPDATE twiddles_v1 "
+          "SET timestamp = CAST(STRFTIME('%s','now') AS INTEGER) "
+          "WHERE"
+          "  length = :length "
+          "  AND length_limit = :length_limit "
+          "  AND precision = :precision "
+          "  AND large_twiddle_base = :large_twiddle_base "
+          "  AND attach_halfN = :attach_halfN "
+          "  AND radices = :radices ";
+
     // prepare get/store statements once so they can be called many
     // times
     if(db_sys)
@@ -203,7 +339,14 @@ RTCCache::RTCCache()
         // so if we are unable to talk to it, just stop using it
         try
         {
-            get_stmt_sys = prepare_stmt(db_sys, get_stmt_text);
+            try
+            {
+                get_stmt_sys = prepare_stmt(db_sys, get_stmt_text);
+            }
+            catch(std::exception&)
+            {
+                get_stmt_sys = prepare_stmt(db_sys, get_stmt_text_no_time);
+            }
         }
         catch(std::exception&)
         {
@@ -214,16 +357,77 @@ RTCCache::RTCCache()
     {
         get_stmt_user   = prepare_stmt(db_user, get_stmt_text);
         store_stmt_user = prepare_stmt(db_user, store_stmt_text);
+        touch_stmt_user = prepare_stmt(db_user, touch_stmt_text);
+        evict_stmt_user = prepare_stmt(db_user, evict_stmt_text.c_str());
+
+        get_twiddles_stmt_user   = prepare_stmt(db_user, get_twiddles_stmt_text);
+        store_twiddles_stmt_user = prepare_stmt(db_user, store_twiddles_stmt_text);
+        touch_twiddles_stmt_user = prepare_stmt(db_user, touch_twiddles_stmt_text);
+        evict_twiddles_stmt_user = prepare_stmt(db_user, evict_twiddles_stmt_text.c_str());
+
+        auto str_max_bytes = rocfft_getenv("ROCFFT_RTC_CACHE_MAX_SIZE");
+        if(!str_max_bytes.empty())
+            max_bytes = strtoull(str_max_bytes.c_str(), nullptr, 0);
+
+        evict_lru();
+    }
+}
+
+void RTCCache::evict_lru()
+{
+    if(max_bytes == 0 || !rocfft_getenv("ROCFFT_RTC_CACHE_WRITE_DISABLE").empty())
+        return;
+
+    std::lock_guard<std::mutex> lock(store_mutex_user);
+
+    // kernels first.  rows that survive are within the limit, so the
+    // twiddle tables that are evicted afterwards are the least
+    // recently used of what's left.
+    for(auto stmt : {evict_stmt_user.get(), evict_twiddles_stmt_user.get()})
+    {
+        sqlite3_reset(stmt);
+        if(sqlite3_bind_int64(stmt, 1, max_bytes) != SQLITE_OK)
+            throw std::runtime_error(std::string("evict_lru bind: ")
+                                     + sqlite3_errmsg(db_user.get()));
+        if(sqlite3_step(stmt) == SQLITE_DONE && LOG_RTC_ENABLED())
+        {
+            auto evicted = sqlite3_changes(db_user.get());
+            if(evicted)
+                (*LogSingleton::GetInstance().GetRTCOS())
+                    << "// cache evicted " << evicted
+                    << (stmt == evict_stmt_user.get() ? " kernels" : " twiddle tables")
+                    << std::endl;
+        }
+        sqlite3_reset(stmt);
     }
 }
 
+// bind the primary key columns of cache_v1 to the first four
+// parameters of a statement
+static bool bind_key(sqlite3_stmt*               s,
+                     const std::string&          kernel_name,
+                     const std::string&          gpu_arch,
+                     int                         hip_version,
+                     const std::array<char, 32>& generator_sum)
+{
+    return sqlite3_bind_text(s, 1, kernel_name.c_str(), kernel_name.size(), SQLITE_TRANSIENT)
+               == SQLITE_OK
+           && sqlite3_bind_text(s, 2, gpu_arch.c_str(), gpu_arch.size(), SQLITE_TRANSIENT)
+                  == SQLITE_OK
+           && sqlite3_bind_int(s, 3, hip_version) == SQLITE_OK
+           && sqlite3_bind_blob(s, 4, generator_sum.data(), generator_sum.size(), SQLITE_TRANSIENT)
+                  == SQLITE_OK;
+}
+
 static std::vector<char> get_code_object_impl(const std::string&          kernel_name,
                                               const std::string&          gpu_arch,
                                               int                         hip_version,
                                               const std::array<char, 32>& generator_sum,
                                               sqlite3_ptr&                db,
                                               sqlite3_stmt_ptr&           get_stmt,
-                                              std::mutex&                 get_mutex)
+                                              std::mutex&                 get_mutex,
+                                              size_t&                     compile_ms,
+                                              sqlite3_int64&              timestamp)
 {
     std::vector<char> code;
 
@@ -252,6 +456,10 @@ static std::vector<char> get_code_object_impl(const std::string&          kernel
         int         nbytes = sqlite3_column_bytes(s, 0);
         const char* data   = static_cast<const char*>(sqlite3_column_blob(s, 0));
         std::copy(data, data + nbytes, std::back_inserter(code));
+        if(sqlite3_column_count(s) > 1)
+            compile_ms = sqlite3_column_int64(s, 1);
+        if(sqlite3_column_count(s) > 2)
+            timestamp = sqlite3_column_int64(s, 2);
     }
     sqlite3_reset(s);
     return code;
@@ -263,33 +471,196 @@ std::vector<char> RTCCache::get_code_object(const std::string&          kernel_n
                                             const std::array<char, 32>& generator_sum)
 {
     std::vector<char> code;
+    size_t            compile_ms = 0;
+    sqlite3_int64     timestamp  = 0;
     // try user cache first
     if(get_stmt_user)
+    {
         code = get_code_object_impl(kernel_name,
                                     gpu_arch,
                                     hip_version,
                                     generator_sum,
                                     db_user,
                                     get_stmt_user,
-                                    get_mutex_user);
+                                    get_mutex_user,
+                                    compile_ms,
+                                    timestamp);
+
+        // mark the row as recently used
+        if(!code.empty() && needs_touch(timestamp)
+           && rocfft_getenv("ROCFFT_RTC_CACHE_WRITE_DISABLE").empty())
+        {
+            std::lock_guard<std::mutex> lock(store_mutex_user);
+
+            auto s = touch_stmt_user.get();
+            sqlite3_reset(s);
+            if(!bind_key(s, kernel_name, gpu_arch, hip_version, generator_sum))
+            {
+                throw std::runtime_error(std::string("get_code_object touch bind: ")
+                                         + sqlite3_errmsg(db_user.get()));
+            }
+            // failing to update the timestamp only makes eviction
+            // less accurate, so ignore the result
+            sqlite3_step(s);
+            sqlite3_reset(s);
+        }
+    }
     // fall back to system cache
     if(code.empty() && get_stmt_sys)
-        code = get_code_object_impl(
-            kernel_name, gpu_arch, hip_version, generator_sum, db_sys, get_stmt_sys, get_mutex_sys);
+        code = get_code_object_impl(kernel_name,
+                                    gpu_arch,
+                                    hip_version,
+                                    generator_sum,
+                                    db_sys,
+                                    get_stmt_sys,
+                                    get_mutex_sys,
+                                    compile_ms,
+                                    timestamp);
+
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    if(code.empty())
+        ++misses;
+    else
+    {
+        ++hits;
+        time_saved_ms += compile_ms;
+    }
     return code;
 }
 
+// look up each of the remaining kernels in one transaction, moving
+// found kernels from "remaining" to "found".  found kernels that
+// need it are touched with touch_stmt if it's non-null.
+static void get_code_objects_impl(std::vector<std::string>&                 remaining,
+                                  const std::string&                        gpu_arch,
+                                  int                                       hip_version,
+                                  const std::array<char, 32>&               generator_sum,
+                                  sqlite3_ptr&                              db,
+                                  sqlite3_stmt_ptr&                         get_stmt,
+                                  sqlite3_stmt_ptr*                         touch_stmt,
+                                  std::map<std::string, std::vector<char>>& found,
+                                  size_t&                                   compile_ms)
+{
+    if(sqlite3_exec(db.get(), "BEGIN TRANSACTION", nullptr, nullptr, nullptr) != SQLITE_OK)
+        throw std::runtime_error(std::string("get_code_objects begin: ")
+                                 + sqlite3_errmsg(db.get()));
+
+    std::vector<std::string> missing;
+    for(const auto& kernel_name : remaining)
+    {
+        auto s = get_stmt.get();
+        sqlite3_reset(s);
+        if(!bind_key(s, kernel_name, gpu_arch, hip_version, generator_sum))
+        {
+            sqlite3_exec(db.get(), "ROLLBACK", nullptr, nullptr, nullptr);
+            throw std::runtime_error(std::string("get_code_objects bind: ")
+                                     + sqlite3_errmsg(db.get()));
+        }
+        if(sqlite3_step(s) != SQLITE_ROW)
+        {
+            missing.push_back(kernel_name);
+            sqlite3_reset(s);
+            continue;
+        }
+
+        int         nbytes = sqlite3_column_bytes(s, 0);
+        const char* data   = static_cast<const char*>(sqlite3_column_blob(s, 0));
+        found[kernel_name].assign(data, data + nbytes);
+        if(sqlite3_column_count(s) > 1)
+            compile_ms += sqlite3_column_int64(s, 1);
+        const bool touch = sqlite3_column_count(s) > 2 && needs_touch(sqlite3_column_int64(s, 2));
+        sqlite3_reset(s);
+
+        // failing to update the timestamp only makes eviction less
+        // accurate, so ignore the result
+        if(touch_stmt && touch)
+        {
+            auto t = touch_stmt->get();
+            sqlite3_reset(t);
+            if(bind_key(t, kernel_name, gpu_arch, hip_version, generator_sum))
+                sqlite3_step(t);
+            sqlite3_reset(t);
+        }
+    }
+
+    sqlite3_exec(db.get(), "COMMIT", nullptr, nullptr, nullptr);
+    remaining.swap(missing);
+}
+
+std::map<std::string, std::vector<char>>
+    RTCCache::get_code_objects(const std::vector<std::string>& kernel_names,
+                               const std::string&              gpu_arch,
+                               int                             hip_version,
+                               const std::array<char, 32>&     generator_sum)
+{
+    std::map<std::string, std::vector<char>> found;
+
+    // allow env variable to disable reads
+    if(!rocfft_getenv("ROCFFT_RTC_CACHE_READ_DISABLE").empty())
+        return found;
+
+    std::vector<std::string> remaining = kernel_names;
+    std::sort(remaining.begin(), remaining.end());
+    remaining.erase(std::unique(remaining.begin(), remaining.end()), remaining.end());
+    remaining.erase(std::remove(remaining.begin(), remaining.end(), std::string()),
+                    remaining.end());
+
+    size_t compile_ms = 0;
+    // try user cache first
+    if(get_stmt_user)
+    {
+        // the transaction spans the whole connection, so keep other
+        // threads from writing to it while the transaction is open
+        std::lock_guard<std::mutex> get_lock(get_mutex_user);
+        std::lock_guard<std::mutex> store_lock(store_mutex_user);
+
+        bool write_enabled = rocfft_getenv("ROCFFT_RTC_CACHE_WRITE_DISABLE").empty();
+        get_code_objects_impl(remaining,
+                              gpu_arch,
+                              hip_version,
+                              generator_sum,
+                              db_user,
+                              get_stmt_user,
+                              write_enabled ? &touch_stmt_user : nullptr,
+                              found,
+                              compile_ms);
+    }
+    // fall back to system cache
+    if(!remaining.empty() && get_stmt_sys)
+    {
+        std::lock_guard<std::mutex> get_lock(get_mutex_sys);
+        get_code_objects_impl(remaining,
+                              gpu_arch,
+                              hip_version,
+                              generator_sum,
+                              db_sys,
+                              get_stmt_sys,
+                              nullptr,
+                              found,
+                              compile_ms);
+    }
+
+    // misses are not counted here - callers look them up again
+    // just before compiling, since another thread may have compiled
+    // them in the meantime
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    hits += found.size();
+    time_saved_ms += compile_ms;
+    return found;
+}
+
 void RTCCache::store_code_object(const std::string&          kernel_name,
                                  const std::string&          gpu_arch,
                                  int                         hip_version,
                                  const std::array<char, 32>& generator_sum,
-                                 const std::vector<char>&    code)
+                                 const std::vector<char>&    code,
+                                 size_t                      compile_ms)
 {
     // allow env variable to disable writes
     if(!rocfft_getenv("ROCFFT_RTC_CACHE_WRITE_DISABLE").empty())
         return;
 
-    std::lock_guard<std::mutex> lock(store_mutex_user);
+    std::unique_lock<std::mutex> lock(store_mutex_user);
 
     auto s = store_stmt_user.get();
     sqlite3_reset(s);
@@ -301,7 +672,8 @@ void RTCCache::store_code_object(const std::string&          kernel_name,
        || sqlite3_bind_int(s, 3, hip_version) != SQLITE_OK
        || sqlite3_bind_blob(s, 4, generator_sum.data(), generator_sum.size(), SQLITE_TRANSIENT)
               != SQLITE_OK
-       || sqlite3_bind_blob(s, 5, code.data(), code.size(), SQLITE_TRANSIENT))
+       || sqlite3_bind_blob(s, 5, code.data(), code.size(), SQLITE_TRANSIENT) != SQLITE_OK
+       || sqlite3_bind_int64(s, 6, compile_ms) != SQLITE_OK)
     {
         throw std::runtime_error(std::string("store_code_object bind: ")
                                  + sqlite3_errmsg(db_user.get()));
@@ -315,6 +687,160 @@ void RTCCache::store_code_object(const std::string&          kernel_name,
                 << "Error: failed to store code object for " << kernel_name << std::flush;
     }
     sqlite3_reset(s);
+    lock.unlock();
+
+    evict_lru();
+}
+
+// bind the primary key columns of twiddles_v1 to the first six
+// parameters of a statement
+static bool bind_twiddles_key(sqlite3_stmt*              s,
+                              size_t                     length,
+                              size_t                     length_limit,
+                              rocfft_precision           precision,
+                              size_t                     large_twiddle_base,
+                              bool                       attach_halfN,
+                              const std::vector<size_t>& radices)
+{
+    std::string radices_str;
+    for(auto r : radices)
+    {
+        if(!radices_str.empty())
+            radices_str += ",";
+        radices_str += std::to_string(r);
+    }
+    return sqlite3_bind_int64(s, 1, length) == SQLITE_OK
+           && sqlite3_bind_int64(s, 2, length_limit) == SQLITE_OK
+           && sqlite3_bind_int(s, 3, precision) == SQLITE_OK
+           && sqlite3_bind_int64(s, 4, large_twiddle_base) == SQLITE_OK
+           && sqlite3_bind_int(s, 5, attach_halfN) == SQLITE_OK
+           && sqlite3_bind_text(s, 6, radices_str.c_str(), radices_str.size(), SQLITE_TRANSIENT)
+                  == SQLITE_OK;
+}
+
+std::vector<char> RTCCache::get_twiddles(size_t                     length,
+                                         size_t                     length_limit,
+                                         rocfft_precision           precision,
+                                         size_t                     large_twiddle_base,
+                                         bool                       attach_halfN,
+                                         const std::vector<size_t>& radices)
+{
+    std::vector<char> data;
+    sqlite3_int64     timestamp = 0;
+
+    // allow env variable to disable reads
+    if(!get_twiddles_stmt_user || !rocfft_getenv("ROCFFT_RTC_CACHE_READ_DISABLE").empty())
+        return data;
+
+    std::unique_lock<std::mutex> lock(get_mutex_user);
+
+    auto s = get_twiddles_stmt_user.get();
+    sqlite3_reset(s);
+    if(!bind_twiddles_key(
+           s, length, length_limit, precision, large_twiddle_base, attach_halfN, radices))
+    {
+        throw std::runtime_error(std::string("get_twiddles bind: ")
+                                 + sqlite3_errmsg(db_user.get()));
+    }
+    if(sqlite3_step(s) == SQLITE_ROW)
+    {
+        int         nbytes = sqlite3_column_bytes(s, 0);
+        const char* blob   = static_cast<const char*>(sqlite3_column_blob(s, 0));
+        data.assign(blob, blob + nbytes);
+        timestamp = sqlite3_column_int64(s, 1);
+    }
+    sqlite3_reset(s);
+    lock.unlock();
+
+    // mark the row as recently used, like kernels
+    if(!data.empty() && needs_touch(timestamp)
+       && rocfft_getenv("ROCFFT_RTC_CACHE_WRITE_DISABLE").empty())
+    {
+        std::lock_guard<std::mutex> store_lock(store_mutex_user);
+
+        auto touch = touch_twiddles_stmt_user.get();
+        sqlite3_reset(touch);
+        if(!bind_twiddles_key(
+               touch, length, length_limit, precision, large_twiddle_base, attach_halfN, radices))
+        {
+            throw std::runtime_error(std::string("get_twiddles touch bind: ")
+                                     + sqlite3_errmsg(db_user.get()));
+        }
+        // failing to update the timestamp only makes eviction less
+        // accurate, so ignore the result
+        sqlite3_step(touch);
+        sqlite3_reset(touch);
+    }
+    return data;
+}
+
+void RTCCache::store_twiddles(size_t                     length,
+                              size_t                     length_limit,
+                              rocfft_precision           precision,
+                              size_t                     large_twiddle_base,
+                              bool                       attach_halfN,
+                              const std::vector<size_t>& radices,
+                              const std::vector<char>&   data)
+{
+    // allow env variable to disable writes
+    if(!store_twiddles_stmt_user || !rocfft_getenv("ROCFFT_RTC_CACHE_WRITE_DISABLE").empty())
+        return;
+
+    std::unique_lock<std::mutex> lock(store_mutex_user);
+
+    auto s = store_twiddles_stmt_user.get();
+    sqlite3_reset(s);
+    if(!bind_twiddles_key(
+           s, length, length_limit, precision, large_twiddle_base, attach_halfN, radices)
+       || sqlite3_bind_blob(s, 7, data.data(), data.size(), SQLITE_TRANSIENT) != SQLITE_OK)
+    {
+        throw std::runtime_error(std::string("store_twiddles bind: ")
+                                 + sqlite3_errmsg(db_user.get()));
+    }
+    // failing to store only means the table is generated again next
+    // time, so just log it
+    if(sqlite3_step(s) != SQLITE_DONE && LOG_RTC_ENABLED())
+        (*LogSingleton::GetInstance().GetRTCOS())
+            << "Error: failed to store twiddles for length " << length << std::endl;
+    sqlite3_reset(s);
+    lock.unlock();
+
+    evict_lru();
+}
+
+rocfft_status RTCCache::get_stats(
+    size_t* entries, size_t* size_bytes, size_t* hits, size_t* misses, double* time_saved_ms)
+{
+    size_t user_entries = 0;
+    size_t user_bytes   = 0;
+    if(db_user)
+    {
+        // twiddle tables count towards the size, since the size
+        // limit applies to them too
+        auto count = prepare_stmt(
+            db_user,
+            "SELECT"
+            "  (SELECT COUNT(*) FROM cache_v1),"
+            "  (SELECT COALESCE(SUM(LENGTH(code)), 0) FROM cache_v1)"
+            "  + (SELECT COALESCE(SUM(LENGTH(data)), 0) FROM twiddles_v1)");
+        if(sqlite3_step(count.get()) != SQLITE_ROW)
+            return rocfft_status_failure;
+        user_entries = sqlite3_column_int64(count.get(), 0);
+        user_bytes   = sqlite3_column_int64(count.get(), 1);
+    }
+    if(entries)
+        *entries = user_entries;
+    if(size_bytes)
+        *size_bytes = user_bytes;
+
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    if(hits)
+        *hits = this->hits;
+    if(misses)
+        *misses = this->misses;
+    if(time_saved_ms)
+        *time_saved_ms = this->time_saved_ms;
+    return rocfft_status_success;
 }
 
 rocfft_status RTCCache::serialize(void** buffer, size_t* buffer_len_bytes)
@@ -360,15 +886,17 @@ rocfft_status RTCCache::deserialize(const void* buffer, size_t buffer_len_bytes)
         return rocfft_status_failure;
 
     // now the deserialized db is in memory.  run an additive query to
-    // update the real db with the temp contents.
-    sql_err           = sqlite3_exec(db_user.get(),
+    // update the real db with the temp contents, keeping compile
+    // times so imported kernels count towards time saved.
+    sql_err = sqlite3_exec(db_user.get(),
                            "INSERT OR REPLACE INTO cache_v1 ("
                            "    kernel_name,"
                            "    arch,"
                            "    hip_version,"
                            "    generator_sum,"
                            "    timestamp,"
-                           "    code"
+                           "    code,"
+                           "    compile_ms"
                            ")"
                            "SELECT"
                            "    kernel_name,"
@@ -376,16 +904,43 @@ rocfft_status RTCCache::deserialize(const void* buffer, size_t buffer_len_bytes)
                            "    hip_version,"
                            "    generator_sum,"
                            "    timestamp,"
-                           "    code "
+                           "    code,"
+                           "    compile_ms "
                            "FROM deserialized.cache_v1",
                            nullptr,
                            nullptr,
                            nullptr);
+    // caches serialized by older versions have no compile times
+    if(sql_err != SQLITE_OK)
+        sql_err = sqlite3_exec(db_user.get(),
+                               "INSERT OR REPLACE INTO cache_v1 ("
+                               "    kernel_name,"
+                               "    arch,"
+                               "    hip_version,"
+                               "    generator_sum,"
+                               "    timestamp,"
+                               "    code"
+                               ")"
+                               "SELECT"
+                               "    kernel_name,"
+                               "    arch,"
+                               "    hip_version,"
+                               "    generator_sum,"
+                               "    timestamp,"
+                               "    code "
+                               "FROM deserialized.cache_v1",
+                               nullptr,
+                               nullptr,
+                               nullptr);
     rocfft_status ret = sql_err == SQLITE_OK ? rocfft_status_success : rocfft_status_failure;
 
     // detach the temp db
     sqlite3_exec(db_user.get(), "DETACH DATABASE deserialized", nullptr, nullptr, nullptr);
 
+    // imported kernels might have pushed the cache over its size limit
+    if(ret == rocfft_status_success)
+        evict_lru();
+
     return ret;
 }
 
@@ -419,6 +974,26 @@ static RTCProcessType get_rtc_process_type()
     return RTCProcessType::DEFAULT;
 }
 
+std::map<std::string, std::vector<char>>
+    RTCKernel::cached_lookup(const std::vector<std::string>& kernel_names,
+                             const std::string&              gpu_arch)
+{
+    static int hip_version = 0;
+    if(!RTCCache::single
+       || (hip_version == 0 && hipRuntimeGetVersion(&hip_version) != hipSuccess))
+        return {};
+
+    auto found = RTCCache::single->get_code_objects(
+        kernel_names, gpu_arch, hip_version, generator_sum());
+    if(LOG_RTC_ENABLED())
+    {
+        for(const auto& f : found)
+            (*LogSingleton::GetInstance().GetRTCOS())
+                << "// cache hit for " << f.first << std::endl;
+    }
+    return found;
+}
+
 std::vector<char> RTCKernel::cached_compile(const std::string& kernel_name,
                                             const std::string& gpu_arch,
                                             kernel_src_gen_t   generate_src)
@@ -546,8 +1121,16 @@ std::vector<char> RTCKernel::cached_compile(const std::string& kernel_name,
 
     if(RTCCache::single)
     {
-        RTCCache::single->store_code_object(
-            kernel_name, gpu_arch, hip_version, generator_sum(), code);
+        // remember how long this kernel took to produce, to know
+        // how much time future cache hits save
+        std::chrono::duration<float, std::milli> produce_ms
+            = (generate_end - generate_begin) + (compile_end - compile_begin);
+        RTCCache::single->store_code_object(kernel_name,
+                                            gpu_arch,
+                                            hip_version,
+                                            generator_sum(),
+                                            code,
+                                            static_cast<size_t>(produce_ms.count()));
     }
     return code;
 }
@@ -0,0 +1,224 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "rtc_compile_queue.h"
+#include "../../shared/environment.h"
+#include "logging.h"
+
+#include <algorithm>
+
+CompileQueue::CompileQueue()
+{
+    stats.max_threads = ConfiguredThreads();
+}
+
+CompileQueue::~CompileQueue()
+{
+    StopWorkers();
+}
+
+CompileQueue& CompileQueue::GetCompileQueue()
+{
+    static CompileQueue queue;
+    return queue;
+}
+
+size_t CompileQueue::ConfiguredThreads()
+{
+    auto   str_threads = rocfft_getenv("ROCFFT_RTC_COMPILE_THREADS");
+    size_t threads     = 0;
+    if(!str_threads.empty())
+        threads = strtoull(str_threads.c_str(), nullptr, 0);
+    if(threads == 0)
+        threads = std::thread::hardware_concurrency();
+    return std::max<size_t>(threads, 1);
+}
+
+// run a compile on the current thread, returning the result as a
+// future
+static CompileQueue::future_t run_inline(CompileQueue::compile_func_t& compile)
+{
+    std::promise<std::unique_ptr<RTCKernel>> p;
+    try
+    {
+        p.set_value(compile());
+    }
+    catch(...)
+    {
+        p.set_exception(std::current_exception());
+    }
+    return p.get_future();
+}
+
+CompileQueue::future_t CompileQueue::Submit(const key_t& key, compile_func_t compile)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+
+    auto existing = in_flight.find(key);
+    if(existing != in_flight.end())
+    {
+        ++stats.deduplicated;
+        if(LOG_RTC_ENABLED())
+            (*LogSingleton::GetInstance().GetRTCOS())
+                << "// compile queue: waiting for in-flight " << key.kernel_name << std::endl;
+        return existing->second;
+    }
+
+    ++stats.submitted;
+
+    // library is being cleaned up, so don't start anything new in
+    // the background
+    if(stopping)
+    {
+        lock.unlock();
+        return run_inline(compile);
+    }
+
+    queue.emplace_back();
+    item_t& item   = queue.back();
+    item.key       = key;
+    item.compile   = std::move(compile);
+    item.queued_at = std::chrono::steady_clock::now();
+    future_t result(item.result.get_future());
+    in_flight.emplace(key, result);
+
+    stats.queue_depth     = queue.size();
+    stats.max_queue_depth = std::max(stats.max_queue_depth, queue.size());
+
+    if(queue.size() > idle_workers && workers.size() < stats.max_threads)
+        workers.emplace_back(&CompileQueue::WorkerLoop, this);
+
+    lock.unlock();
+    cv.notify_one();
+    return result;
+}
+
+void CompileQueue::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    for(;;)
+    {
+        ++idle_workers;
+        cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+        --idle_workers;
+
+        // finish anything that's already queued before stopping
+        if(queue.empty())
+            return;
+
+        item_t item = std::move(queue.front());
+        queue.pop_front();
+
+        std::chrono::duration<double, std::milli> wait
+            = std::chrono::steady_clock::now() - item.queued_at;
+        size_t queue_depth = queue.size();
+        stats.queue_depth  = queue_depth;
+        stats.total_wait += wait;
+        stats.max_wait = std::max(stats.max_wait, wait);
+        lock.unlock();
+
+        if(LOG_RTC_ENABLED())
+            (*LogSingleton::GetInstance().GetRTCOS())
+                << "// compile queue: " << item.key.kernel_name << " waited "
+                << static_cast<int>(wait.count()) << " ms, queue depth " << queue_depth
+                << std::endl;
+
+        try
+        {
+            // worker threads are shared between devices
+            if(item.key.deviceId != NO_DEVICE && hipSetDevice(item.key.deviceId) != hipSuccess)
+                throw std::runtime_error("hipSetDevice failed for deviceId "
+                                         + std::to_string(item.key.deviceId));
+            item.result.set_value(item.compile());
+        }
+        catch(...)
+        {
+            item.result.set_exception(std::current_exception());
+        }
+
+        lock.lock();
+        in_flight.erase(item.key);
+        ++stats.completed;
+
+        if(LOG_PROFILE_ENABLED())
+        {
+            stats_t finished = stats;
+            finished.threads = workers.size();
+            lock.unlock();
+            LogStats(item.key.kernel_name, finished);
+            lock.lock();
+        }
+    }
+}
+
+void CompileQueue::LogStats(const std::string& kernel_name, const stats_t& s)
+{
+    log_profile("compile_queue",
+                "kernel",
+                kernel_name,
+                "threads",
+                s.threads,
+                "max_threads",
+                s.max_threads,
+                "submitted",
+                s.submitted,
+                "deduplicated",
+                s.deduplicated,
+                "completed",
+                s.completed,
+                "queue_depth",
+                s.queue_depth,
+                "max_queue_depth",
+                s.max_queue_depth,
+                "total_wait_ms",
+                s.total_wait.count(),
+                "max_wait_ms",
+                s.max_wait.count());
+}
+
+void CompileQueue::Setup()
+{
+    CompileQueue& queue = GetCompileQueue();
+    // any running threads were started with the old configuration
+    queue.StopWorkers();
+    std::lock_guard<std::mutex> lck(queue.mtx);
+    queue.stats.max_threads = ConfiguredThreads();
+}
+
+void CompileQueue::Stop()
+{
+    GetCompileQueue().StopWorkers();
+}
+
+void CompileQueue::StopWorkers()
+{
+    std::vector<std::thread> stopped;
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        stopping = true;
+        stopped.swap(workers);
+    }
+    cv.notify_all();
+    for(auto& t : stopped)
+        t.join();
+
+    std::lock_guard<std::mutex> lck(mtx);
+    stopping = false;
+}
@@ -18,6 +18,7 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+#include "plan.h"
 #include "rtc_cache.h"
 
 rocfft_status rocfft_cache_serialize(void** buffer, size_t* buffer_len_bytes)
@@ -49,3 +50,42 @@ rocfft_status rocfft_cache_deserialize(const void* buffer, size_t buffer_len_byt
 
     return RTCCache::single->deserialize(buffer, buffer_len_bytes);
 }
+
+rocfft_status rocfft_cache_get_stats(
+    size_t* entries, size_t* size_bytes, size_t* hits, size_t* misses, double* time_saved_ms)
+{
+    if(!RTCCache::single)
+        return rocfft_status_failure;
+
+    return RTCCache::single->get_stats(entries, size_bytes, hits, misses, time_saved_ms);
+}
+
+rocfft_status rocfft_cache_build_kernels(const char*                   gpu_arch,
+                                         const rocfft_result_placement placement,
+                                         const rocfft_transform_type   transform_type,
+                                         const rocfft_precision        precision,
+                                         const size_t                  dimensions,
+                                         const size_t*                 lengths,
+                                         const size_t                  number_of_transforms,
+                                         const rocfft_plan_description description)
+{
+    if(!gpu_arch || !lengths)
+        return rocfft_status_invalid_arg_value;
+
+    if(!RTCCache::single)
+        return rocfft_status_failure;
+
+    // decide the plan without a device, which compiles its kernels
+    // into the cache
+    rocfft_plan_t   plan;
+    hipDeviceProp_t deviceProp = SyntheticDeviceProp(gpu_arch);
+    return rocfft_plan_create_internal(&plan,
+                                       placement,
+                                       transform_type,
+                                       precision,
+                                       dimensions,
+                                       lengths,
+                                       number_of_transforms,
+                                       description,
+                                       &deviceProp);
+}
@@ -21,15 +21,25 @@
 #include "../../shared/environment.h"
 #include "library_path.h"
 #include "rtc.h"
+#include "rtc_helper_protocol.h"
+
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 
 #ifdef WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #else
+#include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <spawn.h>
 #include <stdio.h>
+#include <sys/socket.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #endif
@@ -127,6 +137,8 @@ struct file_handle_wrapper
     file_handle_type fd = FILE_HANDLE_INVALID;
 };
 
+#ifdef WIN32
+// On Windows, each kernel is compiled by a new helper process.
 std::vector<char> RTCKernel::compile_subprocess(const std::string& kernel_src,
                                                 const std::string& gpu_arch)
 {
@@ -135,7 +147,6 @@ std::vector<char> RTCKernel::compile_subprocess(const std::string& kernel_src,
     bool                subprocess_failed = false;
     static const size_t READ_CHUNK_SIZE   = 1024;
 
-#ifdef WIN32
     file_handle_wrapper child_stdin_read;
     file_handle_wrapper child_stdin_write;
     file_handle_wrapper child_stdout_read;
@@ -335,119 +346,386 @@ std::vector<char> RTCKernel::compile_subprocess(const std::string& kernel_src,
     if(!GetExitCodeProcess(hProcess, &exit_code))
         throw std::runtime_error("failed to get child exit code");
     subprocess_failed = exit_code != 0;
+
+    if(code.empty())
+    {
+        throw std::runtime_error("child process failed to produce code");
+    }
+
+    if(subprocess_failed)
+    {
+        // stdout of process is actually an error message, so throw that
+        throw std::runtime_error(std::string(code.data(), code.size()));
+    }
+    return code;
+}
+
+// each kernel gets its own helper process, so there are no idle
+// helpers to stop
+void RTCKernel::SetupHelpers() {}
+
+void RTCKernel::StopHelpers() {}
 #else
-    int stdin_fds[2] = {-1, -1};
-    if(pipe2(stdin_fds, O_CLOEXEC) != 0)
-        throw std::runtime_error("failed to create stdin pipe");
-    file_handle_wrapper child_stdin_read(stdin_fds[0]);
-    file_handle_wrapper child_stdin_write(stdin_fds[1]);
-
-    int stdout_fds[2] = {-1, -1};
-    if(pipe2(stdout_fds, O_CLOEXEC) != 0)
-        throw std::runtime_error("failed to create stdout pipe");
-    file_handle_wrapper child_stdout_read(stdout_fds[0]);
-    file_handle_wrapper child_stdout_write(stdout_fds[1]);
-
-    pid_t pid = 0;
-    char* argv[]
-        = {const_cast<char*>(rtc_helper_exe.c_str()), const_cast<char*>(gpu_arch.c_str()), 0};
-    char* envp[] = {nullptr};
-
-    // set up child's stdin/stdout
-    posix_spawn_file_actions_t spawn_file_actions;
-    posix_spawn_file_actions_init(&spawn_file_actions);
-    posix_spawn_file_actions_adddup2(&spawn_file_actions, child_stdin_read, STDIN_FILENO);
-    posix_spawn_file_actions_adddup2(&spawn_file_actions, child_stdout_write, STDOUT_FILENO);
-
-    int spawn_result
-        = posix_spawn(&pid, rtc_helper_exe.c_str(), &spawn_file_actions, nullptr, argv, envp);
-    if(spawn_result != 0)
+
+// On POSIX systems, helpers are long-lived compile servers (see
+// rtc_helper_protocol.h), so that process startup and compiler
+// initialization are paid once per helper instead of once per
+// kernel.
+//
+// A compile is sent to an idle helper for the right GPU
+// architecture, or a new helper is started if fewer than the
+// maximum are running.  Requests that arrive while all helpers are
+// busy are queued, and the next helper to become free takes them as
+// one batch.
+
+// a compile request waiting for a helper
+struct rtc_helper_request_t
+{
+    std::string                     kernel_src;
+    std::promise<std::vector<char>> result;
+};
+typedef std::vector<std::shared_ptr<rtc_helper_request_t>> rtc_helper_batch_t;
+
+// maximum number of requests sent to a helper at once
+static const size_t RTC_HELPER_MAX_BATCH = 8;
+
+// one running helper process
+class RTCHelperProcess
+{
+public:
+    RTCHelperProcess(const std::string& exe, const std::string& gpu_arch)
     {
-        throw std::runtime_error("failed to spawn child process");
+        // use a socket rather than pipes, so that writing to a
+        // helper that has crashed returns an error instead of
+        // raising SIGPIPE
+        int fds[2] = {-1, -1};
+        if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+            throw std::runtime_error("failed to create helper socket");
+        sock.fd = fds[0];
+        file_handle_wrapper child_sock(fds[1]);
+
+        // we write requests and read responses at the same time, so
+        // our end must not block
+        if(fcntl(sock, F_SETFL, O_NONBLOCK) != 0)
+            throw std::runtime_error("failed to make helper socket non-blocking");
+
+        char* argv[] = {const_cast<char*>(exe.c_str()),
+                        const_cast<char*>(RTC_HELPER_SERVER_ARG),
+                        const_cast<char*>(gpu_arch.c_str()),
+                        nullptr};
+        char* envp[] = {nullptr};
+
+        // child's stdin and stdout are both its end of the socket
+        posix_spawn_file_actions_t spawn_file_actions;
+        posix_spawn_file_actions_init(&spawn_file_actions);
+        posix_spawn_file_actions_adddup2(&spawn_file_actions, child_sock, STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&spawn_file_actions, child_sock, STDOUT_FILENO);
+
+        int spawn_result
+            = posix_spawn(&pid, exe.c_str(), &spawn_file_actions, nullptr, argv, envp);
+        posix_spawn_file_actions_destroy(&spawn_file_actions);
+        if(spawn_result != 0)
+            throw std::runtime_error("failed to spawn child process");
     }
 
-    child_stdin_read.close();
-    child_stdout_write.close();
+    // no copies, moves
+    RTCHelperProcess(const RTCHelperProcess&) = delete;
+    RTCHelperProcess(RTCHelperProcess&&)      = delete;
+    void operator=(const RTCHelperProcess&) = delete;
+    void operator=(RTCHelperProcess&&) = delete;
 
-    // poll read and write fd's
-    pollfd fds[2];
-    fds[0].fd     = child_stdin_write;
-    fds[0].events = POLLOUT;
-    fds[1].fd     = child_stdout_read;
-    fds[1].events = POLLIN;
+    ~RTCHelperProcess()
+    {
+        // closing the socket tells the helper to exit
+        sock.close();
+        int wait_status = 0;
+        waitpid(pid, &wait_status, 0);
+    }
 
-    ssize_t total_bytes_written = 0;
-    while(poll(fds, 2, 1000) >= 0)
+    bool alive() const
     {
-        // error conditions on fds, break
-        if(fds[0].revents & POLLERR || fds[1].revents & POLLERR)
-            break;
+        return !failed;
+    }
 
-        // write kernel source to child
-        if(fds[0].revents & POLLOUT)
+    // Send a batch of requests and fulfil each one with the helper's
+    // response.  Returns the number of requests that got a response.
+    // If the helper dies, the rest of the batch is left unfulfilled
+    // and the helper is no longer alive.
+    size_t compile(const rtc_helper_batch_t& batch)
+    {
+        std::vector<char> out;
+        for(const auto& req : batch)
         {
-            // write a page at a time to prevent the write from
-            // blocking
-            size_t  bytes_to_write = std::min<size_t>(kernel_src.size(), 4096);
-            ssize_t bytes_written
-                = write(child_stdin_write, kernel_src.data() + total_bytes_written, bytes_to_write);
-            if(bytes_written <= 0)
-                break;
-            total_bytes_written += bytes_written;
+            uint64_t src_len = req->kernel_src.size();
+            append(out, &src_len, sizeof(src_len));
+            append(out, req->kernel_src.data(), src_len);
+        }
 
-            if(total_bytes_written >= static_cast<ssize_t>(kernel_src.size()))
+        static const size_t READ_CHUNK_SIZE = 65536;
+        std::vector<char>   chunk(READ_CHUNK_SIZE);
+        std::vector<char>   in;
+        size_t              written  = 0;
+        size_t              answered = 0;
+        while(answered < batch.size())
+        {
+            pollfd fds;
+            fds.fd     = sock;
+            fds.events = POLLIN | (written < out.size() ? POLLOUT : 0);
+            if(poll(&fds, 1, -1) < 0)
             {
-                // close child's stdin so it knows we're done writing
-                child_stdin_write.close();
-                fds[0].events = 0;
+                if(errno == EINTR)
+                    continue;
+                break;
             }
-        }
 
-        // read code object back from child
-        if(fds[1].revents & POLLIN)
-        {
-            size_t code_written_bytes = code.size();
-            code.resize(code_written_bytes + READ_CHUNK_SIZE);
-            auto bytes_read
-                = read(child_stdout_read, code.data() + code_written_bytes, READ_CHUNK_SIZE);
-            // resize code to number of bytes actually written
-            code.resize(code_written_bytes + (bytes_read > 0 ? bytes_read : 0));
-            if(bytes_read == -1)
+            if(fds.revents & POLLOUT)
             {
-                // read error, data is probably not correct
-                throw std::runtime_error("failed read data from child process");
+                ssize_t bytes_written
+                    = send(sock, out.data() + written, out.size() - written, MSG_NOSIGNAL);
+                if(bytes_written > 0)
+                    written += bytes_written;
+                else if(errno != EAGAIN && errno != EINTR)
+                    break;
             }
-            if(bytes_read == 0)
+
+            if(fds.revents & (POLLIN | POLLHUP | POLLERR))
             {
-                // end of file
-                break;
+                ssize_t bytes_read = recv(sock, chunk.data(), chunk.size(), 0);
+                // end of file means the helper exited
+                if(bytes_read == 0)
+                    break;
+                if(bytes_read < 0)
+                {
+                    if(errno == EAGAIN || errno == EINTR)
+                        continue;
+                    break;
+                }
+                in.insert(in.end(), chunk.begin(), chunk.begin() + bytes_read);
+                answered += parse_responses(in, batch, answered);
             }
         }
-        else if(fds[1].revents & POLLHUP)
+        if(answered < batch.size())
+            failed = true;
+        return answered;
+    }
+
+private:
+    static void append(std::vector<char>& buf, const void* data, size_t len)
+    {
+        auto bytes = static_cast<const char*>(data);
+        buf.insert(buf.end(), bytes, bytes + len);
+    }
+
+    // fulfil requests starting at batch[first] with any complete
+    // responses in the buffer, removing them from the buffer.
+    // Returns the number of requests fulfilled.
+    static size_t
+        parse_responses(std::vector<char>& in, const rtc_helper_batch_t& batch, size_t first)
+    {
+        static const size_t HEADER_SIZE = 2 * sizeof(uint64_t);
+
+        size_t pos   = 0;
+        size_t count = 0;
+        while(first + count < batch.size() && in.size() - pos >= HEADER_SIZE)
         {
-            // no data to read, other side hung up
-            break;
+            uint64_t status      = 0;
+            uint64_t payload_len = 0;
+            std::copy_n(in.data() + pos, sizeof(status), reinterpret_cast<char*>(&status));
+            std::copy_n(in.data() + pos + sizeof(status),
+                        sizeof(payload_len),
+                        reinterpret_cast<char*>(&payload_len));
+            if(in.size() - pos - HEADER_SIZE < payload_len)
+                break;
+
+            auto payload_begin = in.begin() + pos + HEADER_SIZE;
+            auto payload_end   = payload_begin + payload_len;
+            auto& result       = batch[first + count]->result;
+            if(status != RTC_HELPER_OK)
+                result.set_exception(std::make_exception_ptr(
+                    std::runtime_error(std::string(payload_begin, payload_end))));
+            else if(payload_len == 0)
+                result.set_exception(std::make_exception_ptr(
+                    std::runtime_error("child process failed to produce code")));
+            else
+                result.set_value(std::vector<char>(payload_begin, payload_end));
+
+            pos += HEADER_SIZE + payload_len;
+            ++count;
         }
+        in.erase(in.begin(), in.begin() + pos);
+        return count;
     }
 
-    child_stdout_read.close();
+    file_handle_wrapper sock;
+    pid_t               pid    = 0;
+    bool                failed = false;
+};
 
-    // wait for the child process
-    int wait_status = 0;
-    if(waitpid(pid, &wait_status, 0) != pid)
-        throw std::runtime_error("failed to wait for child process");
-    subprocess_failed = WIFSIGNALED(wait_status) || WEXITSTATUS(wait_status) != 0;
-#endif
+// Run a batch on a helper, starting one if necessary.  A helper that
+// dies is restarted once per batch.  If the restarted helper also
+// fails, the rest of the batch fails so that callers can fall back
+// to compiling in-process.
+static void run_batch(std::unique_ptr<RTCHelperProcess>& helper,
+                      const rtc_helper_batch_t&          batch,
+                      const std::string&                 exe,
+                      const std::string&                 gpu_arch)
+{
+    size_t done = 0;
+    for(int attempt = 0; attempt < 2 && done < batch.size(); ++attempt)
+    {
+        try
+        {
+            if(!helper)
+                helper = std::make_unique<RTCHelperProcess>(exe, gpu_arch);
+            done += helper->compile(rtc_helper_batch_t(batch.begin() + done, batch.end()));
+        }
+        catch(std::exception&)
+        {
+            // helper could not be started
+        }
+        if(helper && !helper->alive())
+            helper.reset();
+    }
+    for(; done < batch.size(); ++done)
+        batch[done]->result.set_exception(
+            std::make_exception_ptr(std::runtime_error("rtc helper process failed")));
+}
 
-    if(code.empty())
+class RTCHelperPool
+{
+public:
+    // pool is a singleton, so no copying or assignment
+    RTCHelperPool(const RTCHelperPool&) = delete;
+    RTCHelperPool& operator=(const RTCHelperPool&) = delete;
+
+    static RTCHelperPool& GetPool()
     {
-        throw std::runtime_error("child process failed to produce code");
+        static RTCHelperPool pool;
+        return pool;
     }
 
-    if(subprocess_failed)
+    std::vector<char>
+        compile(const std::string& exe, const std::string& kernel_src, const std::string& gpu_arch)
     {
-        // stdout of process is actually an error message, so throw that
-        throw std::runtime_error(std::string(code.data(), code.size()));
+        auto req        = std::make_shared<rtc_helper_request_t>();
+        req->kernel_src = kernel_src;
+        auto result     = req->result.get_future();
+
+        std::unique_lock<std::mutex> lock(mtx);
+        auto&                        group = groups[std::make_pair(exe, gpu_arch)];
+        group.pending.push_back(req);
+
+        // if all helpers are busy, one of them will pick up our
+        // request when it finishes its current batch
+        if(group.busy < max_helpers)
+        {
+            ++group.busy;
+            drive(group, lock, exe, gpu_arch);
+            --group.busy;
+        }
+        lock.unlock();
+        return result.get();
     }
-    return code;
+
+    // stop idle helpers, and re-read the maximum number of helpers
+    void setup()
+    {
+        stop_idle();
+        std::lock_guard<std::mutex> lock(mtx);
+        max_helpers = configured_helpers();
+    }
+
+    // stop idle helpers.  Busy helpers are left running and become
+    // idle when their batch is done.
+    void stop_idle()
+    {
+        // helpers wait for their processes to exit when destroyed,
+        // so destroy them outside the lock
+        std::vector<std::unique_ptr<RTCHelperProcess>> stopped;
+        std::lock_guard<std::mutex>                    lock(mtx);
+        for(auto& group : groups)
+        {
+            for(auto& helper : group.second.idle)
+                stopped.push_back(std::move(helper));
+            group.second.idle.clear();
+        }
+    }
+
+private:
+    RTCHelperPool()
+        : max_helpers(configured_helpers())
+    {
+    }
+
+    // read maximum number of helpers from the environment
+    static size_t configured_helpers()
+    {
+        auto str_helpers = rocfft_getenv("ROCFFT_RTC_HELPER_PROCESSES");
+        if(str_helpers.empty())
+            return DEFAULT_MAX_HELPERS;
+        return std::max<size_t>(strtoull(str_helpers.c_str(), nullptr, 0), 1);
+    }
+
+    static const size_t DEFAULT_MAX_HELPERS = 4;
+
+    // helpers for one helper executable and GPU architecture
+    struct group_t
+    {
+        std::deque<std::shared_ptr<rtc_helper_request_t>> pending;
+        std::vector<std::unique_ptr<RTCHelperProcess>>    idle;
+        size_t                                            busy = 0;
+    };
+
+    // take batches of pending requests and run them on one helper,
+    // until there are none left.  lock is held on entry and exit,
+    // but not while compiling.
+    void drive(group_t&                      group,
+               std::unique_lock<std::mutex>& lock,
+               const std::string&            exe,
+               const std::string&            gpu_arch)
+    {
+        std::unique_ptr<RTCHelperProcess> helper;
+        if(!group.idle.empty())
+        {
+            helper = std::move(group.idle.back());
+            group.idle.pop_back();
+        }
+
+        while(!group.pending.empty())
+        {
+            rtc_helper_batch_t batch;
+            while(!group.pending.empty() && batch.size() < RTC_HELPER_MAX_BATCH)
+            {
+                batch.push_back(group.pending.front());
+                group.pending.pop_front();
+            }
+            lock.unlock();
+            run_batch(helper, batch, exe, gpu_arch);
+            lock.lock();
+        }
+
+        if(helper)
+            group.idle.push_back(std::move(helper));
+    }
+
+    std::map<std::pair<std::string, std::string>, group_t> groups;
+    size_t                                                 max_helpers;
+    std::mutex                                             mtx;
+};
+
+std::vector<char> RTCKernel::compile_subprocess(const std::string& kernel_src,
+                                                const std::string& gpu_arch)
+{
+    return RTCHelperPool::GetPool().compile(find_rtc_helper().string(), kernel_src, gpu_arch);
 }
+
+void RTCKernel::SetupHelpers()
+{
+    RTCHelperPool::GetPool().setup();
+}
+
+void RTCKernel::StopHelpers()
+{
+    RTCHelperPool::GetPool().stop_idle();
+}
+#endif
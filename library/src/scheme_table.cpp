@@ -0,0 +1,504 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "scheme_table.h"
+#include "../../shared/environment.h"
+#include "logging.h"
+
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+// Default block-computing splits (length -> divLength1) for 1D
+// transforms, used on every architecture.
+//
+// TODO:
+//   - validate corresponding functions existing in function pool or not
+//   - SBRC should support un-aligned dim with BWD such as 10752 = 84 x 128(bwd=8)
+static const std::map<size_t, size_t> builtin1DLengthSingle = {
+    // ----------------------------------------------------------
+    // pow2 lengths
+    // ----------------------------------------------------------
+    {8192, 64}, //              CC (64cc + 128rc)
+    {16384, 64}, //             CC (64cc + 256rc) // 128x128 no faster
+    {32768, 128}, //            CC (128cc + 256rc)
+    {65536, 256}, //            CC (256cc + 256rc)
+    {131072, 256}, //           CC (256cc + 512rc)
+    {262144, 512}, //           CC (512cc + 512rc)
+
+    // ----------------------------------------------------------
+    // non-pow2 lengths in (4096, 8192)
+    // ----------------------------------------------------------
+    {4704, 96}, //              CC (96cc + 49rc)
+    {4913, 289}, //             CC (289cc + 17rc)
+    {5488, 112}, //             CC (112cc + 49rc)
+    {6144, 96}, //              CC (96cc + 64rc)
+    {6561, 81}, //              CC (81cc + 81rc)
+
+    // ----------------------------------------------------------
+    // non-pow2 lengths in (8192, 16384)
+    // ----------------------------------------------------------
+    {9216, 72}, //              CC (72cc + 128rc)
+    {10000, 100}, //            CC (100cc + 100rc)
+    {10240, 160}, //            CC (160cc + 64rc)
+    {10752, 96}, //             CC (96cc + 112rc)
+    {11200, 224}, //            CC (224cc + 50rc)
+    {12288, 192}, //            CC (192cc + 64rc)
+    {15625, 125}, //            CC (125cc + 125rc)
+
+    // ----------------------------------------------------------
+    // non-pow2 lengths in (16384, 32768)
+    // ----------------------------------------------------------
+    {16807, 343}, //            CC (343cc + 49rc)
+    {17576, 104}, //            CC (104cc + 169rc)
+    {18816, 168}, //            CC (168cc + 112rc)
+    {19200, 192}, //            CC (192cc + 100rc)
+    {19683, 243}, //            CC (243cc + 81rc)
+    {20480, 160}, //            CC (160cc + 128rc)
+    {21504, 168}, //            CC (168cc + 128rc)
+    {21952, 343}, //            CC (343cc + 64rc)
+    {23232, 192}, //            CC (192cc + 121rc)
+    {24576, 192}, //            CC (192cc + 128rc)
+    {26000, 208}, //            CC (208cc + 125rc)
+    {28672, 256}, //            CC (256cc + 112rc)
+    {32256, 168}, //            CC (168cc + 192rc)
+
+    // ----------------------------------------------------------
+    // non-pow2 lengths in (32768, 65536)
+    // ----------------------------------------------------------
+    {34969, 289}, //            CC (289cc + 121rc)
+    {36864, 192}, //            CC (192cc + 192rc)
+    {38880, 160}, //            CC (160cc + 243rc)
+    {40000, 200}, //            CC (200cc + 200rc)
+    {40960, 160}, //            CC (160cc + 256rc)
+    {43008, 168}, //            CC (168cc + 256rc) // CC (224cc + 192rc)
+    {46080, 240}, //            CC (240cc + 192rc)
+    {48000, 240}, //            CC (240cc + 200rc)
+    {49152, 256}, //            CC (256cc + 192rc)
+    {51200, 512}, //            CC (512cc + 100rc)
+    {53248, 208}, //            CC (208cc + 256rc)
+    {57344, 512}, //            CC (512cc + 112rc)
+
+    // ----------------------------------------------------------
+    // non-pow2 lengths in (65536, 131072)
+    // ----------------------------------------------------------
+    {68600, 343}, //            CC (343cc + 200rc)
+    {71344, 208}, //            CC (208cc + 343rc)
+    {73984, 289}, //            CC (289cc + 256rc)
+    {76832, 224}, //            CC (224cc + 343rc)
+    {79860, 60}, //             CC (60cc + 1331rc)
+    {81920, 160}, //            CC (160cc + 512rc)
+    {83521, 289}, //            CC (289cc + 289rc)
+    {87808, 343}, //            CC (343cc + 256rc)
+    {95832, 72}, //             CC (72cc + 1331rc)
+    {98304, 512}, //            CC (512cc + 192rc)
+    {102400, 512}, //           CC (512cc + 200rc)
+    {106496, 208}, //           CC (208cc + 512rc)
+    {110592, 216}, //           CC (216cc + 512rc)
+    {114688, 224}, //           CC (224cc + 512rc)
+};
+
+static const std::map<size_t, size_t> builtin1DLengthDouble = {
+    // ----------------------------------------------------------
+    // pow2 lengths
+    // ----------------------------------------------------------
+    {4096, 64}, //              CC (64cc + 64rc)
+    {8192, 64}, //              CC (64cc + 128rc)
+    {16384, 64}, //             CC (64cc + 256rc) // 128x128 ?
+    {32768, 128}, //            CC (128cc + 256rc)
+    {65536, 256}, //            CC (256cc + 256rc) // {65536, 64}
+    {131072, 256}, //           CC (256cc + 512rc)
+    {262144, 512}, //           CC (512cc + 512rc)
+
+    // ----------------------------------------------------------
+    // non-pow2 lengths in (4096, 8192)
+    // ----------------------------------------------------------
+    {4704, 96}, //              CC (96cc + 49rc)
+    {4913, 289}, //             CC (289cc + 17rc)
+    {5488, 112}, //             CC (112cc + 49rc)
+    {6144, 96}, //              CC (96cc + 64rc)
+    {6561, 81}, //              CC (81cc + 81rc)
+
+    // ----------------------------------------------------------
+    // non-pow2 lengths in (8192, 16384)
+    // ----------------------------------------------------------
+    {9216, 72}, //              CC (72cc + 128rc)
+    {10000, 100}, //            CC (100cc + 100rc)
+    {10240, 160}, //            CC (160cc + 64rc)
+    {10752, 96}, //             CC (96cc + 112rc)
+    {11200, 224}, //            CC (224cc + 50rc)
+    {12288, 192}, //            CC (192cc + 64rc)
+    {15625, 125}, //            CC (125cc + 125rc)
+
+    // ----------------------------------------------------------
+    // non-pow2 lengths in (16384, 32768)
+    // ----------------------------------------------------------
+    {16807, 343}, //            CC (343cc + 49rc)
+    {17576, 104}, //            CC (104cc + 169rc)
+    {18816, 168}, //            CC (168cc + 112rc)
+    {19200, 192}, //            CC (192cc + 100rc)
+    {19683, 243}, //            CC (243cc + 81rc)
+    {20480, 160}, //            CC (160cc + 128rc)
+    {21504, 168}, //            CC (168cc + 128rc)
+    {21952, 343}, //            CC (343cc + 64rc)
+    {23232, 192}, //            CC (192cc + 121rc)
+    {24576, 192}, //            CC (192cc + 128rc)
+    {26000, 208}, //            CC (208cc + 125rc)
+    {28672, 256}, //            CC (256cc + 112rc)
+    {32256, 168}, //            CC (168cc + 192rc)
+
+    // ----------------------------------------------------------
+    // non-pow2 lengths in (32768, 65536)
+    // ----------------------------------------------------------
+    {34969, 289}, //            CC (289cc + 121rc)
+    {36864, 192}, //            CC (192cc + 192rc)
+    {38880, 160}, //            CC (160cc + 243rc)
+    {40000, 200}, //            CC (200cc + 200rc)
+    {40960, 160}, //            CC (160cc + 256rc)
+    {43008, 168}, //            CC (168cc + 256rc) // or (224cc + 192rc)
+    {46080, 240}, //            CC (240cc + 192rc)
+    {48000, 240}, //            CC (240cc + 200rc)
+    {49152, 256}, //            CC (256cc + 192rc)
+    {51200, 512}, //            CC (512cc + 100rc)
+    {53248, 208}, //            CC (208cc + 256rc)
+    {57344, 512}, //            CC (512cc + 112rc)
+
+    // ----------------------------------------------------------
+    // non-pow2 lengths in (65536, 131072)
+    // ----------------------------------------------------------
+    {68600, 343}, //            CC (343cc + 200rc)
+    {71344, 208}, //            CC (208cc + 343rc)
+    {76832, 224}, //            CC (224cc + 343rc)
+    {78125, 125}, //            CC (125cc + 625rc)
+    {79860, 60}, //             CC (60cc + 1331rc)
+    {81920, 160}, //            CC (160cc + 512rc)
+    {83521, 289}, //            CC (289cc + 289rc)
+    {87808, 343}, //            CC (343cc + 256rc)
+    {95832, 72}, //             CC (72cc + 1331rc)
+    {98304, 512}, //            CC (512cc + 192rc)
+    {102400, 512}, //           CC (512cc + 200rc)
+    {106496, 208}, //           CC (208cc + 512rc)
+    {110592, 216}, //           CC (216cc + 512rc)
+    {114688, 224}, //           CC (224cc + 512rc)
+};
+
+#define TO_STR2(x) #x
+#define TO_STR(x) TO_STR2(x)
+#define ENUMSTR(x) x, TO_STR(x)
+
+static const std::map<FuseType, const char*>& FuseTypeToStringMap()
+{
+    static const std::map<FuseType, const char*> FuseTypeToString
+        = {{ENUMSTR(FT_TRANS_WITH_STOCKHAM)},
+           {ENUMSTR(FT_STOCKHAM_WITH_TRANS)},
+           {ENUMSTR(FT_STOCKHAM_WITH_TRANS_Z_XY)},
+           {ENUMSTR(FT_STOCKHAM_WITH_TRANS_XY_Z)},
+           {ENUMSTR(FT_R2C_TRANSPOSE)},
+           {ENUMSTR(FT_TRANSPOSE_C2R)},
+           {ENUMSTR(FT_STOCKHAM_R2C_TRANSPOSE)}};
+    return FuseTypeToString;
+}
+
+static FuseType StrToFuseType(const std::string& str)
+{
+    for(const auto& i : FuseTypeToStringMap())
+    {
+        if(str == i.second)
+            return i.first;
+    }
+    throw std::runtime_error("unknown fuse type: " + str);
+}
+
+SchemeTable SchemeTable::BuiltIn()
+{
+    SchemeTable table;
+
+    for(const auto& i : builtin1DLengthSingle)
+        table.Add("any", rocfft_precision_single, {i.first}, {CS_L1D_CC, i.second, {}});
+    for(const auto& i : builtin1DLengthDouble)
+        table.Add("any", rocfft_precision_double, {i.first}, {CS_L1D_CC, i.second, {}});
+
+    // for gfx906, 512 CC/RC isn't as fast, so use CRT with a nicer
+    // length
+    table.Add("gfx906", rocfft_precision_single, {262144}, {CS_L1D_CRT, 64, {}});
+    table.Add("gfx906", rocfft_precision_double, {262144}, {CS_L1D_CRT, 64, {}});
+
+    // for 43008 on gfx90a, 224 is better
+    table.Add("gfx90a", rocfft_precision_double, {43008}, {CS_L1D_CC, 224, {}});
+
+    // on gfx906, fusing a length-168 Stockham kernel with the
+    // following transpose is slower
+    table.Add("gfx906", rocfft_precision_single, {168}, {CS_NONE, 0, {FT_STOCKHAM_WITH_TRANS}});
+    table.Add("gfx906", rocfft_precision_double, {168}, {CS_NONE, 0, {FT_STOCKHAM_WITH_TRANS}});
+
+    return table;
+}
+
+// process-wide table, and the override for the current thread
+static std::mutex                                      table_mutex;
+static std::shared_ptr<const SchemeTable>              process_table;
+static thread_local std::shared_ptr<const SchemeTable> override_table;
+
+static std::shared_ptr<const SchemeTable> LoadProcessTable()
+{
+    auto table = std::make_shared<SchemeTable>(SchemeTable::BuiltIn());
+
+    auto path = rocfft_getenv("ROCFFT_SCHEME_TABLE");
+    if(path.empty())
+        return table;
+
+    try
+    {
+        std::ifstream file(path);
+        if(!file)
+            throw std::runtime_error("cannot open file");
+        table->Load(file);
+        log_trace("scheme_table", "load", "path", path, "entries", table->size());
+    }
+    catch(std::exception& e)
+    {
+        rocfft_cerr << "rocFFT: ignoring scheme table " << path << ": " << e.what() << std::endl;
+    }
+    return table;
+}
+
+std::shared_ptr<const SchemeTable> SchemeTable::GetSchemeTable()
+{
+    if(override_table)
+        return override_table;
+
+    std::lock_guard<std::mutex> lck(table_mutex);
+    if(!process_table)
+        process_table = LoadProcessTable();
+    return process_table;
+}
+
+void SchemeTable::Install(const std::string&         arch,
+                          rocfft_precision           precision,
+                          const std::vector<size_t>& length,
+                          const SchemeTuning&        tuning)
+{
+    std::lock_guard<std::mutex> lck(table_mutex);
+    if(!process_table)
+        process_table = LoadProcessTable();
+    auto table = std::make_shared<SchemeTable>(*process_table);
+    table->Add(arch, precision, length, tuning);
+    process_table = table;
+}
+
+void SchemeTable::Reset()
+{
+    std::lock_guard<std::mutex> lck(table_mutex);
+    process_table.reset();
+}
+
+SchemeTable::ScopedOverride::ScopedOverride(std::shared_ptr<const SchemeTable> table)
+    : previous(override_table)
+{
+    override_table = table;
+}
+
+SchemeTable::ScopedOverride::~ScopedOverride()
+{
+    override_table = previous;
+}
+
+bool SchemeTable::ScopedOverride::Active()
+{
+    return override_table != nullptr;
+}
+
+std::string SchemeTable::ArchName(const std::string& arch)
+{
+    return arch.substr(0, arch.find(':'));
+}
+
+const SchemeTuning* SchemeTable::Find(const std::vector<size_t>& length,
+                                      size_t                     dimension,
+                                      rocfft_precision           precision,
+                                      const std::string&         arch) const
+{
+    if(dimension == 0 || dimension > length.size())
+        return nullptr;
+    std::vector<size_t> problem(length.begin(), length.begin() + dimension);
+
+    auto archEntry = entries.find(std::make_tuple(problem, precision, ArchName(arch)));
+    if(archEntry != entries.end())
+        return &archEntry->second;
+
+    auto anyEntry = entries.find(std::make_tuple(problem, precision, std::string("any")));
+    if(anyEntry != entries.end())
+        return &anyEntry->second;
+
+    return nullptr;
+}
+
+std::vector<size_t> SchemeTable::Lengths1D(rocfft_precision precision,
+                                           ComputeScheme    scheme) const
+{
+    std::set<size_t> lengths;
+    for(const auto& entry : entries)
+    {
+        const auto& length = std::get<0>(entry.first);
+        if(length.size() == 1 && std::get<1>(entry.first) == precision
+           && entry.second.scheme == scheme)
+            lengths.insert(length.front());
+    }
+    return {lengths.begin(), lengths.end()};
+}
+
+void SchemeTable::Add(const std::string&         arch,
+                      rocfft_precision           precision,
+                      const std::vector<size_t>& length,
+                      const SchemeTuning&        tuning)
+{
+    entries[std::make_tuple(length, precision, ArchName(arch))] = tuning;
+}
+
+// split a string on a separator character
+static std::vector<std::string> split(const std::string& str, char sep)
+{
+    std::vector<std::string> ret;
+    std::stringstream        ss(str);
+    std::string              token;
+    while(std::getline(ss, token, sep))
+        ret.push_back(token);
+    return ret;
+}
+
+static size_t parse_size(const std::string& str)
+{
+    size_t pos = 0;
+    size_t ret = 0;
+    try
+    {
+        ret = std::stoull(str, &pos);
+    }
+    catch(std::exception&)
+    {
+        pos = 0;
+    }
+    if(str.empty() || pos != str.size())
+        throw std::runtime_error("invalid number: " + str);
+    return ret;
+}
+
+void SchemeTable::Load(std::istream& is)
+{
+    // parse into a separate table, so that errors leave this one
+    // untouched
+    SchemeTable  loaded;
+    bool         haveVersion = false;
+    std::string  line;
+    unsigned int lineNum = 0;
+    while(std::getline(is, line))
+    {
+        ++lineNum;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream       ls(line);
+        std::vector<std::string> fields;
+        std::string              field;
+        while(ls >> field)
+            fields.push_back(field);
+        if(fields.empty())
+            continue;
+
+        try
+        {
+            if(!haveVersion)
+            {
+                if(fields.size() != 2 || fields[0] != "rocfft_scheme_table")
+                    throw std::runtime_error("missing rocfft_scheme_table header");
+                auto version = parse_size(fields[1]);
+                if(version != VERSION)
+                    throw std::runtime_error("unsupported version " + fields[1]);
+                haveVersion = true;
+                continue;
+            }
+
+            if(fields.size() != 5 && fields.size() != 6)
+                throw std::runtime_error("expected 5 or 6 fields");
+
+            rocfft_precision precision;
+            if(fields[1] == "single")
+                precision = rocfft_precision_single;
+            else if(fields[1] == "double")
+                precision = rocfft_precision_double;
+            else
+                throw std::runtime_error("invalid precision: " + fields[1]);
+
+            std::vector<size_t> length;
+            for(const auto& len : split(fields[2], 'x'))
+                length.push_back(parse_size(len));
+            if(length.empty() || length.size() > 3)
+                throw std::runtime_error("invalid lengths: " + fields[2]);
+
+            SchemeTuning tuning;
+            if(fields[3] != "-")
+                tuning.scheme = StrToComputeScheme(fields[3]);
+            tuning.factor = parse_size(fields[4]);
+            if(fields.size() == 6)
+            {
+                for(const auto& fuse : split(fields[5], ','))
+                    tuning.disabledFusions.insert(StrToFuseType(fuse));
+            }
+
+            loaded.Add(fields[0], precision, length, tuning);
+        }
+        catch(std::exception& e)
+        {
+            throw std::runtime_error("line " + std::to_string(lineNum) + ": " + e.what());
+        }
+    }
+    if(!haveVersion)
+        throw std::runtime_error("missing rocfft_scheme_table header");
+
+    for(auto& entry : loaded.entries)
+        entries[entry.first] = std::move(entry.second);
+}
+
+void SchemeTable::Write(std::ostream& os) const
+{
+    os << "rocfft_scheme_table " << VERSION << "\n";
+    os << "# arch precision lengths scheme factor [disabled fusions]\n";
+    for(const auto& entry : entries)
+    {
+        const auto& length = std::get<0>(entry.first);
+        const auto& tuning = entry.second;
+
+        os << std::get<2>(entry.first) << " "
+           << (std::get<1>(entry.first) == rocfft_precision_single ? "single" : "double") << " ";
+        for(size_t i = 0; i < length.size(); ++i)
+        {
+            if(i > 0)
+                os << "x";
+            os << length[i];
+        }
+        os << " " << (tuning.scheme == CS_NONE ? "-" : PrintScheme(tuning.scheme)) << " "
+           << tuning.factor;
+        for(auto fuse = tuning.disabledFusions.begin(); fuse != tuning.disabledFusions.end();
+            ++fuse)
+            os << (fuse == tuning.disabledFusions.begin() ? " " : ",")
+               << FuseTypeToStringMap().at(*fuse);
+        os << "\n";
+    }
+}
@@ -28,8 +28,10 @@
 #include "../../shared/array_predicate.h"
 #include "logging.h"
 #include "plan.h"
+#include "repo.h"
 #include "rocfft.h"
 #include "transform.h"
+#include "work_buffer_pool.h"
 
 rocfft_status rocfft_execution_info_create(rocfft_execution_info* info)
 {
@@ -69,6 +71,16 @@ rocfft_status rocfft_execution_info_set_stream(rocfft_execution_info info, void*
     return rocfft_status_success;
 }
 
+rocfft_status rocfft_execution_info_set_launch_mode(rocfft_execution_info info,
+                                                    rocfft_launch_mode    mode)
+{
+    log_trace(__func__, "info", info, "mode", mode);
+    if(mode != rocfft_launch_mode_direct && mode != rocfft_launch_mode_graph)
+        return rocfft_status_invalid_arg_value;
+    info->launchMode = mode;
+    return rocfft_status_success;
+}
+
 rocfft_status rocfft_execution_info_set_load_callback(rocfft_execution_info info,
                                                       void**                cb_functions,
                                                       void**                cb_data,
@@ -101,6 +113,47 @@ rocfft_status rocfft_execution_info_set_store_callback(rocfft_execution_info inf
     return rocfft_status_success;
 }
 
+rocfft_status rocfft_work_buffer_pool_trim(size_t keep_bytes)
+{
+    log_trace(__func__, "keep_bytes", keep_bytes);
+    WorkBufferPool::GetWorkBufferPool().Trim(keep_bytes);
+    return rocfft_status_success;
+}
+
+rocfft_status
+    rocfft_twiddle_get_stats(int device_id, size_t* buffers, size_t* size_bytes, size_t* tables)
+{
+    log_trace(__func__, "device_id", device_id);
+
+    size_t numBuffers = 0;
+    size_t bytes      = 0;
+    size_t numTables  = 0;
+    Repo::GetStats(device_id, numBuffers, bytes, numTables);
+    if(buffers)
+        *buffers = numBuffers;
+    if(size_bytes)
+        *size_bytes = bytes;
+    if(tables)
+        *tables = numTables;
+    return rocfft_status_success;
+}
+
+// Move buffers of the given type forward by offset_elems elements
+static void OffsetBuffers(void*             buffer[],
+                          rocfft_array_type type,
+                          size_t            base_type_size,
+                          size_t            offset_elems,
+                          void*             offset_buffer[2])
+{
+    const bool planar       = array_type_is_planar(type);
+    const auto elem_bytes   = (type == rocfft_array_type_real || planar) ? base_type_size
+                                                                         : base_type_size * 2;
+    const auto offset_bytes = offset_elems * elem_bytes;
+
+    offset_buffer[0] = static_cast<char*>(buffer[0]) + offset_bytes;
+    offset_buffer[1] = planar ? static_cast<char*>(buffer[1]) + offset_bytes : nullptr;
+}
+
 rocfft_status rocfft_execute(const rocfft_plan     plan,
                              void*                 in_buffer[],
                              void*                 out_buffer[],
@@ -113,6 +166,10 @@ rocfft_status rocfft_execute(const rocfft_plan     plan,
         return rocfft_status_failure;
     const ExecPlan& execPlan = plan->execPlan;
 
+    // plans decided without a device have no kernels to launch
+    if(execPlan.deviceFree)
+        return rocfft_status_failure;
+
     if(LOG_PLAN_ENABLED())
         PrintNode(*LogSingleton::GetInstance().GetPlanOS(), execPlan);
 
@@ -121,16 +178,26 @@ rocfft_status rocfft_execute(const rocfft_plan     plan,
     if(info)
         exec_info = *info;
 
-    gpubuf autoAllocWorkBuf;
+    // returned to the pool once the transform is queued
+    WorkBufferPool::buffer_t autoAllocWorkBuf;
 
     if(execPlan.workBufSize > 0)
     {
-        auto requiredWorkBufBytes = execPlan.WorkBufBytes(plan->base_type_size);
+        auto requiredWorkBufBytes = plan->WorkBufBytes();
         if(!exec_info.workBuffer)
         {
-            // user didn't provide a buffer, alloc one now
-            if(autoAllocWorkBuf.alloc(requiredWorkBufBytes) != hipSuccess)
+            // user didn't provide a buffer, borrow one from the pool
+            try
+            {
+                autoAllocWorkBuf = WorkBufferPool::GetWorkBufferPool().Acquire(
+                    requiredWorkBufBytes, exec_info.rocfft_stream);
+            }
+            catch(std::exception& e)
+            {
+                if(LOG_TRACE_ENABLED())
+                    (*LogSingleton::GetInstance().GetTraceOS()) << e.what() << std::endl;
                 return rocfft_status_failure;
+            }
             exec_info.workBufferSize = requiredWorkBufBytes;
             exec_info.workBuffer     = autoAllocWorkBuf.data();
         }
@@ -145,12 +212,44 @@ rocfft_status rocfft_execute(const rocfft_plan     plan,
        && (exec_info.callbacks.load_cb_fn || exec_info.callbacks.store_cb_fn))
         return rocfft_status_failure;
 
+    // Callbacks are given offsets from the start of the buffers they
+    // were set for, which chunks would move
+    if(plan->chunkBatch && (exec_info.callbacks.load_cb_fn || exec_info.callbacks.store_cb_fn))
+        return rocfft_status_failure;
+
+    if(plan->placement == rocfft_placement_inplace)
+        out_buffer = in_buffer;
+
     try
     {
-        TransformPowX(execPlan,
-                      in_buffer,
-                      (plan->placement == rocfft_placement_inplace) ? in_buffer : out_buffer,
-                      &exec_info);
+        if(!plan->chunkBatch)
+            TransformPowX(execPlan, plan->launchCache, in_buffer, out_buffer, &exec_info);
+        else
+        {
+            // chunks run one after another on the same stream, so
+            // they can all use the same work buffer
+            for(size_t chunk = 0; chunk < plan->chunkCount; ++chunk)
+            {
+                const bool last      = chunk == plan->chunkCount - 1;
+                auto&      chunkPlan = last && plan->remainderPlan ? *plan->remainderPlan : *plan;
+
+                const size_t firstTransform = chunk * plan->chunkBatch;
+                void*        chunkIn[2];
+                void*        chunkOut[2];
+                OffsetBuffers(in_buffer,
+                              plan->desc.inArrayType,
+                              plan->base_type_size,
+                              firstTransform * plan->desc.inDist,
+                              chunkIn);
+                OffsetBuffers(out_buffer,
+                              plan->desc.outArrayType,
+                              plan->base_type_size,
+                              firstTransform * plan->desc.outDist,
+                              chunkOut);
+                TransformPowX(
+                    chunkPlan.execPlan, chunkPlan.launchCache, chunkIn, chunkOut, &exec_info);
+            }
+        }
     }
     catch(std::exception& e)
     {
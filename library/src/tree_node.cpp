@@ -29,15 +29,12 @@ TreeNode::~TreeNode()
 {
     if(twiddles)
     {
-        if(scheme == CS_KERNEL_2D_SINGLE)
-            Repo::ReleaseTwiddle2D(twiddles);
-        else
-            Repo::ReleaseTwiddle1D(twiddles);
+        Repo::ReleaseTwiddles(twiddles);
         twiddles = nullptr;
     }
     if(twiddles_large)
     {
-        Repo::ReleaseTwiddle1D(twiddles_large);
+        Repo::ReleaseTwiddles(twiddles_large);
         twiddles_large = nullptr;
     }
 }
@@ -116,10 +113,9 @@ void LeafNode::SanityCheck()
     TreeNode::SanityCheck();
 }
 
-bool LeafNode::CreateDevKernelArgs()
+size_t LeafNode::AppendKernelArgs(std::vector<size_t>& kernArgs)
 {
-    devKernArg = kargs_create(length, inStride, outStride, iDist, oDist);
-    return (devKernArg != nullptr);
+    return kargs_append(kernArgs, length, inStride, outStride, iDist, oDist);
 }
 
 bool LeafNode::CreateTwiddleTableResource()
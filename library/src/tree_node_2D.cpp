@@ -24,6 +24,7 @@
 #include "fuse_shim.h"
 #include "node_factory.h"
 #include "repo.h"
+#include <numeric>
 
 /*****************************************************
  * 2D_RTRT  *
@@ -217,10 +218,10 @@ void Single2DNode::SetupGPAndFnPtr_internal(DevFnCall& fnPtr, GridParam& gp)
     auto padded_len0 = IsPo2(length[0]) ? length[0] + 1 : length[0];
     lds              = padded_len0 * length[1] * bwd;
 
-    // if we're doing 3D transform, we need to repeat the 2D
-    // transform in the 3rd dimension
-    if(length.size() > 2)
-        gp.b_x *= length[2];
+    // if we're doing a 3D or higher transform, we need to repeat
+    // the 2D transform in each higher dimension
+    gp.b_x *= std::accumulate(
+        length.begin() + 2, length.end(), static_cast<size_t>(1), std::multiplies<size_t>());
 
     return;
 }
@@ -569,11 +569,12 @@ void RC3DNode::AssignParams_internal()
 
     xyPlan->AssignParams();
 
-    zPlan->inStride.push_back(inStride[2]);
-    zPlan->inStride.push_back(inStride[0]);
-    zPlan->inStride.push_back(inStride[1]);
+    // z columns are in-place on the xy plan's output
+    zPlan->inStride.push_back(xyPlan->outStride[2]);
+    zPlan->inStride.push_back(xyPlan->outStride[0]);
+    zPlan->inStride.push_back(xyPlan->outStride[1]);
     for(size_t index = 3; index < length.size(); index++)
-        zPlan->inStride.push_back(inStride[index]);
+        zPlan->inStride.push_back(xyPlan->outStride[index]);
 
     zPlan->iDist = xyPlan->oDist;
 
@@ -713,7 +714,7 @@ void RealCmplxTransZ_XYNode::SetupGPAndFnPtr_internal(DevFnCall& fnPtr, GridPara
     gp.wgs_x      = kernel.workgroup_size;
 }
 
-bool RealCmplxTransZ_XYNode::CreateDevKernelArgs()
+size_t RealCmplxTransZ_XYNode::AppendKernelArgs(std::vector<size_t>& kernArgs)
 {
     // We have a case where this 3D kernel is shoehorned into a 2D plan.
     // If so, add a third dimension when creating kernel args.
@@ -723,5 +724,5 @@ bool RealCmplxTransZ_XYNode::CreateDevKernelArgs()
         inStride.push_back(inStride.back());
         outStride.push_back(outStride.back());
     }
-    return SBRCTranspose3DNode::CreateDevKernelArgs();
+    return SBRCTranspose3DNode::AppendKernelArgs(kernArgs);
 }
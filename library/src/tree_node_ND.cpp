@@ -0,0 +1,142 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "tree_node_ND.h"
+#include "function_pool.h"
+#include "node_factory.h"
+
+std::vector<size_t> DimToFront(const std::vector<size_t>& v, size_t dim)
+{
+    std::vector<size_t> ret;
+    ret.reserve(v.size());
+    ret.push_back(v[dim]);
+    for(size_t index = 0; index < v.size(); index++)
+    {
+        if(index != dim)
+            ret.push_back(v[index]);
+    }
+    return ret;
+}
+
+std::unique_ptr<TreeNode>
+    CreateColumnNode(TreeNode* parent, const std::vector<size_t>& length, size_t dim)
+{
+    // the remaining dimensions stay in order behind the column
+    // dimension, so contiguous ones still collapse into one.
+    //
+    // TODO: SBCC hasn't worked for inner batch (i/oDist == 1), so
+    // those columns get an explicit 1D node like any other length
+    std::unique_ptr<TreeNode> colPlan;
+    if(parent->iDist != 1 && parent->oDist != 1
+       && function_pool::has_SBCC_kernel(length[dim], parent->precision))
+    {
+        colPlan            = NodeFactory::CreateNodeFromScheme(CS_KERNEL_STOCKHAM_BLOCK_CC, parent);
+        colPlan->length    = DimToFront(length, dim);
+        colPlan->dimension = 1;
+        colPlan->large1D   = 0; // No twiddle factor in sbcc kernel
+    }
+    else
+    {
+        NodeMetaData colPlanData(parent);
+        colPlanData.length       = DimToFront(length, dim);
+        colPlanData.dimension    = 1;
+        colPlanData.outputLength = colPlanData.length;
+        colPlan                  = NodeFactory::CreateExplicitNode(colPlanData, parent);
+        colPlan->RecursiveBuildTree();
+    }
+    return colPlan;
+}
+
+/*****************************************************
+ * CS_ND_RC  *
+ *****************************************************/
+void RCNDNode::BuildTree_internal()
+{
+    // Only the innermost dimensions are contiguous enough for
+    // multi-dimensional kernels to be worthwhile.  Take as many of
+    // them as can be done without transposes into one node.  Every
+    // other dimension is then one in-place pass of column FFTs, which
+    // reads and writes the data once without needing temp buffers.
+    NodeMetaData innerPlanData(this);
+    innerPlanData.length    = length;
+    innerPlanData.iDist     = iDist;
+    innerPlanData.oDist     = oDist;
+    innerPlanData.dimension = 3;
+
+    ComputeScheme innerScheme = CS_NONE;
+    if(NodeFactory::use_CS_3D_RC(innerPlanData))
+        innerScheme = CS_3D_RC;
+    else
+    {
+        innerPlanData.dimension = 2;
+        if(NodeFactory::use_CS_2D_SINGLE(innerPlanData))
+            innerScheme = CS_KERNEL_2D_SINGLE;
+        else if(NodeFactory::use_CS_2D_RC(innerPlanData))
+            innerScheme = CS_2D_RC;
+        else
+            innerPlanData.dimension = 1;
+    }
+
+    // NB:
+    //   The inner node is created from the scheme directly, since
+    //   the other 3D schemes don't carry the higher dimensions.
+    std::unique_ptr<TreeNode> innerPlan;
+    if(innerScheme != CS_NONE)
+    {
+        innerPlan = NodeFactory::CreateNodeFromScheme(innerScheme, this);
+        innerPlan->CopyNodeData(innerPlanData);
+    }
+    else
+        innerPlan = NodeFactory::CreateExplicitNode(innerPlanData, this);
+    innerPlan->RecursiveBuildTree();
+    childNodes.emplace_back(std::move(innerPlan));
+
+    for(size_t dim = innerPlanData.dimension; dim < length.size(); ++dim)
+        childNodes.emplace_back(CreateColumnNode(this, length, dim));
+}
+
+void RCNDNode::AssignParams_internal()
+{
+    auto& innerPlan = childNodes.front();
+
+    innerPlan->inStride = inStride;
+    innerPlan->iDist    = iDist;
+
+    innerPlan->outStride = outStride;
+    innerPlan->oDist     = oDist;
+
+    innerPlan->AssignParams();
+
+    // the columns work in-place on the inner node's output, along
+    // the dimensions it didn't do
+    const size_t innerDims = length.size() - (childNodes.size() - 1);
+    for(size_t i = 1; i < childNodes.size(); ++i)
+    {
+        auto&  colPlan = childNodes[i];
+        size_t dim     = innerDims + i - 1;
+
+        colPlan->inStride = DimToFront(innerPlan->outStride, dim);
+        colPlan->iDist    = innerPlan->oDist;
+
+        colPlan->outStride = colPlan->inStride;
+        colPlan->oDist     = colPlan->iDist;
+        colPlan->AssignParams();
+    }
+}
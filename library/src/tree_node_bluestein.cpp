@@ -20,35 +20,47 @@
 
 #include "tree_node_bluestein.h"
 #include "kernel_launch.h"
+#include "function_pool.h"
+#include "logging.h"
 #include "node_factory.h"
+#include "perf_model.h"
+#include "repo.h"
+#include "scheme_table.h"
+#include <limits>
 #include <numeric>
+#include <set>
+#include <sstream>
 
-inline size_t FindBlue(size_t len, rocfft_precision precision)
+// Lengths the convolution in a Bluestein transform of length len
+// could be done with: every supported length from 2*len-1 up to the
+// next power of two, and that power of two, which always works.
+static std::vector<size_t> BlueCandidates(size_t len, rocfft_precision precision)
 {
     size_t lenPow2 = 1;
     while(lenPow2 < len)
         lenPow2 <<= 1;
 
     size_t minLenBlue  = 2 * len - 1;
-    size_t length      = minLenBlue;
     size_t lenPow2Blue = 2 * lenPow2;
 
-    // We don't want to choose a non-pow2 length that is too close to lenPow2Blue,
-    // otherwise using a non-pow2 length may end up being slower than using lenPow2Blue.
-    // This ratio has been experimentally verified to yield a non-pow2 length that is at
-    // least as fast as its corresponding pow2 length.
-    double lenCutOffRatio = .9;
-
-    for(length = minLenBlue; length < lenPow2Blue; ++length)
+    // supported lengths have a single kernel, or a tuned block CC
+    // decomposition
+    std::set<size_t> lengths;
+    for(auto length : function_pool::get_lengths(precision, CS_KERNEL_STOCKHAM))
+        lengths.insert(length);
+    for(auto length : SchemeTable::GetSchemeTable()->Lengths1D(precision, CS_L1D_CC))
+        lengths.insert(length);
+
+    std::vector<size_t> candidates;
+    for(auto length = lengths.lower_bound(minLenBlue);
+        length != lengths.end() && *length < lenPow2Blue;
+        ++length)
     {
-        auto lenSupported = NodeFactory::NonPow2LengthSupported(precision, length);
-        auto lenRatio     = static_cast<double>(length) / static_cast<double>(lenPow2Blue);
-
-        if(lenSupported && lenRatio < lenCutOffRatio)
-            break;
+        if(NodeFactory::NonPow2LengthSupported(precision, *length))
+            candidates.push_back(*length);
     }
-
-    return length;
+    candidates.push_back(lenPow2Blue);
+    return candidates;
 }
 
 /*****************************************************
@@ -59,16 +71,61 @@ void BluesteinNode::BuildTree_internal()
     // Build a node for a 1D stage using the Bluestein algorithm for
     // general transform lengths.
 
-    lengthBlue = FindBlue(length[0], precision);
+    // build the transform with each length the convolution could
+    // use, and keep the one the performance model says is fastest
+    auto        device     = DeviceModel::FromDeviceProp(deviceProp);
+    double      bestTimeUs = std::numeric_limits<double>::max();
+    size_t      bestLength = 0;
+    std::string buildError;
+    decltype(childNodes) bestChildren;
+    // estimate for each candidate, for the plan log
+    std::ostringstream estimates;
+    for(auto candidate : BlueCandidates(length[0], precision))
+    {
+        childNodes.clear();
+        lengthBlue = candidate;
+        try
+        {
+            BuildChildren();
+        }
+        catch(std::exception& e)
+        {
+            buildError = e.what();
+            estimates << " " << candidate << "=failed";
+            continue;
+        }
+
+        std::vector<TreeNode*> leaves;
+        std::vector<FuseShim*> fuseShims;
+        for(auto& child : childNodes)
+            child->CollectLeaves(leaves, fuseShims);
+        double timeUs = 0.0;
+        for(auto leaf : leaves)
+            timeUs += EstimateNode(*leaf, device).timeUs;
+        estimates << " " << candidate << "=" << timeUs << "us";
+
+        if(timeUs < bestTimeUs)
+        {
+            bestTimeUs   = timeUs;
+            bestLength   = candidate;
+            bestChildren = std::move(childNodes);
+        }
+    }
+    if(!bestLength)
+        throw std::runtime_error("no Bluestein length could be built for length "
+                                 + std::to_string(length[0]) + ": " + buildError);
 
-    auto chirpPlan       = NodeFactory::CreateNodeFromScheme(CS_KERNEL_CHIRP, this);
-    chirpPlan->dimension = 1;
-    chirpPlan->length.push_back(length[0]);
-    chirpPlan->lengthBlue = lengthBlue;
-    chirpPlan->direction  = direction;
-    chirpPlan->batch      = 1;
-    chirpPlan->large1D    = 2 * length[0];
+    lengthBlue = bestLength;
+    childNodes = std::move(bestChildren);
 
+    if(LOG_PLAN_ENABLED())
+        (*LogSingleton::GetInstance().GetPlanOS())
+            << "Bluestein length " << length[0] << " convolution estimates:" << estimates.str()
+            << ", chosen " << lengthBlue << std::endl;
+}
+
+void BluesteinNode::BuildChildren()
+{
     auto padmulPlan        = NodeFactory::CreateNodeFromScheme(CS_KERNEL_PAD_MUL, this);
     padmulPlan->dimension  = 1;
     padmulPlan->length     = length;
@@ -79,10 +136,7 @@ void BluesteinNode::BuildTree_internal()
     ffticPlanData.length.push_back(lengthBlue);
     ffticPlanData.batch
         *= std::accumulate(length.begin() + 1, length.end(), 1, std::multiplies<size_t>());
-    ffticPlanData.batch++;
-    ffticPlanData.iOffset = lengthBlue;
-    ffticPlanData.oOffset = lengthBlue;
-    auto ffticPlan        = NodeFactory::CreateExplicitNode(ffticPlanData, this);
+    auto ffticPlan = NodeFactory::CreateExplicitNode(ffticPlanData, this);
     ffticPlan->RecursiveBuildTree();
 
     auto fftmulPlan       = NodeFactory::CreateNodeFromScheme(CS_KERNEL_FFT_MUL, this);
@@ -102,8 +156,6 @@ void BluesteinNode::BuildTree_internal()
         fftrPlanData.length.push_back(length[index]);
     }
     fftrPlanData.direction = -direction;
-    fftrPlanData.iOffset   = 2 * lengthBlue;
-    fftrPlanData.oOffset   = 2 * lengthBlue;
     auto fftrPlan          = NodeFactory::CreateExplicitNode(fftrPlanData, this);
     fftrPlan->RecursiveBuildTree();
 
@@ -112,8 +164,8 @@ void BluesteinNode::BuildTree_internal()
     resmulPlan->length     = length;
     resmulPlan->lengthBlue = lengthBlue;
 
-    // 6 node of bluestein
-    childNodes.emplace_back(std::move(chirpPlan));
+    // 5 nodes of bluestein.  the chirp and its FFT are precomputed
+    // and shared through the repo, so they aren't nodes
     childNodes.emplace_back(std::move(padmulPlan));
     childNodes.emplace_back(std::move(ffticPlan));
     childNodes.emplace_back(std::move(fftmulPlan));
@@ -123,17 +175,11 @@ void BluesteinNode::BuildTree_internal()
 
 void BluesteinNode::AssignParams_internal()
 {
-    auto& chirpPlan  = childNodes[0];
-    auto& padmulPlan = childNodes[1];
-    auto& ffticPlan  = childNodes[2];
-    auto& fftmulPlan = childNodes[3];
-    auto& fftrPlan   = childNodes[4];
-    auto& resmulPlan = childNodes[5];
-
-    chirpPlan->inStride.push_back(1);
-    chirpPlan->iDist = chirpPlan->lengthBlue;
-    chirpPlan->outStride.push_back(1);
-    chirpPlan->oDist = chirpPlan->lengthBlue;
+    auto& padmulPlan = childNodes[0];
+    auto& ffticPlan  = childNodes[1];
+    auto& fftmulPlan = childNodes[2];
+    auto& fftrPlan   = childNodes[3];
+    auto& resmulPlan = childNodes[4];
 
     padmulPlan->inStride = inStride;
     padmulPlan->iDist    = iDist;
@@ -146,8 +192,9 @@ void BluesteinNode::AssignParams_internal()
         padmulPlan->oDist *= length[index];
     }
 
-    ffticPlan->inStride  = chirpPlan->outStride;
-    ffticPlan->iDist     = chirpPlan->oDist;
+    // the input FFT treats higher dimensions as batch
+    ffticPlan->inStride  = {1};
+    ffticPlan->iDist     = lengthBlue;
     ffticPlan->outStride = ffticPlan->inStride;
     ffticPlan->oDist     = ffticPlan->iDist;
 
@@ -173,12 +220,22 @@ void BluesteinNode::AssignParams_internal()
 
 /*****************************************************
  * Component of Bluestein
- * Chirp, XXXMul
+ * XXXMul
  *****************************************************/
+bool BluesteinComponentNode::CreateTwiddleTableResource()
+{
+    // the multiplies all use the chirp, and FFT_MUL uses its FFT.
+    // FFT_MUL's length is the convolution length, so the transform
+    // length comes from the Bluestein node.
+    std::tie(twiddles, twiddles_size)
+        = Repo::GetChirp(parent->length[0], lengthBlue, precision, direction);
+    return twiddles != nullptr;
+}
+
 void BluesteinComponentNode::SetupGPAndFnPtr_internal(DevFnCall& fnPtr, GridParam& gp)
 {
     gp.wgs_x = 64;
-    fnPtr    = (scheme == CS_KERNEL_CHIRP) ? &FN_PRFX(chirp) : &FN_PRFX(mul);
+    fnPtr    = &FN_PRFX(mul);
 
     return;
 }
@@ -23,6 +23,7 @@
 #include "function_pool.h"
 #include "node_factory.h"
 #include "real2complex.h"
+#include "tree_node_ND.h"
 
 // work out the real and complex lengths on a real-complex plan, and
 // return pointers to those lengths
@@ -1414,6 +1415,106 @@ void Real3DEvenNode::AssignParams_internal_TR_pairs()
     }
 }
 
+/*****************************************************
+ * CS_REAL_ND_EVEN
+ *****************************************************/
+void RealNDEvenNode::BuildTree_internal()
+{
+    // Fastest moving dimension must be even:
+    assert(length[0] % 2 == 0);
+    const std::vector<size_t>* realLength    = nullptr;
+    const std::vector<size_t>* complexLength = nullptr;
+    set_complex_length(*this, realLength, complexLength);
+
+    // like the INPLACE_SBCC solution of CS_REAL_2D_EVEN, with a
+    // column pass for each higher dimension
+    if(inArrayType == rocfft_array_type_real) //forward
+    {
+        auto rcplan = NodeFactory::CreateNodeFromScheme(CS_REAL_TRANSFORM_EVEN, this);
+        // for length > 2048, don't try pre/post because LDS usage is too high
+        static_cast<RealTransEvenNode*>(rcplan.get())->try_fuse_pre_post_processing
+            = length[0] <= 2048;
+
+        rcplan->length    = length;
+        rcplan->dimension = 1;
+        rcplan->RecursiveBuildTree();
+        childNodes.emplace_back(std::move(rcplan));
+
+        for(size_t dim = 1; dim < outputLength.size(); ++dim)
+            childNodes.emplace_back(CreateColumnNode(this, outputLength, dim));
+    }
+    else
+    {
+        for(size_t dim = length.size() - 1; dim > 0; --dim)
+            childNodes.emplace_back(CreateColumnNode(this, length, dim));
+
+        // c2r
+        auto crplan = NodeFactory::CreateNodeFromScheme(CS_REAL_TRANSFORM_EVEN, this);
+        // for length > 2048, don't try pre/post because LDS usage is too high
+        static_cast<RealTransEvenNode*>(crplan.get())->try_fuse_pre_post_processing
+            = length[0] <= 2048;
+
+        crplan->length    = outputLength;
+        crplan->dimension = 1;
+        crplan->RecursiveBuildTree();
+        childNodes.emplace_back(std::move(crplan));
+    }
+}
+
+void RealNDEvenNode::AssignParams_internal()
+{
+    const bool forward = inArrayType == rocfft_array_type_real;
+    if(forward)
+    {
+        auto& rcplan = childNodes.front();
+
+        rcplan->inStride = inStride;
+        rcplan->iDist    = iDist;
+
+        rcplan->outStride = outStride;
+        rcplan->oDist     = oDist;
+
+        rcplan->AssignParams();
+
+        // columns are in-place on the complex output
+        for(size_t i = 1; i < childNodes.size(); ++i)
+        {
+            auto& colPlan     = childNodes[i];
+            colPlan->inStride = DimToFront(rcplan->outStride, i);
+            colPlan->iDist    = rcplan->oDist;
+
+            colPlan->outStride = colPlan->inStride;
+            colPlan->oDist     = colPlan->iDist;
+            colPlan->AssignParams();
+        }
+    }
+    else
+    {
+        // columns are in-place on the complex input, from the
+        // highest dimension down
+        for(size_t i = 0; i + 1 < childNodes.size(); ++i)
+        {
+            auto& colPlan     = childNodes[i];
+            colPlan->inStride = DimToFront(inStride, length.size() - 1 - i);
+            colPlan->iDist    = iDist;
+
+            colPlan->outStride = colPlan->inStride;
+            colPlan->oDist     = colPlan->iDist;
+            colPlan->AssignParams();
+        }
+
+        auto& crplan = childNodes.back();
+        {
+            crplan->inStride  = inStride;
+            crplan->iDist     = iDist;
+            crplan->outStride = outStride;
+            crplan->oDist     = oDist;
+            crplan->dimension = 1;
+            crplan->AssignParams();
+        }
+    }
+}
+
 /*****************************************************
  * CS_KERNEL_COPY_R_TO_CMPLX
  * CS_KERNEL_COPY_HERM_TO_CMPLX
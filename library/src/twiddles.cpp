@@ -24,14 +24,24 @@
 #include "arithmetic.h"
 #include "device/kernels/twiddle_factors.h"
 #include "function_pool.h"
+#include "ref_cpu_fft.h"
+#include "../../shared/environment.h"
 #include "rocfft_hip.h"
+#include "rtc_cache.h"
+#include <algorithm>
 #include <cassert>
+#include <complex>
+#include <cstring>
+#include <functional>
 #include <math.h>
 #include <numeric>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
 
+static const long double PI_LONG = 3.141592653589793238462643383279502884L;
+
 // Twiddle factors table
 template <typename T>
 class TwiddleTable
@@ -380,9 +390,201 @@ public:
     }
 };
 
+// Tables generated on the host, from their layout.  Angles are
+// reduced exactly before sin/cos are taken in extended precision, so
+// values are as accurate as the type allows and don't depend on the
+// device.
+
+// fewest values worth giving a thread of its own
+static const size_t TWIDDLE_HOST_MIN_PER_THREAD = 16384;
+// smaller tables are quicker to generate than to look up in the
+// cache, and larger ones would bloat it
+static const size_t TWIDDLE_CACHE_MIN_COUNT = 1024;
+static const size_t TWIDDLE_CACHE_MAX_BYTES = 4 * 1024 * 1024;
+
+// ROCFFT_TWIDDLE_GENERATOR=device generates tables with device
+// kernels instead
+static bool twiddles_on_device()
+{
+    return rocfft_getenv("ROCFFT_TWIDDLE_GENERATOR") == "device";
+}
+
+// exp(-2*pi*i*num/den)
+template <typename T>
+static void twiddle_value(size_t num, size_t den, T& output)
+{
+    long double theta = -2.0L * PI_LONG * (num % den) / den;
+    // round through double, like the device kernels
+    output.x = static_cast<double>(cosl(theta));
+    output.y = static_cast<double>(sinl(theta));
+}
+
+// fill values [begin, end) of a run that starts at 'output'
+template <typename T>
+static void twiddles_fill_segment(const TwiddleSegment& seg, size_t begin, size_t end, T* output)
+{
+    switch(seg.kind)
+    {
+    case TwiddleSegment::LINEAR:
+        for(size_t i = begin; i < end; ++i)
+            twiddle_value(i, seg.length, output[i]);
+        break;
+    case TwiddleSegment::RADICES:
+    {
+        // each pass after the first has radix-1 values for each k
+        // below the product of the radices before it
+        size_t passStart = 0;
+        size_t prod      = seg.radices.front();
+        for(size_t p = 1; p < seg.radices.size() && passStart < end; ++p)
+        {
+            auto radix   = seg.radices[p];
+            auto passEnd = passStart + prod * (radix - 1);
+            for(size_t i = std::max(begin, passStart); i < std::min(end, passEnd); ++i)
+            {
+                auto k = (i - passStart) / (radix - 1);
+                auto j = (i - passStart) % (radix - 1) + 1;
+                twiddle_value(j * k, prod * radix, output[i]);
+            }
+            passStart = passEnd;
+            prod *= radix;
+        }
+        break;
+    }
+    case TwiddleSegment::LARGE:
+    {
+        // row iY holds exp(-2*pi*i*iX*2^(iY*base)/length)
+        const size_t X = static_cast<size_t>(1) << seg.base;
+        for(size_t i = begin; i < end; ++i)
+        {
+            auto   iY     = i / X;
+            auto   iX     = i % X;
+            size_t rowMul = 1 % seg.length;
+            for(size_t b = 0; b < iY * seg.base; ++b)
+                rowMul = rowMul * 2 % seg.length;
+            twiddle_value(rowMul * iX, seg.length, output[i]);
+        }
+        break;
+    }
+    case TwiddleSegment::CHIRP:
+        throw std::runtime_error("chirps are not generated as twiddle tables");
+    }
+}
+
+// generate a whole table, split evenly across the host's cores
+template <typename T>
+static std::vector<T> twiddles_generate_host(const std::vector<TwiddleSegment>& layout)
+{
+    size_t total = 0;
+    for(const auto& seg : layout)
+    {
+        if(seg.kind == TwiddleSegment::CHIRP)
+            throw std::runtime_error("chirps are not generated as twiddle tables");
+        total += seg.count;
+    }
+    std::vector<T> host(total);
+
+    auto fill = [&](size_t begin, size_t end) {
+        size_t segStart = 0;
+        for(const auto& seg : layout)
+        {
+            size_t segEnd = segStart + seg.count;
+            if(segEnd > begin && segStart < end)
+                twiddles_fill_segment(seg,
+                                      std::max(begin, segStart) - segStart,
+                                      std::min(end, segEnd) - segStart,
+                                      host.data() + segStart);
+            segStart = segEnd;
+        }
+    };
+
+    size_t numThreads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u),
+                                         DivRoundingUp(total, TWIDDLE_HOST_MIN_PER_THREAD));
+    numThreads        = std::max<size_t>(numThreads, 1);
+    size_t chunk      = DivRoundingUp(total, numThreads);
+
+    std::vector<std::thread> threads;
+    for(size_t t = 1; t < numThreads; ++t)
+        threads.emplace_back(fill, std::min(total, t * chunk), std::min(total, (t + 1) * chunk));
+    fill(0, std::min(total, chunk));
+    for(auto& t : threads)
+        t.join();
+    return host;
+}
+
+// copy a host table to a new device buffer
+template <typename T>
+static gpubuf twiddles_upload(const std::vector<T>& host)
+{
+    gpubuf twts;
+    auto   bytes = host.size() * sizeof(T);
+    if(twts.alloc(bytes) != hipSuccess)
+        throw std::runtime_error("unable to allocate twiddle table of " + std::to_string(bytes)
+                                 + " bytes");
+    if(bytes == 0)
+        return twts;
+
+    hipStream_t stream;
+    if(hipStreamCreate(&stream) != hipSuccess)
+        throw std::runtime_error("hipStreamCreate failure");
+
+    if(hipMemcpyAsync(twts.data(), host.data(), bytes, hipMemcpyHostToDevice, stream)
+       != hipSuccess)
+        throw std::runtime_error("unable to copy twiddle table");
+
+    if(hipStreamSynchronize(stream) != hipSuccess || hipStreamDestroy(stream) != hipSuccess)
+        throw std::runtime_error("hipStream failure");
+
+    return twts;
+}
+
+// generate a 1D table on the host, or fetch it from the cache
+template <typename T>
+static gpubuf twiddles_create_host(size_t                     N,
+                                   size_t                     length_limit,
+                                   rocfft_precision           precision,
+                                   size_t                     largeTwdBase,
+                                   bool                       attach_halfN,
+                                   const std::vector<size_t>& radices)
+{
+    auto   layout = twiddles_layout(N, length_limit, largeTwdBase, attach_halfN, radices);
+    size_t count  = 0;
+    for(const auto& seg : layout)
+        count += seg.count;
+    const size_t bytes = count * sizeof(T);
+
+    const bool cacheable = RTCCache::single && count >= TWIDDLE_CACHE_MIN_COUNT
+                           && bytes <= TWIDDLE_CACHE_MAX_BYTES;
+    if(cacheable)
+    {
+        auto cached = RTCCache::single->get_twiddles(
+            N, length_limit, precision, largeTwdBase, attach_halfN, radices);
+        if(cached.size() == bytes)
+        {
+            std::vector<T> host(count);
+            std::memcpy(host.data(), cached.data(), bytes);
+            return twiddles_upload(host);
+        }
+    }
+
+    auto host = twiddles_generate_host<T>(layout);
+    if(cacheable)
+    {
+        auto data = reinterpret_cast<const char*>(host.data());
+        RTCCache::single->store_twiddles(N,
+                                         length_limit,
+                                         precision,
+                                         largeTwdBase,
+                                         attach_halfN,
+                                         radices,
+                                         std::vector<char>(data, data + bytes));
+    }
+    return twiddles_upload(host);
+}
+
 template <typename T>
 gpubuf twiddles_create_pr(size_t                     N,
                           size_t                     length_limit,
+                          rocfft_precision           precision,
                           size_t                     largeTwdBase,
                           bool                       attach_halfN,
                           const std::vector<size_t>& radices)
@@ -390,6 +592,10 @@ gpubuf twiddles_create_pr(size_t                     N,
     if(largeTwdBase && length_limit)
         throw std::runtime_error("length-limited large twiddles are not supported");
 
+    if(!twiddles_on_device())
+        return twiddles_create_host<T>(
+            N, length_limit, precision, largeTwdBase, attach_halfN, radices);
+
     gpubuf      twts;
     hipStream_t stream;
 
@@ -431,9 +637,11 @@ gpubuf twiddles_create(size_t                     N,
                        const std::vector<size_t>& radices)
 {
     if(precision == rocfft_precision_single)
-        return twiddles_create_pr<float2>(N, length_limit, largeTwdBase, attach_halfN, radices);
+        return twiddles_create_pr<float2>(
+            N, length_limit, precision, largeTwdBase, attach_halfN, radices);
     else if(precision == rocfft_precision_double)
-        return twiddles_create_pr<double2>(N, length_limit, largeTwdBase, attach_halfN, radices);
+        return twiddles_create_pr<double2>(
+            N, length_limit, precision, largeTwdBase, attach_halfN, radices);
     else
     {
         assert(false);
@@ -441,11 +649,14 @@ gpubuf twiddles_create(size_t                     N,
     }
 }
 
-template <typename T>
-gpubuf twiddles_create_2D_pr(size_t N1, size_t N2, rocfft_precision precision)
+// split the factors of a 2D kernel into the radices of each dimension
+static void twiddles_radices_2D(size_t               N1,
+                                size_t               N2,
+                                rocfft_precision     precision,
+                                std::vector<size_t>& radices1,
+                                std::vector<size_t>& radices2)
 {
-    auto                kernel = function_pool::get_kernel(fpkey(N1, N2, precision));
-    std::vector<size_t> radices1, radices2;
+    auto kernel = function_pool::get_kernel(fpkey(N1, N2, precision));
 
     int    count               = 0;
     size_t cummulative_product = 1;
@@ -453,8 +664,18 @@ gpubuf twiddles_create_2D_pr(size_t N1, size_t N2, rocfft_precision precision)
     {
         cummulative_product *= kernel.factors[count++];
     }
-    radices1.insert(radices1.cbegin(), kernel.factors.cbegin(), kernel.factors.cbegin() + count);
-    radices2.insert(radices2.cbegin(), kernel.factors.cbegin() + count, kernel.factors.cend());
+    radices1.assign(kernel.factors.cbegin(), kernel.factors.cbegin() + count);
+    radices2.assign(kernel.factors.cbegin() + count, kernel.factors.cend());
+}
+
+template <typename T>
+gpubuf twiddles_create_2D_pr(size_t N1, size_t N2, rocfft_precision precision)
+{
+    if(!twiddles_on_device())
+        return twiddles_upload(twiddles_generate_host<T>(twiddles_layout_2D(N1, N2, precision)));
+
+    std::vector<size_t> radices1, radices2;
+    twiddles_radices_2D(N1, N2, precision, radices1, radices2);
 
     gpubuf      twts;
     hipStream_t stream;
@@ -483,3 +704,159 @@ gpubuf twiddles_create_2D(size_t N1, size_t N2, rocfft_precision precision)
         return {};
     }
 }
+
+bool TwiddleSegment::Contains(const TwiddleSegment& other) const
+{
+    if(kind != other.kind || count < other.count)
+        return false;
+    switch(kind)
+    {
+    case LINEAR:
+        return length == other.length;
+    case RADICES:
+        // values for each pass only depend on the radices up to it
+        return other.radices.size() <= radices.size()
+               && std::equal(other.radices.begin(), other.radices.end(), radices.begin());
+    case LARGE:
+        return length == other.length && base == other.base;
+    case CHIRP:
+        return length == other.length && base == other.base && direction == other.direction;
+    }
+    return false;
+}
+
+// number of values in the per-pass table for these radices
+static size_t radices_table_size(const std::vector<size_t>& radices)
+{
+    if(radices.empty())
+        return 0;
+    return std::accumulate(
+               radices.begin(), radices.end(), static_cast<size_t>(1), std::multiplies<size_t>())
+           - radices.front();
+}
+
+static TwiddleSegment radices_segment(const std::vector<size_t>& radices, size_t count)
+{
+    TwiddleSegment seg;
+    seg.kind    = TwiddleSegment::RADICES;
+    seg.radices = radices;
+    seg.count   = count;
+    return seg;
+}
+
+std::vector<TwiddleSegment> twiddles_layout(size_t                     N,
+                                            size_t                     length_limit,
+                                            size_t                     largeTwdBase,
+                                            bool                       attach_halfN,
+                                            const std::vector<size_t>& radices)
+{
+    std::vector<TwiddleSegment> layout;
+    if(largeTwdBase)
+    {
+        TwiddleSegment seg;
+        seg.kind   = TwiddleSegment::LARGE;
+        seg.length = N;
+        seg.base   = largeTwdBase;
+        seg.count  = (static_cast<size_t>(1) << largeTwdBase)
+                    * DivRoundingUp<size_t>(CeilPo2(N), largeTwdBase);
+        layout.push_back(seg);
+        return layout;
+    }
+
+    auto limit = length_limit ? length_limit : N;
+    if(!radices.empty())
+        layout.push_back(radices_segment(radices, std::min(radices_table_size(radices), limit)));
+    else
+    {
+        TwiddleSegment seg;
+        seg.kind   = TwiddleSegment::LINEAR;
+        seg.length = N;
+        seg.count  = std::min(N, limit);
+        layout.push_back(seg);
+    }
+
+    // the half-N table is the start of a length-2N table
+    if(attach_halfN)
+    {
+        TwiddleSegment seg;
+        seg.kind   = TwiddleSegment::LINEAR;
+        seg.length = 2 * N;
+        seg.count  = (N + 1) / 2;
+        layout.push_back(seg);
+    }
+    return layout;
+}
+
+std::vector<TwiddleSegment> twiddles_layout_2D(size_t N1, size_t N2, rocfft_precision precision)
+{
+    std::vector<size_t> radices1, radices2;
+    twiddles_radices_2D(N1, N2, precision, radices1, radices2);
+
+    std::vector<TwiddleSegment> layout;
+    layout.push_back(radices_segment(radices1, radices_table_size(radices1)));
+    // both dimensions use the same table if they have the same radices
+    if(radices1 != radices2)
+        layout.push_back(radices_segment(radices2, radices_table_size(radices2)));
+    return layout;
+}
+
+std::vector<TwiddleSegment> chirp_layout(size_t N, size_t M, int direction)
+{
+    TwiddleSegment seg;
+    seg.kind      = TwiddleSegment::CHIRP;
+    seg.length    = N;
+    seg.base      = M;
+    seg.direction = direction;
+    seg.count     = 2 * M;
+    return {seg};
+}
+
+template <typename T>
+gpubuf chirp_create_pr(size_t N, size_t M, int direction)
+{
+    // the chirp is exp(-dir * pi * i * n^2 / N), mirrored so that the
+    // convolution wraps around
+    std::vector<std::complex<double>> chirp(M);
+    for(size_t n = 0; n < N; ++n)
+    {
+        long double theta = -direction * PI_LONG * ((n * n) % (2 * N)) / N;
+        std::complex<double> val{static_cast<double>(cosl(theta)),
+                                 static_cast<double>(sinl(theta))};
+        chirp[n] = val;
+        if(n > 0)
+            chirp[M - n] = val;
+    }
+    auto               chirpFFT = chirp;
+    RefFFTPlan<double> plan(M, direction);
+    plan.Execute(chirpFFT.data(), 1, 1, M, 1);
+
+    std::vector<T> host(2 * M);
+    for(size_t i = 0; i < M; ++i)
+    {
+        host[i].x     = chirp[i].real();
+        host[i].y     = chirp[i].imag();
+        host[M + i].x = chirpFFT[i].real();
+        host[M + i].y = chirpFFT[i].imag();
+    }
+
+    gpubuf buf;
+    auto   bytes = host.size() * sizeof(T);
+    if(buf.alloc(bytes) != hipSuccess)
+        throw std::runtime_error("unable to allocate chirp length " + std::to_string(M));
+    if(hipMemcpy(buf.data(), host.data(), bytes, hipMemcpyHostToDevice) != hipSuccess)
+        throw std::runtime_error("unable to copy chirp length " + std::to_string(M));
+    return buf;
+}
+
+gpubuf chirp_create(size_t N, size_t M, rocfft_precision precision, int direction)
+{
+    if(precision == rocfft_precision_single)
+        return chirp_create_pr<float2>(N, M, direction);
+    else if(precision == rocfft_precision_double)
+        return chirp_create_pr<double2>(N, M, direction);
+    else
+    {
+        assert(false);
+        return {};
+    }
+}
@@ -0,0 +1,266 @@
+// Copyright (C) 2022 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "work_buffer_pool.h"
+#include "../../shared/environment.h"
+#include "arithmetic.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+// idle bytes kept per device, unless configured otherwise
+static const size_t DEFAULT_POOL_LIMIT = 512 * 1024 * 1024;
+
+WorkBufferPool::buffer_t::~buffer_t()
+{
+    if(buf)
+        WorkBufferPool::GetWorkBufferPool().Release(*this);
+}
+
+WorkBufferPool::WorkBufferPool()
+    : limit(ConfiguredLimit())
+{
+}
+
+WorkBufferPool& WorkBufferPool::GetWorkBufferPool()
+{
+    static WorkBufferPool pool;
+    return pool;
+}
+
+size_t WorkBufferPool::ConfiguredLimit()
+{
+    auto str_limit = rocfft_getenv("ROCFFT_WORK_BUFFER_POOL_SIZE");
+    if(str_limit.empty())
+        return DEFAULT_POOL_LIMIT;
+    return strtoull(str_limit.c_str(), nullptr, 0);
+}
+
+size_t WorkBufferPool::SizeClass(size_t size_bytes)
+{
+    // smallest class is 64 KiB, above that there are four classes
+    // per power of two, so at most 25% of a buffer is wasted
+    static const size_t MIN_CLASS = 64 * 1024;
+    if(size_bytes <= MIN_CLASS)
+        return MIN_CLASS;
+    size_t pow2 = MIN_CLASS;
+    while(pow2 * 2 < size_bytes)
+        pow2 *= 2;
+    size_t step = pow2 / 4;
+    return pow2 + DivRoundingUp(size_bytes - pow2, step) * step;
+}
+
+void WorkBufferPool::LogStats(const char* event, size_t size_bytes) const
+{
+    log_profile("work_buffer_pool",
+                "event",
+                event,
+                "size_bytes",
+                size_bytes,
+                "in_use_bytes",
+                stats.in_use_bytes,
+                "idle_bytes",
+                stats.idle_bytes,
+                "peak_bytes",
+                stats.peak_bytes,
+                "hits",
+                stats.hits,
+                "misses",
+                stats.misses,
+                "evictions",
+                stats.evictions);
+}
+
+WorkBufferPool::buffer_t WorkBufferPool::Acquire(size_t size_bytes, hipStream_t stream)
+{
+    buffer_t ret;
+    ret.stream = stream;
+    if(hipGetDevice(&ret.deviceId) != hipSuccess)
+        throw std::runtime_error("hipGetDevice failed.");
+
+    const size_t      class_bytes = SizeClass(size_bytes);
+    std::list<gpubuf> evicted;
+    hipEvent_t        released = nullptr;
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        ret.pooled = limit > 0;
+
+        // reuse the smallest idle buffer on this stream that's big
+        // enough, but not one that's much bigger than needed
+        auto& device_idle = idle[ret.deviceId];
+        auto  best        = device_idle.end();
+        for(auto it = device_idle.begin(); it != device_idle.end(); ++it)
+        {
+            if(it->stream != stream || it->buf.size() < class_bytes
+               || it->buf.size() > 2 * class_bytes)
+                continue;
+            if(best == device_idle.end() || it->buf.size() < best->buf.size())
+                best = it;
+        }
+        if(best != device_idle.end())
+        {
+            ret.buf  = std::move(best->buf);
+            released = best->released;
+            device_idle.erase(best);
+            idle_bytes[ret.deviceId] -= ret.buf.size();
+            stats.idle_bytes -= ret.buf.size();
+            stats.in_use_bytes += ret.buf.size();
+            ++stats.hits;
+            LogStats("hit", ret.buf.size());
+        }
+        else
+            ++stats.misses;
+    }
+
+    if(released)
+    {
+        // queue this transform behind the previous one to use the
+        // buffer, or failing that, wait for it here
+        hipError_t err = hipStreamWaitEvent(stream, released, 0);
+        if(err != hipSuccess)
+            err = hipEventSynchronize(released);
+        (void)hipEventDestroy(released);
+        if(err != hipSuccess)
+        {
+            // freeing the buffer waits for the device, so it's safe
+            ret.pooled = false;
+            throw std::runtime_error("unable to wait for previous use of work buffer");
+        }
+        return ret;
+    }
+
+    const size_t alloc_bytes = ret.pooled ? class_bytes : size_bytes;
+    if(ret.buf.alloc(alloc_bytes) != hipSuccess)
+    {
+        // idle buffers on other streams might be what's using up the
+        // memory, so free them and try again
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            EvictIdle(ret.deviceId, 0, evicted);
+        }
+        evicted.clear();
+        if(ret.buf.alloc(alloc_bytes) != hipSuccess)
+            throw std::runtime_error("work buffer allocation of " + std::to_string(alloc_bytes)
+                                     + " bytes failed");
+    }
+
+    std::lock_guard<std::mutex> lck(mtx);
+    stats.in_use_bytes += ret.buf.size();
+    stats.peak_bytes = std::max(stats.peak_bytes, stats.in_use_bytes + stats.idle_bytes);
+    LogStats("miss", ret.buf.size());
+    return ret;
+}
+
+void WorkBufferPool::Release(buffer_t& buffer)
+{
+    // evicted buffers are freed outside the lock, since freeing
+    // synchronizes with the device
+    std::list<gpubuf> evicted;
+
+    // mark the end of the work queued with the buffer, for the next
+    // borrower to wait on.  Without an event, the buffer is freed
+    // instead.
+    hipEvent_t released = nullptr;
+    if(buffer.pooled)
+    {
+        if(hipEventCreateWithFlags(&released, hipEventDisableTiming) != hipSuccess)
+            released = nullptr;
+        else if(hipEventRecord(released, buffer.stream) != hipSuccess)
+        {
+            (void)hipEventDestroy(released);
+            released = nullptr;
+        }
+    }
+
+    std::lock_guard<std::mutex> lck(mtx);
+    stats.in_use_bytes -= buffer.buf.size();
+    // the pool may have been disabled since the buffer was borrowed
+    if(!released || limit == 0)
+    {
+        if(released)
+            (void)hipEventDestroy(released);
+        evicted.push_back(std::move(buffer.buf));
+        return;
+    }
+
+    size_t size_bytes = buffer.buf.size();
+    idle[buffer.deviceId].push_back({buffer.stream, std::move(buffer.buf), released});
+    idle_bytes[buffer.deviceId] += size_bytes;
+    stats.idle_bytes += size_bytes;
+    EvictIdle(buffer.deviceId, limit, evicted);
+    LogStats("release", size_bytes);
+}
+
+void WorkBufferPool::EvictIdle(int deviceId, size_t keep_bytes, std::list<gpubuf>& evicted)
+{
+    auto& device_idle  = idle[deviceId];
+    auto& device_bytes = idle_bytes[deviceId];
+    while(device_bytes > keep_bytes && !device_idle.empty())
+    {
+        size_t size_bytes = device_idle.front().buf.size();
+        evicted.push_back(std::move(device_idle.front().buf));
+        (void)hipEventDestroy(device_idle.front().released);
+        device_idle.pop_front();
+        device_bytes -= size_bytes;
+        stats.idle_bytes -= size_bytes;
+        ++stats.evictions;
+    }
+}
+
+void WorkBufferPool::Trim(size_t keep_bytes)
+{
+    std::list<gpubuf>           evicted;
+    std::lock_guard<std::mutex> lck(mtx);
+    for(auto& device_idle : idle)
+        EvictIdle(device_idle.first, keep_bytes, evicted);
+    LogStats("trim", keep_bytes);
+}
+
+void WorkBufferPool::Setup()
+{
+    WorkBufferPool&             pool = GetWorkBufferPool();
+    std::lock_guard<std::mutex> lck(pool.mtx);
+    pool.limit = ConfiguredLimit();
+}
+
+void WorkBufferPool::Clear()
+{
+    WorkBufferPool& pool = GetWorkBufferPool();
+
+    std::map<int, std::list<idle_buffer_t>> evicted;
+    {
+        std::lock_guard<std::mutex> lck(pool.mtx);
+        evicted.swap(pool.idle);
+        pool.idle_bytes.clear();
+        // buffers still borrowed are accounted for when they're
+        // released
+        size_t in_use_bytes     = pool.stats.in_use_bytes;
+        pool.stats              = stats_t();
+        pool.stats.in_use_bytes = in_use_bytes;
+    }
+    for(auto& device_idle : evicted)
+    {
+        for(auto& buffer : device_idle.second)
+            (void)hipEventDestroy(buffer.released);
+    }
+}